@@ -15,21 +15,21 @@
 void Buzzer_init(void){
 
 	// Set direction of BUZZER_PIN as input
-	GPIO_setupPinDirection(BUZZER_PORT_ID , BUZZER_PIN_ID , PIN_OUTPUT);
+	GPIO_PIN_OUTPUT(BUZZER_PORT_ID , BUZZER_PIN_ID);
 
 	// Deactivates Buzzer at beginning
 
-	GPIO_writePin(BUZZER_PORT_ID , BUZZER_PIN_ID , LOGIC_LOW);
+	GPIO_CLEAR_PIN(BUZZER_PORT_ID , BUZZER_PIN_ID);
 }
 
 
 /* Turn on Buzzer */
 
 void Buzzer_on(void){
-	GPIO_writePin(BUZZER_PORT_ID , BUZZER_PIN_ID , LOGIC_HIGH);
+	GPIO_SET_PIN(BUZZER_PORT_ID , BUZZER_PIN_ID);
 }
 
 // Deactivate Buzzer
 void Buzzer_off(void){
-	GPIO_writePin(BUZZER_PORT_ID , BUZZER_PIN_ID , LOGIC_LOW);
+	GPIO_CLEAR_PIN(BUZZER_PORT_ID , BUZZER_PIN_ID);
 }
@@ -10,15 +10,24 @@
 #include <avr/io.h>
 #include "PWM.h"
 
+/* IN1 and IN2 change together in one masked port write, the H-bridge never sees
+ * an intermediate state (IN1 = IN2 = 1 brakes) while the direction changes */
+#define DC_MOTOR_PINS_MASK	((uint8)((1 << IN1_PIN_ID) | (1 << IN2_PIN_ID)))
+#define DC_MOTOR_CW_PINS	((uint8)(1 << IN1_PIN_ID))
+#define DC_MOTOR_CCW_PINS	((uint8)(1 << IN2_PIN_ID))
+#define DC_MOTOR_STOP_PINS	((uint8)0)
+#define DC_MOTOR_BRAKE_PINS	DC_MOTOR_PINS_MASK
+
 /* Initialize the MOTOR */
 void DC_Motor_init(void) {
-	/* Set Direction of Input1 and Input2 pin as input */
-	GPIO_setupPinDirection(DC_MOTOR_PORT_ID , IN1_PIN_ID , PIN_OUTPUT);
-	GPIO_setupPinDirection(DC_MOTOR_PORT_ID , IN2_PIN_ID , PIN_OUTPUT);
+	/* Stop the Motor IN1 = 0 & IN2 = 0, before the pins become outputs */
+	GPIO_WRITE_PORT_MASKED(DC_MOTOR_PORT_ID, DC_MOTOR_PINS_MASK, DC_MOTOR_STOP_PINS);
+
+	/* Set Direction of Input1 and Input2 pin as output */
+	GPIO_PORT_DIRECTION_MASKED(DC_MOTOR_PORT_ID, DC_MOTOR_PINS_MASK, PORT_OUTPUT);
 
-	/* Stop the Motor IN1 = 0 & IN2 = 0 */
-	GPIO_writePin(DC_MOTOR_PORT_ID , IN1_PIN_ID , LOGIC_LOW);
-	GPIO_writePin(DC_MOTOR_PORT_ID , IN2_PIN_ID , LOGIC_LOW);
+	/* The enable PWM starts at duty 0 and runs from now on, a move only changes its duty */
+	PWM_init();
 }
 
 
@@ -31,23 +40,25 @@ void DC_Motor_Rotate(Dc_Motor_State state, uint8 duty_cycle_percentage) {
 	if(duty_cycle_percentage > 100)
 		duty_cycle_percentage = 100;
 
-	PWM_Set_Duty_Cycle(duty_cycle_percentage);
+	/* Table lookup, the duty starts with the next PWM period */
+	PWM_setDutyPercent(duty_cycle_percentage);
 
     switch(state) {
         case DC_MOTOR_CW:
-            GPIO_writePin(DC_MOTOR_PORT_ID, IN1_PIN_ID, LOGIC_HIGH);
-            GPIO_writePin(DC_MOTOR_PORT_ID, IN2_PIN_ID, LOGIC_LOW);
+            GPIO_WRITE_PORT_MASKED(DC_MOTOR_PORT_ID, DC_MOTOR_PINS_MASK, DC_MOTOR_CW_PINS);
             break;
 
         case DC_MOTOR_CCW:
-            GPIO_writePin(DC_MOTOR_PORT_ID, IN1_PIN_ID, LOGIC_LOW);
-            GPIO_writePin(DC_MOTOR_PORT_ID, IN2_PIN_ID, LOGIC_HIGH);
+            GPIO_WRITE_PORT_MASKED(DC_MOTOR_PORT_ID, DC_MOTOR_PINS_MASK, DC_MOTOR_CCW_PINS);
+            break;
+
+        case DC_MOTOR_BRAKE:
+            GPIO_WRITE_PORT_MASKED(DC_MOTOR_PORT_ID, DC_MOTOR_PINS_MASK, DC_MOTOR_BRAKE_PINS);
             break;
 
         case DC_MOTOR_STOP:
          default:
-            GPIO_writePin(DC_MOTOR_PORT_ID, IN1_PIN_ID, LOGIC_LOW);
-            GPIO_writePin(DC_MOTOR_PORT_ID, IN2_PIN_ID, LOGIC_LOW);
+            GPIO_WRITE_PORT_MASKED(DC_MOTOR_PORT_ID, DC_MOTOR_PINS_MASK, DC_MOTOR_STOP_PINS);
             break;
 
     }
@@ -59,18 +70,17 @@ void DC_Motor_Rotate(Dc_Motor_State state, uint8 duty_cycle_percentage) {
 
 /* Function to get the current status of the motor */
 Dc_Motor_State DC_Motor_getStatus(void) {
-	uint8 in1_state = GPIO_readPin(DC_MOTOR_PORT_ID, IN1_PIN_ID);
-	uint8 in2_state = GPIO_readPin(DC_MOTOR_PORT_ID, IN2_PIN_ID);
+	/* Both pins in one read, a direction change can not be seen half done */
+	uint8 pins = GPIO_READ_PORT(DC_MOTOR_PORT_ID) & DC_MOTOR_PINS_MASK;
 
-	/* Determine the motor state based on the IN1 and IN2 pin states */
-	if (in1_state == LOGIC_LOW && in2_state == LOGIC_LOW) {
-		return DC_MOTOR_STOP;  // Motor is stopped
-	} else if (in1_state == LOGIC_LOW && in2_state == LOGIC_HIGH) {
+	/* Determine the motor state based on the IN1 and IN2 pin states, as set by DC_Motor_Rotate */
+	if (pins == DC_MOTOR_CW_PINS) {
 		return DC_MOTOR_CW;    // Motor is rotating clockwise
-	} else if (in1_state == LOGIC_HIGH && in2_state == LOGIC_LOW) {
+	} else if (pins == DC_MOTOR_CCW_PINS) {
 		return DC_MOTOR_CCW;   // Motor is rotating counterclockwise
+	} else if (pins == DC_MOTOR_BRAKE_PINS) {
+		return DC_MOTOR_BRAKE; // Both pins high, the motor is braking
 	}
 
-	// Default return to stop (safety in case of unexpected states)
 	return DC_MOTOR_STOP;
 }
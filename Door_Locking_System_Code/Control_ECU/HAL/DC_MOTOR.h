@@ -27,7 +27,8 @@
 typedef enum {
 	DC_MOTOR_STOP,        /* Stop motor */
 	DC_MOTOR_CW,          /* Rotate clockwise */
-	DC_MOTOR_CCW          /* Rotate counterclockwise (anti-clockwise) */
+	DC_MOTOR_CCW,         /* Rotate counterclockwise (anti-clockwise) */
+	DC_MOTOR_BRAKE        /* Short the motor (IN1 = IN2 = 1), the speed sets the brake strength */
 } Dc_Motor_State;
 
 /*******************************************************************************
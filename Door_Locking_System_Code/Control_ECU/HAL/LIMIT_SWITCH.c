@@ -0,0 +1,142 @@
+ /******************************************************************************
+ *
+ * Module: Limit Switch
+ *
+ * File Name: LIMIT_SWITCH.c
+ *
+ * Description: Source file for the door end of travel switches.
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#include "LIMIT_SWITCH.h"
+#include "gpio.h"
+#include "debounce.h"
+#include "registers.h" /* For the external interrupt registers */
+#include <avr/interrupt.h> /* For the switch interrupts */
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define LIMIT_SWITCH_PINS_MASK \
+	((uint8)((1 << LIMIT_SWITCH_OPEN_PIN_ID) | (1 << LIMIT_SWITCH_CLOSED_PIN_ID)))
+#define LIMIT_SWITCH_INTS_MASK         ((uint8)((1 << INT0) | (1 << INT1)))
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+/* Pin, interrupt enable bit and interrupt flag of each switch */
+static const uint8 g_pins[] = { LIMIT_SWITCH_OPEN_PIN_ID, LIMIT_SWITCH_CLOSED_PIN_ID };
+static const uint8 g_intBits[] = { INT0, INT1 };
+static const uint8 g_intFlags[] = { INTF0, INTF1 };
+
+static uint8 g_switchGroup = DEBOUNCE_NO_GROUP;
+static void (*volatile g_callBackPtr)(void) = NULL_PTR;
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Set up the switch pins with their pull-up and add them to the debouncer, no switch
+ * is armed. Debounce_tick must be a SysTime tick hook for LimitSwitch_isReached.
+ */
+void LimitSwitch_init(void)
+{
+	Debounce_GroupConfigType config = { LIMIT_SWITCH_PORT_ID, LIMIT_SWITCH_PINS_MASK, LIMIT_SWITCH_PINS_MASK,
+			DEBOUNCE_MS_TO_SAMPLE_TICKS(LIMIT_SWITCH_STABLE_MS), NULL_PTR };
+
+	LimitSwitch_disarm();
+	GPIO_PORT_DIRECTION_MASKED(LIMIT_SWITCH_PORT_ID, LIMIT_SWITCH_PINS_MASK, PORT_INPUT);
+	GPIO_WRITE_PORT_MASKED(LIMIT_SWITCH_PORT_ID, LIMIT_SWITCH_PINS_MASK, LIMIT_SWITCH_PINS_MASK); /* Pull-ups */
+
+	/* Falling edge on INT0 and INT1: the switch closes */
+	REG_CLEAR_BITS(MCUCR, (1 << ISC00) | (1 << ISC10));
+	REG_SET_BITS(MCUCR, (1 << ISC01) | (1 << ISC11));
+
+	g_switchGroup = Debounce_addGroup(&config);
+}
+
+/*
+ * Description :
+ * Set the end of travel callback, called from the interrupt of the armed switch.
+ */
+void LimitSwitch_setCallBack(void (*a_ptr)(void))
+{
+	g_callBackPtr = a_ptr;
+}
+
+/*
+ * Description :
+ * Arm the switch at the end of the move, the other one is disarmed (its bounces while
+ * the door leaves it are ignored). The callback is called at once if the switch is
+ * already closed, there is no edge to wait for.
+ */
+void LimitSwitch_arm(LimitSwitch_IdType id)
+{
+	uint8 sreg = SREG;
+
+	cli();
+	REG_CLEAR_BITS(GICR, LIMIT_SWITCH_INTS_MASK);
+	REG_WRITE(GIFR, (1 << g_intFlags[id])); /* Edge of an earlier move */
+	if(GPIO_READ_PIN(LIMIT_SWITCH_PORT_ID, g_pins[id]) == LOGIC_LOW)
+	{
+		if(g_callBackPtr != NULL_PTR)
+		{
+			g_callBackPtr();
+		}
+	}
+	else
+	{
+		REG_SET_BIT(GICR, g_intBits[id]);
+	}
+	SREG = sreg;
+}
+
+/*
+ * Description :
+ * Disarm both switches.
+ */
+void LimitSwitch_disarm(void)
+{
+	uint8 sreg = SREG;
+
+	cli();
+	REG_CLEAR_BITS(GICR, LIMIT_SWITCH_INTS_MASK);
+	SREG = sreg;
+}
+
+/*
+ * Description :
+ * Return TRUE while the switch is closed (debounced), no port access.
+ */
+boolean LimitSwitch_isReached(LimitSwitch_IdType id)
+{
+	return (Debounce_getState(g_switchGroup) & (1 << g_pins[id])) ? TRUE : FALSE;
+}
+
+/*
+ * Description :
+ * The armed switch closed: one shot, the bounces that follow are not seen.
+ */
+ISR(INT0_vect)
+{
+	REG_CLEAR_BIT(GICR, INT0);
+	if(g_callBackPtr != NULL_PTR)
+	{
+		g_callBackPtr();
+	}
+}
+
+ISR(INT1_vect)
+{
+	REG_CLEAR_BIT(GICR, INT1);
+	if(g_callBackPtr != NULL_PTR)
+	{
+		g_callBackPtr();
+	}
+}
@@ -0,0 +1,82 @@
+ /******************************************************************************
+ *
+ * Module: Limit Switch
+ *
+ * File Name: LIMIT_SWITCH.h
+ *
+ * Description: Header file for the door end of travel switches.
+ *              Each switch closes to ground at one end of the door travel (pull-up
+ *              enabled). Its pin is an external interrupt, the switch of the running
+ *              move is armed and its first falling edge calls the end of travel
+ *              callback at once, before any bounce is over. The debounced levels
+ *              are read from the Debounce_tick samples.
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#ifndef LIMIT_SWITCH_H_
+#define LIMIT_SWITCH_H_
+
+#include "std_types.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/* Both switches on the external interrupt pins: INT0 (PD2) and INT1 (PD3) */
+#define LIMIT_SWITCH_PORT_ID           PORTD_ID
+#define LIMIT_SWITCH_OPEN_PIN_ID       PIN2_ID
+#define LIMIT_SWITCH_CLOSED_PIN_ID     PIN3_ID
+
+/* The pin must hold its level this long (rounded up to whole debounce samples) to be seen */
+#define LIMIT_SWITCH_STABLE_MS         10
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+typedef enum
+{
+	LIMIT_SWITCH_OPEN,                 /* Door fully open */
+	LIMIT_SWITCH_CLOSED                /* Door fully closed */
+}LimitSwitch_IdType;
+
+/*******************************************************************************
+ *                              Functions Prototypes                           *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Set up the switch pins with their pull-up and add them to the debouncer, no switch
+ * is armed. Debounce_tick must be a SysTime tick hook for LimitSwitch_isReached.
+ */
+void LimitSwitch_init(void);
+
+/*
+ * Description :
+ * Set the end of travel callback, called from the interrupt of the armed switch.
+ */
+void LimitSwitch_setCallBack(void (*a_ptr)(void));
+
+/*
+ * Description :
+ * Arm the switch at the end of the move, the other one is disarmed (its bounces while
+ * the door leaves it are ignored). The callback is called at once if the switch is
+ * already closed, there is no edge to wait for.
+ */
+void LimitSwitch_arm(LimitSwitch_IdType id);
+
+/*
+ * Description :
+ * Disarm both switches.
+ */
+void LimitSwitch_disarm(void);
+
+/*
+ * Description :
+ * Return TRUE while the switch is closed (debounced), no port access.
+ */
+boolean LimitSwitch_isReached(LimitSwitch_IdType id);
+
+#endif /* LIMIT_SWITCH_H_ */
@@ -0,0 +1,87 @@
+ /******************************************************************************
+ *
+ * Module: Motor Current
+ *
+ * File Name: MOTOR_CURRENT.c
+ *
+ * Description: Source file for the door motor current sensing.
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#include "MOTOR_CURRENT.h"
+#include "registers.h" /* To use the SREG register */
+#include <avr/interrupt.h> /* For cli() */
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+/* Last ADC result of the motor current and the highest one since the peak reset */
+static volatile uint16 g_current = 0;
+static volatile uint16 g_peak = 0;
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * ADC callback (ADC_setCallBack), keeps the results of the motor current channel.
+ */
+void MotorCurrent_sample(uint8 index, uint16 value)
+{
+	if(index != MOTOR_CURRENT_ADC_INDEX)
+	{
+		return;
+	}
+	g_current = value;
+	if(value > g_peak)
+	{
+		g_peak = value;
+	}
+}
+
+/*
+ * Description :
+ * Return the last motor current in mA.
+ */
+uint16 MotorCurrent_get(void)
+{
+	uint8 sreg = SREG;
+	uint16 value;
+
+	cli();
+	value = g_current;
+	SREG = sreg;
+	return MOTOR_CURRENT_TO_MA(value);
+}
+
+/*
+ * Description :
+ * Return the highest motor current in mA since MotorCurrent_resetPeak.
+ */
+uint16 MotorCurrent_getPeak(void)
+{
+	uint8 sreg = SREG;
+	uint16 value;
+
+	cli();
+	value = g_peak;
+	SREG = sreg;
+	return MOTOR_CURRENT_TO_MA(value);
+}
+
+/*
+ * Description :
+ * Start a new peak measurement, e.g. at the start of a move.
+ */
+void MotorCurrent_resetPeak(void)
+{
+	uint8 sreg = SREG;
+
+	cli();
+	g_peak = 0;
+	SREG = sreg;
+}
@@ -0,0 +1,67 @@
+ /******************************************************************************
+ *
+ * Module: Motor Current
+ *
+ * File Name: MOTOR_CURRENT.h
+ *
+ * Description: Header file for the door motor current sensing.
+ *              The H-bridge current flows through a low side shunt, its amplifier
+ *              output is RC filtered below the PWM frequency and read on an ADC
+ *              channel. The ADC results are kept as they come from the ADC
+ *              interrupt with the peak of the current move, they are converted to
+ *              milliamperes when read.
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#ifndef MOTOR_CURRENT_H_
+#define MOTOR_CURRENT_H_
+
+#include "std_types.h"
+#include "adc.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/* Shunt amplifier output on ADC0 (PA0), first channel of the ADC sequence */
+#define MOTOR_CURRENT_ADC_CHANNEL      0
+#define MOTOR_CURRENT_ADC_INDEX        0
+
+/* 0.1 ohm shunt and a gain of 20 give 2 V/A, 2.5 A at the 5 V AVCC reference */
+#define MOTOR_CURRENT_FULL_SCALE_MA    2500UL
+
+/* ADC result to mA, a multiply and a shift */
+#define MOTOR_CURRENT_TO_MA(value) \
+	((uint16)(((uint32)(value) * MOTOR_CURRENT_FULL_SCALE_MA) >> ADC_RESULT_BITS))
+
+/*******************************************************************************
+ *                              Functions Prototypes                           *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * ADC callback (ADC_setCallBack), keeps the results of the motor current channel.
+ */
+void MotorCurrent_sample(uint8 index, uint16 value);
+
+/*
+ * Description :
+ * Return the last motor current in mA.
+ */
+uint16 MotorCurrent_get(void);
+
+/*
+ * Description :
+ * Return the highest motor current in mA since MotorCurrent_resetPeak.
+ */
+uint16 MotorCurrent_getPeak(void);
+
+/*
+ * Description :
+ * Start a new peak measurement, e.g. at the start of a move.
+ */
+void MotorCurrent_resetPeak(void);
+
+#endif /* MOTOR_CURRENT_H_ */
@@ -7,30 +7,38 @@
 
 #include "PIR.h"     // Include header file for PIR sensor configuration and function declarations
 #include "gpio.h"    // Include header file for GPIO configurations and functions
+#include "debounce.h" // Include header file for the debouncer sampling the sensor pin
+
+static uint8 g_pirGroup = DEBOUNCE_NO_GROUP;  // Debouncer group of the PIR pin
 
 
 /*
  * Function: PIR_init
  * -------------------
- * Initializes the PIR sensor by setting up the pin direction.
+ * Initializes the PIR sensor by setting up the pin direction and adding it to the debouncer.
  * PIR_PORT_ID: The port where the PIR sensor is connected.
  * PIR_PIN_ID: The specific pin of the port used for PIR sensor input.
+ * Debounce_tick must be a SysTime tick hook for PIR_Motion to follow the sensor.
  */
 void PIR_init(){
-	GPIO_setupPinDirection(PIR_PORT_ID, PIR_PIN_ID, PIN_INPUT);  // Set the PIR pin as an input
+	Debounce_GroupConfigType config = { PIR_PORT_ID, (1 << PIR_PIN_ID), 0,
+			DEBOUNCE_MS_TO_SAMPLE_TICKS(PIR_STABLE_MS), NULL_PTR };
+
+	GPIO_PIN_INPUT(PIR_PORT_ID, PIR_PIN_ID);  // Set the PIR pin as an input
+	g_pirGroup = Debounce_addGroup(&config);  // The sensor drives the pin high on motion
 }
 
 
 /*
  * Function: PIR_Motion
  * ---------------------
- * Reads and returns the state of the PIR sensor.
+ * Returns the debounced state of the PIR sensor, no port access.
  * Returns:
  *    uint8 motion - The current state of the PIR sensor (1 if motion is detected, 0 otherwise).
  */
 uint8 PIR_Motion(){
 
-	uint8 motion = GPIO_readPin(PIR_PORT_ID, PIR_PIN_ID);  // Read PIR sensor pin value
+	uint8 motion = (Debounce_getState(g_pirGroup) != 0) ? MOTION : NO_MOTION;  // Read the debounced state
 
 	return motion;  // Return motion status
 }
@@ -20,6 +20,9 @@
 #define PIR_PORT_ID  PORTC_ID
 #define PIR_PIN_ID 	 PIN2_ID
 
+/* The output must hold its level this long (rounded up to whole debounce samples) to be seen */
+#define PIR_STABLE_MS 	 50
+
 
 /*******************************************************************************
  *                                Functions Protoype                            *
@@ -28,9 +31,10 @@
 /*
  * Function: PIR_init
  * -------------------
- * Initializes the PIR sensor by setting up the pin direction.
+ * Initializes the PIR sensor by setting up the pin direction and adding it to the debouncer.
  * PIR_PORT_ID: The port where the PIR sensor is connected.
  * PIR_PIN_ID: The specific pin of the port used for PIR sensor input.
+ * Debounce_tick must be a SysTime tick hook for PIR_Motion to follow the sensor.
  */
 
 void PIR_init();
@@ -38,7 +42,7 @@ void PIR_init();
 /*
  * Function: PIR_Motion
  * ---------------------
- * Reads and returns the state of the PIR sensor.
+ * Returns the debounced state of the PIR sensor, no port access.
  * Returns:
  *    uint8 motion - The current state of the PIR sensor (1 if motion is detected, 0 otherwise).
  */
@@ -13,6 +13,7 @@
 #include "external_eeprom.h"   // Include the header file for External EEPROM functions and definitions
 #include "twi.h"               // Include the TWI (I2C) communication library
 #include <util/delay.h>        // Include delay functions
+#include "trace.h"             // Include the trace points for the TWI transactions
 
 
 /*
@@ -119,8 +120,12 @@ uint8 EEPROM_readByte(uint16 u16addr, uint8 *u8data)
  */
 void EEPROM_writeArray(uint16 address, uint8 *arr, uint8 arr_size)
 {
+    uint8 status;
+
     for(uint8 i = 0; i < arr_size; i++) {
-        EEPROM_writeByte((address + i), arr[i]);  // Write each byte from the array
+        TRACE(TRACE_EVENT_TWI_WRITE, address + i);
+        status = EEPROM_writeByte((address + i), arr[i]);  // Write each byte from the array
+        TRACE(TRACE_EVENT_TWI_END, status);
         _delay_ms(10);  // Delay to allow EEPROM write time
     }
 }
@@ -138,8 +143,12 @@ void EEPROM_writeArray(uint16 address, uint8 *arr, uint8 arr_size)
  */
 void EEPROM_readArray(uint16 address, uint8 *arr, uint8 arr_size)
 {
+    uint8 status;
+
     for(uint8 i = 0; i < arr_size; i++) {
-        EEPROM_readByte((address + i), &arr[i]);  // Read each byte into the array
+        TRACE(TRACE_EVENT_TWI_READ, address + i);
+        status = EEPROM_readByte((address + i), &arr[i]);  // Read each byte into the array
+        TRACE(TRACE_EVENT_TWI_END, status);
         _delay_ms(10);  // Delay to ensure stable reading
     }
 }
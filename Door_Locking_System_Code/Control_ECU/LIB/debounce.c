@@ -0,0 +1,197 @@
+ /******************************************************************************
+ *
+ * Module: DEBOUNCE
+ *
+ * File Name: debounce.c
+ *
+ * Description: Source file for the discrete inputs debouncer
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#include "debounce.h"
+#include "gpio.h"
+#include "registers.h" /* To use the SREG and PIN registers */
+#include <avr/interrupt.h> /* For cli() */
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+typedef struct
+{
+	REG_RefType pin_register;          /* Found once from the port id, read directly in the tick */
+	uint8 mask;
+	uint8 active_low;
+	uint8 sample_ticks;
+	uint8 countdown;                   /* Ticks to the next sample */
+	uint8 counter0;                    /* Vertical counters, bit n of both is the counter of pin n */
+	uint8 counter1;
+	volatile uint8 state;              /* Debounced state, 1 = active */
+	volatile uint8 activated;          /* Latched edges, cleared when read */
+	volatile uint8 deactivated;
+	void (*callback)(uint8 activated, uint8 deactivated);
+}Debounce_GroupType;
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+static const REG_RefType g_pinRegisters[NUM_OF_PORTS] = { REG_REF(PINA), REG_REF(PINB), REG_REF(PINC), REG_REF(PIND) };
+
+static Debounce_GroupType g_groups[DEBOUNCE_MAX_GROUPS];
+static volatile uint8 g_numOfGroups = 0;
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Remove all the groups, Debounce_tick can be a tick hook before or after this call.
+ */
+void Debounce_init(void)
+{
+	g_numOfGroups = 0;
+}
+
+/*
+ * Description :
+ * Add a group of input pins, the pins must already be set up as inputs. The debounced
+ * state starts from the current pin levels, so there is no event for the initial level.
+ * Returns the group id used by the other functions, or DEBOUNCE_NO_GROUP.
+ */
+uint8 Debounce_addGroup(const Debounce_GroupConfigType *config)
+{
+	Debounce_GroupType *group;
+
+	if((g_numOfGroups >= DEBOUNCE_MAX_GROUPS) || (config->port_num >= NUM_OF_PORTS))
+	{
+		return DEBOUNCE_NO_GROUP;
+	}
+
+	group = &g_groups[g_numOfGroups];
+	group->pin_register = g_pinRegisters[config->port_num];
+	group->mask = config->mask;
+	group->active_low = config->active_low & config->mask;
+	group->sample_ticks = (config->sample_ticks == 0) ? 1 : config->sample_ticks;
+	group->countdown = 1;
+	group->counter0 = 0xFF;
+	group->counter1 = 0xFF;
+	group->state = (REG_READ_REF(group->pin_register) ^ group->active_low) & group->mask;
+	group->activated = 0;
+	group->deactivated = 0;
+	group->callback = config->callback;
+
+	/* Fill the group before publishing the new count to the interrupt */
+	g_numOfGroups++;
+
+	return g_numOfGroups - 1;
+}
+
+/*
+ * Description :
+ * Sample the groups due on this tick and latch the state changes,
+ * called from the timer interrupt (SysTime tick hook).
+ */
+void Debounce_tick(void)
+{
+	Debounce_GroupType *group;
+	uint8 i;
+	uint8 changed;
+
+	for(i = 0; i < g_numOfGroups; i++)
+	{
+		group = &g_groups[i];
+		group->countdown--;
+		if(group->countdown != 0)
+		{
+			continue;
+		}
+		group->countdown = group->sample_ticks;
+
+		/* One port read, the pins whose level differs from their debounced state */
+		changed = (REG_READ_REF(group->pin_register) ^ group->active_low ^ group->state) & group->mask;
+
+		/*
+		 * Count these pins down, the other pins reload their counter (counter1:counter0 = 11).
+		 * Both counter bytes are updated for the 8 pins at once.
+		 */
+		group->counter0 = ~(group->counter0 & changed);
+		group->counter1 = group->counter0 ^ (group->counter1 & changed);
+
+		/* A counter back to 11 after DEBOUNCE_SAMPLES different samples toggles its pin */
+		changed &= group->counter0 & group->counter1;
+		if(changed != 0)
+		{
+			group->state ^= changed;
+			group->activated |= changed & group->state;
+			group->deactivated |= changed & ~group->state;
+			if(group->callback != NULL_PTR)
+			{
+				group->callback(changed & group->state, changed & ~group->state);
+			}
+		}
+	}
+}
+
+/*
+ * Description :
+ * Return the debounced state of the group pins, a bit is set while its pin is active.
+ */
+uint8 Debounce_getState(uint8 group)
+{
+	if(group >= g_numOfGroups)
+	{
+		return 0;
+	}
+	return g_groups[group].state;
+}
+
+/*
+ * Description :
+ * Return the pins of mask that became active since the last call for them, and clear these events.
+ */
+uint8 Debounce_getActivated(uint8 group, uint8 mask)
+{
+	uint8 events;
+	uint8 sreg;
+
+	if(group >= g_numOfGroups)
+	{
+		return 0;
+	}
+
+	/* The tick may latch a new edge between the read and the clear */
+	sreg = SREG;
+	cli();
+	events = g_groups[group].activated & mask;
+	g_groups[group].activated &= ~events;
+	SREG = sreg;
+
+	return events;
+}
+
+/*
+ * Description :
+ * Return the pins of mask that became inactive since the last call for them, and clear these events.
+ */
+uint8 Debounce_getDeactivated(uint8 group, uint8 mask)
+{
+	uint8 events;
+	uint8 sreg;
+
+	if(group >= g_numOfGroups)
+	{
+		return 0;
+	}
+
+	sreg = SREG;
+	cli();
+	events = g_groups[group].deactivated & mask;
+	g_groups[group].deactivated &= ~events;
+	SREG = sreg;
+
+	return events;
+}
@@ -0,0 +1,94 @@
+ /******************************************************************************
+ *
+ * Module: DEBOUNCE
+ *
+ * File Name: debounce.h
+ *
+ * Description: Header file for the discrete inputs debouncer.
+ *              Each group is a set of pins of one port read with a single PIN
+ *              read from the SysTime tick. The 8 pins of a group are debounced
+ *              together with vertical counters: bit n of two counter bytes is
+ *              the 2-bit counter of pin n, so one sample of the whole port is a
+ *              few logic operations whatever the number of pins.
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#ifndef DEBOUNCE_H_
+#define DEBOUNCE_H_
+
+#include "std_types.h"
+#include "systime.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/* Maximum number of input groups */
+#define DEBOUNCE_MAX_GROUPS            4
+
+/* Consecutive samples at the new level before a pin changes state (2-bit vertical counter) */
+#define DEBOUNCE_SAMPLES               4
+
+/* Returned by Debounce_addGroup when all the DEBOUNCE_MAX_GROUPS slots are used */
+#define DEBOUNCE_NO_GROUP              0xFF
+
+/* Sample period giving at least the required stable time in milliseconds */
+#define DEBOUNCE_MS_TO_SAMPLE_TICKS(ms) \
+	((uint8)(((uint32)(ms) + (DEBOUNCE_SAMPLES * SYSTIME_MS_PER_TICK) - 1) / (DEBOUNCE_SAMPLES * SYSTIME_MS_PER_TICK)))
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+typedef struct
+{
+	uint8 port_num;                    /* PORTA_ID..PORTD_ID */
+	uint8 mask;                        /* Pins of the port in the group */
+	uint8 active_low;                  /* Pins active at LOGIC_LOW (switch to ground with pull-up) */
+	uint8 sample_ticks;                /* Ticks between samples (0 is 1), stable time = DEBOUNCE_SAMPLES * sample_ticks */
+	/* Called from the tick interrupt with the pins that just became active/inactive, or NULL_PTR */
+	void (*callback)(uint8 activated, uint8 deactivated);
+}Debounce_GroupConfigType;
+
+/*******************************************************************************
+ *                              Functions Prototypes                           *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Remove all the groups, Debounce_tick can be a tick hook before or after this call.
+ */
+void Debounce_init(void);
+
+/*
+ * Description :
+ * Add a group of input pins, the pins must already be set up as inputs. The debounced
+ * state starts from the current pin levels, so there is no event for the initial level.
+ * Returns the group id used by the other functions, or DEBOUNCE_NO_GROUP.
+ */
+uint8 Debounce_addGroup(const Debounce_GroupConfigType *config);
+
+/*
+ * Description :
+ * Sample the groups due on this tick and latch the state changes,
+ * called from the timer interrupt (SysTime tick hook).
+ */
+void Debounce_tick(void);
+
+/*
+ * Description :
+ * Return the debounced state of the group pins, a bit is set while its pin is active.
+ */
+uint8 Debounce_getState(uint8 group);
+
+/*
+ * Description :
+ * Return the pins of mask that became active (activated) or inactive (deactivated)
+ * since the last call for them, and clear these events.
+ */
+uint8 Debounce_getActivated(uint8 group, uint8 mask);
+uint8 Debounce_getDeactivated(uint8 group, uint8 mask);
+
+#endif /* DEBOUNCE_H_ */
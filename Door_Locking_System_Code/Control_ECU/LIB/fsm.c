@@ -0,0 +1,247 @@
+ /******************************************************************************
+ *
+ * Module: FSM
+ *
+ * File Name: fsm.c
+ *
+ * Description: Source file for the table-driven finite state machine engine.
+ *              The engine has no hardware dependency so it can also be built
+ *              and exercised on the host (with TRACE_ENABLE=0).
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#include "fsm.h"
+#include "trace.h"
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static void FSM_readTransition(const FSM_TransitionType *entry, FSM_TransitionType *transition);
+static FSM_HandlerType FSM_readHandler(const FSM_HandlerType *entry);
+static uint32 FSM_getTime(const FSM_Type *fsm);
+static void FSM_enterState(FSM_Type *fsm, FSM_StateType state);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Initialize the state machine and enter the initial state.
+ * state_stats and transition_counts are optional RAM arrays for the instrumentation,
+ * pass NULL_PTR to disable it.
+ */
+void FSM_init(FSM_Type *fsm, const FSM_ConfigType *config,
+		FSM_StateStatsType *state_stats, uint16 *transition_counts)
+{
+	fsm->config = config;
+	fsm->state_stats = state_stats;
+	fsm->transition_counts = transition_counts;
+
+	FSM_resetStats(fsm);
+	FSM_enterState(fsm, config->initial_state);
+}
+
+/*
+ * Description :
+ * Look up the transition of the current state for the required event in O(1).
+ * Returns TRUE if a transition was taken, FALSE if the event is ignored or the guard failed.
+ */
+boolean FSM_dispatch(FSM_Type *fsm, FSM_EventType event)
+{
+	const FSM_ConfigType *config = fsm->config;
+	uint16 index;
+	FSM_TransitionType transition;
+
+	if(event >= config->num_events)
+	{
+		return FALSE;
+	}
+
+	/* Direct indexing in the [state][event] table, no search is needed */
+	index = ((uint16)fsm->current_state * config->num_events) + event;
+	FSM_readTransition(&config->transitions[index], &transition);
+
+	if(transition.next_state == FSM_NO_STATE)
+	{
+		return FALSE; /* Event is ignored in this state */
+	}
+
+	if((transition.guard != NULL_PTR) && (transition.guard() == FALSE))
+	{
+		return FALSE;
+	}
+
+	if(fsm->transition_counts != NULL_PTR)
+	{
+		fsm->transition_counts[index]++;
+	}
+
+	if(transition.action != NULL_PTR)
+	{
+		transition.action();
+	}
+
+	/* Close the measurement of the state we are leaving */
+	if(fsm->state_stats != NULL_PTR)
+	{
+		fsm->state_stats[fsm->current_state].time_in_state += FSM_getTime(fsm) - fsm->state_entry_time;
+	}
+
+	FSM_enterState(fsm, transition.next_state);
+
+	return TRUE;
+}
+
+/*
+ * Description :
+ * Run the activity of the current state once and dispatch the event it returns.
+ */
+void FSM_run(FSM_Type *fsm)
+{
+	FSM_HandlerType handler = FSM_readHandler(&fsm->config->handlers[fsm->current_state]);
+
+	if(handler != NULL_PTR)
+	{
+		FSM_dispatch(fsm, handler());
+	}
+}
+
+/*
+ * Description :
+ * Return the current state of the machine.
+ */
+FSM_StateType FSM_getState(const FSM_Type *fsm)
+{
+	return fsm->current_state;
+}
+
+/*
+ * Description :
+ * Return the total time spent in the required state, including the current visit.
+ */
+uint32 FSM_getTimeInState(const FSM_Type *fsm, FSM_StateType state)
+{
+	uint32 time = 0;
+
+	if((fsm->state_stats != NULL_PTR) && (state < fsm->config->num_states))
+	{
+		time = fsm->state_stats[state].time_in_state;
+
+		if(state == fsm->current_state)
+		{
+			time += FSM_getTime(fsm) - fsm->state_entry_time;
+		}
+	}
+
+	return time;
+}
+
+/*
+ * Description :
+ * Return how many times the transition [state][event] was taken.
+ */
+uint16 FSM_getTransitionCount(const FSM_Type *fsm, FSM_StateType state, FSM_EventType event)
+{
+	const FSM_ConfigType *config = fsm->config;
+
+	if((fsm->transition_counts == NULL_PTR) || (state >= config->num_states) || (event >= config->num_events))
+	{
+		return 0;
+	}
+
+	return fsm->transition_counts[((uint16)state * config->num_events) + event];
+}
+
+/*
+ * Description :
+ * Clear the instrumentation counters and restart the measurement of the current state.
+ */
+void FSM_resetStats(FSM_Type *fsm)
+{
+	const FSM_ConfigType *config = fsm->config;
+	uint16 i;
+
+	if(fsm->state_stats != NULL_PTR)
+	{
+		for(i = 0; i < config->num_states; i++)
+		{
+			fsm->state_stats[i].time_in_state = 0;
+			fsm->state_stats[i].entries = 0;
+		}
+	}
+
+	if(fsm->transition_counts != NULL_PTR)
+	{
+		for(i = 0; i < ((uint16)config->num_states * config->num_events); i++)
+		{
+			fsm->transition_counts[i] = 0;
+		}
+	}
+
+	fsm->state_entry_time = FSM_getTime(fsm);
+}
+
+/*******************************************************************************
+ *                      Private Functions Definitions                          *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Copy one cell of the transition table from the flash to RAM.
+ */
+static void FSM_readTransition(const FSM_TransitionType *entry, FSM_TransitionType *transition)
+{
+#ifdef __AVR__
+	memcpy_P(transition, entry, sizeof(FSM_TransitionType));
+#else
+	*transition = *entry;
+#endif
+}
+
+/*
+ * Description :
+ * Read the activity function of a state from the flash.
+ */
+static FSM_HandlerType FSM_readHandler(const FSM_HandlerType *entry)
+{
+#ifdef __AVR__
+	return (FSM_HandlerType)pgm_read_word(entry);
+#else
+	return *entry;
+#endif
+}
+
+/*
+ * Description :
+ * Read the time source of the machine, 0 if the time measurement is disabled.
+ */
+static uint32 FSM_getTime(const FSM_Type *fsm)
+{
+	if(fsm->config->get_time == NULL_PTR)
+	{
+		return 0;
+	}
+
+	return fsm->config->get_time();
+}
+
+/*
+ * Description :
+ * Make the required state the current one and start measuring its time.
+ */
+static void FSM_enterState(FSM_Type *fsm, FSM_StateType state)
+{
+	fsm->current_state = state;
+	fsm->state_entry_time = FSM_getTime(fsm);
+
+	TRACE(TRACE_EVENT_STATE, state);
+
+	if(fsm->state_stats != NULL_PTR)
+	{
+		fsm->state_stats[state].entries++;
+	}
+}
@@ -0,0 +1,154 @@
+ /******************************************************************************
+ *
+ * Module: HISTOGRAM
+ *
+ * File Name: histogram.c
+ *
+ * Description: Source file for the log-bucketed latency histograms.
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#include "histogram.h"
+#include "uart.h"
+#include <avr/pgmspace.h>
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+/* Exclusive upper limit of each bucket except the last one: round(10^((i + 1) / 3)) */
+static const uint32 g_bucketLimits[HISTOGRAM_NUM_BUCKETS - 1] PROGMEM = {
+	2, 5, 10,
+	22, 46, 100,
+	215, 464, 1000,
+	2154, 4642, 10000,
+	21544, 46416, 100000,
+	215443, 464159, 1000000
+};
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static uint8 Histogram_getBucket(uint32 value);
+static void Histogram_sendHex(uint32 value, uint8 digits);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Clear the histogram.
+ */
+void Histogram_reset(Histogram_Type *histogram)
+{
+	uint8 i;
+
+	for(i = 0; i < HISTOGRAM_NUM_BUCKETS; i++)
+	{
+		histogram->buckets[i] = 0;
+	}
+	histogram->count = 0;
+	histogram->min = 0xFFFFFFFFUL;
+	histogram->max = 0;
+}
+
+/*
+ * Description :
+ * Add a value to its bucket (binary search in a flash table, no division).
+ * Each histogram must be updated from a single task, it is not locked.
+ */
+void Histogram_record(Histogram_Type *histogram, uint32 value)
+{
+	uint8 bucket = Histogram_getBucket(value);
+
+	if(histogram->buckets[bucket] != 0xFFFF)
+	{
+		histogram->buckets[bucket]++;
+	}
+	if(histogram->count != 0xFFFF)
+	{
+		histogram->count++;
+	}
+	if(value < histogram->min)
+	{
+		histogram->min = value;
+	}
+	if(value > histogram->max)
+	{
+		histogram->max = value;
+	}
+}
+
+/*
+ * Description :
+ * Send the histogram over the UART as text lines:
+ * "S<id:2><count:4><min:8><max:8>\n" then "B<id:2><bucket:2><count:4>\n" for each used bucket.
+ */
+void Histogram_send(const Histogram_Type *histogram, uint8 id)
+{
+	uint8 i;
+
+	UART_sendByte('S');
+	Histogram_sendHex(id, 2);
+	Histogram_sendHex(histogram->count, 4);
+	Histogram_sendHex((histogram->count != 0) ? histogram->min : 0, 8);
+	Histogram_sendHex(histogram->max, 8);
+	UART_sendByte('\n');
+
+	for(i = 0; i < HISTOGRAM_NUM_BUCKETS; i++)
+	{
+		if(histogram->buckets[i] != 0)
+		{
+			UART_sendByte('B');
+			Histogram_sendHex(id, 2);
+			Histogram_sendHex(i, 2);
+			Histogram_sendHex(histogram->buckets[i], 4);
+			UART_sendByte('\n');
+		}
+	}
+}
+
+/*******************************************************************************
+ *                      Private Functions Definitions                          *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Return the index of the first limit above the value, 5 flash reads at most.
+ */
+static uint8 Histogram_getBucket(uint32 value)
+{
+	uint8 low = 0;
+	uint8 high = HISTOGRAM_NUM_BUCKETS - 1;
+	uint8 middle;
+
+	while(low < high)
+	{
+		middle = (low + high) / 2;
+		if(value < pgm_read_dword(&g_bucketLimits[middle]))
+		{
+			high = middle;
+		}
+		else
+		{
+			low = middle + 1;
+		}
+	}
+	return low;
+}
+
+static void Histogram_sendHex(uint32 value, uint8 digits)
+{
+	uint8 nibble;
+
+	while(digits > 0)
+	{
+		digits--;
+		nibble = (uint8)(value >> (digits * 4)) & 0x0F;
+		UART_sendByte((nibble < 10) ? ('0' + nibble) : ('A' + nibble - 10));
+	}
+}
@@ -0,0 +1,69 @@
+ /******************************************************************************
+ *
+ * Module: HISTOGRAM
+ *
+ * File Name: histogram.h
+ *
+ * Description: Header file for the log-bucketed latency histograms.
+ *              Values are SysTime_now() differences (32us counts), the buckets
+ *              are spaced by a constant ratio with HISTOGRAM_BUCKETS_PER_DECADE
+ *              buckets in each decade.
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#ifndef HISTOGRAM_H_
+#define HISTOGRAM_H_
+
+#include "std_types.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Bucket i holds the values below round(10^((i + 1) / HISTOGRAM_BUCKETS_PER_DECADE))
+ * and the last bucket holds everything from 10^HISTOGRAM_DECADES counts (32s) up.
+ */
+#define HISTOGRAM_BUCKETS_PER_DECADE   3
+#define HISTOGRAM_DECADES              6
+#define HISTOGRAM_NUM_BUCKETS          ((HISTOGRAM_BUCKETS_PER_DECADE * HISTOGRAM_DECADES) + 1)
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+typedef struct
+{
+	uint16 buckets[HISTOGRAM_NUM_BUCKETS];     /* Saturate at 0xFFFF */
+	uint16 count;                              /* Saturates at 0xFFFF */
+	uint32 min;
+	uint32 max;
+}Histogram_Type;
+
+/*******************************************************************************
+ *                              Functions Prototypes                           *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Clear the histogram.
+ */
+void Histogram_reset(Histogram_Type *histogram);
+
+/*
+ * Description :
+ * Add a value to its bucket (binary search in a flash table, no division).
+ * Each histogram must be updated from a single task, it is not locked.
+ */
+void Histogram_record(Histogram_Type *histogram, uint32 value);
+
+/*
+ * Description :
+ * Send the histogram over the UART as text lines:
+ * "S<id:2><count:4><min:8><max:8>\n" then "B<id:2><bucket:2><count:4>\n" for each used bucket.
+ */
+void Histogram_send(const Histogram_Type *histogram, uint8 id);
+
+#endif /* HISTOGRAM_H_ */
@@ -0,0 +1,734 @@
+ /******************************************************************************
+ *
+ * Module: KERNEL
+ *
+ * File Name: kernel.c
+ *
+ * Description: Source file for the fixed-priority preemptive kernel.
+ *              The scheduler runs on the SysTime tick (Timer1 compare interrupt).
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#include "kernel.h"
+#include "gpio.h"
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#if !defined(__AVR__)
+#include <stdio.h>
+#include <stdlib.h>
+#include <ucontext.h>
+#endif
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/* Save the interrupt state and disable interrupts / restore the saved state */
+#define KERNEL_ENTER_CRITICAL(sreg)    do { (sreg) = SREG; cli(); } while(0)
+#define KERNEL_EXIT_CRITICAL(sreg)     do { SREG = (sreg); } while(0)
+
+/* The idle task is always the last one in the priority list */
+#define KERNEL_IDLE_PRIORITY           0xFF
+
+#if !defined(__AVR__)
+/*
+ * Host build: the tasks run on ucontext contexts with their own host stack, the
+ * stack_pointer member holds the index of the context (0 is main()).
+ */
+#define KERNEL_HOST_NUM_OF_CONTEXTS    (KERNEL_MAX_TASKS + 2)
+#define KERNEL_HOST_STACK_SIZE         (64 * 1024)
+#endif
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+/* Running task, accessed from the context switch assembly so it is not static */
+Kernel_TaskType *volatile g_kernel_currentTask = NULL_PTR;
+
+/* All the tasks sorted by priority, the idle task is the last one */
+static Kernel_TaskType *g_taskList = NULL_PTR;
+static uint8 g_numOfTasks = 0;
+static volatile boolean g_kernelStarted = FALSE;
+
+static Kernel_TaskType g_idleTask;
+static uint8 g_idleStack[KERNEL_IDLE_STACK_SIZE];
+static void (*volatile g_idleCallBackPtr)(void) = NULL_PTR;
+
+/* Receives the context of main() when the kernel starts, it is never resumed */
+static Kernel_TaskType g_mainContext;
+
+#if !defined(__AVR__)
+static ucontext_t g_hostContexts[KERNEL_HOST_NUM_OF_CONTEXTS];
+static uint8 g_numOfHostContexts = 1;
+#endif
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+#if defined(__AVR__)
+void Kernel_switchContext(void) __attribute__((naked, noinline));
+#else
+void Kernel_switchContext(void);
+static void Kernel_hostTaskStart(void);
+#endif
+void Kernel_selectNextTask(void);
+static void Kernel_insertTask(Kernel_TaskType *task);
+static void Kernel_initStackFrame(Kernel_TaskType *task);
+static void Kernel_taskStart(void);
+static void Kernel_idleTask(void);
+static void Kernel_tick(void);
+static Kernel_TaskType *Kernel_getHighestReady(void);
+static boolean Kernel_semRelease(Kernel_SemaphoreType *sem);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Create a task with the required priority on a statically allocated stack.
+ * The stack is filled with KERNEL_STACK_FILL_BYTE for the watermark.
+ * Returns FALSE if KERNEL_MAX_TASKS is reached or the stack is too small.
+ */
+boolean Kernel_createTask(Kernel_TaskType *task, void (*entry)(void), uint8 priority,
+		uint8 *stack, uint16 stack_size)
+{
+	uint16 i;
+
+	if((g_kernelStarted == TRUE) || (g_numOfTasks >= KERNEL_MAX_TASKS) || (stack_size < KERNEL_MIN_STACK_SIZE))
+	{
+		return FALSE;
+	}
+
+	for(i = 0; i < stack_size; i++)
+	{
+		stack[i] = KERNEL_STACK_FILL_BYTE;
+	}
+
+	task->entry = entry;
+	task->stack = stack;
+	task->stack_size = stack_size;
+	task->priority = priority;
+	task->state = KERNEL_TASK_READY;
+	task->delay = 0;
+	task->blocked_on = NULL_PTR;
+
+	Kernel_initStackFrame(task);
+	Kernel_insertTask(task);
+	g_numOfTasks++;
+
+	return TRUE;
+}
+
+/*
+ * Description :
+ * Hook the scheduler on the SysTime tick and switch to the highest priority task.
+ * SysTime_init must be called first and the kernel should be the last tick hook.
+ * This function never returns.
+ */
+void Kernel_start(void)
+{
+	uint16 i;
+
+	/* The idle task is created here so it does not take an application slot */
+	for(i = 0; i < KERNEL_IDLE_STACK_SIZE; i++)
+	{
+		g_idleStack[i] = KERNEL_STACK_FILL_BYTE;
+	}
+	g_idleTask.entry = Kernel_idleTask;
+	g_idleTask.stack = g_idleStack;
+	g_idleTask.stack_size = KERNEL_IDLE_STACK_SIZE;
+	g_idleTask.priority = KERNEL_IDLE_PRIORITY;
+	g_idleTask.state = KERNEL_TASK_READY;
+	g_idleTask.blocked_on = NULL_PTR;
+	Kernel_initStackFrame(&g_idleTask);
+	Kernel_insertTask(&g_idleTask);
+
+#if (KERNEL_SWITCH_TRACE_ENABLE == 1)
+	GPIO_setupPinDirection(KERNEL_TRACE_PORT_ID, KERNEL_TRACE_PIN_ID, PIN_OUTPUT);
+	GPIO_writePin(KERNEL_TRACE_PORT_ID, KERNEL_TRACE_PIN_ID, LOGIC_LOW);
+#endif
+
+	cli();
+	SysTime_addTickHook(&Kernel_tick);
+	g_kernelStarted = TRUE;
+
+	/* Save main() in a context that is never scheduled and jump to the first task */
+	g_kernel_currentTask = &g_mainContext;
+	Kernel_switchContext();
+
+	while(1);
+}
+
+/*
+ * Description :
+ * Set the function called repeatedly by the idle task when no other task is ready.
+ */
+void Kernel_setIdleCallBack(void (*a_ptr)(void))
+{
+	g_idleCallBackPtr = a_ptr;
+}
+
+/*
+ * Description :
+ * Block the calling task for the required number of ticks.
+ */
+void Kernel_delay(uint16 ticks)
+{
+	uint8 sreg;
+
+	KERNEL_ENTER_CRITICAL(sreg);
+	if(ticks != 0)
+	{
+		g_kernel_currentTask->delay = ticks;
+		g_kernel_currentTask->state = KERNEL_TASK_DELAYED;
+	}
+	Kernel_switchContext();
+	KERNEL_EXIT_CRITICAL(sreg);
+}
+
+/*
+ * Description :
+ * Give the CPU to the highest priority ready task.
+ */
+void Kernel_yield(void)
+{
+	Kernel_delay(0);
+}
+
+/*
+ * Description :
+ * Return the task running now.
+ */
+Kernel_TaskType *Kernel_getCurrentTask(void)
+{
+	return g_kernel_currentTask;
+}
+
+/*
+ * Description :
+ * Return the number of stack bytes never used by the task (stack watermark).
+ */
+uint16 Kernel_getStackUnused(const Kernel_TaskType *task)
+{
+	uint16 unused = 0;
+
+	/* The stack grows down, so the untouched bytes are at the lowest addresses */
+	while((unused < task->stack_size) && (task->stack[unused] == KERNEL_STACK_FILL_BYTE))
+	{
+		unused++;
+	}
+
+	return unused;
+}
+
+/*
+ * Description :
+ * Return the idle task, for its stack watermark.
+ */
+const Kernel_TaskType *Kernel_getIdleTask(void)
+{
+	return &g_idleTask;
+}
+
+/*
+ * Description :
+ * Initialize a semaphore with a start count.
+ */
+void Kernel_semInit(Kernel_SemaphoreType *sem, uint8 count)
+{
+	sem->count = count;
+}
+
+/*
+ * Description :
+ * Take the semaphore, block up to timeout ticks if it is not available.
+ * Returns FALSE on timeout.
+ */
+boolean Kernel_semTake(Kernel_SemaphoreType *sem, uint16 timeout)
+{
+	uint8 sreg;
+	boolean taken = TRUE;
+
+	KERNEL_ENTER_CRITICAL(sreg);
+	if(sem->count > 0)
+	{
+		sem->count--;
+	}
+	else if(timeout == 0)
+	{
+		taken = FALSE;
+	}
+	else
+	{
+		/* The giver clears blocked_on when it hands the semaphore to this task */
+		g_kernel_currentTask->blocked_on = sem;
+		g_kernel_currentTask->delay = timeout;
+		g_kernel_currentTask->state = KERNEL_TASK_BLOCKED;
+		Kernel_switchContext();
+
+		taken = (g_kernel_currentTask->blocked_on == NULL_PTR) ? TRUE : FALSE;
+		g_kernel_currentTask->blocked_on = NULL_PTR;
+	}
+	KERNEL_EXIT_CRITICAL(sreg);
+
+	return taken;
+}
+
+/*
+ * Description :
+ * Give the semaphore from a task, switch at once if a higher priority task was waiting.
+ */
+void Kernel_semGive(Kernel_SemaphoreType *sem)
+{
+	uint8 sreg;
+
+	KERNEL_ENTER_CRITICAL(sreg);
+	if(Kernel_semRelease(sem) == TRUE)
+	{
+		Kernel_switchContext();
+	}
+	KERNEL_EXIT_CRITICAL(sreg);
+}
+
+/*
+ * Description :
+ * Give the semaphore from an ISR, the woken task runs at the latest on the next tick.
+ */
+void Kernel_semGiveFromISR(Kernel_SemaphoreType *sem)
+{
+	uint8 sreg;
+
+	KERNEL_ENTER_CRITICAL(sreg);
+	Kernel_semRelease(sem);
+	KERNEL_EXIT_CRITICAL(sreg);
+}
+
+/*
+ * Description :
+ * Initialize a message queue of length items of item_size bytes each on the given buffer.
+ */
+void Kernel_queueInit(Kernel_QueueType *queue, uint8 *buffer, uint8 item_size, uint8 length)
+{
+	queue->buffer = buffer;
+	queue->item_size = item_size;
+	queue->length = length;
+	queue->head = 0;
+	queue->count = 0;
+	Kernel_semInit(&queue->items, 0);
+	Kernel_semInit(&queue->spaces, length);
+}
+
+/*
+ * Description :
+ * Copy an item at the end of the queue, block up to timeout ticks if the queue is full.
+ * Returns FALSE on timeout.
+ */
+boolean Kernel_queueSend(Kernel_QueueType *queue, const void *item, uint16 timeout)
+{
+	uint8 sreg;
+	uint8 i;
+	uint8 *slot;
+
+	if(Kernel_semTake(&queue->spaces, timeout) == FALSE)
+	{
+		return FALSE;
+	}
+
+	KERNEL_ENTER_CRITICAL(sreg);
+	slot = &queue->buffer[(uint16)((queue->head + queue->count) % queue->length) * queue->item_size];
+	for(i = 0; i < queue->item_size; i++)
+	{
+		slot[i] = ((const uint8 *)item)[i];
+	}
+	queue->count++;
+	KERNEL_EXIT_CRITICAL(sreg);
+
+	Kernel_semGive(&queue->items);
+
+	return TRUE;
+}
+
+/*
+ * Description :
+ * Copy out the oldest item of the queue, block up to timeout ticks if the queue is empty.
+ * Returns FALSE on timeout.
+ */
+boolean Kernel_queueReceive(Kernel_QueueType *queue, void *item, uint16 timeout)
+{
+	uint8 sreg;
+	uint8 i;
+	uint8 *slot;
+
+	if(Kernel_semTake(&queue->items, timeout) == FALSE)
+	{
+		return FALSE;
+	}
+
+	KERNEL_ENTER_CRITICAL(sreg);
+	slot = &queue->buffer[(uint16)queue->head * queue->item_size];
+	for(i = 0; i < queue->item_size; i++)
+	{
+		((uint8 *)item)[i] = slot[i];
+	}
+	queue->head = (queue->head + 1) % queue->length;
+	queue->count--;
+	KERNEL_EXIT_CRITICAL(sreg);
+
+	Kernel_semGive(&queue->spaces);
+
+	return TRUE;
+}
+
+/*******************************************************************************
+ *                      Private Functions Definitions                          *
+ *******************************************************************************/
+
+#if defined(__AVR__)
+
+/*
+ * Description :
+ * Save the full context of the running task on its stack, select the next task and
+ * restore its context. It is called with a normal call from the task or from the tick
+ * interrupt, so the return address is already on the stack and ret resumes the task.
+ * The frame must match Kernel_initStackFrame.
+ */
+void Kernel_switchContext(void)
+{
+	__asm__ __volatile__(
+		"push r0                        \n\t"
+		"in   r0, __SREG__              \n\t"
+		"cli                            \n\t"
+		"push r0                        \n\t"
+		"push r1                        \n\t"
+		"clr  r1                        \n\t"
+		"push r2                        \n\t"
+		"push r3                        \n\t"
+		"push r4                        \n\t"
+		"push r5                        \n\t"
+		"push r6                        \n\t"
+		"push r7                        \n\t"
+		"push r8                        \n\t"
+		"push r9                        \n\t"
+		"push r10                       \n\t"
+		"push r11                       \n\t"
+		"push r12                       \n\t"
+		"push r13                       \n\t"
+		"push r14                       \n\t"
+		"push r15                       \n\t"
+		"push r16                       \n\t"
+		"push r17                       \n\t"
+		"push r18                       \n\t"
+		"push r19                       \n\t"
+		"push r20                       \n\t"
+		"push r21                       \n\t"
+		"push r22                       \n\t"
+		"push r23                       \n\t"
+		"push r24                       \n\t"
+		"push r25                       \n\t"
+		"push r26                       \n\t"
+		"push r27                       \n\t"
+		"push r28                       \n\t"
+		"push r29                       \n\t"
+		"push r30                       \n\t"
+		"push r31                       \n\t"
+		/* g_kernel_currentTask->stack_pointer = SP */
+		"lds  r26, g_kernel_currentTask \n\t"
+		"lds  r27, g_kernel_currentTask+1 \n\t"
+		"in   r0, __SP_L__              \n\t"
+		"st   X+, r0                    \n\t"
+		"in   r0, __SP_H__              \n\t"
+		"st   X+, r0                    \n\t"
+		/* g_kernel_currentTask = highest priority ready task */
+		"call Kernel_selectNextTask     \n\t"
+		/* SP = g_kernel_currentTask->stack_pointer */
+		"lds  r26, g_kernel_currentTask \n\t"
+		"lds  r27, g_kernel_currentTask+1 \n\t"
+		"ld   r28, X+                   \n\t"
+		"out  __SP_L__, r28             \n\t"
+		"ld   r29, X+                   \n\t"
+		"out  __SP_H__, r29             \n\t"
+		"pop  r31                       \n\t"
+		"pop  r30                       \n\t"
+		"pop  r29                       \n\t"
+		"pop  r28                       \n\t"
+		"pop  r27                       \n\t"
+		"pop  r26                       \n\t"
+		"pop  r25                       \n\t"
+		"pop  r24                       \n\t"
+		"pop  r23                       \n\t"
+		"pop  r22                       \n\t"
+		"pop  r21                       \n\t"
+		"pop  r20                       \n\t"
+		"pop  r19                       \n\t"
+		"pop  r18                       \n\t"
+		"pop  r17                       \n\t"
+		"pop  r16                       \n\t"
+		"pop  r15                       \n\t"
+		"pop  r14                       \n\t"
+		"pop  r13                       \n\t"
+		"pop  r12                       \n\t"
+		"pop  r11                       \n\t"
+		"pop  r10                       \n\t"
+		"pop  r9                        \n\t"
+		"pop  r8                        \n\t"
+		"pop  r7                        \n\t"
+		"pop  r6                        \n\t"
+		"pop  r5                        \n\t"
+		"pop  r4                        \n\t"
+		"pop  r3                        \n\t"
+		"pop  r2                        \n\t"
+		"pop  r1                        \n\t"
+		"pop  r0                        \n\t"
+		"out  __SREG__, r0              \n\t"
+		"pop  r0                        \n\t"
+		"ret                            \n\t"
+	);
+}
+
+#else
+
+/*
+ * Description :
+ * Host build of the context switch: the interrupt state stays with the task that
+ * is switched out, as the SREG saved in the AVR frame.
+ */
+void Kernel_switchContext(void)
+{
+	Kernel_TaskType *previous = g_kernel_currentTask;
+	uint8 sreg;
+
+	KERNEL_ENTER_CRITICAL(sreg);
+	Kernel_selectNextTask();
+	if(g_kernel_currentTask != previous)
+	{
+		swapcontext(&g_hostContexts[previous->stack_pointer],
+				&g_hostContexts[g_kernel_currentTask->stack_pointer]);
+	}
+	KERNEL_EXIT_CRITICAL(sreg);
+}
+
+#endif
+
+/*
+ * Description :
+ * Called from the context switch with interrupts disabled to select the next task.
+ */
+void Kernel_selectNextTask(void)
+{
+	g_kernel_currentTask = Kernel_getHighestReady();
+
+#if (KERNEL_SWITCH_TRACE_ENABLE == 1)
+	/* The restore that follows takes a fixed number of cycles */
+	GPIO_writePin(KERNEL_TRACE_PORT_ID, KERNEL_TRACE_PIN_ID, LOGIC_LOW);
+#endif
+}
+
+/*
+ * Description :
+ * Insert the task in the list after the tasks of the same or higher priority.
+ */
+static void Kernel_insertTask(Kernel_TaskType *task)
+{
+	Kernel_TaskType **link = &g_taskList;
+
+	while((*link != NULL_PTR) && ((*link)->priority <= task->priority))
+	{
+		link = &(*link)->next;
+	}
+
+	task->next = *link;
+	*link = task;
+}
+
+#if defined(__AVR__)
+
+/*
+ * Description :
+ * Build the frame Kernel_switchContext pops on the first switch to the task:
+ * return address of Kernel_taskStart, r0, SREG with interrupts enabled, r1..r31 cleared.
+ */
+static void Kernel_initStackFrame(Kernel_TaskType *task)
+{
+	uint8 *stack_top = &task->stack[task->stack_size - 1];
+	uint16 start_address = (uint16)Kernel_taskStart;
+	uint8 i;
+
+	*stack_top-- = (uint8)(start_address);      /* Return address, low byte on top as pushed by call */
+	*stack_top-- = (uint8)(start_address >> 8);
+	*stack_top-- = 0x00;                         /* r0 */
+	*stack_top-- = (1 << 7);                     /* SREG, I bit set */
+	for(i = 1; i <= 31; i++)
+	{
+		*stack_top-- = 0x00;                     /* r1..r31, r1 must be zero for the C code */
+	}
+
+	/* SP points to the next free location */
+	task->stack_pointer = (uint16)stack_top;
+}
+
+#else
+
+/*
+ * Description :
+ * Host build: make the context started on the first switch to the task, the task
+ * stack is not used so the watermark always reports it unused.
+ */
+static void Kernel_initStackFrame(Kernel_TaskType *task)
+{
+	ucontext_t *context;
+
+	if(g_numOfHostContexts >= KERNEL_HOST_NUM_OF_CONTEXTS)
+	{
+		fprintf(stderr, "kernel: too many host contexts\n");
+		exit(2);
+	}
+	context = &g_hostContexts[g_numOfHostContexts];
+	getcontext(context);
+	context->uc_stack.ss_sp = malloc(KERNEL_HOST_STACK_SIZE);
+	context->uc_stack.ss_size = KERNEL_HOST_STACK_SIZE;
+	context->uc_link = NULL;
+	makecontext(context, Kernel_hostTaskStart, 0);
+
+	task->stack_pointer = g_numOfHostContexts++;
+}
+
+/*
+ * Description :
+ * Host build: the task starts with interrupts enabled, as the SREG of the AVR frame.
+ */
+static void Kernel_hostTaskStart(void)
+{
+	SREG = (1 << SREG_I);
+	Kernel_taskStart();
+}
+
+#endif
+
+/*
+ * Description :
+ * First code run by every task, it calls the task function and suspends the task if it returns.
+ */
+static void Kernel_taskStart(void)
+{
+	uint8 sreg;
+
+	g_kernel_currentTask->entry();
+
+	KERNEL_ENTER_CRITICAL(sreg);
+	g_kernel_currentTask->state = KERNEL_TASK_SUSPENDED;
+	Kernel_switchContext();
+	KERNEL_EXIT_CRITICAL(sreg);
+}
+
+/*
+ * Description :
+ * Runs when no other task is ready.
+ */
+static void Kernel_idleTask(void)
+{
+	void (*idle_callback)(void);
+
+	while(1)
+	{
+		idle_callback = g_idleCallBackPtr;
+		if(idle_callback != NULL_PTR)
+		{
+			/* Called with interrupts enabled, the tick preempts it when a task becomes ready */
+			idle_callback();
+		}
+	}
+}
+
+/*
+ * Description :
+ * SysTime tick hook, called from the Timer1 compare interrupt with interrupts disabled.
+ * Counts down the delays and timeouts and preempts the running task if a higher
+ * priority task became ready.
+ */
+static void Kernel_tick(void)
+{
+	Kernel_TaskType *task;
+
+	if(g_kernelStarted == FALSE)
+	{
+		return;
+	}
+
+#if (KERNEL_SWITCH_TRACE_ENABLE == 1)
+	GPIO_writePin(KERNEL_TRACE_PORT_ID, KERNEL_TRACE_PIN_ID, LOGIC_HIGH);
+#endif
+
+	for(task = g_taskList; task != NULL_PTR; task = task->next)
+	{
+		if(((task->state == KERNEL_TASK_DELAYED) || (task->state == KERNEL_TASK_BLOCKED))
+				&& (task->delay != KERNEL_WAIT_FOREVER))
+		{
+			task->delay--;
+			if(task->delay == 0)
+			{
+				/* A blocked task keeps blocked_on set, so it knows it timed out */
+				task->state = KERNEL_TASK_READY;
+			}
+		}
+	}
+
+	if(Kernel_getHighestReady() != g_kernel_currentTask)
+	{
+		Kernel_switchContext();
+	}
+	else
+	{
+#if (KERNEL_SWITCH_TRACE_ENABLE == 1)
+		GPIO_writePin(KERNEL_TRACE_PORT_ID, KERNEL_TRACE_PIN_ID, LOGIC_LOW);
+#endif
+	}
+}
+
+/*
+ * Description :
+ * Return the first ready task in priority order, the idle task is always ready.
+ */
+static Kernel_TaskType *Kernel_getHighestReady(void)
+{
+	Kernel_TaskType *task = g_taskList;
+
+	while(task->state != KERNEL_TASK_READY)
+	{
+		task = task->next;
+	}
+
+	return task;
+}
+
+/*
+ * Description :
+ * Hand the semaphore to the highest priority task waiting for it, or increment the count.
+ * Returns TRUE if the woken task has a higher priority than the running one.
+ * Must be called with interrupts disabled.
+ */
+static boolean Kernel_semRelease(Kernel_SemaphoreType *sem)
+{
+	Kernel_TaskType *task;
+
+	for(task = g_taskList; task != NULL_PTR; task = task->next)
+	{
+		if((task->state == KERNEL_TASK_BLOCKED) && (task->blocked_on == sem))
+		{
+			task->blocked_on = NULL_PTR;
+			task->state = KERNEL_TASK_READY;
+			return (task->priority < g_kernel_currentTask->priority) ? TRUE : FALSE;
+		}
+	}
+
+	if(sem->count < 0xFF)
+	{
+		sem->count++;
+	}
+
+	return FALSE;
+}
@@ -0,0 +1,184 @@
+ /******************************************************************************
+ *
+ * Module: KERNEL
+ *
+ * File Name: kernel.h
+ *
+ * Description: Header file for the fixed-priority preemptive kernel.
+ *              The scheduler runs on the SysTime tick (Timer1 compare interrupt).
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#ifndef KERNEL_H_
+#define KERNEL_H_
+
+#include "std_types.h"
+#include "systime.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/* Maximum number of application tasks, the idle task is not included */
+#define KERNEL_MAX_TASKS               4
+
+/*
+ * Stack budget at -O0, hand estimated from the frame layout of the compiler: an ISR pushes
+ * 17 registers on the 2 bytes return address, a function pushes Y and keeps all its locals
+ * and arguments in its frame. The interrupts do not nest, each task stack holds its deepest
+ * call chain plus the worst interrupt on top of it, the tick that switches the task out:
+ * Timer1 compare ISR 19 + SysTime tick 7 + Kernel_tick 6 + context frame 35
+ * + Kernel_selectNextTask 4 + Kernel_getHighestReady 6 = 77 bytes. The tick hooks
+ * (Motion_tick, DC_Motor_Rotate, PWM, Debounce_tick) and the other interrupts take less.
+ */
+#define KERNEL_INTERRUPT_STACK_LOAD    80
+
+/* Bytes left unused by the budget, Kernel_getStackUnused should never report less */
+#define KERNEL_STACK_MARGIN            16
+
+/* Minimum task stack: interrupt load and margin, the task own calls come on top */
+#define KERNEL_MIN_STACK_SIZE          (KERNEL_INTERRUPT_STACK_LOAD + KERNEL_STACK_MARGIN)
+
+/*
+ * Idle task calls: Kernel_taskStart 3 + idle loop 4 + Power_idle 9 + SysTime_isElapsed 9
+ * + SysTime_getSeconds 4 + SysTime_getTicks 9 = 38 bytes, rounded up
+ */
+#define KERNEL_IDLE_STACK_SIZE         (KERNEL_MIN_STACK_SIZE + 48)
+
+/* Value used to fill the unused stacks, for the stack watermark */
+#define KERNEL_STACK_FILL_BYTE         0xA5
+
+/* Timeout value to block until the object is available */
+#define KERNEL_WAIT_FOREVER            0xFFFF
+
+/* Convert milliseconds to kernel ticks */
+#define KERNEL_MS_TO_TICKS(ms)         ((uint16)SYSTIME_MS_TO_TICKS(ms))
+
+/*
+ * Set to 1 to drive the trace pin high when the tick interrupt enters the kernel
+ * and low when the next task is selected, the pulse width plus the fixed restore
+ * sequence is the context switch latency (observed with a scope or a simavr VCD trace).
+ */
+#define KERNEL_SWITCH_TRACE_ENABLE     0
+#define KERNEL_TRACE_PORT_ID           PORTB_ID
+#define KERNEL_TRACE_PIN_ID            PIN0_ID
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+typedef enum
+{
+	KERNEL_TASK_READY, KERNEL_TASK_DELAYED, KERNEL_TASK_BLOCKED, KERNEL_TASK_SUSPENDED
+}Kernel_TaskStateType;
+
+/* Task control block, the saved stack pointer must be the first member */
+typedef struct Kernel_Task
+{
+	volatile uint16 stack_pointer;     /* Saved SP while the task is switched out */
+	void (*entry)(void);               /* Task function, it should never return */
+	uint8 *stack;                      /* Lowest address of the task stack */
+	uint16 stack_size;
+	uint8 priority;                    /* 0 is the highest priority */
+	volatile Kernel_TaskStateType state;
+	volatile uint16 delay;             /* Remaining ticks of a delay or a blocking timeout */
+	void *volatile blocked_on;         /* Object the task waits for, NULL_PTR when it is given */
+	struct Kernel_Task *next;          /* Next task in priority order */
+}Kernel_TaskType;
+
+typedef struct
+{
+	volatile uint8 count;
+}Kernel_SemaphoreType;
+
+typedef struct
+{
+	uint8 *buffer;                     /* length * item_size bytes */
+	uint8 item_size;
+	uint8 length;
+	uint8 head;                        /* Index of the oldest item */
+	uint8 count;                       /* Number of items in the buffer */
+	Kernel_SemaphoreType items;        /* Counts the stored items */
+	Kernel_SemaphoreType spaces;       /* Counts the free slots */
+}Kernel_QueueType;
+
+/*******************************************************************************
+ *                              Functions Prototypes                           *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Create a task with the required priority on a statically allocated stack.
+ * The stack is filled with KERNEL_STACK_FILL_BYTE for the watermark.
+ * Returns FALSE if KERNEL_MAX_TASKS is reached or the stack is too small.
+ */
+boolean Kernel_createTask(Kernel_TaskType *task, void (*entry)(void), uint8 priority,
+		uint8 *stack, uint16 stack_size);
+
+/*
+ * Description :
+ * Hook the scheduler on the SysTime tick and switch to the highest priority task.
+ * SysTime_init must be called first and the kernel should be the last tick hook.
+ * This function never returns.
+ */
+void Kernel_start(void);
+
+/*
+ * Description :
+ * Set the function called repeatedly by the idle task when no other task is ready
+ * (e.g. Power_idle). It must not block on a kernel object.
+ */
+void Kernel_setIdleCallBack(void (*a_ptr)(void));
+
+/*
+ * Description :
+ * Block the calling task for the required number of ticks.
+ */
+void Kernel_delay(uint16 ticks);
+
+/*
+ * Description :
+ * Give the CPU to the highest priority ready task.
+ */
+void Kernel_yield(void);
+
+/*
+ * Description :
+ * Return the task running now.
+ */
+Kernel_TaskType *Kernel_getCurrentTask(void);
+
+/*
+ * Description :
+ * Return the number of stack bytes never used by the task (stack watermark).
+ */
+uint16 Kernel_getStackUnused(const Kernel_TaskType *task);
+
+/*
+ * Description :
+ * Return the idle task, for its stack watermark.
+ */
+const Kernel_TaskType *Kernel_getIdleTask(void);
+
+/*
+ * Description :
+ * Semaphores: init with a start count, take with a timeout in ticks, give from a task or an ISR.
+ * Kernel_semTake returns FALSE on timeout.
+ */
+void Kernel_semInit(Kernel_SemaphoreType *sem, uint8 count);
+boolean Kernel_semTake(Kernel_SemaphoreType *sem, uint16 timeout);
+void Kernel_semGive(Kernel_SemaphoreType *sem);
+void Kernel_semGiveFromISR(Kernel_SemaphoreType *sem);
+
+/*
+ * Description :
+ * Message queues of fixed size items copied in and out of the buffer.
+ * Send and receive return FALSE on timeout.
+ */
+void Kernel_queueInit(Kernel_QueueType *queue, uint8 *buffer, uint8 item_size, uint8 length);
+boolean Kernel_queueSend(Kernel_QueueType *queue, const void *item, uint16 timeout);
+boolean Kernel_queueReceive(Kernel_QueueType *queue, void *item, uint16 timeout);
+
+#endif /* KERNEL_H_ */
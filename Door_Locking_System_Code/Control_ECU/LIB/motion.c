@@ -0,0 +1,363 @@
+ /******************************************************************************
+ *
+ * Module: MOTION
+ *
+ * File Name: motion.c
+ *
+ * Description: Source file for the door motor motion profiles
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#include "motion.h"
+#include "systime.h"
+#include "registers.h" /* To use the SREG register */
+#include <avr/interrupt.h> /* For cli() */
+#include <avr/pgmspace.h> /* For the S-curve table */
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/* A ramp is a 16-bit phase from 0 to 0xFFFF, its 8 high bits index the shape */
+#define MOTION_PHASE_END               0xFFFFU
+
+/* The S-curve table has a point every 8 shape steps */
+#define MOTION_S_CURVE_SHIFT           3
+#define MOTION_S_CURVE_POINTS          ((256 >> MOTION_S_CURVE_SHIFT) + 1)
+
+#define MOTION_STALL_TICKS             SYSTIME_MS_TO_TICKS(MOTION_STALL_MS)
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static uint16 Motion_phaseStep(uint32 ticks);
+static uint8 Motion_rampDuty(uint16 phase, uint8 low_duty);
+static uint16 Motion_decelPhase(uint8 duty);
+static void Motion_startBrake(void);
+static boolean Motion_checkStall(void);
+static void Motion_output(Dc_Motor_State state, uint8 duty);
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+/* 255 * (3x^2 - 2x^3) for x = 0, 1/32 .. 1 */
+static const uint8 g_sCurve[MOTION_S_CURVE_POINTS] PROGMEM =
+{
+	0, 1, 3, 6, 11, 17, 24, 31, 40, 49, 59, 70, 81, 92, 104, 116, 128,
+	139, 151, 163, 174, 185, 196, 206, 215, 224, 231, 238, 244, 249, 252, 254, 255
+};
+
+static Motion_ConfigType g_config = { MOTION_TRAPEZOID, 100, 0, 0, 0, 0, 0, NULL_PTR };
+
+/* Move in progress, written with the interrupts disabled outside the tick */
+static volatile Motion_StateType g_state = MOTION_IDLE;
+static volatile uint8 g_duty = 0;
+static Dc_Motor_State g_direction = DC_MOTOR_STOP;
+static uint16 g_phase = 0;
+static uint16 g_accelStep = 0;
+static uint16 g_decelStep = 0;
+static uint32 g_countdown = 0;             /* Cruise or brake ticks left */
+static uint8 g_stallTicks = 0;             /* Ticks in a row over the stall threshold */
+static volatile boolean g_stalled = FALSE;
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Set the profile of the next moves (copied), the motor must be stopped.
+ * Motion_tick must be a SysTime tick hook.
+ */
+void Motion_init(const Motion_ConfigType *config)
+{
+	g_config = *config;
+	if(g_config.cruise_duty > 100)
+	{
+		g_config.cruise_duty = 100;
+	}
+	if(g_config.creep_duty > g_config.cruise_duty)
+	{
+		g_config.creep_duty = g_config.cruise_duty;
+	}
+	g_state = MOTION_IDLE;
+	g_duty = 0;
+}
+
+/*
+ * Description :
+ * Start a move of duration_ms in the required direction (DC_MOTOR_CW or DC_MOTOR_CCW),
+ * the deceleration ends at duration_ms and the brake or the creep follows. The ramps
+ * are shortened in proportion if they do not fit in the duration.
+ */
+void Motion_move(Dc_Motor_State direction, uint32 duration_ms)
+{
+	uint32 total_ticks = SYSTIME_MS_TO_TICKS(duration_ms);
+	uint32 accel_ticks = SYSTIME_MS_TO_TICKS(g_config.accel_ms);
+	uint32 decel_ticks = SYSTIME_MS_TO_TICKS(g_config.decel_ms);
+	uint8 sreg;
+
+	if((accel_ticks + decel_ticks) > total_ticks)
+	{
+		accel_ticks = (accel_ticks + decel_ticks == 0) ? 0 : (total_ticks * accel_ticks) / (accel_ticks + decel_ticks);
+		decel_ticks = total_ticks - accel_ticks;
+	}
+
+	/* The divisions are done here, the tick only adds */
+	sreg = SREG;
+	cli();
+	g_direction = direction;
+	g_accelStep = Motion_phaseStep(accel_ticks);
+	g_decelStep = Motion_phaseStep(decel_ticks);
+	g_countdown = total_ticks - accel_ticks - decel_ticks;
+	g_phase = 0;
+	g_stallTicks = 0;
+	g_stalled = FALSE;
+	g_state = MOTION_ACCEL;
+	Motion_output(direction, 0);
+	SREG = sreg;
+}
+
+/*
+ * Description :
+ * End the move early: decelerate from the current duty then creep or brake as at the end
+ * of a move, a duty under the creep duty goes to the creep at once. Brake at once when creeping.
+ */
+void Motion_stop(void)
+{
+	uint8 sreg = SREG;
+
+	cli();
+	if((g_state == MOTION_ACCEL) || (g_state == MOTION_CRUISE))
+	{
+		/* The deceleration ends at the creep duty, not at 0 as the acceleration starts */
+		g_phase = Motion_decelPhase(g_duty);
+		g_state = MOTION_DECEL;
+	}
+	else if(g_state == MOTION_CREEP)
+	{
+		Motion_startBrake();
+	}
+	SREG = sreg;
+}
+
+/*
+ * Description :
+ * Brake at once, e.g. at the end of travel, then release the motor.
+ * Can be called from an interrupt, a brake in progress goes on.
+ */
+void Motion_brake(void)
+{
+	uint8 sreg = SREG;
+
+	cli();
+	if((g_state != MOTION_IDLE) && (g_state != MOTION_BRAKE))
+	{
+		Motion_startBrake();
+	}
+	SREG = sreg;
+}
+
+/*
+ * Description :
+ * Update the duty of the move, called from the timer interrupt (SysTime tick hook).
+ */
+void Motion_tick(void)
+{
+	if((g_state == MOTION_CRUISE) || (g_state == MOTION_DECEL) || (g_state == MOTION_CREEP))
+	{
+		if(Motion_checkStall() == TRUE)
+		{
+			g_stalled = TRUE;
+			Motion_startBrake();
+			return;
+		}
+	}
+
+	switch(g_state)
+	{
+	case MOTION_ACCEL:
+		if(g_phase > (MOTION_PHASE_END - g_accelStep))
+		{
+			g_state = MOTION_CRUISE;
+			Motion_output(g_direction, g_config.cruise_duty);
+		}
+		else
+		{
+			g_phase += g_accelStep;
+			Motion_output(g_direction, Motion_rampDuty(g_phase, 0));
+		}
+		break;
+
+	case MOTION_CRUISE:
+		if(g_countdown != 0)
+		{
+			g_countdown--;
+		}
+		else
+		{
+			g_phase = 0;
+			g_state = MOTION_DECEL;
+		}
+		break;
+
+	case MOTION_DECEL:
+		if(g_phase <= (MOTION_PHASE_END - g_decelStep))
+		{
+			g_phase += g_decelStep;
+			Motion_output(g_direction, Motion_rampDuty(MOTION_PHASE_END - g_phase, g_config.creep_duty));
+		}
+		else if(g_config.creep_duty != 0)
+		{
+			g_state = MOTION_CREEP;
+			Motion_output(g_direction, g_config.creep_duty);
+		}
+		else
+		{
+			Motion_startBrake();
+		}
+		break;
+
+	case MOTION_BRAKE:
+		if(g_countdown != 0)
+		{
+			g_countdown--;
+		}
+		else
+		{
+			g_state = MOTION_IDLE;
+			Motion_output(DC_MOTOR_STOP, 0);
+		}
+		break;
+
+	default:
+		break;
+	}
+}
+
+/*
+ * Description :
+ * Return the phase of the move.
+ */
+Motion_StateType Motion_getState(void)
+{
+	return g_state;
+}
+
+/*
+ * Description :
+ * Return the commanded duty in percent.
+ */
+uint8 Motion_getDuty(void)
+{
+	return g_duty;
+}
+
+/*
+ * Description :
+ * Return TRUE if the motor stalled (and braked) since the move started.
+ */
+boolean Motion_isStalled(void)
+{
+	return g_stalled;
+}
+
+/*******************************************************************************
+ *                      Private Functions Definitions                          *
+ *******************************************************************************/
+
+/* Phase increment of a ramp lasting the required ticks, 0 ticks ends it on the first tick */
+static uint16 Motion_phaseStep(uint32 ticks)
+{
+	return (ticks <= 1) ? MOTION_PHASE_END : (uint16)(0x10000UL / ticks);
+}
+
+/* Duty at a phase of the ramp from low_duty to the cruise duty, an 8x8 multiply and the table interpolation */
+static uint8 Motion_rampDuty(uint16 phase, uint8 low_duty)
+{
+	uint8 position = (uint8)(phase >> 8);
+	uint8 index;
+	uint8 low;
+	uint8 high;
+	uint8 shape = position;
+
+	if(g_config.shape == MOTION_S_CURVE)
+	{
+		index = position >> MOTION_S_CURVE_SHIFT;
+		low = pgm_read_byte(&g_sCurve[index]);
+		high = pgm_read_byte(&g_sCurve[index + 1]);
+		shape = low + (uint8)(((uint16)(high - low) * (position & ((1 << MOTION_S_CURVE_SHIFT) - 1))) >> MOTION_S_CURVE_SHIFT);
+	}
+
+	return low_duty + (uint8)(((uint16)(g_config.cruise_duty - low_duty) * shape + 128) >> 8);
+}
+
+/*
+ * Phase of the deceleration whose duty is the highest one not over the required duty, found
+ * by a binary search of the ramp position (the duty never decreases with the position).
+ * Under the creep duty the deceleration is over at once.
+ */
+static uint16 Motion_decelPhase(uint8 duty)
+{
+	uint8 low = 0;
+	uint8 high = 0xFF;
+	uint8 middle;
+
+	if(Motion_rampDuty(0, g_config.creep_duty) > duty)
+	{
+		return MOTION_PHASE_END;
+	}
+
+	while(low < high)
+	{
+		middle = low + (uint8)((high - low + 1) >> 1);
+		if(Motion_rampDuty((uint16)middle << 8, g_config.creep_duty) <= duty)
+		{
+			low = middle;
+		}
+		else
+		{
+			high = middle - 1;
+		}
+	}
+
+	/* The deceleration runs the ramp backwards from position low */
+	return (uint16)(0xFF - low) << 8;
+}
+
+/* Active brake for the brake time, the interrupts are disabled */
+static void Motion_startBrake(void)
+{
+	g_countdown = SYSTIME_MS_TO_TICKS(g_config.brake_ms);
+	g_state = MOTION_BRAKE;
+	Motion_output(DC_MOTOR_BRAKE, 100);
+}
+
+/* TRUE after MOTION_STALL_TICKS over current * 100 >= stall_ma * duty, two multiplies and no division */
+static boolean Motion_checkStall(void)
+{
+	if((g_config.readCurrent == NULL_PTR) || (g_config.stall_ma == 0) || (g_duty < MOTION_STALL_MIN_DUTY) ||
+			(((uint32)g_config.readCurrent() * 100U) < ((uint32)g_config.stall_ma * g_duty)))
+	{
+		g_stallTicks = 0;
+		return FALSE;
+	}
+	return (++g_stallTicks >= MOTION_STALL_TICKS) ? TRUE : FALSE;
+}
+
+/* Drive the motor only when the command changes */
+static void Motion_output(Dc_Motor_State state, uint8 duty)
+{
+	static Dc_Motor_State last_state = DC_MOTOR_STOP;
+
+	if((state != last_state) || (duty != g_duty))
+	{
+		last_state = state;
+		g_duty = duty;
+		DC_Motor_Rotate(state, duty);
+	}
+}
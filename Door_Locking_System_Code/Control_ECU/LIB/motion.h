@@ -0,0 +1,120 @@
+ /******************************************************************************
+ *
+ * Module: MOTION
+ *
+ * File Name: motion.h
+ *
+ * Description: Header file for the door motor motion profiles.
+ *              A move ramps the PWM duty up (acceleration), holds it (cruise),
+ *              ramps it down (deceleration) then brakes the motor actively
+ *              (IN1 = IN2 = 1) before releasing it. With a creep duty the move
+ *              goes on slowly after the deceleration until Motion_brake, e.g.
+ *              from an end of travel switch. The duty is updated from the
+ *              SysTime tick, the ramps are linear (trapezoid profile) or follow
+ *              3x^2 - 2x^3 (S-curve profile, no step in the acceleration).
+ *
+ *              With a current source the tick also watches for a stall after the
+ *              acceleration (the start current of a motor is its stall current):
+ *              a motor turning slowly for its duty draws close to its stall
+ *              current, so the threshold follows the duty. A stall brakes at once.
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#ifndef MOTION_H_
+#define MOTION_H_
+
+#include "std_types.h"
+#include "DC_MOTOR.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * A stall is a current over the threshold for MOTION_STALL_MS. Below MOTION_STALL_MIN_DUTY
+ * the friction can hold a free motor, the current is not checked.
+ */
+#define MOTION_STALL_MS                40U
+#define MOTION_STALL_MIN_DUTY          20U
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+typedef enum
+{
+	MOTION_TRAPEZOID, MOTION_S_CURVE
+}Motion_ShapeType;
+
+typedef enum
+{
+	MOTION_IDLE, MOTION_ACCEL, MOTION_CRUISE, MOTION_DECEL, MOTION_CREEP, MOTION_BRAKE
+}Motion_StateType;
+
+typedef struct
+{
+	Motion_ShapeType shape;
+	uint8 cruise_duty;                 /* Duty of the cruise, percent */
+	uint8 creep_duty;                  /* Duty kept after the deceleration until Motion_brake, 0 brakes at once */
+	uint16 accel_ms;                   /* Ramp from 0 to the cruise duty */
+	uint16 decel_ms;                   /* Ramp from the cruise duty to 0 */
+	uint16 brake_ms;                   /* Active brake at the end of the move, 0 for none */
+	uint16 stall_ma;                   /* Stall threshold at 100% duty, scaled with the duty, 0 for none */
+	uint16 (*readCurrent)(void);       /* Motor current in mA, called from the tick, NULL_PTR for none */
+}Motion_ConfigType;
+
+/*******************************************************************************
+ *                              Functions Prototypes                           *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Set the profile of the next moves (copied), the motor must be stopped.
+ * Motion_tick must be a SysTime tick hook.
+ */
+void Motion_init(const Motion_ConfigType *config);
+
+/*
+ * Description :
+ * Start a move of duration_ms in the required direction (DC_MOTOR_CW or DC_MOTOR_CCW),
+ * the deceleration ends at duration_ms and the brake or the creep follows. The ramps
+ * are shortened in proportion if they do not fit in the duration.
+ */
+void Motion_move(Dc_Motor_State direction, uint32 duration_ms);
+
+/*
+ * Description :
+ * End the move early: decelerate from the current duty then creep or brake as at the end
+ * of a move, a duty under the creep duty goes to the creep at once. Brake at once when creeping.
+ */
+void Motion_stop(void);
+
+/*
+ * Description :
+ * Brake at once, e.g. at the end of travel, then release the motor.
+ * Can be called from an interrupt, a brake in progress goes on.
+ */
+void Motion_brake(void);
+
+/*
+ * Description :
+ * Update the duty of the move, called from the timer interrupt (SysTime tick hook).
+ */
+void Motion_tick(void);
+
+/*
+ * Description :
+ * Return the phase of the move and the commanded duty in percent.
+ */
+Motion_StateType Motion_getState(void);
+uint8 Motion_getDuty(void);
+
+/*
+ * Description :
+ * Return TRUE if the motor stalled (and braked) since the move started.
+ */
+boolean Motion_isStalled(void);
+
+#endif /* MOTION_H_ */
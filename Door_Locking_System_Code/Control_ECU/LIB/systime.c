@@ -0,0 +1,164 @@
+ /******************************************************************************
+ *
+ * Module: SYSTIME
+ *
+ * File Name: systime.c
+ *
+ * Description: Source file for the system time base built on Timer1
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#include "systime.h"
+#include "timer.h"
+#include "registers.h" /* To use the SREG and TIFR registers */
+#include <avr/interrupt.h> /* For cli() */
+#include <avr/cpufunc.h> /* For _NOP() */
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+/* Ticks counter incremented by the Timer1 compare match interrupt */
+static volatile uint32 g_ticks = 0;
+
+/* Functions called on every tick */
+static void (*volatile g_tickHooks[SYSTIME_MAX_TICK_HOOKS])(void);
+static volatile uint8 g_numOfTickHooks = 0;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static void SysTime_tickCallback(void);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Start Timer1 in compare mode with a SYSTIME_MS_PER_TICK period and attach the time keeping callback.
+ */
+void SysTime_init(void)
+{
+	/* CTC mode counts from 0 to the compare value, so the period is compare value + 1 */
+	Timer_ConfigType TIMER_configurations = { 0, (uint16)(SYSTIME_COUNTS_PER_TICK - 1), TIMER1, F_CPU_256, COMPARE };
+
+	g_ticks = 0;
+	Timer_setCallBack(&SysTime_tickCallback, TIMER1);
+	Timer_init(&TIMER_configurations);
+}
+
+/*
+ * Description :
+ * Register a function to be called from the Timer1 interrupt on every tick.
+ * Hooks are called in the registration order.
+ * Returns FALSE if all the SYSTIME_MAX_TICK_HOOKS slots are used.
+ */
+boolean SysTime_addTickHook(void (*a_ptr)(void))
+{
+	if(g_numOfTickHooks >= SYSTIME_MAX_TICK_HOOKS)
+	{
+		return FALSE;
+	}
+
+	/* Store the hook before publishing the new count to the interrupt */
+	g_tickHooks[g_numOfTickHooks] = a_ptr;
+	g_numOfTickHooks++;
+
+	return TRUE;
+}
+
+/*
+ * Description :
+ * Return the time since SysTime_init in timer counts (SYSTIME_US_PER_COUNT each).
+ */
+uint32 SysTime_now(void)
+{
+	uint8 sreg = SREG;
+	uint32 ticks;
+	uint16 count;
+
+	/*
+	 * Both read with the interrupts disabled, so it also works in an ISR or under cli(). A compare
+	 * match still pending with a small count is a tick the interrupt has not counted yet: the count
+	 * already wrapped. A count read before the match is still large when the flag is seen.
+	 */
+	cli();
+	ticks = g_ticks;
+	count = Timer_getCount(TIMER1);
+	if(REG_BIT_IS_SET(TIFR, OCF1A) && (count < (SYSTIME_COUNTS_PER_TICK / 2)))
+	{
+		ticks++;
+	}
+	SREG = sreg;
+
+	return (ticks * SYSTIME_COUNTS_PER_TICK) + count;
+}
+
+/*
+ * Description :
+ * Return the number of ticks since SysTime_init.
+ */
+uint32 SysTime_getTicks(void)
+{
+	uint32 ticks;
+
+	do
+	{
+		ticks = g_ticks;
+	} while(ticks != g_ticks);
+
+	return ticks;
+}
+
+/*
+ * Description :
+ * Return the number of whole seconds since SysTime_init.
+ */
+uint32 SysTime_getSeconds(void)
+{
+	return SysTime_getTicks() / SYSTIME_TICKS_PER_SECOND;
+}
+
+/*
+ * Description :
+ * Return TRUE once the required number of seconds passed since start_seconds.
+ */
+boolean SysTime_isElapsed(uint32 start_seconds, uint8 seconds)
+{
+	return ((SysTime_getSeconds() - start_seconds) >= seconds) ? TRUE : FALSE;
+}
+
+/*
+ * Description :
+ * Busy wait for the required number of seconds.
+ */
+void SysTime_delaySeconds(uint8 seconds)
+{
+	uint32 start_seconds = SysTime_getSeconds();
+
+	while(SysTime_isElapsed(start_seconds, seconds) == FALSE)
+	{
+		_NOP();
+	}
+}
+
+/*******************************************************************************
+ *                      Private Functions Definitions                          *
+ *******************************************************************************/
+
+/* Timer1 compare match callback, called once per tick */
+static void SysTime_tickCallback(void)
+{
+	uint8 i;
+
+	g_ticks++;
+
+	for(i = 0; i < g_numOfTickHooks; i++)
+	{
+		g_tickHooks[i]();
+	}
+}
@@ -0,0 +1,172 @@
+ /******************************************************************************
+ *
+ * Module: TRACE
+ *
+ * File Name: trace.c
+ *
+ * Description: Source file for the binary trace buffer.
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#include "trace.h"
+#include "systime.h"
+#include "uart.h"
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+typedef struct
+{
+	uint32 time;        /* SysTime_now() counts */
+	uint8 event;
+	uint16 arg;
+}Trace_RecordType;
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+static Trace_RecordType g_records[TRACE_BUFFER_SIZE];
+static volatile uint8 g_head = 0;      /* Next record to write */
+static volatile uint8 g_tail = 0;      /* Next record to drain */
+static volatile uint16 g_dropped = 0;
+static uint8 g_source = '?';
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static void Trace_sendLine(uint32 time, uint8 event, uint16 arg);
+static void Trace_sendHex(uint32 value, uint8 digits);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Clear the ring and set the source character written in the drained lines
+ * ('C' for the Control ECU, 'H' for the HMI ECU).
+ */
+void Trace_init(uint8 source)
+{
+	uint8 sreg = SREG;
+
+	cli();
+	g_head = 0;
+	g_tail = 0;
+	g_dropped = 0;
+	g_source = source;
+	SREG = sreg;
+}
+
+/*
+ * Description :
+ * Store a record with the current SysTime_now() timestamp, can be called from an ISR.
+ * The record is dropped (and counted) if the ring is full.
+ */
+void Trace_record(uint8 event, uint16 arg)
+{
+	uint8 sreg = SREG;
+	uint8 head;
+	Trace_RecordType *record;
+
+	cli();
+	head = g_head;
+	if((uint8)(head - g_tail) >= TRACE_BUFFER_SIZE)
+	{
+		g_dropped++;
+	}
+	else
+	{
+		record = &g_records[head & (TRACE_BUFFER_SIZE - 1)];
+		record->time = SysTime_now();
+		record->event = event;
+		record->arg = arg;
+		g_head = head + 1;
+	}
+	SREG = sreg;
+}
+
+/*
+ * Description :
+ * Send the oldest record over the UART.
+ * Returns FALSE if the ring is empty.
+ */
+boolean Trace_drainRecord(void)
+{
+	uint8 sreg;
+	uint16 dropped;
+	Trace_RecordType record;
+
+	sreg = SREG;
+	cli();
+	dropped = g_dropped;
+	g_dropped = 0;
+	SREG = sreg;
+
+	/* Report the lost records first so the decoder can mark the gap */
+	if(dropped != 0)
+	{
+		Trace_sendLine(SysTime_now(), TRACE_EVENT_DROPPED, dropped);
+		return TRUE;
+	}
+
+	if(g_tail == g_head)
+	{
+		return FALSE;
+	}
+
+	/* Copy the record out, the slot is released only after it is copied */
+	record = g_records[g_tail & (TRACE_BUFFER_SIZE - 1)];
+	g_tail++;
+
+	Trace_sendLine(record.time, record.event, record.arg);
+
+	return TRUE;
+}
+
+/*
+ * Description :
+ * Send a statistics line at once (Trace_ValueType kind), not through the ring.
+ */
+void Trace_sendValue(uint8 kind, uint16 id, uint32 value)
+{
+	UART_sendByte(TRACE_VALUE_LINE_START);
+	UART_sendByte(g_source);
+	Trace_sendHex(kind, 2);
+	Trace_sendHex(id, 4);
+	Trace_sendHex(value, 8);
+	UART_sendByte('\n');
+}
+
+/*******************************************************************************
+ *                      Private Functions Definitions                          *
+ *******************************************************************************/
+
+static void Trace_sendLine(uint32 time, uint8 event, uint16 arg)
+{
+	UART_sendByte(TRACE_LINE_START);
+	UART_sendByte(g_source);
+	Trace_sendHex(time, 8);
+	Trace_sendHex(event, 2);
+	Trace_sendHex(arg, 4);
+	UART_sendByte('\n');
+}
+
+static void Trace_sendHex(uint32 value, uint8 digits)
+{
+	uint8 nibble;
+
+	while(digits > 0)
+	{
+		digits--;
+		nibble = (uint8)(value >> (digits * 4)) & 0x0F;
+		UART_sendByte((nibble < 10) ? ('0' + nibble) : ('A' + nibble - 10));
+	}
+}
@@ -1,36 +1,151 @@
-/*
- * PWM.c
+ /******************************************************************************
  *
- *  Created on: Oct 4, 2024
- *      Author: Mohamed
- */
-
+ * Module: PWM
+ *
+ * File Name: PWM.c
+ *
+ * Description: Source file for the ATmega32 PWM driver
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
 
 #include "PWM.h"
 #include "gpio.h"
-#include <avr/io.h>
+#include "registers.h"
+#include <avr/pgmspace.h> /* For the percent table */
+#if (PWM_CHANNEL == PWM_TIMER1A) || (PWM_CHANNEL == PWM_TIMER1B)
+#include <avr/interrupt.h> /* For the 16-bit register writes */
+#endif
 
-void PWM_Timer0_init(void){
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
 
-    TCNT0 = 0; // Start Count From Zero
+/*
+ * Compare register and pin of the channel, and the phase correct PWM mode: the output is
+ * cleared on the compare match counting up and set on the match counting down.
+ */
+#if (PWM_CHANNEL == PWM_TIMER0)
+#define PWM_CONTROL_REG                TCCR0
+#define PWM_COUNTER_REG                TCNT0
+#define PWM_COMPARE_REG                OCR0
+#define PWM_PORT_ID                    PORTB_ID
+#define PWM_PIN_ID                     PIN3_ID
+#define PWM_CONTROL                    ((uint8)((1 << WGM00) | (1 << COM01) | PWM_CLOCK_SELECT))
+#elif (PWM_CHANNEL == PWM_TIMER2)
+#define PWM_CONTROL_REG                TCCR2
+#define PWM_COUNTER_REG                TCNT2
+#define PWM_COMPARE_REG                OCR2
+#define PWM_PORT_ID                    PORTD_ID
+#define PWM_PIN_ID                     PIN7_ID
+#define PWM_CONTROL                    ((uint8)((1 << WGM20) | (1 << COM21) | PWM_CLOCK_SELECT))
+#else
+#if (PWM_CHANNEL == PWM_TIMER1A)
+#define PWM_COMPARE_REG                OCR1A
+#define PWM_PIN_ID                     PIN5_ID
+#define PWM_CONTROL_A                  ((uint8)((1 << COM1A1) | (1 << WGM11)))
+#else
+#define PWM_COMPARE_REG                OCR1B
+#define PWM_PIN_ID                     PIN4_ID
+#define PWM_CONTROL_A                  ((uint8)((1 << COM1B1) | (1 << WGM11)))
+#endif
+#define PWM_PORT_ID                    PORTD_ID
+/* Mode 10, phase correct with TOP in ICR1 */
+#define PWM_CONTROL_B                  ((uint8)((1 << WGM13) | PWM_CLOCK_SELECT))
+#endif
 
-    // Make the OC0 as Output PIN -> pin which generates the PWM signal
-    GPIO_setupPinDirection(PORTB_ID , PWM_OUTPUT_PIN , PIN_OUTPUT);
+/* Native duties of 0 to 100 percent, ten at a time */
+#define PWM_PERCENTS_OF_TEN(tens) \
+	PWM_PERCENT_TO_DUTY((tens) + 0), PWM_PERCENT_TO_DUTY((tens) + 1), PWM_PERCENT_TO_DUTY((tens) + 2), \
+	PWM_PERCENT_TO_DUTY((tens) + 3), PWM_PERCENT_TO_DUTY((tens) + 4), PWM_PERCENT_TO_DUTY((tens) + 5), \
+	PWM_PERCENT_TO_DUTY((tens) + 6), PWM_PERCENT_TO_DUTY((tens) + 7), PWM_PERCENT_TO_DUTY((tens) + 8), \
+	PWM_PERCENT_TO_DUTY((tens) + 9)
 
-    /*
-        1. Set Fast PWM Mode: WGM01 = 1 & WGM00
-        2. Set non-inverting Mode (Clear OC0 pin on compare match) COM01 = 1
-        3. Set prescaler 64: CS00 = 1 & CS01 = 1
-    */
-    TCCR0 = (1 << WGM01) | (1 << WGM00) | (1 << COM01) | (1 << CS01) | (1 << CS00);
-}
+#if (PWM_RESOLUTION_BITS > 8)
+#define PWM_READ_DUTY(address)         pgm_read_word(address)
+#else
+#define PWM_READ_DUTY(address)         pgm_read_byte(address)
+#endif
 
-void PWM_Set_Duty_Cycle(uint8 duty_cycle){
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
 
-	/* Set Duty Cycle */
+static const PWM_DutyType g_percentDuties[101] PROGMEM =
+{
+	PWM_PERCENTS_OF_TEN(0), PWM_PERCENTS_OF_TEN(10), PWM_PERCENTS_OF_TEN(20), PWM_PERCENTS_OF_TEN(30),
+	PWM_PERCENTS_OF_TEN(40), PWM_PERCENTS_OF_TEN(50), PWM_PERCENTS_OF_TEN(60), PWM_PERCENTS_OF_TEN(70),
+	PWM_PERCENTS_OF_TEN(80), PWM_PERCENTS_OF_TEN(90), PWM_PERCENT_TO_DUTY(100)
+};
 
-	if(duty_cycle > 100)
-		duty_cycle = 100;
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
 
-	OCR0 = (uint8)(((uint16)255 * duty_cycle) / 100);
+/*
+ * Description :
+ * Start the timer of the channel at duty 0, then drive the output pin. Called once, the
+ * timer runs on between the moves.
+ */
+void PWM_init(void)
+{
+#if (PWM_CHANNEL == PWM_TIMER0) || (PWM_CHANNEL == PWM_TIMER2)
+	REG_WRITE(PWM_COMPARE_REG, 0);
+	REG_WRITE(PWM_COUNTER_REG, 0);
+	REG_WRITE(PWM_CONTROL_REG, PWM_CONTROL);
+#else
+	uint8 sreg = SREG;
+
+	cli();
+	REG_WRITE16(PWM_COMPARE_REG, 0);
+	REG_WRITE16(ICR1, (uint16)PWM_TOP);
+	REG_WRITE16(TCNT1, 0);
+	REG_WRITE(TCCR1A, PWM_CONTROL_A);
+	REG_WRITE(TCCR1B, PWM_CONTROL_B);
+	SREG = sreg;
+#endif
+
+	/* Low until the timer drives it */
+	GPIO_CLEAR_PIN(PWM_PORT_ID, PWM_PIN_ID);
+	GPIO_PIN_OUTPUT(PWM_PORT_ID, PWM_PIN_ID);
+}
+
+/*
+ * Description :
+ * Set the native duty, 0 to PWM_TOP (clamped). The compare register is buffered and the
+ * new duty starts with the next period.
+ */
+void PWM_setDuty(PWM_DutyType duty)
+{
+#if (PWM_CHANNEL == PWM_TIMER0) || (PWM_CHANNEL == PWM_TIMER2)
+	REG_WRITE(PWM_COMPARE_REG, duty); /* 8 bits, PWM_TOP is the largest value */
+#else
+	uint8 sreg = SREG;
+
+#if (PWM_RESOLUTION_BITS < 16)
+	if(duty > PWM_TOP)
+	{
+		duty = (PWM_DutyType)PWM_TOP;
+	}
+#endif
+	/* The TEMP register of the 16-bit write is shared with the interrupts */
+	cli();
+	REG_WRITE16(PWM_COMPARE_REG, duty);
+	SREG = sreg;
+#endif
+}
+
+/*
+ * Description :
+ * Set the duty in percent (clamped to 100) from a table of the native duties in flash,
+ * no multiply or division.
+ */
+void PWM_setDutyPercent(uint8 percent)
+{
+	if(percent > 100)
+	{
+		percent = 100;
+	}
+	PWM_setDuty(PWM_READ_DUTY(&g_percentDuties[percent]));
 }
@@ -1,17 +1,158 @@
-/*
- * PWM.h
+ /******************************************************************************
  *
- *  Created on: Oct 4, 2024
- *      Author: Mohamed
- */
+ * Module: PWM
+ *
+ * File Name: PWM.h
+ *
+ * Description: Header file for the ATmega32 PWM driver.
+ *              One output compare channel of Timer0, Timer1 or Timer2 runs in
+ *              phase correct PWM, chosen at build time with its resolution and
+ *              lowest frequency: the prescaler and TOP are computed here by the
+ *              preprocessor. The duty is the native compare value (0 to PWM_TOP),
+ *              written once per update and taken by the timer at TOP, so a period
+ *              is never cut short. 0 and PWM_TOP give a steady low and high output
+ *              without the one clock spike of the fast PWM mode.
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
 
 #ifndef PWM_H_
 #define PWM_H_
 
 #include "std_types.h"
 
-#define PWM_OUTPUT_PIN PIN3_ID
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/* Output compare channels */
+#define PWM_TIMER0                     0      /* OC0 (PB3), 8-bit */
+#define PWM_TIMER1A                    1      /* OC1A (PD5), 2 to 16 bits, TOP in ICR1 */
+#define PWM_TIMER1B                    2      /* OC1B (PD4), same */
+#define PWM_TIMER2                     3      /* OC2 (PD7), 8-bit */
+
+/*
+ * Channel of the motor enable. Timer1 is the SysTime time base and OC2 is the IN2 pin of
+ * the motor on this board, the other channels are for other boards.
+ */
+#define PWM_CHANNEL                    PWM_TIMER0
+
+/* Duty steps are 2^bits - 1, the 8-bit timers have 8 bits only */
+#define PWM_RESOLUTION_BITS            8
+
+/* The largest prescaler keeping the PWM frequency at or above this one is used */
+#define PWM_MIN_FREQUENCY_HZ           15000UL
+
+#ifndef F_CPU
+#error "F_CPU must be defined for the PWM frequency"
+#endif
+
+#if (PWM_CHANNEL == PWM_TIMER0) || (PWM_CHANNEL == PWM_TIMER2)
+#if (PWM_RESOLUTION_BITS != 8)
+#error "PWM_RESOLUTION_BITS must be 8 on Timer0 and Timer2"
+#endif
+#elif (PWM_CHANNEL == PWM_TIMER1A) || (PWM_CHANNEL == PWM_TIMER1B)
+#if (PWM_RESOLUTION_BITS < 2) || (PWM_RESOLUTION_BITS > 16)
+#error "PWM_RESOLUTION_BITS must be 2 to 16 on Timer1"
+#endif
+#else
+#error "PWM_CHANNEL must be one of the PWM_TIMERx channels"
+#endif
+
+#define PWM_TOP                        ((1UL << PWM_RESOLUTION_BITS) - 1)
+
+/* Phase correct PWM frequency at a prescaler: the counter goes up to TOP and back down */
+#define PWM_FREQUENCY_AT(prescaler)    (F_CPU / (2UL * (prescaler) * PWM_TOP))
+
+/* Prescaler and its CSn2:0 value, Timer2 has two more prescalers than Timer0 and Timer1 */
+#if (PWM_CHANNEL == PWM_TIMER2)
+#if (PWM_FREQUENCY_AT(1024) >= PWM_MIN_FREQUENCY_HZ)
+#define PWM_PRESCALER                  1024
+#define PWM_CLOCK_SELECT               7
+#elif (PWM_FREQUENCY_AT(256) >= PWM_MIN_FREQUENCY_HZ)
+#define PWM_PRESCALER                  256
+#define PWM_CLOCK_SELECT               6
+#elif (PWM_FREQUENCY_AT(128) >= PWM_MIN_FREQUENCY_HZ)
+#define PWM_PRESCALER                  128
+#define PWM_CLOCK_SELECT               5
+#elif (PWM_FREQUENCY_AT(64) >= PWM_MIN_FREQUENCY_HZ)
+#define PWM_PRESCALER                  64
+#define PWM_CLOCK_SELECT               4
+#elif (PWM_FREQUENCY_AT(32) >= PWM_MIN_FREQUENCY_HZ)
+#define PWM_PRESCALER                  32
+#define PWM_CLOCK_SELECT               3
+#elif (PWM_FREQUENCY_AT(8) >= PWM_MIN_FREQUENCY_HZ)
+#define PWM_PRESCALER                  8
+#define PWM_CLOCK_SELECT               2
+#elif (PWM_FREQUENCY_AT(1) >= PWM_MIN_FREQUENCY_HZ)
+#define PWM_PRESCALER                  1
+#define PWM_CLOCK_SELECT               1
+#endif
+#else
+#if (PWM_FREQUENCY_AT(1024) >= PWM_MIN_FREQUENCY_HZ)
+#define PWM_PRESCALER                  1024
+#define PWM_CLOCK_SELECT               5
+#elif (PWM_FREQUENCY_AT(256) >= PWM_MIN_FREQUENCY_HZ)
+#define PWM_PRESCALER                  256
+#define PWM_CLOCK_SELECT               4
+#elif (PWM_FREQUENCY_AT(64) >= PWM_MIN_FREQUENCY_HZ)
+#define PWM_PRESCALER                  64
+#define PWM_CLOCK_SELECT               3
+#elif (PWM_FREQUENCY_AT(8) >= PWM_MIN_FREQUENCY_HZ)
+#define PWM_PRESCALER                  8
+#define PWM_CLOCK_SELECT               2
+#elif (PWM_FREQUENCY_AT(1) >= PWM_MIN_FREQUENCY_HZ)
+#define PWM_PRESCALER                  1
+#define PWM_CLOCK_SELECT               1
+#endif
+#endif
+
+#ifndef PWM_PRESCALER
+#error "PWM_MIN_FREQUENCY_HZ can not be reached, lower PWM_RESOLUTION_BITS"
+#endif
+
+/* Frequency of the output: 15.686 kHz for 8 bits at 8 MHz */
+#define PWM_FREQUENCY_HZ               PWM_FREQUENCY_AT(PWM_PRESCALER)
+
+/* Native duty of a constant in percent or permille, rounded, computed by the compiler */
+#define PWM_PERCENT_TO_DUTY(percent)   ((PWM_DutyType)(((uint32)(percent) * PWM_TOP + 50) / 100))
+#define PWM_PERMILLE_TO_DUTY(permille) ((PWM_DutyType)(((uint32)(permille) * PWM_TOP + 500) / 1000))
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+/* Compare value, 0 to PWM_TOP */
+#if (PWM_RESOLUTION_BITS > 8)
+typedef uint16 PWM_DutyType;
+#else
+typedef uint8 PWM_DutyType;
+#endif
+
+/*******************************************************************************
+ *                              Functions Prototypes                           *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Start the timer of the channel at duty 0, then drive the output pin. Called once, the
+ * timer runs on between the moves.
+ */
+void PWM_init(void);
+
+/*
+ * Description :
+ * Set the native duty, 0 to PWM_TOP (clamped). The compare register is buffered and the
+ * new duty starts with the next period.
+ */
+void PWM_setDuty(PWM_DutyType duty);
+
+/*
+ * Description :
+ * Set the duty in percent (clamped to 100) from a table of the native duties in flash,
+ * no multiply or division.
+ */
+void PWM_setDutyPercent(uint8 percent);
 
-void PWM_Timer0_init(void);
-void PWM_Set_Duty_Cycle(uint8 duty_cycle);
 #endif /* PWM_H_ */
@@ -0,0 +1,160 @@
+ /******************************************************************************
+ *
+ * Module: ADC
+ *
+ * File Name: adc.c
+ *
+ * Description: Source file for the ATmega32 ADC driver
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#include "adc.h"
+#include "gpio.h"
+#include "registers.h" /* To use the ADC registers */
+#include <avr/interrupt.h> /* For the conversion complete ISR */
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define ADC_PORT_ID                    PORTA_ID
+#define ADC_CHANNEL_MASK               0x07
+#define ADC_TRIGGER_MASK               ((uint8)((1 << ADTS2) | (1 << ADTS1) | (1 << ADTS0)))
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+/* ADMUX value of each channel of the sequence: reference and channel */
+static uint8 g_admux[ADC_MAX_CHANNELS];
+static uint8 g_numOfChannels = 1;
+
+/*
+ * Sequence index of the running conversion and of the next one. In free running mode
+ * the next conversion starts with the ADMUX value of the end of the running one, so
+ * an ADMUX write in the ISR selects the channel of the conversion after the next.
+ */
+static uint8 g_convIndex = 0;
+static uint8 g_nextIndex = 0;
+
+/* Sums of the conversions of each channel until ADC_SAMPLES_PER_RESULT of them */
+static uint16 g_sums[ADC_MAX_CHANNELS];
+static uint8 g_counts[ADC_MAX_CHANNELS];
+static volatile uint16 g_results[ADC_MAX_CHANNELS];
+
+static void (*volatile g_callBackPtr)(uint8 index, uint16 value) = NULL_PTR;
+
+/*******************************************************************************
+ *                       Interrupt Service Routines                            *
+ *******************************************************************************/
+
+/*
+ * Conversion complete: sum it to its channel, then select the channel of the conversion
+ * after the next. The decimation is a shift, there is no division in the interrupt.
+ */
+ISR(ADC_vect)
+{
+	uint8 index = g_convIndex;
+	uint16 value;
+
+	g_sums[index] += REG_READ16(ADC);
+
+	g_convIndex = g_nextIndex;
+	g_nextIndex = (g_nextIndex + 1 < g_numOfChannels) ? (g_nextIndex + 1) : 0;
+	REG_WRITE(ADMUX, g_admux[g_nextIndex]);
+
+	if(++g_counts[index] == ADC_SAMPLES_PER_RESULT)
+	{
+		value = g_sums[index] >> ADC_OVERSAMPLING_BITS;
+		g_sums[index] = 0;
+		g_counts[index] = 0;
+		g_results[index] = value;
+		if(g_callBackPtr != NULL_PTR)
+		{
+			g_callBackPtr(index, value);
+		}
+	}
+}
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Make the channels inputs without pull-up and start the conversions of the sequence.
+ * Each channel gets a result every num_of_channels * ADC_SAMPLES_PER_RESULT conversions.
+ */
+void ADC_init(const ADC_ConfigType *config)
+{
+	uint8 pins = 0;
+	uint8 index;
+
+	ADC_deInit();
+
+	g_numOfChannels = config->num_of_channels;
+	if((g_numOfChannels == 0) || (g_numOfChannels > ADC_MAX_CHANNELS))
+	{
+		g_numOfChannels = 1;
+	}
+	for(index = 0; index < g_numOfChannels; index++)
+	{
+		g_admux[index] = (uint8)((config->reference << REFS0) | (config->channels[index] & ADC_CHANNEL_MASK));
+		pins |= (1 << (config->channels[index] & ADC_CHANNEL_MASK));
+		g_sums[index] = 0;
+		g_counts[index] = 0;
+		g_results[index] = 0;
+	}
+	GPIO_setupPortDirectionMasked(ADC_PORT_ID, pins, PORT_INPUT);
+	GPIO_writePortMasked(ADC_PORT_ID, pins, 0); /* No pull-up on an analog input */
+
+	/* The first two conversions are of the first channel, see g_nextIndex */
+	g_convIndex = 0;
+	g_nextIndex = 0;
+	REG_WRITE(ADMUX, g_admux[0]);
+
+	/* Free running trigger, then enable, start and auto trigger with the interrupt */
+	REG_CLEAR_BITS(SFIOR, ADC_TRIGGER_MASK);
+	REG_WRITE(ADCSRA, (1 << ADEN) | (1 << ADSC) | (1 << ADATE) | (1 << ADIF) | (1 << ADIE) | config->prescaler);
+}
+
+/*
+ * Description :
+ * Stop the conversions and switch the ADC off.
+ */
+void ADC_deInit(void)
+{
+	REG_WRITE(ADCSRA, (1 << ADIF)); /* A pending flag is cleared by writing it to one */
+}
+
+/*
+ * Description :
+ * Set the function called from the ADC interrupt with each result: the index of its
+ * channel in the sequence and the value, 0 to ADC_RESULT_MAX.
+ */
+void ADC_setCallBack(void (*a_ptr)(uint8 index, uint16 value))
+{
+	g_callBackPtr = a_ptr;
+}
+
+/*
+ * Description :
+ * Return the last result of the channel at index in the sequence, 0 before the first one.
+ */
+uint16 ADC_getResult(uint8 index)
+{
+	uint8 sreg;
+	uint16 value;
+
+	if(index >= ADC_MAX_CHANNELS)
+	{
+		return 0;
+	}
+	sreg = SREG;
+	cli();
+	value = g_results[index];
+	SREG = sreg;
+	return value;
+}
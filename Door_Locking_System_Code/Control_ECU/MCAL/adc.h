@@ -0,0 +1,99 @@
+ /******************************************************************************
+ *
+ * Module: ADC
+ *
+ * File Name: adc.h
+ *
+ * Description: Header file for the ATmega32 ADC driver.
+ *              The ADC runs free (auto trigger, free running mode) and its
+ *              interrupt converts the channels of a sequence in turn, the
+ *              multiplexer of the next conversion is set while the current one
+ *              runs. ADC_SAMPLES_PER_RESULT conversions of a channel are summed
+ *              and decimated to one result with ADC_OVERSAMPLING_BITS more bits,
+ *              the input noise must be about 1 LSB for the extra bits to be real.
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#ifndef ADC_H_
+#define ADC_H_
+
+#include "std_types.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/* Maximum number of channels in the sequence */
+#define ADC_MAX_CHANNELS               4
+
+/* Extra result bits, 4^n conversions per result: 2 gives 12-bit results from 16 conversions */
+#define ADC_OVERSAMPLING_BITS          2
+#define ADC_SAMPLES_PER_RESULT         (1U << (2 * ADC_OVERSAMPLING_BITS))
+#define ADC_RESULT_BITS                (10 + ADC_OVERSAMPLING_BITS)
+#define ADC_RESULT_MAX                 ((1U << ADC_RESULT_BITS) - 1)
+
+/* The sums of the conversions are 16-bit */
+#if (ADC_OVERSAMPLING_BITS > 3)
+#error "ADC_OVERSAMPLING_BITS must be 3 or less"
+#endif
+
+/* A conversion takes 13 ADC clocks in free running mode */
+#define ADC_CLOCKS_PER_CONVERSION      13U
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+/* REFS1:0 values */
+typedef enum
+{
+	ADC_AREF, ADC_AVCC, ADC_INTERNAL_2_56V = 3
+}ADC_ReferenceType;
+
+/* ADPS2:0 values, the ADC clock must be 50 to 200 kHz for the full resolution */
+typedef enum
+{
+	ADC_F_CPU_2 = 1, ADC_F_CPU_4, ADC_F_CPU_8, ADC_F_CPU_16, ADC_F_CPU_32, ADC_F_CPU_64, ADC_F_CPU_128
+}ADC_PrescalerType;
+
+typedef struct
+{
+	ADC_ReferenceType reference;
+	ADC_PrescalerType prescaler;
+	uint8 num_of_channels;                 /* 1 to ADC_MAX_CHANNELS */
+	uint8 channels[ADC_MAX_CHANNELS];      /* Single ended inputs (PA0..PA7) in the conversion order */
+}ADC_ConfigType;
+
+/*******************************************************************************
+ *                              Functions Prototypes                           *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Make the channels inputs without pull-up and start the conversions of the sequence.
+ * Each channel gets a result every num_of_channels * ADC_SAMPLES_PER_RESULT conversions.
+ */
+void ADC_init(const ADC_ConfigType *config);
+
+/*
+ * Description :
+ * Stop the conversions and switch the ADC off.
+ */
+void ADC_deInit(void);
+
+/*
+ * Description :
+ * Set the function called from the ADC interrupt with each result: the index of its
+ * channel in the sequence and the value, 0 to ADC_RESULT_MAX.
+ */
+void ADC_setCallBack(void (*a_ptr)(uint8 index, uint16 value));
+
+/*
+ * Description :
+ * Return the last result of the channel at index in the sequence, 0 before the first one.
+ */
+uint16 ADC_getResult(uint8 index);
+
+#endif /* ADC_H_ */
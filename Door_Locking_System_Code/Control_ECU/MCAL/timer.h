@@ -72,4 +72,11 @@ void Timer_deInit(Timer_ID_Type timer_type);
  */
 void Timer_setCallBack(void(*a_ptr)(void), Timer_ID_Type a_timer_ID);
 
+/*
+ * Function to read the current counter value of a timer
+ * Parameters:
+ * - timer_type: The timer to read (TIMER0, TIMER1, TIMER2)
+ */
+uint16 Timer_getCount(Timer_ID_Type timer_type);
+
 #endif /* TIMER_H_ */
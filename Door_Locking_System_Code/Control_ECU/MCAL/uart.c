@@ -11,8 +11,31 @@
  *******************************************************************************/
 
 #include "uart.h"
-#include "avr/io.h" /* To use the UART Registers */
-#include "common_macros.h" /* To use the macros like SET_BIT */
+#include "registers.h" /* To use the UART Registers */
+#include <avr/interrupt.h> /* For the RX complete ISR */
+#include "trace.h"
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+/* Called while waiting for a received byte, NULL_PTR to busy wait */
+static void (*volatile g_idleCallBackPtr)(void) = NULL_PTR;
+
+/*******************************************************************************
+ *                       Interrupt Service Routines                            *
+ *******************************************************************************/
+
+/*
+ * The RX complete interrupt is only used to wake the MCU from sleep, it disables
+ * itself and leaves the byte in UDR so UART_recieveByte reads it as usual.
+ */
+ISR(USART_RXC_vect)
+{
+	TRACE_ISR(TRACE_EVENT_ISR_ENTER, TRACE_ISR_UART_RX);
+	REG_CLEAR_BIT(UCSRB,RXCIE);
+	TRACE_ISR(TRACE_EVENT_ISR_EXIT, TRACE_ISR_UART_RX);
+}
 
 /*******************************************************************************
  *                      Functions Definitions                                  *
@@ -30,42 +53,38 @@ void UART_init(UART_ConfigType * Config_Ptr)
     uint16 ubrr_value = 0;
 
     /* U2X = 1 for double transmission speed */
-    UCSRA = (1 << U2X);
+    REG_WRITE(UCSRA,(1 << U2X));
 
     /* Enable the Sending and Receiving enable*/
-    UCSRB = (1 << RXEN) | (1 << TXEN);
+    REG_WRITE(UCSRB,(1 << RXEN) | (1 << TXEN));
 
     /* If 9-bit data size, enable UCSZ2 in UCSRB */
     if (Config_Ptr->bit_data == Character_SIZE_9)
     {
-        UCSRB |= (1 << UCSZ2); /* Set UCSZ2 for 9-bit data size */
+        REG_SET_BIT(UCSRB,UCSZ2); /* Set UCSZ2 for 9-bit data size */
     }
     else
     {
-        UCSRB &= ~(1 << UCSZ2); /* Clear UCSZ2 for other data sizes */
+        REG_CLEAR_BIT(UCSRB,UCSZ2); /* Clear UCSZ2 for other data sizes */
     }
 
     /************************** UCSRC Description **************************
      * URSEL  = 1  to select the UCSRC register
      * Set UCSZ1 and UCSZ0 for character size based on Config_Ptr->bit_data
+     * UCSRC shares its address with UBRRH and reads as UBRRH unless read twice
+     * in a row, so the frame format is built first and written once.
      ***********************************************************************/
-    UCSRC = (1 << URSEL);  /* To select UCSRC register */
-
-    /* Write the Parity bit (Config_Ptr->parity) */
-    UCSRC |= (Config_Ptr->parity);
-
-    /* Write the Stop bit (Config_Ptr->stop_bit) */
-    UCSRC |= (Config_Ptr->stop_bit);
-
-    /* Write the character size (UCSZ1, UCSZ0 in UCSRC) */
-    UCSRC |= ((Config_Ptr->bit_data & 0x03) << 1); /* Shift left to align UCSZ0 and UCSZ1 */
+    REG_WRITE(UCSRC,(1 << URSEL)  /* To select UCSRC register */
+            | (Config_Ptr->parity) /* Write the Parity bit (Config_Ptr->parity) */
+            | (Config_Ptr->stop_bit) /* Write the Stop bit (Config_Ptr->stop_bit) */
+            | ((Config_Ptr->bit_data & 0x03) << 1)); /* Character size, shift left to align UCSZ0 and UCSZ1 */
 
     /* Calculate the UBRR value for the baud rate */
     ubrr_value = (uint16)(((F_CPU / (Config_Ptr->baud_rate * 8UL))) - 1);
 
     /* Set the UBRR value: First 8 bits in UBRRL and the higher 4 bits in UBRRH */
-    UBRRH = (ubrr_value >> 8);
-    UBRRL = ubrr_value;
+    REG_WRITE(UBRRH,(ubrr_value >> 8));
+    REG_WRITE(UBRRL,ubrr_value);
 }
 
 /*
@@ -78,13 +97,13 @@ void UART_sendByte(const uint8 data)
 	 * UDRE flag is set when the Tx buffer (UDR) is empty and ready for
 	 * transmitting a new byte so wait until this flag is set to one
 	 */
-	while(BIT_IS_CLEAR(UCSRA,UDRE)){}
+	while(REG_BIT_IS_CLEAR(UCSRA,UDRE)){}
 
 	/*
 	 * Put the required data in the UDR register and it also clear the UDRE flag as
 	 * the UDR register is not empty now
 	 */
-	UDR = data;
+	REG_WRITE(UDR,data);
 
 	/************************* Another Method *************************
 	UDR = data;
@@ -99,14 +118,47 @@ void UART_sendByte(const uint8 data)
  */
 uint8 UART_recieveByte(void)
 {
+	void (*idle_callback)(void);
+
 	/* RXC flag is set when the UART receive data so wait until this flag is set to one */
-	while(BIT_IS_CLEAR(UCSRA,RXC)){}
+	while(REG_BIT_IS_CLEAR(UCSRA,RXC))
+	{
+		idle_callback = g_idleCallBackPtr;
+		if(idle_callback != NULL_PTR)
+		{
+			/*
+			 * Arm the RX complete interrupt to wake up from the idle sleep. A byte received
+			 * just before the sleep is caught by the next timer tick at worst.
+			 */
+			REG_SET_BIT(UCSRB,RXCIE);
+			idle_callback();
+		}
+	}
 
 	/*
 	 * Read the received data from the Rx buffer (UDR)
 	 * The RXC flag will be cleared after read the data
 	 */
-    return UDR;		
+    return REG_READ(UDR);		
+}
+
+/*
+ * Description :
+ * Check if a received byte is waiting in UDR, without reading it.
+ */
+boolean UART_isByteReceived(void)
+{
+	return REG_BIT_IS_SET(UCSRA,RXC) ? TRUE : FALSE;
+}
+
+/*
+ * Description :
+ * Set the function called while UART_recieveByte waits for data (e.g. Power_idle).
+ * The RX complete interrupt is used to wake up, so global interrupts must be enabled.
+ */
+void UART_setIdleCallBack(void (*a_ptr)(void))
+{
+	g_idleCallBackPtr = a_ptr;
 }
 
 /*
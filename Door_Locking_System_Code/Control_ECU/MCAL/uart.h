@@ -74,6 +74,19 @@ void UART_sendByte(const uint8 data);
  */
 uint8 UART_recieveByte(void);
 
+/*
+ * Description :
+ * Check if a received byte is waiting in UDR, without reading it.
+ */
+boolean UART_isByteReceived(void);
+
+/*
+ * Description :
+ * Set the function called while UART_recieveByte waits for data (e.g. Power_idle).
+ * The RX complete interrupt is used to wake up, so global interrupts must be enabled.
+ */
+void UART_setIdleCallBack(void (*a_ptr)(void));
+
 /*
  * Description :
  * Send the required string through UART to the other UART device.
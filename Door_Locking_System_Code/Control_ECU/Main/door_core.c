@@ -0,0 +1,516 @@
+ /******************************************************************************
+ *
+ * Module: Door Core
+ *
+ * File Name: door_core.c
+ *
+ * Description: Source file for the access control policy of the Control ECU,
+ *              a state machine on the FSM engine driven by the board operations.
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#include "door_core.h"
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static uint32 DoorCore_now(void);
+static void DoorCore_dispatch(FSM_EventType event);
+static void DoorCore_enterState(FSM_StateType previous);
+static boolean DoorCore_isEqual(const uint8 *passward1, const uint8 *passward2);
+static uint16 DoorCore_checkTravel(uint16 travel_ms);
+static void DoorCore_startMove(DoorCore_MotorType motion);
+static void DoorCore_learnTravel(uint32 travel_ms);
+static void DoorCore_forgetTravel(void);
+
+/* States activities, run by DoorCore_update */
+static FSM_EventType DoorCore_waitTravel(void);
+static FSM_EventType DoorCore_waitHold(void);
+static FSM_EventType DoorCore_waitNoMotion(void);
+static FSM_EventType DoorCore_waitLockout(void);
+
+/* Transitions actions */
+static void DoorCore_savePassward(void);
+static void DoorCore_acceptPassward(void);
+static void DoorCore_rejectPassward(void);
+static void DoorCore_startRetries(void);
+static void DoorCore_startLockout(void);
+static void DoorCore_endLockout(void);
+static void DoorCore_openDoor(void);
+static void DoorCore_endTravel(void);
+static void DoorCore_failTravel(void);
+static void DoorCore_timeoutTravel(void);
+static void DoorCore_reverseTravel(void);
+static void DoorCore_closeDoor(void);
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+/* Activity of each state, the states waiting for the link have none */
+static const FSM_HandlerType g_handlers[DOOR_CORE_NUM_OF_STATES] FSM_FLASH =
+{
+	[DOOR_CORE_OPENING_STATE]  = DoorCore_waitTravel,
+	[DOOR_CORE_HOLDING_STATE]  = DoorCore_waitHold,
+	[DOOR_CORE_CLEARING_STATE] = DoorCore_waitNoMotion,
+	[DOOR_CORE_CLOSING_STATE]  = DoorCore_waitTravel,
+	[DOOR_CORE_LOCKOUT_STATE]  = DoorCore_waitLockout,
+};
+
+/* Transition table [state][event] = { guard, action, next state } */
+static const FSM_TransitionType g_transitions[DOOR_CORE_NUM_OF_STATES][DOOR_CORE_NUM_OF_EVENTS] FSM_FLASH =
+{
+	[DOOR_CORE_NEW_PASSWARD_STATE] =
+	{
+		[DOOR_CORE_PASS_MATCH_EVENT]        = { NULL_PTR, DoorCore_savePassward, DOOR_CORE_LOCKED_STATE },
+		[DOOR_CORE_PASS_MISMATCH_EVENT]     = { NULL_PTR, DoorCore_rejectPassward, DOOR_CORE_NEW_PASSWARD_STATE },
+	},
+	[DOOR_CORE_LOCKED_STATE] =
+	{
+		[DOOR_CORE_PASS_MATCH_EVENT]        = { NULL_PTR, DoorCore_acceptPassward, DOOR_CORE_CHOICE_STATE },
+		[DOOR_CORE_PASS_MISMATCH_EVENT]     = { NULL_PTR, DoorCore_startRetries, DOOR_CORE_RETRY_STATE },
+	},
+	[DOOR_CORE_RETRY_STATE] =
+	{
+		[DOOR_CORE_PASS_MATCH_EVENT]        = { NULL_PTR, DoorCore_acceptPassward, DOOR_CORE_LOCKED_STATE },
+		[DOOR_CORE_PASS_MISMATCH_EVENT]     = { NULL_PTR, DoorCore_rejectPassward, DOOR_CORE_RETRY_STATE },
+		[DOOR_CORE_RETRIES_EXHAUSTED_EVENT] = { NULL_PTR, DoorCore_startLockout, DOOR_CORE_LOCKOUT_STATE },
+	},
+	[DOOR_CORE_CHOICE_STATE] =
+	{
+		[DOOR_CORE_OPEN_CHOICE_EVENT]       = { NULL_PTR, DoorCore_openDoor, DOOR_CORE_OPENING_STATE },
+		[DOOR_CORE_CHANGE_CHOICE_EVENT]     = { NULL_PTR, NULL_PTR, DOOR_CORE_NEW_PASSWARD_STATE },
+		[DOOR_CORE_INVALID_CHOICE_EVENT]    = { NULL_PTR, NULL_PTR, DOOR_CORE_LOCKED_STATE },
+	},
+	[DOOR_CORE_OPENING_STATE] =
+	{
+		[DOOR_CORE_END_REACHED_EVENT]       = { NULL_PTR, DoorCore_endTravel, DOOR_CORE_HOLDING_STATE },
+		[DOOR_CORE_TRAVEL_TIMEOUT_EVENT]    = { NULL_PTR, DoorCore_timeoutTravel, DOOR_CORE_HOLDING_STATE },
+		[DOOR_CORE_STALL_EVENT]             = { NULL_PTR, DoorCore_failTravel, DOOR_CORE_HOLDING_STATE },
+	},
+	[DOOR_CORE_HOLDING_STATE] =
+	{
+		[DOOR_CORE_TIME_ELAPSED_EVENT]      = { NULL_PTR, NULL_PTR, DOOR_CORE_CLEARING_STATE },
+	},
+	[DOOR_CORE_CLEARING_STATE] =
+	{
+		[DOOR_CORE_NO_MOTION_EVENT]         = { NULL_PTR, DoorCore_closeDoor, DOOR_CORE_CLOSING_STATE },
+	},
+	[DOOR_CORE_CLOSING_STATE] =
+	{
+		[DOOR_CORE_END_REACHED_EVENT]       = { NULL_PTR, DoorCore_endTravel, DOOR_CORE_LOCKED_STATE },
+		[DOOR_CORE_TRAVEL_TIMEOUT_EVENT]    = { NULL_PTR, DoorCore_timeoutTravel, DOOR_CORE_LOCKED_STATE },
+		[DOOR_CORE_STALL_EVENT]             = { NULL_PTR, DoorCore_reverseTravel, DOOR_CORE_OPENING_STATE },
+	},
+	[DOOR_CORE_LOCKOUT_STATE] =
+	{
+		[DOOR_CORE_TIME_ELAPSED_EVENT]      = { NULL_PTR, DoorCore_endLockout, DOOR_CORE_LOCKED_STATE },
+	},
+};
+
+static const FSM_ConfigType g_config =
+{
+	g_handlers, &g_transitions[0][0], DOOR_CORE_NUM_OF_STATES, DOOR_CORE_NUM_OF_EVENTS,
+	DOOR_CORE_NEW_PASSWARD_STATE, DoorCore_now
+};
+
+static const DoorCore_OpsType *g_ops = NULL_PTR;
+static FSM_Type g_fsm;
+
+/* Time the current state was entered, in ms */
+static uint32 g_stateStartTime = 0;
+
+/* Password being saved and the stored password */
+static const uint8 *g_newPassward = NULL_PTR;
+static uint8 g_storedPassward[PASSWARD_LENGTH];
+
+/* Number of wrong passwords entered after the first one */
+static uint8 g_failedRetries = 0;
+
+/*
+ * Running door move, its timeout and whether it started from an end of travel. The door is
+ * at an end once its switch was reached, and not known to be after the power up or a fault.
+ */
+static DoorCore_MotorType g_motion = DOOR_CORE_MOTOR_STOP;
+static uint32 g_travelTimeout = 0;
+static boolean g_fullTravel = FALSE;
+static boolean g_atEnd = FALSE;
+
+/* Learned travel times and the last stored ones */
+static DoorCore_TravelTimesType g_travelTimes;
+static DoorCore_TravelTimesType g_storedTravelTimes;
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+void DoorCore_init(const DoorCore_OpsType *ops, FSM_StateStatsType *state_stats, uint16 *transition_counts)
+{
+	g_ops = ops;
+	g_failedRetries = 0;
+	g_newPassward = NULL_PTR;
+	g_motion = DOOR_CORE_MOTOR_STOP;
+	g_atEnd = FALSE;
+
+	/* An erased or damaged EEPROM gives travel times out of the limits, they are learned again */
+	g_ops->loadTravelTimes(&g_travelTimes);
+	g_travelTimes.open_ms = DoorCore_checkTravel(g_travelTimes.open_ms);
+	g_travelTimes.close_ms = DoorCore_checkTravel(g_travelTimes.close_ms);
+	g_storedTravelTimes = g_travelTimes;
+
+	FSM_init(&g_fsm, &g_config, state_stats, transition_counts);
+	g_stateStartTime = g_ops->now();
+}
+
+void DoorCore_setPassward(const uint8 *passward, const uint8 *confirmed_passward)
+{
+	if(FSM_getState(&g_fsm) != DOOR_CORE_NEW_PASSWARD_STATE)
+	{
+		return;
+	}
+	g_newPassward = passward;
+	DoorCore_dispatch((DoorCore_isEqual(passward, confirmed_passward) == TRUE) ?
+			DOOR_CORE_PASS_MATCH_EVENT : DOOR_CORE_PASS_MISMATCH_EVENT);
+}
+
+void DoorCore_checkPassward(const uint8 *passward)
+{
+	FSM_StateType state = FSM_getState(&g_fsm);
+	FSM_EventType event;
+
+	if((state != DOOR_CORE_LOCKED_STATE) && (state != DOOR_CORE_RETRY_STATE))
+	{
+		return;
+	}
+	event = (DoorCore_isEqual(passward, g_storedPassward) == TRUE) ?
+			DOOR_CORE_PASS_MATCH_EVENT : DOOR_CORE_PASS_MISMATCH_EVENT;
+
+	/* The retries run out after RETRIES wrong passwords in the retry state */
+	if((state == DOOR_CORE_RETRY_STATE) && (event == DOOR_CORE_PASS_MISMATCH_EVENT) && (++g_failedRetries >= RETRIES))
+	{
+		event = DOOR_CORE_RETRIES_EXHAUSTED_EVENT;
+	}
+	DoorCore_dispatch(event);
+}
+
+void DoorCore_selectChoice(uint8 choice)
+{
+	if(choice == OPEN_DOOR_CHOICE)
+	{
+		DoorCore_dispatch(DOOR_CORE_OPEN_CHOICE_EVENT);
+	}
+	else if(choice == CHANGE_PASS_CHOICE)
+	{
+		DoorCore_dispatch(DOOR_CORE_CHANGE_CHOICE_EVENT);
+	}
+	else
+	{
+		DoorCore_dispatch(DOOR_CORE_INVALID_CHOICE_EVENT);
+	}
+}
+
+void DoorCore_update(void)
+{
+	FSM_StateType previous = FSM_getState(&g_fsm);
+
+	FSM_run(&g_fsm);
+	if(FSM_getState(&g_fsm) != previous)
+	{
+		DoorCore_enterState(previous);
+	}
+}
+
+boolean DoorCore_isBusy(void)
+{
+	return (FSM_getState(&g_fsm) >= DOOR_CORE_OPENING_STATE) ? TRUE : FALSE;
+}
+
+DoorCore_StateType DoorCore_getState(void)
+{
+	return (DoorCore_StateType)FSM_getState(&g_fsm);
+}
+
+const FSM_Type *DoorCore_getFsm(void)
+{
+	return &g_fsm;
+}
+
+void DoorCore_resetStats(void)
+{
+	FSM_resetStats(&g_fsm);
+}
+
+/*******************************************************************************
+ *                      Private Functions Definitions                          *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Time source of the FSM instrumentation, the core counts in ms.
+ */
+static uint32 DoorCore_now(void)
+{
+	return g_ops->now();
+}
+
+/*
+ * Description :
+ * Dispatch an event of the link.
+ */
+static void DoorCore_dispatch(FSM_EventType event)
+{
+	FSM_StateType previous = FSM_getState(&g_fsm);
+
+	if(FSM_dispatch(&g_fsm, event) == TRUE)
+	{
+		DoorCore_enterState(previous);
+	}
+}
+
+/*
+ * Description :
+ * Follow a transition. The stored password is read on each password wait,
+ * so the read overlaps with the typing.
+ */
+static void DoorCore_enterState(FSM_StateType previous)
+{
+	FSM_StateType state = FSM_getState(&g_fsm);
+
+	g_stateStartTime = g_ops->now();
+	if((state == DOOR_CORE_LOCKED_STATE) || (state == DOOR_CORE_RETRY_STATE))
+	{
+		g_ops->loadPassward(g_storedPassward);
+	}
+	if(g_ops->stateChanged != NULL_PTR)
+	{
+		g_ops->stateChanged((DoorCore_StateType)previous, (DoorCore_StateType)state);
+	}
+}
+
+/* An incomplete entry (NULL_PTR) never matches */
+static boolean DoorCore_isEqual(const uint8 *passward1, const uint8 *passward2)
+{
+	uint8 count;
+
+	if((passward1 == NULL_PTR) || (passward2 == NULL_PTR))
+	{
+		return FALSE;
+	}
+	for(count = 0; count < PASSWARD_LENGTH; count++)
+	{
+		if(passward1[count] != passward2[count])
+		{
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/* Learned travel time, or 0 if it is out of the limits */
+static uint16 DoorCore_checkTravel(uint16 travel_ms)
+{
+	return ((travel_ms < DOOR_CORE_MIN_TRAVEL_MS) || (travel_ms > DOOR_CORE_MAX_TRAVEL_MS)) ? 0 : travel_ms;
+}
+
+/*
+ * Description :
+ * Start the motor, planned over the learned travel time, with the timeout of the move.
+ * Only a move from an end of travel is a full travel, the door leaves the end.
+ */
+static void DoorCore_startMove(DoorCore_MotorType motion)
+{
+	uint32 travel_ms = (motion == DOOR_CORE_MOTOR_OPEN) ? g_travelTimes.open_ms : g_travelTimes.close_ms;
+
+	if(travel_ms == 0)
+	{
+		travel_ms = DOOR_CORE_TRAVEL_MS;
+		g_travelTimeout = DOOR_CORE_MAX_TRAVEL_MS;
+	}
+	else
+	{
+		g_travelTimeout = travel_ms + (travel_ms / 2);
+		if(g_travelTimeout > DOOR_CORE_MAX_TRAVEL_MS)
+		{
+			g_travelTimeout = DOOR_CORE_MAX_TRAVEL_MS;
+		}
+	}
+	g_motion = motion;
+	g_fullTravel = g_atEnd;
+	g_atEnd = FALSE;
+	g_ops->setMotor(motion, travel_ms);
+}
+
+/*
+ * Description :
+ * Average a travel time that reached its switch into the learned one (the first one
+ * is taken as is, then 1/4 of each new one), and store it once it moved enough.
+ */
+static void DoorCore_learnTravel(uint32 travel_ms)
+{
+	uint16 *learned = (g_motion == DOOR_CORE_MOTOR_OPEN) ? &g_travelTimes.open_ms : &g_travelTimes.close_ms;
+	uint16 stored = (g_motion == DOOR_CORE_MOTOR_OPEN) ? g_storedTravelTimes.open_ms : g_storedTravelTimes.close_ms;
+
+	if((travel_ms < DOOR_CORE_MIN_TRAVEL_MS) || (travel_ms > DOOR_CORE_MAX_TRAVEL_MS))
+	{
+		return;
+	}
+	if(*learned == 0)
+	{
+		*learned = (uint16)travel_ms;
+	}
+	else
+	{
+		*learned = (uint16)(((3UL * *learned) + travel_ms + 2) / 4);
+	}
+
+	if((uint16)((*learned > stored) ? (*learned - stored) : (stored - *learned)) >= DOOR_CORE_TRAVEL_SAVE_MS)
+	{
+		g_storedTravelTimes = g_travelTimes;
+		g_ops->storeTravelTimes(&g_travelTimes);
+	}
+}
+
+/*
+ * Description :
+ * Drop the learned travel time of the running move after its timeout, the next move runs
+ * with the DOOR_CORE_MAX_TRAVEL_MS timeout and learns it again. A door slower than the
+ * learned time would else time out on every move. Stored if it was not already dropped.
+ */
+static void DoorCore_forgetTravel(void)
+{
+	uint16 *learned = (g_motion == DOOR_CORE_MOTOR_OPEN) ? &g_travelTimes.open_ms : &g_travelTimes.close_ms;
+	uint16 stored = (g_motion == DOOR_CORE_MOTOR_OPEN) ? g_storedTravelTimes.open_ms : g_storedTravelTimes.close_ms;
+
+	*learned = 0;
+	if(stored != 0)
+	{
+		g_storedTravelTimes = g_travelTimes;
+		g_ops->storeTravelTimes(&g_travelTimes);
+	}
+}
+
+/*
+ * The end of travel switch closes the move, a stall means an obstruction (the motor is already
+ * braked) and the timeout is the failsafe of a bad switch or a door stuck without stalling.
+ */
+static FSM_EventType DoorCore_waitTravel(void)
+{
+	if(g_ops->isEndReached(g_motion) == TRUE)
+	{
+		return DOOR_CORE_END_REACHED_EVENT;
+	}
+	if(g_ops->isStalled() == TRUE)
+	{
+		return DOOR_CORE_STALL_EVENT;
+	}
+	return ((g_ops->now() - g_stateStartTime) >= g_travelTimeout) ?
+			DOOR_CORE_TRAVEL_TIMEOUT_EVENT : DOOR_CORE_NUM_OF_EVENTS;
+}
+
+static FSM_EventType DoorCore_waitHold(void)
+{
+	return ((g_ops->now() - g_stateStartTime) >= DOOR_CORE_HOLD_MS) ?
+			DOOR_CORE_TIME_ELAPSED_EVENT : DOOR_CORE_NUM_OF_EVENTS;
+}
+
+static FSM_EventType DoorCore_waitNoMotion(void)
+{
+	return (g_ops->isMotion() == FALSE) ? DOOR_CORE_NO_MOTION_EVENT : DOOR_CORE_NUM_OF_EVENTS;
+}
+
+static FSM_EventType DoorCore_waitLockout(void)
+{
+	return ((g_ops->now() - g_stateStartTime) >= DOOR_CORE_LOCKOUT_MS) ?
+			DOOR_CORE_TIME_ELAPSED_EVENT : DOOR_CORE_NUM_OF_EVENTS;
+}
+
+/* Passwords match, the result is sent before the slow EEPROM write */
+static void DoorCore_savePassward(void)
+{
+	g_ops->sendResult(EQUAL_PASS);
+	g_ops->storePassward(g_newPassward);
+}
+
+static void DoorCore_acceptPassward(void)
+{
+	g_ops->sendResult(EQUAL_PASS);
+}
+
+static void DoorCore_rejectPassward(void)
+{
+	g_ops->sendResult(NOT_EQUAL_PASS);
+}
+
+/* First wrong password, allow up to RETRIES attempts */
+static void DoorCore_startRetries(void)
+{
+	g_ops->sendResult(NOT_EQUAL_PASS);
+	g_failedRetries = 0;
+}
+
+/* Password is incorrect after all retries, start the alarm */
+static void DoorCore_startLockout(void)
+{
+	g_ops->sendResult(NOT_EQUAL_PASS);
+	g_ops->setBuzzer(TRUE);
+}
+
+static void DoorCore_endLockout(void)
+{
+	g_ops->setBuzzer(FALSE);
+}
+
+static void DoorCore_openDoor(void)
+{
+	DoorCore_startMove(DOOR_CORE_MOTOR_OPEN);
+}
+
+/*
+ * Door at its end of travel, the HMI is told before the travel time is stored.
+ * A move started half way (a reopening, after a fault) does not teach the travel time.
+ */
+static void DoorCore_endTravel(void)
+{
+	g_ops->setMotor(DOOR_CORE_MOTOR_STOP, 0);
+	g_ops->reportDoorState((g_motion == DOOR_CORE_MOTOR_OPEN) ? DOOR_OPENED_BYTE : DOOR_CLOSED_BYTE);
+	if(g_fullTravel == TRUE)
+	{
+		DoorCore_learnTravel(g_ops->now() - g_stateStartTime);
+	}
+	g_motion = DOOR_CORE_MOTOR_STOP;
+	g_atEnd = TRUE;
+}
+
+/* Obstruction while opening, the sequence goes on from where the door stopped */
+static void DoorCore_failTravel(void)
+{
+	g_ops->setMotor(DOOR_CORE_MOTOR_STOP, 0);
+	g_ops->reportDoorState(DOOR_FAULT_BYTE);
+	g_motion = DOOR_CORE_MOTOR_STOP;
+	g_atEnd = FALSE;
+}
+
+/* Switch not reached in time, a fault and the learned travel time is not trusted anymore */
+static void DoorCore_timeoutTravel(void)
+{
+	DoorCore_forgetTravel();
+	DoorCore_failTravel();
+}
+
+/* Obstruction while closing: stop and reverse, the door opens again from where it stopped */
+static void DoorCore_reverseTravel(void)
+{
+	g_ops->setMotor(DOOR_CORE_MOTOR_STOP, 0);
+	g_ops->reportDoorState(DOOR_OBSTRUCTED_BYTE);
+	DoorCore_startMove(DOOR_CORE_MOTOR_OPEN);
+}
+
+/* No motion anymore, tell the HMI then close the door */
+static void DoorCore_closeDoor(void)
+{
+	g_ops->reportDoorClear();
+	DoorCore_startMove(DOOR_CORE_MOTOR_CLOSE);
+}
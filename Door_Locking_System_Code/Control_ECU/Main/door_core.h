@@ -0,0 +1,175 @@
+ /******************************************************************************
+ *
+ * Module: Door Core
+ *
+ * File Name: door_core.h
+ *
+ * Description: Header file for the access control policy of the Control ECU:
+ *              password setup and checks, retries, lockout and the door
+ *              sequence. The door moves until its end of travel switch or a
+ *              timeout, the travel times are learned to plan the next moves.
+ *              The core has no hardware access, the board and the
+ *              clock are operations given at init (the firmware in main.c, the
+ *              scenario runner in Tools/door_sim on the host). It never blocks,
+ *              the password and choice functions are called when the link
+ *              receives them and DoorCore_update while DoorCore_isBusy.
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#ifndef DOOR_CORE_H_
+#define DOOR_CORE_H_
+
+#include "std_types.h"
+#include "fsm.h"
+#include "door_protocol.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/* Door sequence and lockout times */
+#define DOOR_CORE_TRAVEL_MS            (DOOR_TRAVEL_SECONDS * 1000UL)
+#define DOOR_CORE_HOLD_MS              3000UL
+#define DOOR_CORE_LOCKOUT_MS           (LOCKOUT_SECONDS * 1000UL)
+
+/*
+ * Travel times: DOOR_CORE_TRAVEL_MS is planned until a travel is learned. A move times out
+ * after 1.5 times the learned travel, or DOOR_CORE_MAX_TRAVEL_MS before the first one. A
+ * timeout drops the learned travel. Only the moves from an end of travel are learned, and
+ * not the shorter or longer travels than the limits (e.g. a move started at its end).
+ */
+#define DOOR_CORE_MIN_TRAVEL_MS        1000UL
+#define DOOR_CORE_MAX_TRAVEL_MS        (2 * DOOR_CORE_TRAVEL_MS)
+
+/* Change of a learned travel time before it is stored again, spares the EEPROM writes */
+#define DOOR_CORE_TRAVEL_SAVE_MS       250U
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+/* States of the core, the state 0 is reserved by the FSM engine */
+typedef enum
+{
+	DOOR_CORE_NO_STATE = FSM_NO_STATE,
+	DOOR_CORE_NEW_PASSWARD_STATE,      /* Waits for a new password and its confirmation */
+	DOOR_CORE_LOCKED_STATE,            /* Waits for the password before a choice */
+	DOOR_CORE_RETRY_STATE,             /* Same, after a wrong password */
+	DOOR_CORE_CHOICE_STATE,            /* Waits for the open door / change password choice */
+	DOOR_CORE_OPENING_STATE,           /* Motor opens the door until the open switch, a stall or the timeout */
+	DOOR_CORE_HOLDING_STATE,           /* Door open for DOOR_CORE_HOLD_MS */
+	DOOR_CORE_CLEARING_STATE,          /* Door open until the PIR sees no motion */
+	DOOR_CORE_CLOSING_STATE,           /* Motor closes the door until the closed switch or the timeout, a stall reopens it */
+	DOOR_CORE_LOCKOUT_STATE,           /* Buzzer on for DOOR_CORE_LOCKOUT_MS */
+	DOOR_CORE_NUM_OF_STATES
+}DoorCore_StateType;
+
+/* Events of the core state machine */
+typedef enum
+{
+	DOOR_CORE_PASS_MATCH_EVENT,
+	DOOR_CORE_PASS_MISMATCH_EVENT,
+	DOOR_CORE_RETRIES_EXHAUSTED_EVENT,
+	DOOR_CORE_OPEN_CHOICE_EVENT,
+	DOOR_CORE_CHANGE_CHOICE_EVENT,
+	DOOR_CORE_INVALID_CHOICE_EVENT,
+	DOOR_CORE_TIME_ELAPSED_EVENT,
+	DOOR_CORE_NO_MOTION_EVENT,
+	DOOR_CORE_END_REACHED_EVENT,
+	DOOR_CORE_TRAVEL_TIMEOUT_EVENT,
+	DOOR_CORE_STALL_EVENT,
+	DOOR_CORE_NUM_OF_EVENTS
+}DoorCore_EventType;
+
+typedef enum
+{
+	DOOR_CORE_MOTOR_STOP, DOOR_CORE_MOTOR_OPEN, DOOR_CORE_MOTOR_CLOSE
+}DoorCore_MotorType;
+
+/* Learned travel times in ms, 0 while not learned */
+typedef struct
+{
+	uint16 open_ms;
+	uint16 close_ms;
+}DoorCore_TravelTimesType;
+
+/* Board and clock of the core */
+typedef struct
+{
+	uint32 (*now)(void);                              /* Milliseconds, may wrap */
+	void (*sendResult)(uint8 result);                 /* EQUAL_PASS or NOT_EQUAL_PASS to the HMI */
+	void (*reportDoorClear)(void);                    /* No motion anymore, the door closes */
+	void (*reportDoorState)(uint8 state);             /* DOOR_OPENED/CLOSED/FAULT/OBSTRUCTED_BYTE to the HMI */
+	void (*loadPassward)(uint8 *passward);            /* Read the stored password */
+	void (*storePassward)(const uint8 *passward);     /* Save a new password */
+	void (*loadTravelTimes)(DoorCore_TravelTimesType *times);
+	void (*storeTravelTimes)(const DoorCore_TravelTimesType *times);
+	void (*setMotor)(DoorCore_MotorType motion, uint32 travel_ms); /* Move planned over travel_ms */
+	boolean (*isEndReached)(DoorCore_MotorType motion); /* End of travel switch of the move */
+	boolean (*isStalled)(void);                       /* The motor stalled and braked since the move started */
+	void (*setBuzzer)(boolean on);
+	boolean (*isMotion)(void);                        /* PIR output */
+	void (*stateChanged)(DoorCore_StateType previous, DoorCore_StateType state); /* NULL_PTR if not needed */
+}DoorCore_OpsType;
+
+/*******************************************************************************
+ *                              Functions Prototypes                           *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Start in DOOR_CORE_NEW_PASSWARD_STATE with the board operations (kept by pointer)
+ * and the stored travel times. state_stats and transition_counts are the optional FSM instrumentation arrays.
+ */
+void DoorCore_init(const DoorCore_OpsType *ops, FSM_StateStatsType *state_stats, uint16 *transition_counts);
+
+/*
+ * Description :
+ * New password and its confirmation, in DOOR_CORE_NEW_PASSWARD_STATE.
+ * The result is sent then a matching password is stored. NULL_PTR is an incomplete entry,
+ * it never matches.
+ */
+void DoorCore_setPassward(const uint8 *passward, const uint8 *confirmed_passward);
+
+/*
+ * Description :
+ * Password entered, in DOOR_CORE_LOCKED_STATE or DOOR_CORE_RETRY_STATE.
+ * RETRIES wrong passwords in a row after the first one start the lockout.
+ * NULL_PTR is an incomplete entry, a wrong password.
+ */
+void DoorCore_checkPassward(const uint8 *passward);
+
+/*
+ * Description :
+ * User choice (OPEN_DOOR_CHOICE or CHANGE_PASS_CHOICE), in DOOR_CORE_CHOICE_STATE.
+ */
+void DoorCore_selectChoice(uint8 choice);
+
+/*
+ * Description :
+ * Follow the time, the switches and the PIR sensor, to call periodically while DoorCore_isBusy.
+ */
+void DoorCore_update(void);
+
+/*
+ * Description :
+ * TRUE while the door moves or the lockout runs, the link waits for the core.
+ */
+boolean DoorCore_isBusy(void);
+
+/*
+ * Description :
+ * Return the current state and the state machine, for its instrumentation.
+ */
+DoorCore_StateType DoorCore_getState(void);
+const FSM_Type *DoorCore_getFsm(void);
+
+/*
+ * Description :
+ * Clear the instrumentation counters of the state machine.
+ */
+void DoorCore_resetStats(void);
+
+#endif /* DOOR_CORE_H_ */
@@ -9,48 +9,174 @@
 #include "PIR.h"
 #include "DC_MOTOR.h"
 #include "BUZZER.h"
-#include "UART.h"
+#include "LIMIT_SWITCH.h"
+#include "MOTOR_CURRENT.h"
+#include "uart.h"
 #include "PWM.h"
-#include "TWI.h"
-#include "timer.h"
+#include "twi.h"
+#include "adc.h"
+#include "fsm.h"
+#include "systime.h"
+#include "kernel.h"
+#include "power.h"
+#include "trace.h"
+#include "histogram.h"
+#include "debounce.h"
+#include "motion.h"
+#include "gpio.h"
+#include "door_protocol.h"
+#include "door_core.h"
 #include <avr/io.h>
 #include <avr/interrupt.h>
-#include <util/delay.h>
 
-/* Defines various stages for application functionality */
-#define PASSWARD_RECEIVING_STAGE  1
-#define CHECKING_PASSWARD_STAGE   2
-#define MAIN_OPTIONS_STAGE        3
-#define OPEN_DOOR_STAGE           4
+/* Latencies measured with a histogram each, keep Tools/latency_report.py in sync.
+ * The last ones are not times: their unit is given. */
+typedef enum {
+    RECEIVE_LATENCY,           /* Password frame, first to last byte (not recorded when streaming) */
+    EEPROM_READ_LATENCY,       /* Stored password read */
+    COMPARE_LATENCY,           /* Password comparison */
+    REPLY_LATENCY,             /* Result byte transfer */
+    VERIFY_LATENCY,            /* Password frame or submit key received to result sent */
+    MOTOR_START_LATENCY,       /* Open choice received to motor start */
+    TRAVEL_LATENCY,            /* Door travel, motor start to the end of travel switch or the timeout */
+    PIR_CLEAR_LATENCY,         /* End of the door hold to no motion */
+    MOTOR_PEAK_CURRENT,        /* Peak motor current of each door move, in mA */
+    NUM_OF_LATENCIES
+} Application_LatencyType;
+
+/* Tasks priorities, 0 is the highest */
+#define DOOR_TASK_PRIORITY        1
+#define LINK_TASK_PRIORITY        2
 
-/* Password configuration */
-#define PASSWARD_LENGTH           5
+/*
+ * Tasks stack sizes in bytes: deepest call chain, hand estimated at -O0 as in LIB/kernel.h,
+ * plus KERNEL_MIN_STACK_SIZE (interrupt load and margin). The deepest chains store to the
+ * EEPROM, whose _delay_ms runs the float library at -O0 (__mulsf3 saves 18 registers and
+ * keeps 32 bytes of locals). The watermarks are sent with the statistics snapshot.
+ *  door: Kernel_taskStart 3, door_task 4, DoorCore_update 5, FSM_run 9, FSM_dispatch 18,
+ *        DoorCore_endTravel 4, DoorCore_learnTravel 16, board_store_travel_times 6,
+ *        EEPROM_writeArray 24, __mulsf3 52, __unpack_f 4 = 145 bytes
+ *  link: Kernel_taskStart 3, link_task 7, DoorCore_setPassward 8, DoorCore_dispatch 6,
+ *        FSM_dispatch 18, DoorCore_savePassward 4, board_store_passward 6,
+ *        EEPROM_writeArray 24, __mulsf3 52, __unpack_f 4 = 132 bytes, the door moves
+ *        (board_set_motor, Motion_move, DC_Motor_Rotate, PWM) and the statistics take less
+ */
+#define DOOR_TASK_STACK_SIZE      256
+#define LINK_TASK_STACK_SIZE      240
 
-/* UART communication bytes for readiness and completion */
-#define READY_BYTE                0xFF
-#define DONE_BYTE                 0xF0
+/* Period of the door core updates while the door moves or the lockout runs, the end of
+ * travel brake does not wait for it, the switch interrupt brakes the motor */
+#define CORE_UPDATE_TICKS         1
 
-/* Number of retry attempts */
-#define RETRIES                   2
+/*
+ * Door motor profile: S-curve ramps and full speed cruise, the deceleration ends MOTOR_CREEP_MS
+ * before the expected travel time and the door creeps to its end of travel switch, then an
+ * active brake. The expected travel is learned by the door core.
+ */
+#define MOTOR_RAMP_MS             1500
+#define MOTOR_BRAKE_MS            200
+#define MOTOR_CREEP_DUTY          30
+#define MOTOR_CREEP_MS            500
 
-/* Password comparison results */
-#define EQUAL_PASS                0x10
-#define NOT_EQUAL_PASS            0x11
+/*
+ * Stall threshold at full duty, 3/4 of the 2 A stall current of the motor: the motor turns at
+ * less than 1/4 of its free speed for the duty. The ADC converts at F_CPU/64/13 = 9.6 kHz,
+ * a current result every 1.7 ms.
+ */
+#define MOTOR_STALL_MA            1500
+
+/* EEPROM addresses of the password and of the learned travel times */
+#define PASSWARD_ADDRESS          0x0000
+#define TRAVEL_TIMES_ADDRESS      0x0010
+
+/*
+ * Set to 1 to trace at startup the CPU cycles of one debounce sample of a whole port
+ * (DEBOUNCE_PORT_CYCLES_EVENT) and of the same 8 pins debounced one by one
+ * (DEBOUNCE_PIN_CYCLES_EVENT), one SysTime count = 256 cycles, the loop overhead is included.
+ */
+#define DEBOUNCE_BENCHMARK_ENABLE 0
+#define DEBOUNCE_BENCHMARK_SAMPLES 1024U
+#define DEBOUNCE_PORT_CYCLES_EVENT TRACE_EVENT_USER
+#define DEBOUNCE_PIN_CYCLES_EVENT  (TRACE_EVENT_USER + 1)
+
+/*
+ * Set to 1 to trace at startup the CPU cycles of one motor duty update from the percent
+ * table (PWM_UPDATE_CYCLES_EVENT) and with the multiply and division by 100 of the former
+ * driver (PWM_REFERENCE_CYCLES_EVENT), one SysTime count = 256 cycles, the loop overhead
+ * is included.
+ */
+#define PWM_BENCHMARK_ENABLE      0
+#define PWM_BENCHMARK_UPDATES     1024U
+#define PWM_UPDATE_CYCLES_EVENT   (TRACE_EVENT_USER + 2)
+#define PWM_REFERENCE_CYCLES_EVENT (TRACE_EVENT_USER + 3)
 
 /* Variables to hold password and confirmed password */
 uint8 passward[PASSWARD_LENGTH], confirmed_passward[PASSWARD_LENGTH];
-/* Tracks the current application stage */
-uint8 application_stage = PASSWARD_RECEIVING_STAGE;
-/* Tick counter for timer callback */
-uint8 ticks = 0;
+
+/* Tasks and their stacks */
+Kernel_TaskType link_task_tcb, door_task_tcb;
+uint8 link_task_stack[LINK_TASK_STACK_SIZE];
+uint8 door_task_stack[DOOR_TASK_STACK_SIZE];
+
+/* The link task hands the core to the door task while it is busy and gets it back after */
+Kernel_SemaphoreType core_busy, core_idle;
+
+/* Latency histograms and the start times of the measurements crossing functions */
+Histogram_Type latencies[NUM_OF_LATENCIES];
+uint32 frame_received_time;
+uint32 check_start_time;
+uint32 open_choice_time;
+boolean open_choice_pending = FALSE; /* Only the move of the choice is measured, not a reopening */
+uint32 motor_start_time;
+uint32 pir_wait_time;
 
 /* Function declarations */
-void receive_passward(uint8 *passward_array);
+boolean receive_passward(uint8 *passward_array);
 void send_byte(uint8 byte);
 uint8 receive_byte();
-uint8 check_passwards(uint8 *passward_array1, uint8 *passward_array2);
-void _delay_seconds(uint8 seconds);
-void Timer_Callbackfunc();
+void wait_transfer_start(void);
+void send_result(uint8 result);
+void send_statistics(void);
+void send_latencies(void);
+void send_state_stats(void);
+void send_stack_stats(void);
+void send_power_stats(void);
+void reset_statistics(void);
+void reset_latencies(void);
+void debounce_benchmark(void);
+void debounce_pin_reference(void);
+void pwm_benchmark(void);
+void pwm_duty_reference(uint8 duty_cycle);
+
+/* Tasks */
+void link_task(void);
+void door_task(void);
+
+/* Board operations of the door core */
+uint32 board_now(void);
+void board_report_door_clear(void);
+void board_report_door_state(uint8 state);
+void board_load_passward(uint8 *passward_array);
+void board_store_passward(const uint8 *passward_array);
+void board_load_travel_times(DoorCore_TravelTimesType *times);
+void board_store_travel_times(const DoorCore_TravelTimesType *times);
+void board_set_motor(DoorCore_MotorType motion, uint32 travel_ms);
+boolean board_is_end_reached(DoorCore_MotorType motion);
+boolean board_is_stalled(void);
+void board_set_buzzer(boolean on);
+boolean board_is_motion(void);
+void board_state_changed(DoorCore_StateType previous, DoorCore_StateType state);
+
+static const DoorCore_OpsType board_ops = {
+    board_now, send_result, board_report_door_clear, board_report_door_state,
+    board_load_passward, board_store_passward, board_load_travel_times, board_store_travel_times,
+    board_set_motor, board_is_end_reached, board_is_stalled, board_set_buzzer, board_is_motion,
+    board_state_changed
+};
+
+/* Instrumentation counters of the door core state machine */
+FSM_StateStatsType state_stats[DOOR_CORE_NUM_OF_STATES];
+uint16 transition_counts[DOOR_CORE_NUM_OF_STATES * DOOR_CORE_NUM_OF_EVENTS];
 
 int main() {
 
@@ -65,147 +191,268 @@ int main() {
     TWI_ConfigType TWI_configurations = { 0x01, 0x02 };
     TWI_init(&TWI_configurations);
 
-    /* Timer setup and callback function initialization */
-    Timer_ConfigType TIMER_configurations = { 0, 31250, TIMER1, F_CPU_256, COMPARE };
-    Timer_init(&TIMER_configurations);
-    Timer_setCallBack(&Timer_Callbackfunc, TIMER1);
+    /* Timer1 time base for the kernel tick and the FSM instrumentation */
+    SysTime_init();
 
+    /*
+     * Sleep in idle mode when no task is ready and while the link task waits for a byte.
+     * No power-down wake source is registered: the RX complete interrupt can not wake
+     * the MCU from power-down and the HMI may send at any time.
+     */
+    Power_init();
+    Trace_init('C');
+    reset_latencies();
+    Kernel_setIdleCallBack(Power_idle);
+    UART_setIdleCallBack(Power_idle);
 
     /* Initialize peripherals */
     Buzzer_init();
     DC_Motor_init();
+    Motion_ConfigType motion_configurations = { MOTION_S_CURVE, 100, MOTOR_CREEP_DUTY, MOTOR_RAMP_MS, MOTOR_RAMP_MS,
+            MOTOR_BRAKE_MS, MOTOR_STALL_MA, MotorCurrent_get };
+    Motion_init(&motion_configurations);
+#if (PWM_BENCHMARK_ENABLE == 1)
+    pwm_benchmark();
+#endif
+
+    /* Motor current conversions, the only channel of the sequence */
+    ADC_ConfigType ADC_configurations = { ADC_AVCC, ADC_F_CPU_64, 1, { MOTOR_CURRENT_ADC_CHANNEL } };
+    ADC_setCallBack(MotorCurrent_sample);
+    ADC_init(&ADC_configurations);
+#if (DEBOUNCE_BENCHMARK_ENABLE == 1)
+    debounce_benchmark();
+#endif
+    /* The discrete inputs are sampled on the tick, before the kernel (the last hook) */
+    Debounce_init();
     PIR_init();
+    LimitSwitch_init();
+    LimitSwitch_setCallBack(Motion_brake);
+    SysTime_addTickHook(Debounce_tick);
+    SysTime_addTickHook(Motion_tick);
+
+    /* The link and the door core timing run as separate tasks */
+    Kernel_semInit(&core_busy, 0);
+    Kernel_semInit(&core_idle, 0);
+
+    Kernel_createTask(&door_task_tcb, door_task, DOOR_TASK_PRIORITY, door_task_stack, DOOR_TASK_STACK_SIZE);
+    Kernel_createTask(&link_task_tcb, link_task, LINK_TASK_PRIORITY, link_task_stack, LINK_TASK_STACK_SIZE);
+
+    Kernel_start();
+}
+
+/*******************************************************************************
+ *                                    Tasks                                    *
+ *******************************************************************************/
+
+/* Runs the password and menu flow with the HMI ECU, the door core decides what comes next */
+void link_task(void) {
+    uint8 choice;
+    boolean complete, confirmed_complete;
+
+    DoorCore_init(&board_ops, state_stats, transition_counts);
 
     while (1) {
-        switch (application_stage) {
-
-            /* Receive password and confirmation password, then proceed to check stage */
-            case PASSWARD_RECEIVING_STAGE:
-                receive_passward(passward);
-                receive_passward(confirmed_passward);
-                application_stage = CHECKING_PASSWARD_STAGE;
-                break;
-
-                /* Verify the password against the confirmation password */
-            case CHECKING_PASSWARD_STAGE: {
-                uint8 passwards_check = check_passwards(passward, confirmed_passward);
-
-                /* If passwords match, save to EEPROM and proceed to main options */
-                if (passwards_check == EQUAL_PASS) {
-                    send_byte(EQUAL_PASS);
-                    EEPROM_writeArray(0x0000, passward, PASSWARD_LENGTH);
-                    application_stage = MAIN_OPTIONS_STAGE;
-                }
-                    /* If passwords do not match, go back to password receiving stage */
-                else if (passwards_check == NOT_EQUAL_PASS) {
-                    send_byte(NOT_EQUAL_PASS);
-                    application_stage = PASSWARD_RECEIVING_STAGE;
-                }
-                break;
-            }
+        switch (DoorCore_getState()) {
+        case DOOR_CORE_NEW_PASSWARD_STATE:
+            complete = receive_passward(passward);
+            confirmed_complete = receive_passward(confirmed_passward);
+            check_start_time = SysTime_now();
+            DoorCore_setPassward((complete == TRUE) ? passward : NULL_PTR,
+                    (confirmed_complete == TRUE) ? confirmed_passward : NULL_PTR);
+            break;
+        case DOOR_CORE_LOCKED_STATE:
+        case DOOR_CORE_RETRY_STATE:
+            complete = receive_passward(passward);
+            check_start_time = SysTime_now();
+            DoorCore_checkPassward((complete == TRUE) ? passward : NULL_PTR);
+            break;
+        case DOOR_CORE_CHOICE_STATE:
+            choice = receive_byte();
+            open_choice_time = SysTime_now();
+            open_choice_pending = TRUE;
+            DoorCore_selectChoice(choice);
+            break;
+        default:
+            /* The door moves or the lockout runs, nothing is received until the core is idle */
+            Kernel_semGive(&core_busy);
+            Kernel_semTake(&core_idle, KERNEL_WAIT_FOREVER);
+            break;
+        }
+    }
+}
 
-                /* Main options stage to open door or reset password based on user input */
-            case MAIN_OPTIONS_STAGE: {
-                uint8 passwards_check, choice;
-
-                /* Receive and verify entered password against stored password */
-                receive_passward(passward);
-                EEPROM_readArray(0x0000, confirmed_passward, PASSWARD_LENGTH);
-                passwards_check = check_passwards(passward, confirmed_passward);
-
-                /* If password is correct, send confirmation and check user choice */
-                if (passwards_check == EQUAL_PASS) {
-                    send_byte(EQUAL_PASS);
-                    choice = receive_byte();
-
-                    /* Open door or reset password based on user choice */
-                    if (choice == '+') {
-                        application_stage = OPEN_DOOR_STAGE;
-                    } else if (choice == '-') {
-                        application_stage = PASSWARD_RECEIVING_STAGE;
-                    }
-                }
-                    /* If password is incorrect, allow retry attempts and activate buzzer if all fail */
-                else if (passwards_check == NOT_EQUAL_PASS) {
-                    uint8 count;
+/* Updates the door core while it is busy: door sequence and lockout */
+void door_task(void) {
+    while (1) {
+        Kernel_semTake(&core_busy, KERNEL_WAIT_FOREVER);
 
-                    send_byte(NOT_EQUAL_PASS);
+        while (DoorCore_isBusy() == TRUE) {
+            Kernel_delay(CORE_UPDATE_TICKS);
+            DoorCore_update();
+        }
 
-                    /* Allow up to RETRIES attempts */
-                    for (count = 0; count < RETRIES; count++) {
-                        receive_passward(passward);
-                        EEPROM_readArray(0x0000, confirmed_passward, PASSWARD_LENGTH);
+        Kernel_semGive(&core_idle);
+    }
+}
+
+/*******************************************************************************
+ *                          Door Core Board Operations                         *
+ *******************************************************************************/
 
-                        if (check_passwards(passward, confirmed_passward) == EQUAL_PASS) {
-                            send_byte(EQUAL_PASS);
-                            application_stage = MAIN_OPTIONS_STAGE;
-                            break;
-                        } else {
-                            send_byte(NOT_EQUAL_PASS);
-                        }
-                    }
+/* Millisecond clock of the core, from the kernel tick count (wraps after 49 days) */
+uint32 board_now(void) {
+    return SysTime_getTicks() * SYSTIME_MS_PER_TICK;
+}
 
-                    /* Activate buzzer if password is incorrect after all retries */
-                    if (count == RETRIES) {
-                        Buzzer_on();
+/* No motion anymore, tell the HMI while the door closes */
+void board_report_door_clear(void) {
+    send_byte(NO_MOTION);
+}
 
-                        _delay_seconds(60);
+/* End of a door move, the HMI screen follows the door */
+void board_report_door_state(uint8 state) {
+    send_byte(state);
+}
 
-                        Buzzer_off();
-                    }
+void board_load_passward(uint8 *passward_array) {
+    uint32 start_time = SysTime_now();
 
-                    application_stage = MAIN_OPTIONS_STAGE;
-                }
-                break;
-            }
+    EEPROM_readArray(PASSWARD_ADDRESS, passward_array, PASSWARD_LENGTH);
+    Histogram_record(&latencies[EEPROM_READ_LATENCY], SysTime_now() - start_time);
+}
+
+void board_store_passward(const uint8 *passward_array) {
+    EEPROM_writeArray(PASSWARD_ADDRESS, (uint8 *)passward_array, PASSWARD_LENGTH);
+}
+
+/* Travel times in ms, little endian as in the RAM of both the AVR and the host */
+void board_load_travel_times(DoorCore_TravelTimesType *times) {
+    EEPROM_readArray(TRAVEL_TIMES_ADDRESS, (uint8 *)times, sizeof(DoorCore_TravelTimesType));
+}
+
+void board_store_travel_times(const DoorCore_TravelTimesType *times) {
+    EEPROM_writeArray(TRAVEL_TIMES_ADDRESS, (uint8 *)times, sizeof(DoorCore_TravelTimesType));
+}
+
+/*
+ * The moves are planned over the expected travel, the door creeps to the end of travel switch
+ * whose interrupt brakes the motor. A stop brakes at once: the switch was seen, the motor
+ * stalled or the move timed out. The peak current of each move is recorded.
+ */
+void board_set_motor(DoorCore_MotorType motion, uint32 travel_ms) {
+    uint32 now = SysTime_now();
+
+    if (motion == DOOR_CORE_MOTOR_STOP) {
+        LimitSwitch_disarm();
+        Motion_brake();
+        Histogram_record(&latencies[TRAVEL_LATENCY], now - motor_start_time);
+        Histogram_record(&latencies[MOTOR_PEAK_CURRENT], MotorCurrent_getPeak());
+        return;
+    }
 
-                /* Open door sequence with motor rotation and PIR sensor check */
-            case OPEN_DOOR_STAGE:
-                PWM_Timer0_init();
-                DC_Motor_Rotate(DC_MOTOR_CCW, 100);
-                _delay_seconds(15);
-                DC_Motor_Rotate(DC_MOTOR_STOP, 0);
-                _delay_ms(3000);
-
-                /* Wait until no motion is detected */
-                while (PIR_Motion() == MOTION);
-                send_byte(NO_MOTION);
-
-                /* Rotate motor counterclockwise to close door */
-                DC_Motor_Rotate(DC_MOTOR_CW, 100);
-                _delay_seconds(15);
-                DC_Motor_Rotate(DC_MOTOR_STOP, 0);
-
-                application_stage = MAIN_OPTIONS_STAGE;
-                break;
+    MotorCurrent_resetPeak();
+
+    travel_ms = (travel_ms > MOTOR_CREEP_MS) ? (travel_ms - MOTOR_CREEP_MS) : 0;
+    if (motion == DOOR_CORE_MOTOR_OPEN) {
+        Motion_move(DC_MOTOR_CCW, travel_ms);
+        LimitSwitch_arm(LIMIT_SWITCH_OPEN);
+        if (open_choice_pending == TRUE) {
+            Histogram_record(&latencies[MOTOR_START_LATENCY], now - open_choice_time);
         }
+    } else {
+        Motion_move(DC_MOTOR_CW, travel_ms);
+        LimitSwitch_arm(LIMIT_SWITCH_CLOSED);
     }
+    open_choice_pending = FALSE;
+    motor_start_time = now;
 }
 
-/* Check if two password arrays match */
-uint8 check_passwards(uint8 *passward_array1, uint8 *passward_array2) {
-    for (uint8 count = 0; count < PASSWARD_LENGTH; count++) {
-        if (passward_array1[count] != passward_array2[count]) {
-            return NOT_EQUAL_PASS;
+boolean board_is_end_reached(DoorCore_MotorType motion) {
+    return LimitSwitch_isReached((motion == DOOR_CORE_MOTOR_OPEN) ? LIMIT_SWITCH_OPEN : LIMIT_SWITCH_CLOSED);
+}
+
+/* The motion profile watches the current and brakes on a stall */
+boolean board_is_stalled(void) {
+    return Motion_isStalled();
+}
+
+void board_set_buzzer(boolean on) {
+    if (on == TRUE) {
+        Buzzer_on();
+    } else {
+        Buzzer_off();
+    }
+}
+
+boolean board_is_motion(void) {
+    return (PIR_Motion() == MOTION) ? TRUE : FALSE;
+}
+
+/* Measures the wait for no motion after the door hold */
+void board_state_changed(DoorCore_StateType previous, DoorCore_StateType state) {
+    if (state == DOOR_CORE_CLEARING_STATE) {
+        pir_wait_time = SysTime_now();
+    } else if (previous == DOOR_CORE_CLEARING_STATE) {
+        Histogram_record(&latencies[PIR_CLEAR_LATENCY], SysTime_now() - pir_wait_time);
+    }
+}
+
+/*******************************************************************************
+ *                              Helper Functions                               *
+ *******************************************************************************/
+
+#if (PASSWARD_STREAM_ENABLE == 1)
+/*
+ * Receives the keys of a password entry as they are typed into the specified array.
+ * Nothing is answered before the submit key, the result is sent by the caller.
+ * Returns FALSE if the entry was submitted with fewer than PASSWARD_LENGTH keys.
+ */
+boolean receive_passward(uint8 *passward_array) {
+    uint8 byte, count = 0;
+
+    wait_transfer_start();
+    UART_sendByte(READY_BYTE);
+
+    while ((byte = UART_recieveByte()) != KEY_SUBMIT_BYTE) {
+        if (byte == KEY_ERASE_BYTE) {
+            if (count > 0) {
+                count--;
+            }
+        } else if (count < PASSWARD_LENGTH) {
+            passward_array[count++] = byte;
         }
     }
-    return EQUAL_PASS;
+
+    frame_received_time = SysTime_now();
+
+    return (count == PASSWARD_LENGTH) ? TRUE : FALSE;
 }
+#else
+/* Receives a password through UART into the specified array, always complete */
+boolean receive_passward(uint8 *passward_array) {
+    uint32 start_time = 0;
 
-/* Receives a password through UART into the specified array */
-void receive_passward(uint8 *passward_array) {
-    while (UART_recieveByte() != READY_BYTE);
+    wait_transfer_start();
     UART_sendByte(READY_BYTE);
 
     for (uint8 count = 0; count < PASSWARD_LENGTH; count++) {
         passward_array[count] = UART_recieveByte();
+        if (count == 0) {
+            start_time = SysTime_now();
+        }
     }
 
+    frame_received_time = SysTime_now();
+    Histogram_record(&latencies[RECEIVE_LATENCY], frame_received_time - start_time);
     UART_sendByte(DONE_BYTE);
+
+    return TRUE;
 }
+#endif
 
 /* Sends a byte through UART with synchronization */
 void send_byte(uint8 byte) {
+    TRACE(TRACE_EVENT_LINK_TX, byte);
     UART_sendByte(READY_BYTE);
     while (UART_recieveByte() != READY_BYTE);
     UART_sendByte(byte);
@@ -215,21 +462,197 @@ void send_byte(uint8 byte) {
 /* Receives a byte through UART with synchronization */
 uint8 receive_byte() {
     uint8 byte;
-    while (UART_recieveByte() != READY_BYTE);
+    wait_transfer_start();
     UART_sendByte(READY_BYTE);
     byte = UART_recieveByte();
     UART_sendByte(DONE_BYTE);
+    TRACE(TRACE_EVENT_LINK_RX, byte);
     return byte;
 }
 
-/* Timer callback function to increment tick count */
-void Timer_Callbackfunc() {
-    ticks++;
+/* Waits for the HMI to start a transfer, serving the link commands meanwhile */
+void wait_transfer_start(void) {
+    uint8 byte;
+    /*
+     * The link is idle until the HMI starts a transfer, stream the trace meanwhile.
+     * The HMI drops the trace text as it only waits for READY_BYTE.
+     */
+    while (UART_isByteReceived() == FALSE && Trace_drainRecord() == TRUE);
+
+    while ((byte = UART_recieveByte()) != READY_BYTE) {
+        if (byte == STATS_SNAPSHOT_COMMAND) {
+            send_statistics();
+        } else if (byte == STATS_RESET_COMMAND) {
+            reset_statistics();
+        }
+    }
+}
+
+/* Sends a password check result and measures the reply and the whole verification */
+void send_result(uint8 result) {
+    uint32 start_time = SysTime_now();
+
+    Histogram_record(&latencies[COMPARE_LATENCY], start_time - check_start_time);
+
+    send_byte(result);
+    Histogram_record(&latencies[REPLY_LATENCY], SysTime_now() - start_time);
+    Histogram_record(&latencies[VERIFY_LATENCY], SysTime_now() - frame_received_time);
+}
+
+/* Streams all the statistics, the HMI drops the text as it is not a handshake byte */
+void send_statistics(void) {
+    send_latencies();
+    send_state_stats();
+    send_stack_stats();
+    send_power_stats();
+}
+
+void send_latencies(void) {
+    for (uint8 latency = 0; latency < NUM_OF_LATENCIES; latency++) {
+        Histogram_send(&latencies[latency], latency);
+    }
+}
+
+/* Time in each door core state (ms) and the transitions taken, the unused ones are not sent */
+void send_state_stats(void) {
+    const FSM_Type *fsm = DoorCore_getFsm();
+    uint16 count;
+
+    for (FSM_StateType state = DOOR_CORE_NO_STATE + 1; state < DOOR_CORE_NUM_OF_STATES; state++) {
+        Trace_sendValue(TRACE_VALUE_STATE_TIME, state, FSM_getTimeInState(fsm, state));
+        Trace_sendValue(TRACE_VALUE_STATE_ENTRIES, state, state_stats[state].entries);
+        for (FSM_EventType event = 0; event < DOOR_CORE_NUM_OF_EVENTS; event++) {
+            count = FSM_getTransitionCount(fsm, state, event);
+            if (count != 0) {
+                Trace_sendValue(TRACE_VALUE_TRANSITIONS, (state * DOOR_CORE_NUM_OF_EVENTS) + event, count);
+            }
+        }
+    }
+}
+
+/* Stack bytes never used by each task, less than KERNEL_STACK_MARGIN breaks the stack budget */
+void send_stack_stats(void) {
+    const Kernel_TaskType *idle_task = Kernel_getIdleTask();
+
+    Trace_sendValue(TRACE_VALUE_STACK_UNUSED, door_task_tcb.priority, Kernel_getStackUnused(&door_task_tcb));
+    Trace_sendValue(TRACE_VALUE_STACK_UNUSED, link_task_tcb.priority, Kernel_getStackUnused(&link_task_tcb));
+    Trace_sendValue(TRACE_VALUE_STACK_UNUSED, idle_task->priority, Kernel_getStackUnused(idle_task));
+}
+
+/* Time since the statistics reset, time in each sleep mode (ms) and number of sleeps */
+void send_power_stats(void) {
+    Power_StatsType stats;
+
+    Power_getStats(&stats);
+    Trace_sendValue(TRACE_VALUE_POWER_TIME, TRACE_POWER_TOTAL, SYSTIME_LONG_TO_MS(stats.total_time));
+    Trace_sendValue(TRACE_VALUE_POWER_TIME, TRACE_POWER_IDLE, SYSTIME_LONG_TO_MS(stats.idle_time));
+    Trace_sendValue(TRACE_VALUE_POWER_COUNT, TRACE_POWER_IDLE, stats.idle_count);
+    Trace_sendValue(TRACE_VALUE_POWER_TIME, TRACE_POWER_DOWN, SYSTIME_LONG_TO_MS(stats.power_down_time));
+    Trace_sendValue(TRACE_VALUE_POWER_COUNT, TRACE_POWER_DOWN, stats.power_down_count);
+}
+
+void reset_statistics(void) {
+    reset_latencies();
+    DoorCore_resetStats();
+    Power_resetStats();
+}
+
+void reset_latencies(void) {
+    for (uint8 latency = 0; latency < NUM_OF_LATENCIES; latency++) {
+        Histogram_reset(&latencies[latency]);
+    }
+}
+
+#if (DEBOUNCE_BENCHMARK_ENABLE == 1)
+/* Integrators and states of the per-pin debounce of the benchmark */
+uint8 pin_integrators[NUM_OF_PINS_PER_PORT];
+uint8 pin_states;
+
+/*
+ * Times DEBOUNCE_BENCHMARK_SAMPLES samples of the 8 pins of the PIR port with the
+ * vertical counters and with one integrator per pin, and traces the cycles of one sample.
+ * It runs before Debounce_tick is a tick hook, so the interrupt does not sample at the same time.
+ */
+void debounce_benchmark(void) {
+    Debounce_GroupConfigType config = { PIR_PORT_ID, 0xFF, 0, 1, NULL_PTR };
+    uint32 start, counts;
+    uint16 i;
+
+    Debounce_init();
+    Debounce_addGroup(&config);
+    start = SysTime_now();
+    for (i = 0; i < DEBOUNCE_BENCHMARK_SAMPLES; i++) {
+        Debounce_tick();
+    }
+    counts = SysTime_now() - start;
+    TRACE(DEBOUNCE_PORT_CYCLES_EVENT, (uint16)((counts * 256UL) / DEBOUNCE_BENCHMARK_SAMPLES));
+
+    start = SysTime_now();
+    for (i = 0; i < DEBOUNCE_BENCHMARK_SAMPLES; i++) {
+        debounce_pin_reference();
+    }
+    counts = SysTime_now() - start;
+    TRACE(DEBOUNCE_PIN_CYCLES_EVENT, (uint16)((counts * 256UL) / DEBOUNCE_BENCHMARK_SAMPLES));
+}
+
+/* Debounces the 8 pins of the PIR port one by one, a pin read and an integrator per pin */
+void debounce_pin_reference(void) {
+    for (uint8 pin = 0; pin < NUM_OF_PINS_PER_PORT; pin++) {
+        if (GPIO_readPin(PIR_PORT_ID, pin) == LOGIC_HIGH) {
+            if (pin_integrators[pin] < DEBOUNCE_SAMPLES) {
+                pin_integrators[pin]++;
+                if (pin_integrators[pin] == DEBOUNCE_SAMPLES) {
+                    pin_states |= (1 << pin);
+                }
+            }
+        } else if (pin_integrators[pin] > 0) {
+            pin_integrators[pin]--;
+            if (pin_integrators[pin] == 0) {
+                pin_states &= ~(1 << pin);
+            }
+        }
+    }
 }
+#endif
 
-void _delay_seconds(uint8 seconds) {
-    ticks = 0; // Reset tick counter
+#if (PWM_BENCHMARK_ENABLE == 1)
+/* Duty of the former driver, the output of the reference */
+volatile uint8 pwm_reference_output;
 
-    while (ticks < seconds); // Wait until the desired seconds have passed
+/*
+ * Times PWM_BENCHMARK_UPDATES duty updates over 0 to 100 percent with the table of the
+ * PWM driver and with the former computation, and traces the cycles of one update.
+ * The motor is stopped, only the enable output changes.
+ */
+void pwm_benchmark(void) {
+    uint32 start, counts;
+    uint8 percent = 0;
+    uint16 i;
+
+    start = SysTime_now();
+    for (i = 0; i < PWM_BENCHMARK_UPDATES; i++) {
+        PWM_setDutyPercent(percent);
+        percent = (percent < 100) ? (percent + 1) : 0;
+    }
+    counts = SysTime_now() - start;
+    TRACE(PWM_UPDATE_CYCLES_EVENT, (uint16)((counts * 256UL) / PWM_BENCHMARK_UPDATES));
+
+    start = SysTime_now();
+    for (i = 0; i < PWM_BENCHMARK_UPDATES; i++) {
+        pwm_duty_reference(percent);
+        percent = (percent < 100) ? (percent + 1) : 0;
+    }
+    counts = SysTime_now() - start;
+    TRACE(PWM_REFERENCE_CYCLES_EVENT, (uint16)((counts * 256UL) / PWM_BENCHMARK_UPDATES));
+
+    PWM_setDuty(0);
 }
 
+/* Percent to an 8-bit compare value as the former PWM_Set_Duty_Cycle did it */
+void pwm_duty_reference(uint8 duty_cycle) {
+    if (duty_cycle > 100) {
+        duty_cycle = 100;
+    }
+    pwm_reference_output = (uint8)(((uint16)255 * duty_cycle) / 100);
+}
+#endif
@@ -11,160 +11,440 @@
  *******************************************************************************/
 #include "keypad.h"
 #include "gpio.h"
-#include <util/delay.h>
+#include "registers.h" /* For the external interrupt registers */
+#include <avr/pgmspace.h> /* For the key map */
+#if (KEYPAD_WAKE_ENABLE == 1)
+#include <avr/interrupt.h> /* For the wake interrupt */
+#include <util/delay.h> /* For the settling delay */
+#include "systime.h"
+#include "trace.h"
+#endif
 
 /*******************************************************************************
- *                      Functions Prototypes(Private)                          *
+ *                                Definitions                                  *
  *******************************************************************************/
 
-#ifndef STANDARD_KEYPAD
+/* Column input register, the columns of a row are read with one PIN read */
+#define KEYPAD_COL_PIN_REG                GPIO_PIN_REG(KEYPAD_COL_PORT_ID)
+
+#if ((KEYPAD_FIRST_ROW_PIN_ID + KEYPAD_NUM_ROWS) > NUM_OF_PINS_PER_PORT) || \
+    ((KEYPAD_FIRST_COL_PIN_ID + KEYPAD_NUM_COLS) > NUM_OF_PINS_PER_PORT)
+#error "The keypad rows and columns must fit in their port"
+#endif
+
+/* Row and column pins, they are consecutive from the first pin */
+#define KEYPAD_ROW_MASK                   ((uint8)(((1 << KEYPAD_NUM_ROWS) - 1) << KEYPAD_FIRST_ROW_PIN_ID))
+#define KEYPAD_COLS_BITS                  ((uint8)((1 << KEYPAD_NUM_COLS) - 1))
+#define KEYPAD_COL_MASK                   ((uint8)(KEYPAD_COLS_BITS << KEYPAD_FIRST_COL_PIN_ID))
+
+/* Drive one row and release the others with a single masked direction write */
+#define KEYPAD_DRIVE_ROW(row) \
+	GPIO_PORT_DIRECTION_MASKED(KEYPAD_ROW_PORT_ID,KEYPAD_ROW_MASK,(1 << (KEYPAD_FIRST_ROW_PIN_ID + (row))))
+
+#if (KEYPAD_WAKE_ENABLE == 1)
+
+/* Wake interrupt and its pin */
+#if (KEYPAD_WAKE_INT_ID == 0)
+#define KEYPAD_WAKE_VECTOR                INT0_vect
+#define KEYPAD_WAKE_INT_BIT               INT0
+#define KEYPAD_WAKE_FLAG_BIT              INTF0
+#define KEYPAD_WAKE_PORT_ID               PORTD_ID
+#define KEYPAD_WAKE_PIN_ID                PIN2_ID
+#elif (KEYPAD_WAKE_INT_ID == 1)
+#define KEYPAD_WAKE_VECTOR                INT1_vect
+#define KEYPAD_WAKE_INT_BIT               INT1
+#define KEYPAD_WAKE_FLAG_BIT              INTF1
+#define KEYPAD_WAKE_PORT_ID               PORTD_ID
+#define KEYPAD_WAKE_PIN_ID                PIN3_ID
+#elif (KEYPAD_WAKE_INT_ID == 2)
+#define KEYPAD_WAKE_VECTOR                INT2_vect
+#define KEYPAD_WAKE_INT_BIT               INT2
+#define KEYPAD_WAKE_FLAG_BIT              INTF2
+#define KEYPAD_WAKE_PORT_ID               PORTB_ID
+#define KEYPAD_WAKE_PIN_ID                PIN2_ID
+#else
+#error "Invalid keypad wake interrupt"
+#endif
+
+#if ((KEYPAD_WAKE_PORT_ID == KEYPAD_ROW_PORT_ID) && (KEYPAD_WAKE_PIN_ID >= KEYPAD_FIRST_ROW_PIN_ID) && \
+     (KEYPAD_WAKE_PIN_ID < KEYPAD_FIRST_ROW_PIN_ID + KEYPAD_NUM_ROWS)) || \
+    ((KEYPAD_WAKE_PORT_ID == KEYPAD_COL_PORT_ID) && (KEYPAD_WAKE_PIN_ID >= KEYPAD_FIRST_COL_PIN_ID) && \
+     (KEYPAD_WAKE_PIN_ID < KEYPAD_FIRST_COL_PIN_ID + KEYPAD_NUM_COLS))
+#error "The keypad wake interrupt pin is a row or column pin"
+#endif
+
+/* Time for the rows and the diode-OR to settle once all the rows are driven */
+#define KEYPAD_WAKE_SETTLE_US             5
+
+#endif /* KEYPAD_WAKE_ENABLE */
+
+/* Set in the FIFO entries of the release events */
+#define KEYPAD_RELEASE_FLAG               0x80
+
+#define KEYPAD_NUM_KEYS                   (KEYPAD_NUM_ROWS * KEYPAD_NUM_COLS)
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+/* Called by KEYPAD_getPressedKey while the FIFO is empty, NULL_PTR to busy wait */
+static void (*volatile g_idleCallBackPtr)(void) = NULL_PTR;
+
+/* Button numbers (1 to KEYPAD_NUM_KEYS) with KEYPAD_RELEASE_FLAG, written by the ISR only at the head */
+static volatile uint8 g_events[KEYPAD_FIFO_SIZE];
+static volatile uint8 g_eventsHead = 0;
+static volatile uint8 g_eventsTail = 0;
 
+/* Debounce state of each key, only used by KEYPAD_tick */
+static uint8 g_integrators[KEYPAD_NUM_KEYS];
+/* One bit per column: keys pressed, and keys being debounced (pressed or integrator not 0) */
+static uint8 g_pressedColumns[KEYPAD_NUM_ROWS];
+static uint8 g_activeColumns[KEYPAD_NUM_ROWS];
+/* Row driven since the previous tick */
+static uint8 g_row = 0;
+
+#if (KEYPAD_WAKE_ENABLE == 1)
+/* Time of the wake interrupt, the next tick traces the latency to the first scan */
+static volatile uint32 g_wakeTime = 0;
+static volatile boolean g_wakePending = FALSE;
+#endif
+
+#ifndef STANDARD_KEYPAD
+/* Key value of each button number - 1, as drawn on the keypad used in proteus */
+static const uint8 g_keyMap[KEYPAD_NUM_KEYS] PROGMEM =
+{
 #if (KEYPAD_NUM_COLS == 3)
-/*
- * Function responsible for mapping the switch number in the keypad to
- * its corresponding functional number in the proteus for 4x3 keypad
- */
-static uint8 KEYPAD_4x3_adjustKeyNumber(uint8 button_number);
+	1,   2,   3,
+	4,   5,   6,
+	7,   8,   9,
+	'*', 0,   '#'
 #elif (KEYPAD_NUM_COLS == 4)
-/*
- * Function responsible for mapping the switch number in the keypad to
- * its corresponding functional number in the proteus for 4x4 keypad
- */
-static uint8 KEYPAD_4x4_adjustKeyNumber(uint8 button_number);
+	7,   8,   9,   '%',
+	4,   5,   6,   '*',
+	1,   2,   3,   '-',
+	13,  0,   '=', '+'   /* 13 is the ASCII of Enter */
 #endif
-
+};
 #endif /* STANDARD_KEYPAD */
 
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static void KEYPAD_debounce(uint8 col, uint8 index, boolean pressed);
+static void KEYPAD_pushEvent(uint8 entry);
+#if (KEYPAD_WAKE_ENABLE == 1)
+static void KEYPAD_disarmWake(void);
+#endif
+
 /*******************************************************************************
  *                      Functions Definitions                                  *
  *******************************************************************************/
 
-uint8 KEYPAD_getPressedKey(void)
+/*
+ * Description :
+ * Set the function called by KEYPAD_getPressedKey while no key is pressed (e.g. Power_idle).
+ */
+void KEYPAD_setIdleCallBack(void (*a_ptr)(void))
 {
-	uint8 col,row;
-	GPIO_setupPinDirection(KEYPAD_ROW_PORT_ID, KEYPAD_FIRST_ROW_PIN_ID, PIN_INPUT);
-	GPIO_setupPinDirection(KEYPAD_ROW_PORT_ID, KEYPAD_FIRST_ROW_PIN_ID+1, PIN_INPUT);
-	GPIO_setupPinDirection(KEYPAD_ROW_PORT_ID, KEYPAD_FIRST_ROW_PIN_ID+2, PIN_INPUT);
-	GPIO_setupPinDirection(KEYPAD_ROW_PORT_ID, KEYPAD_FIRST_ROW_PIN_ID+3, PIN_INPUT);
-
-	GPIO_setupPinDirection(KEYPAD_COL_PORT_ID, KEYPAD_FIRST_COL_PIN_ID, PIN_INPUT);
-	GPIO_setupPinDirection(KEYPAD_COL_PORT_ID, KEYPAD_FIRST_COL_PIN_ID+1, PIN_INPUT);
-	GPIO_setupPinDirection(KEYPAD_COL_PORT_ID, KEYPAD_FIRST_COL_PIN_ID+2, PIN_INPUT);
-#if(KEYPAD_NUM_COLS == 4)
-	GPIO_setupPinDirection(KEYPAD_COL_PORT_ID, KEYPAD_FIRST_COL_PIN_ID+3, PIN_INPUT);
+	g_idleCallBackPtr = a_ptr;
+}
+
+/*
+ * Description :
+ * Setup the keypad pins, clear the debounce state and the events FIFO.
+ * KEYPAD_tick must then be called periodically (e.g. from a SysTime tick hook).
+ */
+void KEYPAD_init(void)
+{
+	uint8 i;
+
+	/* Rows and columns are inputs, the rows output the pressed level once they are outputs */
+	GPIO_PORT_DIRECTION_MASKED(KEYPAD_COL_PORT_ID,KEYPAD_COL_MASK,PORT_INPUT);
+	GPIO_PORT_DIRECTION_MASKED(KEYPAD_ROW_PORT_ID,KEYPAD_ROW_MASK,PORT_INPUT);
+#if (KEYPAD_BUTTON_PRESSED == LOGIC_LOW)
+	GPIO_WRITE_PORT_MASKED(KEYPAD_ROW_PORT_ID,KEYPAD_ROW_MASK,0);
+#else
+	GPIO_WRITE_PORT_MASKED(KEYPAD_ROW_PORT_ID,KEYPAD_ROW_MASK,KEYPAD_ROW_MASK);
 #endif
-	while(1)
+
+	for(i = 0; i < KEYPAD_NUM_KEYS; i++)
+	{
+		g_integrators[i] = 0;
+	}
+	for(i = 0; i < KEYPAD_NUM_ROWS; i++)
+	{
+		g_pressedColumns[i] = 0;
+		g_activeColumns[i] = 0;
+	}
+	g_eventsHead = 0;
+	g_eventsTail = 0;
+
+	/* Drive the first row, it is read on the first tick */
+	g_row = 0;
+	KEYPAD_DRIVE_ROW(g_row);
+}
+
+/*
+ * Description :
+ * Scan one row and debounce its keys, called from the timer interrupt.
+ * Press and release events are added to the FIFO (dropped if it is full).
+ */
+void KEYPAD_tick(void)
+{
+	uint8 columns;
+	uint8 keys;
+	uint8 col;
+	uint8 index;
+
+#if (KEYPAD_WAKE_ENABLE == 1)
+	if(g_wakePending == TRUE)
+	{
+		g_wakePending = FALSE;
+		TRACE(TRACE_EVENT_KEYPAD_WAKE, (uint16)(SysTime_now() - g_wakeTime));
+	}
+#endif
+
+	/* The row was driven one tick ago, the column lines had the time to settle.
+	 * Read all the columns at once, one bit per column set if its key is pressed */
+#if (KEYPAD_BUTTON_PRESSED == LOGIC_LOW)
+	columns = (uint8)(~REG_READ(KEYPAD_COL_PIN_REG) >> KEYPAD_FIRST_COL_PIN_ID) & KEYPAD_COLS_BITS;
+#else
+	columns = (uint8)(REG_READ(KEYPAD_COL_PIN_REG) >> KEYPAD_FIRST_COL_PIN_ID) & KEYPAD_COLS_BITS;
+#endif
+
+	/* Only the keys read pressed or still being debounced need work, in the usual
+	 * case (no key) the loop is skipped. The lowest key left is found by shifting
+	 * both masks until no key is left */
+	keys = columns | g_activeColumns[g_row];
+	col = 0;
+	index = g_row * KEYPAD_NUM_COLS;
+	while(keys != 0)
 	{
-		for(row=0 ; row<KEYPAD_NUM_ROWS ; row++) /* loop for rows */
+		if(keys & 1)
 		{
-			/* 
-			 * Each time setup the direction for all keypad port as input pins,
-			 * except this row will be output pin
-			 */
-			GPIO_setupPinDirection(KEYPAD_ROW_PORT_ID,KEYPAD_FIRST_ROW_PIN_ID+row,PIN_OUTPUT);
+			KEYPAD_debounce(col, index, (columns & 1) ? TRUE : FALSE);
+		}
+		keys >>= 1;
+		columns >>= 1;
+		col++;
+		index++;
+	}
+
+	/* Release this row and drive the next one */
+	g_row++;
+	if(g_row == KEYPAD_NUM_ROWS)
+	{
+		g_row = 0;
+	}
+	KEYPAD_DRIVE_ROW(g_row);
+}
+
+/*
+ * Description :
+ * Get the oldest key event without waiting.
+ * Returns FALSE if there is no event.
+ */
+boolean KEYPAD_getEvent(KEYPAD_EventType *event)
+{
+	uint8 entry;
 
-			/* Set/Clear the row output pin */
-			GPIO_writePin(KEYPAD_ROW_PORT_ID, KEYPAD_FIRST_ROW_PIN_ID+row, KEYPAD_BUTTON_PRESSED);
+	if(g_eventsTail == g_eventsHead)
+	{
+		return FALSE;
+	}
+	entry = g_events[g_eventsTail];
+	g_eventsTail = (g_eventsTail + 1) & (KEYPAD_FIFO_SIZE - 1);
 
-			for(col=0 ; col<KEYPAD_NUM_COLS ; col++) /* loop for columns */
+	event->pressed = (entry & KEYPAD_RELEASE_FLAG) ? FALSE : TRUE;
+	entry &= ~KEYPAD_RELEASE_FLAG;
+#ifdef STANDARD_KEYPAD
+	event->key = entry;
+#else
+	event->key = pgm_read_byte(&g_keyMap[entry - 1]);
+#endif
+	return TRUE;
+}
+
+/*
+ * Description :
+ * Drop the events not read yet (keys pressed before a prompt is shown).
+ */
+void KEYPAD_clearEvents(void)
+{
+	g_eventsTail = g_eventsHead;
+}
+
+/*
+ * Description :
+ * Wait for the next key press and return its value, the releases are skipped.
+ */
+uint8 KEYPAD_getPressedKey(void)
+{
+	KEYPAD_EventType event;
+	void (*idle_callback)(void);
+
+	while(1)
+	{
+		if(KEYPAD_getEvent(&event) == TRUE)
+		{
+			if(event.pressed == TRUE)
+			{
+				return event.key;
+			}
+		}
+		else
+		{
+			idle_callback = g_idleCallBackPtr;
+			if(idle_callback != NULL_PTR)
 			{
-				/* Check if the switch is pressed in this column */
-				if(GPIO_readPin(KEYPAD_COL_PORT_ID,KEYPAD_FIRST_COL_PIN_ID+col) == KEYPAD_BUTTON_PRESSED)
-				{
-					#if (KEYPAD_NUM_COLS == 3)
-						#ifdef STANDARD_KEYPAD
-							return ((row*KEYPAD_NUM_COLS)+col+1);
-						#else
-							return KEYPAD_4x3_adjustKeyNumber((row*KEYPAD_NUM_COLS)+col+1);
-						#endif
-					#elif (KEYPAD_NUM_COLS == 4)
-						#ifdef STANDARD_KEYPAD
-							return ((row*KEYPAD_NUM_COLS)+col+1);
-						#else
-							return KEYPAD_4x4_adjustKeyNumber((row*KEYPAD_NUM_COLS)+col+1);
-						#endif
-					#endif
-				}
+				idle_callback(); /* Sleep until the next interrupt (at most one timer tick) */
 			}
-			GPIO_setupPinDirection(KEYPAD_ROW_PORT_ID,KEYPAD_FIRST_ROW_PIN_ID+row,PIN_INPUT);
-			_delay_ms(5); /* Add small delay to fix CPU load issue in proteus */
 		}
-	}	
+	}
 }
 
-#ifndef STANDARD_KEYPAD
-
-#if (KEYPAD_NUM_COLS == 3)
+#if (KEYPAD_WAKE_ENABLE == 1)
 /*
  * Description :
- * Update the keypad pressed button value with the correct one in keypad 4x3 shape
+ * Power-down prepare callback, called with interrupts disabled: drive all the rows
+ * and arm the wake interrupt. Returns FALSE (stay awake) while a key is down or once
+ * a key woke the MCU.
  */
-static uint8 KEYPAD_4x3_adjustKeyNumber(uint8 button_number)
+boolean KEYPAD_prepareWake(void)
 {
-	uint8 keypad_button = 0;
-	switch(button_number)
+	uint8 row;
+
+	/* Called again after the other wake ups of the power-down */
+	if(g_wakePending == TRUE)
 	{
-		case 10: keypad_button = '*'; // ASCII Code of *
-				 break;
-		case 11: keypad_button = 0;
-				 break;		
-		case 12: keypad_button = '#'; // ASCII Code of #
-				 break;
-		default: keypad_button = button_number;
-				break;
+		return FALSE;
 	}
-	return keypad_button;
-} 
 
-#elif (KEYPAD_NUM_COLS == 4)
+	for(row = 0; row < KEYPAD_NUM_ROWS; row++)
+	{
+		if(g_activeColumns[row] != 0)
+		{
+			return FALSE; /* A key is pressed or still being debounced */
+		}
+	}
+
+	/* Any pressed key now pulls its column and the interrupt pin low */
+	GPIO_PIN_INPUT(KEYPAD_WAKE_PORT_ID,KEYPAD_WAKE_PIN_ID);
+	GPIO_SET_PIN(KEYPAD_WAKE_PORT_ID,KEYPAD_WAKE_PIN_ID); /* Pull-up */
+	GPIO_PORT_DIRECTION_MASKED(KEYPAD_ROW_PORT_ID,KEYPAD_ROW_MASK,PORT_OUTPUT);
+
+#if (KEYPAD_WAKE_INT_ID == 0)
+	REG_CLEAR_BITS(MCUCR,(1 << ISC01) | (1 << ISC00)); /* Low level, the only INT0 sense that wakes from power-down */
+#elif (KEYPAD_WAKE_INT_ID == 1)
+	REG_CLEAR_BITS(MCUCR,(1 << ISC11) | (1 << ISC10)); /* Low level, the only INT1 sense that wakes from power-down */
+#else
+	REG_CLEAR_BIT(MCUCSR,ISC2); /* Falling edge, asynchronous so it wakes from power-down */
+#endif
+	REG_WRITE(GIFR,(1 << KEYPAD_WAKE_FLAG_BIT));
+	REG_SET_BIT(GICR,KEYPAD_WAKE_INT_BIT);
+
+	/* There is no edge for a key pressed before the interrupt is armed (INT2), read
+	 * the pin once the lines settled */
+	_delay_us(KEYPAD_WAKE_SETTLE_US);
+	if(GPIO_READ_PIN(KEYPAD_WAKE_PORT_ID,KEYPAD_WAKE_PIN_ID) == LOGIC_LOW)
+	{
+		KEYPAD_disarmWake();
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/*
+ * Description :
+ * Power-down resume callback: disarm the wake interrupt and go back to one row per tick.
+ * The time from the wake interrupt to the first scan is traced (TRACE_EVENT_KEYPAD_WAKE).
+ */
+void KEYPAD_resumeScan(void)
+{
+	uint8 sreg = SREG;
+
+	/* Already done by the interrupt when a key woke the MCU */
+	cli();
+	KEYPAD_disarmWake();
+	SREG = sreg;
+}
+
+/*
+ * Description :
+ * A key was pressed in power-down. The low level keeps requesting the interrupt,
+ * so it is disarmed here and the scanner takes over on the next tick.
+ */
+ISR(KEYPAD_WAKE_VECTOR)
+{
+	KEYPAD_disarmWake();
+	g_wakeTime = SysTime_now();
+	g_wakePending = TRUE;
+}
+#endif /* KEYPAD_WAKE_ENABLE */
+
+/*******************************************************************************
+ *                      Private Functions Definitions                          *
+ *******************************************************************************/
 
 /*
  * Description :
- * Update the keypad pressed button value with the correct one in keypad 4x4 shape
+ * Integrator debounce of the key at column col of the scanned row (index = button number - 1):
+ * the counter moves one step toward the read level on each scan, the key changes state
+ * when the counter reaches an end.
  */
-static uint8 KEYPAD_4x4_adjustKeyNumber(uint8 button_number)
+static void KEYPAD_debounce(uint8 col, uint8 index, boolean pressed)
+{
+	uint8 bit = (1 << col);
+
+	if(pressed == TRUE)
+	{
+		if(g_integrators[index] < KEYPAD_DEBOUNCE_SCANS)
+		{
+			g_integrators[index]++;
+			g_activeColumns[g_row] |= bit;
+			if((g_integrators[index] == KEYPAD_DEBOUNCE_SCANS) && !(g_pressedColumns[g_row] & bit))
+			{
+				g_pressedColumns[g_row] |= bit;
+				KEYPAD_pushEvent(index + 1);
+			}
+		}
+	}
+	else if(g_integrators[index] > 0)
+	{
+		g_integrators[index]--;
+		if(g_integrators[index] == 0)
+		{
+			g_activeColumns[g_row] &= ~bit;
+			if(g_pressedColumns[g_row] & bit)
+			{
+				g_pressedColumns[g_row] &= ~bit;
+				KEYPAD_pushEvent((index + 1) | KEYPAD_RELEASE_FLAG);
+			}
+		}
+	}
+}
+
+static void KEYPAD_pushEvent(uint8 entry)
 {
-	uint8 keypad_button = 0;
-	switch(button_number)
+	uint8 next = (g_eventsHead + 1) & (KEYPAD_FIFO_SIZE - 1);
+
+	if(next != g_eventsTail)
 	{
-		case 1: keypad_button = 7;
-				break;
-		case 2: keypad_button = 8;
-				break;
-		case 3: keypad_button = 9;
-				break;
-		case 4: keypad_button = '%'; // ASCII Code of %
-				break;
-		case 5: keypad_button = 4;
-				break;
-		case 6: keypad_button = 5;
-				break;
-		case 7: keypad_button = 6;
-				break;
-		case 8: keypad_button = '*'; /* ASCII Code of '*' */
-				break;		
-		case 9: keypad_button = 1;
-				break;
-		case 10: keypad_button = 2;
-				break;
-		case 11: keypad_button = 3;
-				break;
-		case 12: keypad_button = '-'; /* ASCII Code of '-' */
-				break;
-		case 13: keypad_button = 13;  /* ASCII of Enter */
-				break;			
-		case 14: keypad_button = 0;
-				break;
-		case 15: keypad_button = '='; /* ASCII Code of '=' */
-				break;
-		case 16: keypad_button = '+'; /* ASCII Code of '+' */
-				break;
-		default: keypad_button = button_number;
-				break;
+		g_events[g_eventsHead] = entry;
+		g_eventsHead = next;
 	}
-	return keypad_button;
-} 
+}
 
+#if (KEYPAD_WAKE_ENABLE == 1)
+/*
+ * Description :
+ * Disable the wake interrupt and drive the row scanned on the next tick only.
+ * Called with interrupts disabled.
+ */
+static void KEYPAD_disarmWake(void)
+{
+	REG_CLEAR_BIT(GICR,KEYPAD_WAKE_INT_BIT);
+	KEYPAD_DRIVE_ROW(g_row);
+}
 #endif
-
-#endif /* STANDARD_KEYPAD */
@@ -34,14 +34,108 @@
 #define KEYPAD_BUTTON_PRESSED            LOGIC_LOW
 #define KEYPAD_BUTTON_RELEASED           LOGIC_HIGH
 
+/*
+ * Background scanner: KEYPAD_tick is called from a periodic interrupt and scans one row
+ * per call. A key is pressed (or released) once it is read in the same state on
+ * KEYPAD_DEBOUNCE_SCANS full scans in a row.
+ */
+#define KEYPAD_DEBOUNCE_SCANS             3
+
+/* Number of events waiting to be read, must be a power of 2 */
+#define KEYPAD_FIFO_SIZE                  8
+
+/*
+ * Wake on key press: while the MCU is powered down all the rows are driven and the
+ * column lines, joined by a diode-OR (cathodes on the columns), pull an external
+ * interrupt pin low. KEYPAD_prepareWake/KEYPAD_resumeScan are the Power module
+ * power-down callbacks. The interrupt pin uses its internal pull-up.
+ * Press to first scan = oscillator start-up (SUT fuses, 6 CK + 4.1ms or less, not the
+ * 65ms setting) + at most one SysTime tick.
+ * Hardware needed, not on the current board: one diode per column line, anodes joined
+ * on the KEYPAD_WAKE_INT_ID pin (PD2 for INT0), and the 32.768 kHz crystal of the
+ * power-down clock (LIB/power.h). Without them no key wakes the MCU, so it stays off
+ * and the HMI only sleeps in idle mode. The host board (Tools/host/hmi_board.c) models
+ * the diode-OR, build with -DKEYPAD_WAKE_ENABLE=1 to run it there.
+ */
+#ifndef KEYPAD_WAKE_ENABLE
+#define KEYPAD_WAKE_ENABLE                0
+#endif
+
+/*
+ * External interrupt of the diode-OR: 0 = INT0 (PD2), 1 = INT1 (PD3), 2 = INT2 (PB2).
+ * INT0/INT1 wake on the low level, INT2 on the falling edge. PB2 is a row pin with
+ * the keypad on PORTB, move the rows to use INT2.
+ */
+#define KEYPAD_WAKE_INT_ID                0
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+typedef struct
+{
+	uint8 key;          /* Key value, as returned by KEYPAD_getPressedKey */
+	boolean pressed;    /* TRUE for a press, FALSE for a release */
+}KEYPAD_EventType;
+
 /*******************************************************************************
  *                      Functions Prototypes                                   *
  *******************************************************************************/
 
 /*
  * Description :
- * Get the Keypad pressed button
+ * Setup the keypad pins, clear the debounce state and the events FIFO.
+ * KEYPAD_tick must then be called periodically (e.g. from a SysTime tick hook).
+ */
+void KEYPAD_init(void);
+
+/*
+ * Description :
+ * Scan one row and debounce its keys, called from the timer interrupt.
+ * Press and release events are added to the FIFO (dropped if it is full).
+ */
+void KEYPAD_tick(void);
+
+/*
+ * Description :
+ * Get the oldest key event without waiting.
+ * Returns FALSE if there is no event.
+ */
+boolean KEYPAD_getEvent(KEYPAD_EventType *event);
+
+/*
+ * Description :
+ * Drop the events not read yet (keys pressed before a prompt is shown).
+ */
+void KEYPAD_clearEvents(void);
+
+/*
+ * Description :
+ * Wait for the next key press and return its value, the releases are skipped.
  */
 uint8 KEYPAD_getPressedKey(void);
 
+/*
+ * Description :
+ * Set the function called by KEYPAD_getPressedKey while no key is pressed (e.g. Power_idle).
+ */
+void KEYPAD_setIdleCallBack(void (*a_ptr)(void));
+
+#if (KEYPAD_WAKE_ENABLE == 1)
+/*
+ * Description :
+ * Power-down prepare callback, called with interrupts disabled: drive all the rows
+ * and arm the wake interrupt. Returns FALSE (stay awake) while a key is down or once
+ * a key woke the MCU.
+ */
+boolean KEYPAD_prepareWake(void);
+
+/*
+ * Description :
+ * Power-down resume callback: disarm the wake interrupt and go back to one row per tick.
+ * The time from the wake interrupt to the first scan is traced (TRACE_EVENT_KEYPAD_WAKE).
+ */
+void KEYPAD_resumeScan(void);
+#endif
+
 #endif /* KEYPAD_H_ */
@@ -14,6 +14,115 @@
 #include "common_macros.h" /* For GET_BIT Macro */
 #include "lcd.h"
 #include "gpio.h"
+#include "trace.h"
+#include <avr/io.h> /* To use the SREG register */
+#include <avr/interrupt.h> /* For cli() */
+#include <avr/pgmspace.h> /* For the flash strings */
+#include <avr/cpufunc.h> /* For _NOP() */
+#if (LCD_ASYNC_ENABLE == 1)
+#include "timer.h"
+#endif
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#if (LCD_DATA_BITS_MODE == 4)
+
+/* The 4 data pins, written together in one masked port write */
+#define LCD_DATA_MASK                  ((uint8)((1 << LCD_DB4_PIN_ID) | (1 << LCD_DB5_PIN_ID) | \
+                                                (1 << LCD_DB6_PIN_ID) | (1 << LCD_DB7_PIN_ID)))
+
+/* Move the nibble bits to the data pins, a single shift if the pins are in order */
+#if ((LCD_DB5_PIN_ID == LCD_DB4_PIN_ID + 1) && (LCD_DB6_PIN_ID == LCD_DB4_PIN_ID + 2) && \
+     (LCD_DB7_PIN_ID == LCD_DB4_PIN_ID + 3))
+#define LCD_NIBBLE_TO_PORT(nibble)     ((uint8)((nibble) << LCD_DB4_PIN_ID))
+#else
+#define LCD_NIBBLE_TO_PORT(nibble)     ((uint8)((GET_BIT((nibble),0) << LCD_DB4_PIN_ID) | \
+                                                (GET_BIT((nibble),1) << LCD_DB5_PIN_ID) | \
+                                                (GET_BIT((nibble),2) << LCD_DB6_PIN_ID) | \
+                                                (GET_BIT((nibble),3) << LCD_DB7_PIN_ID)))
+#endif
+
+#endif
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static void LCD_output(uint8 value, uint8 rs_value);
+static void LCD_write(uint8 value, uint8 rs_value);
+static void LCD_writeBus(uint8 value);
+#if (LCD_DATA_BITS_MODE == 4)
+static void LCD_writeNibble(uint8 nibble);
+#endif
+static void LCD_trackCommand(uint8 command);
+static void LCD_trackCharacter(uint8 data);
+#if (LCD_RW_PIN_ENABLE == 1)
+static void LCD_waitReady(void);
+static uint8 LCD_readBusyFlag(void);
+static void LCD_setupDataDirection(GPIO_PinDirectionType direction);
+#endif
+#if (LCD_ASYNC_ENABLE == 1)
+static void LCD_enqueue(uint16 entry);
+static void LCD_drainQueue(void);
+static void LCD_asyncTick(void);
+#endif
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+#if (LCD_RW_PIN_ENABLE == 1)
+/* The busy flag can only be read once the data length is set by the function set command */
+static boolean g_busyFlagValid = FALSE;
+#endif
+
+/* Marks the cursor as not in the visible DDRAM (CGRAM access or unknown position) */
+#define LCD_CURSOR_UNKNOWN             0xFF
+
+/* What the application draws and what the LCD shows, the difference is sent by LCD_flush */
+static uint8 g_frameBuffer[LCD_ROWS][LCD_COLS];
+static uint8 g_screen[LCD_ROWS][LCD_COLS];
+/* FALSE when the screen content is not known, the next flush sends all the cells */
+static boolean g_screenValid = FALSE;
+/* Cursor (address counter) position, followed on every command and character */
+static uint8 g_cursorRow = LCD_CURSOR_UNKNOWN;
+static uint8 g_cursorCol = 0;
+
+static LCD_FlushStatsType g_flushStats;
+
+/* Flash address of the glyph loaded in each CGRAM slot, NULL_PTR if not known */
+static const uint8 *g_glyphs[LCD_NUM_GLYPHS];
+
+/* Partial progress bar cells, 1 to 4 columns filled, the last row is left for the cursor */
+static const uint8 g_progressGlyphs[LCD_PROGRESS_CELL_COLUMNS - 1][LCD_GLYPH_ROWS] PROGMEM = {
+	{ 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x00 },
+	{ 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x00 },
+	{ 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x00 },
+	{ 0x1E, 0x1E, 0x1E, 0x1E, 0x1E, 0x1E, 0x1E, 0x00 }
+};
+
+/* Full cell from the character ROM */
+#define LCD_FULL_BLOCK                 0xFF
+
+#if (LCD_ASYNC_ENABLE == 1)
+/* Queue entry: the byte in the low 8 bits, RS in bit 8 */
+#define LCD_QUEUE_DATA_FLAG            0x0100
+
+/* Ticks to skip after a clear or home command, the write tick itself is the first one */
+#define LCD_CLEAR_WAIT_TICKS           (((LCD_CLEAR_EXECUTION_TIME_US + LCD_ASYNC_TICK_US - 1) / LCD_ASYNC_TICK_US) - 1)
+
+static uint16 g_queue[LCD_QUEUE_SIZE];
+/* Head written by the application only, tail by the timer ISR only */
+static volatile uint8 g_queueHead = 0;
+static volatile uint8 g_queueTail = 0;
+static volatile uint8 g_waitTicks = 0;
+/* TRUE while the timer is stopped, the queue is then empty and the LCD ready */
+static volatile boolean g_lcdIdle = TRUE;
+/* The writes of LCD_init are blocking, the queue is used after it */
+static boolean g_asyncStarted = FALSE;
+#endif
 
 /*******************************************************************************
  *                      Functions Definitions                                  *
@@ -27,37 +136,69 @@
  */
 void LCD_init(void)
 {
+	uint8 i;
+
 	/* Configure the direction for RS and E pins as output pins */
-	GPIO_setupPinDirection(LCD_RS_PORT_ID,LCD_RS_PIN_ID,PIN_OUTPUT);
-	GPIO_setupPinDirection(LCD_E_PORT_ID,LCD_E_PIN_ID,PIN_OUTPUT);
+	GPIO_PIN_OUTPUT(LCD_RS_PORT_ID,LCD_RS_PIN_ID);
+	GPIO_PIN_OUTPUT(LCD_E_PORT_ID,LCD_E_PIN_ID);
+
+#if (LCD_RW_PIN_ENABLE == 1)
+	/* Write mode by default, the busy flag is read only while waiting */
+	GPIO_PIN_OUTPUT(LCD_RW_PORT_ID,LCD_RW_PIN_ID);
+	GPIO_CLEAR_PIN(LCD_RW_PORT_ID,LCD_RW_PIN_ID);
+#endif
 
 	_delay_ms(20);		/* LCD Power ON delay always > 15ms */
 
 #if(LCD_DATA_BITS_MODE == 4)
 	/* Configure 4 pins in the data port as output pins */
-	GPIO_setupPinDirection(LCD_DATA_PORT_ID,LCD_DB4_PIN_ID,PIN_OUTPUT);
-	GPIO_setupPinDirection(LCD_DATA_PORT_ID,LCD_DB5_PIN_ID,PIN_OUTPUT);
-	GPIO_setupPinDirection(LCD_DATA_PORT_ID,LCD_DB6_PIN_ID,PIN_OUTPUT);
-	GPIO_setupPinDirection(LCD_DATA_PORT_ID,LCD_DB7_PIN_ID,PIN_OUTPUT);
+	GPIO_PORT_DIRECTION_MASKED(LCD_DATA_PORT_ID,LCD_DATA_MASK,PORT_OUTPUT);
 
-	/* Send for 4 bit initialization of LCD  */
-	LCD_sendCommand(LCD_TWO_LINES_FOUR_BITS_MODE_INIT1);
-	LCD_sendCommand(LCD_TWO_LINES_FOUR_BITS_MODE_INIT2);
+	/*
+	 * Send for 4 bit initialization of LCD, the nibbles of LCD_TWO_LINES_FOUR_BITS_MODE_INIT1
+	 * and LCD_TWO_LINES_FOUR_BITS_MODE_INIT2 sent one by one with the reset timings
+	 */
+	GPIO_CLEAR_PIN(LCD_RS_PORT_ID,LCD_RS_PIN_ID);
+	LCD_writeNibble(LCD_TWO_LINES_FOUR_BITS_MODE_INIT1 >> 4);
+	_delay_us(4100);
+	LCD_writeNibble(LCD_TWO_LINES_FOUR_BITS_MODE_INIT1 & 0x0F);
+	_delay_us(100);
+	LCD_writeNibble(LCD_TWO_LINES_FOUR_BITS_MODE_INIT2 >> 4);
+	_delay_us(LCD_EXECUTION_TIME_US);
+	LCD_writeNibble(LCD_TWO_LINES_FOUR_BITS_MODE_INIT2 & 0x0F);
+	_delay_us(LCD_EXECUTION_TIME_US);
 
 	/* use 2-lines LCD + 4-bits Data Mode + 5*7 dot display Mode */
 	LCD_sendCommand(LCD_TWO_LINES_FOUR_BITS_MODE);
 
 #elif(LCD_DATA_BITS_MODE == 8)
 	/* Configure the data port as output port */
-	GPIO_setupPortDirection(LCD_DATA_PORT_ID,PORT_OUTPUT);
+	GPIO_PORT_DIRECTION(LCD_DATA_PORT_ID,PORT_OUTPUT);
 
 	/* use 2-lines LCD + 8-bits Data Mode + 5*7 dot display Mode */
 	LCD_sendCommand(LCD_TWO_LINES_EIGHT_BITS_MODE);
 
 #endif
 
+#if (LCD_RW_PIN_ENABLE == 1)
+	_delay_us(LCD_EXECUTION_TIME_US);
+	g_busyFlagValid = TRUE;
+#endif
+
 	LCD_sendCommand(LCD_CURSOR_OFF); /* cursor off */
 	LCD_sendCommand(LCD_CLEAR_COMMAND); /* clear LCD at the beginning */
+
+	LCD_drawClear();
+
+	/* The CGRAM content is random after power on */
+	for(i = 0; i < LCD_NUM_GLYPHS; i++)
+	{
+		g_glyphs[i] = NULL_PTR;
+	}
+
+#if (LCD_ASYNC_ENABLE == 1)
+	g_asyncStarted = TRUE;
+#endif
 }
 
 /*
@@ -66,38 +207,10 @@ void LCD_init(void)
  */
 void LCD_sendCommand(uint8 command)
 {
-	GPIO_writePin(LCD_RS_PORT_ID,LCD_RS_PIN_ID,LOGIC_LOW); /* Instruction Mode RS=0 */
-	_delay_ms(1); /* delay for processing Tas = 50ns */
-	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_HIGH); /* Enable LCD E=1 */
-	_delay_ms(1); /* delay for processing Tpw - Tdws = 190ns */
+	TRACE(TRACE_EVENT_LCD_COMMAND, command);
 
-#if(LCD_DATA_BITS_MODE == 4)
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB4_PIN_ID,GET_BIT(command,4));
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB5_PIN_ID,GET_BIT(command,5));
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB6_PIN_ID,GET_BIT(command,6));
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB7_PIN_ID,GET_BIT(command,7));
-
-	_delay_ms(1); /* delay for processing Tdsw = 100ns */
-	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_LOW); /* Disable LCD E=0 */
-	_delay_ms(1); /* delay for processing Th = 13ns */
-	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_HIGH); /* Enable LCD E=1 */
-	_delay_ms(1); /* delay for processing Tpw - Tdws = 190ns */
-
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB4_PIN_ID,GET_BIT(command,0));
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB5_PIN_ID,GET_BIT(command,1));
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB6_PIN_ID,GET_BIT(command,2));
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB7_PIN_ID,GET_BIT(command,3));
-
-	_delay_ms(1); /* delay for processing Tdsw = 100ns */
-	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_LOW); /* Disable LCD E=0 */
-	_delay_ms(1); /* delay for processing Th = 13ns */
-
-#elif(LCD_DATA_BITS_MODE == 8)
-	GPIO_writePort(LCD_DATA_PORT_ID,command); /* out the required command to the data bus D0 --> D7 */
-	_delay_ms(1); /* delay for processing Tdsw = 100ns */
-	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_LOW); /* Disable LCD E=0 */
-	_delay_ms(1); /* delay for processing Th = 13ns */
-#endif
+	LCD_output(command, LOGIC_LOW); /* Instruction Mode RS=0 */
+	LCD_trackCommand(command);
 }
 
 /*
@@ -106,38 +219,8 @@ void LCD_sendCommand(uint8 command)
  */
 void LCD_displayCharacter(uint8 data)
 {
-	GPIO_writePin(LCD_RS_PORT_ID,LCD_RS_PIN_ID,LOGIC_HIGH); /* Data Mode RS=1 */
-	_delay_ms(1); /* delay for processing Tas = 50ns */
-	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_HIGH); /* Enable LCD E=1 */
-	_delay_ms(1); /* delay for processing Tpw - Tdws = 190ns */
-
-#if(LCD_DATA_BITS_MODE == 4)
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB4_PIN_ID,GET_BIT(data,4));
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB5_PIN_ID,GET_BIT(data,5));
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB6_PIN_ID,GET_BIT(data,6));
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB7_PIN_ID,GET_BIT(data,7));
-
-	_delay_ms(1); /* delay for processing Tdsw = 100ns */
-	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_LOW); /* Disable LCD E=0 */
-	_delay_ms(1); /* delay for processing Th = 13ns */
-	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_HIGH); /* Enable LCD E=1 */
-	_delay_ms(1); /* delay for processing Tpw - Tdws = 190ns */
-
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB4_PIN_ID,GET_BIT(data,0));
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB5_PIN_ID,GET_BIT(data,1));
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB6_PIN_ID,GET_BIT(data,2));
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB7_PIN_ID,GET_BIT(data,3));
-
-	_delay_ms(1); /* delay for processing Tdsw = 100ns */
-	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_LOW); /* Disable LCD E=0 */
-	_delay_ms(1); /* delay for processing Th = 13ns */
-
-#elif(LCD_DATA_BITS_MODE == 8)
-	GPIO_writePort(LCD_DATA_PORT_ID,data); /* out the required command to the data bus D0 --> D7 */
-	_delay_ms(1); /* delay for processing Tdsw = 100ns */
-	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_LOW); /* Disable LCD E=0 */
-	_delay_ms(1); /* delay for processing Th = 13ns */
-#endif
+	LCD_output(data, LOGIC_HIGH); /* Data Mode RS=1 */
+	LCD_trackCharacter(data);
 }
 
 /*
@@ -179,10 +262,10 @@ void LCD_moveCursor(uint8 row,uint8 col)
 			lcd_memory_address=col+0x40;
 				break;
 		case 2:
-			lcd_memory_address=col+0x10;
+			lcd_memory_address=col+LCD_COLS;
 				break;
 		case 3:
-			lcd_memory_address=col+0x50;
+			lcd_memory_address=col+0x40+LCD_COLS;
 				break;
 	}					
 	/* Move the LCD cursor to this specific address */
@@ -199,6 +282,32 @@ void LCD_displayStringRowColumn(uint8 row,uint8 col,const char *Str)
 	LCD_displayString(Str); /* display the string */
 }
 
+/*
+ * Description :
+ * Display the required string from the flash memory (PROGMEM or PSTR) on the screen
+ */
+void LCD_displayString_P(const char *Str)
+{
+	uint8 data = pgm_read_byte(Str);
+
+	while(data != '\0')
+	{
+		LCD_displayCharacter(data);
+		Str++;
+		data = pgm_read_byte(Str);
+	}
+}
+
+/*
+ * Description :
+ * Display the required string from the flash memory in a specified row and column index on the screen
+ */
+void LCD_displayStringRowColumn_P(uint8 row,uint8 col,const char *Str)
+{
+	LCD_moveCursor(row,col); /* go to to the required LCD position */
+	LCD_displayString_P(Str); /* display the string */
+}
+
 /*
  * Description :
  * Display the required decimal value on the screen
@@ -218,3 +327,579 @@ void LCD_clearScreen(void)
 {
 	LCD_sendCommand(LCD_CLEAR_COMMAND); /* Send clear display command */
 }
+
+/*
+ * Description :
+ * Fill the frame buffer with spaces, nothing is sent to the LCD until LCD_flush.
+ */
+void LCD_drawClear(void)
+{
+	uint8 row,col;
+
+	for(row = 0; row < LCD_ROWS; row++)
+	{
+		for(col = 0; col < LCD_COLS; col++)
+		{
+			g_frameBuffer[row][col] = ' ';
+		}
+	}
+}
+
+/*
+ * Description :
+ * Put a character in the frame buffer.
+ */
+void LCD_drawCharacter(uint8 row,uint8 col,uint8 data)
+{
+	if((row < LCD_ROWS) && (col < LCD_COLS))
+	{
+		g_frameBuffer[row][col] = data;
+	}
+}
+
+/*
+ * Description :
+ * Put a string in the frame buffer, it is clipped at the end of the row.
+ */
+void LCD_drawStringRowColumn(uint8 row,uint8 col,const char *Str)
+{
+	if(row >= LCD_ROWS)
+	{
+		return;
+	}
+	while((*Str != '\0') && (col < LCD_COLS))
+	{
+		g_frameBuffer[row][col] = *Str;
+		Str++;
+		col++;
+	}
+}
+
+/*
+ * Description :
+ * Put a string from the flash memory in the frame buffer, it is clipped at the end of the row.
+ */
+void LCD_drawStringRowColumn_P(uint8 row,uint8 col,const char *Str)
+{
+	uint8 data;
+
+	if(row >= LCD_ROWS)
+	{
+		return;
+	}
+	data = pgm_read_byte(Str);
+	while((data != '\0') && (col < LCD_COLS))
+	{
+		g_frameBuffer[row][col] = data;
+		Str++;
+		col++;
+		data = pgm_read_byte(Str);
+	}
+}
+
+/*
+ * Description :
+ * Send the cells of the frame buffer that differ from the screen content.
+ * A run of changed cells costs one cursor command.
+ */
+void LCD_flush(void)
+{
+	uint8 row,col;
+	uint8 bytes = 0;
+
+	for(row = 0; row < LCD_ROWS; row++)
+	{
+		for(col = 0; col < LCD_COLS; col++)
+		{
+			if((g_screenValid == FALSE) || (g_frameBuffer[row][col] != g_screen[row][col]))
+			{
+				/* The address counter auto increments, move only at the start of a run */
+				if((g_cursorRow != row) || (g_cursorCol != col))
+				{
+					LCD_moveCursor(row,col);
+					bytes++;
+				}
+				LCD_displayCharacter(g_frameBuffer[row][col]);
+				bytes++;
+			}
+		}
+	}
+	g_screenValid = TRUE;
+
+	g_flushStats.flushes++;
+	g_flushStats.last_bytes = bytes;
+	g_flushStats.total_bytes += bytes;
+	if(bytes > g_flushStats.max_bytes)
+	{
+		g_flushStats.max_bytes = bytes;
+	}
+}
+
+/*
+ * Description :
+ * Copy the statistics of the bytes sent by LCD_flush.
+ */
+void LCD_getFlushStats(LCD_FlushStatsType *stats)
+{
+	*stats = g_flushStats;
+}
+
+/*
+ * Description :
+ * Load a 5x8 glyph (LCD_GLYPH_ROWS bytes in the flash memory, 5 low bits per row) in
+ * the CGRAM slot of the character code. Nothing is sent if this glyph is already loaded.
+ */
+void LCD_loadGlyph(uint8 code,const uint8 *pattern)
+{
+	uint8 i;
+
+	code &= (LCD_NUM_GLYPHS - 1);
+	if(g_glyphs[code] == pattern)
+	{
+		return;
+	}
+
+	/* The cursor leaves the DDRAM, the next flush moves it back before writing a cell */
+	LCD_sendCommand(LCD_SET_CGRAM_ADDRESS | (code * LCD_GLYPH_ROWS));
+	for(i = 0; i < LCD_GLYPH_ROWS; i++)
+	{
+		LCD_displayCharacter(pgm_read_byte(&pattern[i]));
+	}
+	g_glyphs[code] = pattern;
+}
+
+/*
+ * Description :
+ * Load the partial cell glyphs and draw an empty bar in the frame buffer.
+ */
+void LCD_initProgressBar(LCD_ProgressBarType *bar,uint8 row,uint8 col,uint8 width)
+{
+	uint8 i;
+
+	for(i = 0; i < (LCD_PROGRESS_CELL_COLUMNS - 1); i++)
+	{
+		LCD_loadGlyph(LCD_PROGRESS_FIRST_GLYPH + i, g_progressGlyphs[i]);
+	}
+
+	bar->row = row;
+	bar->col = col;
+	bar->width = width;
+	bar->columns = 0;
+	for(i = 0; i < width; i++)
+	{
+		LCD_drawCharacter(row, col + i, ' ');
+	}
+}
+
+/*
+ * Description :
+ * Draw the bar filled at value/max in the frame buffer, only the cells between the old
+ * and the new end of the bar are drawn. Returns TRUE if a cell changed (flush needed).
+ */
+boolean LCD_drawProgressBar(LCD_ProgressBarType *bar,uint32 value,uint32 max)
+{
+	uint8 columns,first,last,cell;
+	uint8 cell_columns;
+
+	if((max == 0) || (value >= max))
+	{
+		columns = bar->width * LCD_PROGRESS_CELL_COLUMNS;
+	}
+	else
+	{
+		columns = (uint8)((value * (bar->width * LCD_PROGRESS_CELL_COLUMNS)) / max);
+	}
+	if(columns == bar->columns)
+	{
+		return FALSE;
+	}
+
+	/* Cells holding the old and the new end of the bar and the ones between them */
+	first = ((columns < bar->columns) ? columns : bar->columns) / LCD_PROGRESS_CELL_COLUMNS;
+	last = ((columns > bar->columns) ? columns : bar->columns) / LCD_PROGRESS_CELL_COLUMNS;
+	if(last >= bar->width)
+	{
+		last = bar->width - 1;
+	}
+	for(cell = first; cell <= last; cell++)
+	{
+		if(columns >= ((cell + 1) * LCD_PROGRESS_CELL_COLUMNS))
+		{
+			LCD_drawCharacter(bar->row, bar->col + cell, LCD_FULL_BLOCK);
+		}
+		else if(columns > (cell * LCD_PROGRESS_CELL_COLUMNS))
+		{
+			cell_columns = columns - (cell * LCD_PROGRESS_CELL_COLUMNS);
+			LCD_drawCharacter(bar->row, bar->col + cell, LCD_PROGRESS_FIRST_GLYPH + cell_columns - 1);
+		}
+		else
+		{
+			LCD_drawCharacter(bar->row, bar->col + cell, ' ');
+		}
+	}
+	bar->columns = columns;
+	return TRUE;
+}
+
+/*
+ * Description :
+ * Return TRUE when all the queued writes are sent and executed by the LCD.
+ * Always TRUE with blocking writes.
+ */
+boolean LCD_isIdle(void)
+{
+#if (LCD_ASYNC_ENABLE == 1)
+	return g_lcdIdle;
+#else
+	return TRUE;
+#endif
+}
+
+/*
+ * Description :
+ * Wait until the queued writes are done, e.g. before timing a redraw or before
+ * a sleep mode that stops Timer0.
+ */
+void LCD_waitIdle(void)
+{
+	while(LCD_isIdle() == FALSE)
+	{
+		_NOP();
+	}
+}
+
+/*******************************************************************************
+ *                      Private Functions Definitions                          *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Queue a command (RS=0) or a data byte (RS=1) once the LCD is initialized,
+ * otherwise write it and wait for its execution time.
+ * With interrupts disabled (LCD_init under cli(), drawing from an ISR) the timer can
+ * not free the queue: the queued writes are sent first then this one, all blocking.
+ */
+static void LCD_output(uint8 value, uint8 rs_value)
+{
+#if (LCD_ASYNC_ENABLE == 1)
+	if(g_asyncStarted == TRUE)
+	{
+		if((SREG & (1 << 7)) != 0)
+		{
+			LCD_enqueue((rs_value == LOGIC_HIGH) ? (LCD_QUEUE_DATA_FLAG | value) : value);
+			return;
+		}
+		LCD_drainQueue();
+	}
+#endif
+
+	LCD_write(value, rs_value);
+
+#if (LCD_RW_PIN_ENABLE == 0)
+	if(rs_value == LOGIC_HIGH)
+	{
+		_delay_us(LCD_EXECUTION_TIME_US + 4); /* tADD = 4us for the address counter update */
+	}
+	/* Clear display and return home are the only long instructions */
+	else if((value == LCD_CLEAR_COMMAND) || (value == LCD_GO_TO_HOME))
+	{
+		_delay_us(LCD_CLEAR_EXECUTION_TIME_US);
+	}
+	else
+	{
+		_delay_us(LCD_EXECUTION_TIME_US);
+	}
+#endif
+}
+
+#if (LCD_ASYNC_ENABLE == 1)
+/*
+ * Description :
+ * Add an entry to the queue, wait for a free entry if it is full,
+ * and start the timer if it is stopped. Interrupts must be enabled.
+ */
+static void LCD_enqueue(uint16 entry)
+{
+	uint8 next = (g_queueHead + 1) & (LCD_QUEUE_SIZE - 1);
+	uint8 sreg;
+	Timer_ConfigType TIMER_configurations = { 0, (uint16)((LCD_ASYNC_TICK_US * (F_CPU / 1000000UL) / 8) - 1),
+			LCD_ASYNC_TIMER_ID, F_CPU_8, COMPARE };
+
+	/* Full, the running timer frees one entry per tick */
+	while(next == g_queueTail)
+	{
+		_NOP();
+	}
+
+	g_queue[g_queueHead] = entry;
+	g_queueHead = next;
+
+	/* The ISR may stop the timer between the queue update and this test */
+	sreg = SREG;
+	cli();
+	if(g_lcdIdle == TRUE)
+	{
+		g_lcdIdle = FALSE;
+		Timer_setCallBack(&LCD_asyncTick, LCD_ASYNC_TIMER_ID);
+		Timer_init(&TIMER_configurations);
+	}
+	SREG = sreg;
+}
+
+/*
+ * Description :
+ * Send the queued writes without the timer interrupt, interrupts disabled. The ticks
+ * are run here at the same period, the last one leaves time for the last write.
+ * The timer stops at its next interrupt, the queue being empty.
+ */
+static void LCD_drainQueue(void)
+{
+	if(g_lcdIdle == TRUE)
+	{
+		return;
+	}
+
+	while(1)
+	{
+		_delay_us(LCD_ASYNC_TICK_US);
+		if((g_queueTail == g_queueHead) && (g_waitTicks == 0))
+		{
+			return;
+		}
+		LCD_asyncTick();
+	}
+}
+
+/*
+ * Description :
+ * Timer tick, called from the ISR: at most one bus write (plus one busy flag read
+ * with the RW pin), so the time spent in each tick is bounded.
+ * The timer is stopped once the queue is empty and the last write is executed.
+ */
+static void LCD_asyncTick(void)
+{
+	uint16 entry;
+
+	if(g_waitTicks > 0)
+	{
+		g_waitTicks--;
+		return;
+	}
+
+#if (LCD_RW_PIN_ENABLE == 1)
+	if(LCD_readBusyFlag() == LOGIC_HIGH)
+	{
+		return;
+	}
+#endif
+
+	if(g_queueTail == g_queueHead)
+	{
+		Timer_deInit(LCD_ASYNC_TIMER_ID);
+		g_lcdIdle = TRUE;
+		return;
+	}
+
+	entry = g_queue[g_queueTail];
+	g_queueTail = (g_queueTail + 1) & (LCD_QUEUE_SIZE - 1);
+
+	GPIO_WRITE_PIN(LCD_RS_PORT_ID,LCD_RS_PIN_ID,(entry & LCD_QUEUE_DATA_FLAG) ? LOGIC_HIGH : LOGIC_LOW);
+	LCD_writeBus((uint8)entry);
+
+#if (LCD_RW_PIN_ENABLE == 0)
+	if((entry == LCD_CLEAR_COMMAND) || (entry == LCD_GO_TO_HOME))
+	{
+		g_waitTicks = LCD_CLEAR_WAIT_TICKS;
+	}
+#endif
+}
+#endif
+
+/*
+ * Description :
+ * Follow the effect of a command on the screen content and the cursor position.
+ */
+static void LCD_trackCommand(uint8 command)
+{
+	uint8 row,col;
+	uint8 address;
+
+	if(command == LCD_CLEAR_COMMAND)
+	{
+		for(row = 0; row < LCD_ROWS; row++)
+		{
+			for(col = 0; col < LCD_COLS; col++)
+			{
+				g_screen[row][col] = ' ';
+			}
+		}
+		g_screenValid = TRUE;
+		g_cursorRow = 0;
+		g_cursorCol = 0;
+	}
+	else if((command & 0xFE) == LCD_GO_TO_HOME)
+	{
+		g_cursorRow = 0;
+		g_cursorCol = 0;
+	}
+	else if(command & LCD_SET_CURSOR_LOCATION)
+	{
+		/* DDRAM address, find the visible cell */
+		address = command & 0x7F;
+		g_cursorRow = LCD_CURSOR_UNKNOWN;
+		for(row = 0; row < LCD_ROWS; row++)
+		{
+			col = address - ((row & 1) ? 0x40 : 0x00) - ((row & 2) ? LCD_COLS : 0);
+			if(col < LCD_COLS)
+			{
+				g_cursorRow = row;
+				g_cursorCol = col;
+			}
+		}
+	}
+	else if(command & 0x40)
+	{
+		/* CGRAM address, the next characters do not go to the screen */
+		g_cursorRow = LCD_CURSOR_UNKNOWN;
+	}
+	else if((command & 0xF0) == 0x10)
+	{
+		/* Cursor or display shift, the position is not followed */
+		g_cursorRow = LCD_CURSOR_UNKNOWN;
+		g_screenValid = FALSE;
+	}
+}
+
+/*
+ * Description :
+ * Follow a character written at the cursor position.
+ */
+static void LCD_trackCharacter(uint8 data)
+{
+	if(g_cursorRow == LCD_CURSOR_UNKNOWN)
+	{
+		return;
+	}
+	if(g_cursorCol < LCD_COLS)
+	{
+		g_screen[g_cursorRow][g_cursorCol] = data;
+		g_cursorCol++;
+	}
+	else
+	{
+		/* Written past the end of the row, where it lands depends on the LCD size */
+		g_screenValid = FALSE;
+	}
+}
+
+/*
+ * Description :
+ * Write a command (RS=0) or a data byte (RS=1) on the bus.
+ * With the RW pin, wait first until the LCD finished the previous instruction.
+ */
+static void LCD_write(uint8 value, uint8 rs_value)
+{
+#if (LCD_RW_PIN_ENABLE == 1)
+	if(g_busyFlagValid == TRUE)
+	{
+		LCD_waitReady();
+	}
+#endif
+
+	GPIO_WRITE_PIN(LCD_RS_PORT_ID,LCD_RS_PIN_ID,rs_value);
+	LCD_writeBus(value);
+}
+
+/*
+ * Description :
+ * Latch a byte on the data bus, in 4-bit mode the high nibble is sent first.
+ * RS setup (tAS = 40ns) and data hold (10ns) are shorter than one sbi/cbi
+ * (250ns at 8MHz), the E pulse width (230ns) gets a delay.
+ */
+static void LCD_writeBus(uint8 value)
+{
+#if(LCD_DATA_BITS_MODE == 4)
+	LCD_writeNibble(value >> 4);
+	LCD_writeNibble(value & 0x0F);
+
+#elif(LCD_DATA_BITS_MODE == 8)
+	GPIO_WRITE_PORT(LCD_DATA_PORT_ID,value); /* out the required data to the data bus D0 --> D7 */
+	GPIO_SET_PIN(LCD_E_PORT_ID,LCD_E_PIN_ID); /* Enable LCD E=1 */
+	_delay_us(1); /* E pulse width PWeh = 230ns */
+	GPIO_CLEAR_PIN(LCD_E_PORT_ID,LCD_E_PIN_ID); /* Disable LCD E=0 */
+#endif
+}
+
+#if (LCD_DATA_BITS_MODE == 4)
+/*
+ * Description :
+ * Latch the low 4 bits of nibble on DB4..DB7.
+ * The data pins change in one port write, the other pins of the port keep their value.
+ */
+static void LCD_writeNibble(uint8 nibble)
+{
+	GPIO_WRITE_PORT_MASKED(LCD_DATA_PORT_ID,LCD_DATA_MASK,LCD_NIBBLE_TO_PORT(nibble));
+
+	GPIO_SET_PIN(LCD_E_PORT_ID,LCD_E_PIN_ID); /* Enable LCD E=1 */
+	_delay_us(1); /* E pulse width PWeh = 230ns */
+	GPIO_CLEAR_PIN(LCD_E_PORT_ID,LCD_E_PIN_ID); /* Disable LCD E=0 */
+}
+#endif
+
+#if (LCD_RW_PIN_ENABLE == 1)
+/*
+ * Description :
+ * Wait until the LCD is ready for the next write.
+ */
+static void LCD_waitReady(void)
+{
+	while(LCD_readBusyFlag() == LOGIC_HIGH);
+}
+
+/*
+ * Description :
+ * Read the busy flag once (DB7 with RS=0, RW=1), the bus is left in write mode.
+ */
+static uint8 LCD_readBusyFlag(void)
+{
+	uint8 busy;
+
+	/* Release the data bus before the LCD drives it */
+	LCD_setupDataDirection(PIN_INPUT);
+	GPIO_CLEAR_PIN(LCD_RS_PORT_ID,LCD_RS_PIN_ID);
+	GPIO_SET_PIN(LCD_RW_PORT_ID,LCD_RW_PIN_ID);
+
+	GPIO_SET_PIN(LCD_E_PORT_ID,LCD_E_PIN_ID);
+	_delay_us(1); /* Data delay tDDR = 160ns */
+#if(LCD_DATA_BITS_MODE == 4)
+	busy = GPIO_READ_PIN(LCD_DATA_PORT_ID,LCD_DB7_PIN_ID);
+	GPIO_CLEAR_PIN(LCD_E_PORT_ID,LCD_E_PIN_ID);
+	_delay_us(1);
+	/* Clock out the low nibble (address counter), it is not used */
+	GPIO_SET_PIN(LCD_E_PORT_ID,LCD_E_PIN_ID);
+	_delay_us(1);
+#elif(LCD_DATA_BITS_MODE == 8)
+	busy = GPIO_READ_PIN(LCD_DATA_PORT_ID,PIN7_ID);
+#endif
+	GPIO_CLEAR_PIN(LCD_E_PORT_ID,LCD_E_PIN_ID);
+	_delay_us(1);
+
+	GPIO_CLEAR_PIN(LCD_RW_PORT_ID,LCD_RW_PIN_ID);
+	LCD_setupDataDirection(PIN_OUTPUT);
+
+	return busy;
+}
+
+/*
+ * Description :
+ * Switch the data pins between output (write) and input (busy flag read).
+ */
+static void LCD_setupDataDirection(GPIO_PinDirectionType direction)
+{
+#if(LCD_DATA_BITS_MODE == 4)
+	GPIO_PORT_DIRECTION_MASKED(LCD_DATA_PORT_ID,LCD_DATA_MASK,(direction == PIN_OUTPUT) ? PORT_OUTPUT : PORT_INPUT);
+#elif(LCD_DATA_BITS_MODE == 8)
+	GPIO_PORT_DIRECTION(LCD_DATA_PORT_ID,(direction == PIN_OUTPUT) ? PORT_OUTPUT : PORT_INPUT);
+#endif
+}
+#endif
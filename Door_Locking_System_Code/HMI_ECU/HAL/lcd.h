@@ -19,8 +19,13 @@
  *                                Definitions                                  *
  *******************************************************************************/
 
-/* LCD Data bits mode configuration, its value should be 4 or 8*/
+/*
+ * LCD Data bits mode configuration, its value should be 4 or 8
+ * (the configuration options can also be overridden from the compiler command line)
+ */
+#ifndef LCD_DATA_BITS_MODE
 #define LCD_DATA_BITS_MODE 8
+#endif
 
 #if((LCD_DATA_BITS_MODE != 4) && (LCD_DATA_BITS_MODE != 8))
 
@@ -28,6 +33,16 @@
 
 #endif
 
+/* LCD size for the shadow frame buffer, up to 4 rows of 20 columns */
+#define LCD_ROWS                       2
+#define LCD_COLS                       16
+
+#if ((LCD_ROWS > 4) || (LCD_COLS > 20))
+
+#error "The LCD size should be up to 4x20"
+
+#endif
+
 /* LCD HW Ports and Pins Ids */
 #define LCD_RS_PORT_ID                 PORTC_ID
 #define LCD_RS_PIN_ID                  PIN0_ID
@@ -37,6 +52,22 @@
 
 #define LCD_DATA_PORT_ID               PORTA_ID
 
+/*
+ * Set to 1 if the LCD RW pin is connected, the driver then polls the busy flag
+ * before each write. Set to 0 if RW is tied to ground, the driver then waits the
+ * datasheet execution time after each write.
+ */
+#ifndef LCD_RW_PIN_ENABLE
+#define LCD_RW_PIN_ENABLE              0
+#endif
+
+#if (LCD_RW_PIN_ENABLE == 1)
+
+#define LCD_RW_PORT_ID                 PORTC_ID
+#define LCD_RW_PIN_ID                  PIN2_ID
+
+#endif
+
 #if (LCD_DATA_BITS_MODE == 4)
 
 #define LCD_DB4_PIN_ID                 PIN3_ID
@@ -46,6 +77,38 @@
 
 #endif
 
+/* HD44780 execution times (fosc = 270kHz) with a small margin, used when RW is tied to ground */
+#define LCD_EXECUTION_TIME_US                40
+#define LCD_CLEAR_EXECUTION_TIME_US          1600
+
+/*
+ * Set to 1 to queue the commands and characters once LCD_init is done, the queue is
+ * sent from the Timer0 compare interrupt with one bus write per tick. The tick is
+ * longer than the execution time of a write, a clear or home command skips the next
+ * ticks. Set to 0 for blocking writes.
+ */
+#ifndef LCD_ASYNC_ENABLE
+#define LCD_ASYNC_ENABLE                     1
+#endif
+
+#if (LCD_ASYNC_ENABLE == 1)
+
+#define LCD_ASYNC_TIMER_ID                   TIMER0
+
+/* Timer0 counts at F_CPU/8 (1us at 8MHz), up to 256 counts per tick */
+#define LCD_ASYNC_TICK_US                    50
+
+/* Number of queued writes, must be a power of 2 (a full 2x16 redraw is 35 writes) */
+#define LCD_QUEUE_SIZE                       64
+
+#if ((LCD_ASYNC_TICK_US * (F_CPU / 1000000UL) / 8) > 256)
+
+#error "LCD_ASYNC_TICK_US is too long for the 8-bit Timer0"
+
+#endif
+
+#endif
+
 /* LCD Commands */
 #define LCD_CLEAR_COMMAND                    0x01
 #define LCD_GO_TO_HOME                       0x02
@@ -56,6 +119,37 @@
 #define LCD_CURSOR_OFF                       0x0C
 #define LCD_CURSOR_ON                        0x0E
 #define LCD_SET_CURSOR_LOCATION              0x80
+#define LCD_SET_CGRAM_ADDRESS                0x40
+
+/* Custom 5x8 characters in the CGRAM, shown with the character codes 0 to 7 */
+#define LCD_NUM_GLYPHS                       8
+#define LCD_GLYPH_ROWS                       8
+
+/* Progress bar: 5 pixel columns per cell, drawn with glyphs 4 to 7 for the partial cells */
+#define LCD_PROGRESS_FIRST_GLYPH             4
+#define LCD_PROGRESS_CELL_COLUMNS            5
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+/* Bus writes (commands + characters) sent by LCD_flush */
+typedef struct
+{
+	uint16 flushes;
+	uint8 last_bytes;
+	uint8 max_bytes;
+	uint32 total_bytes;
+}LCD_FlushStatsType;
+
+/* Horizontal bar in the frame buffer, the filled part grows from the left */
+typedef struct
+{
+	uint8 row;
+	uint8 col;
+	uint8 width;       /* Cells */
+	uint8 columns;     /* Filled pixel columns in the frame buffer */
+}LCD_ProgressBarType;
 
 /*******************************************************************************
  *                      Functions Prototypes                                   *
@@ -99,6 +193,18 @@ void LCD_moveCursor(uint8 row,uint8 col);
  */
 void LCD_displayStringRowColumn(uint8 row,uint8 col,const char *Str);
 
+/*
+ * Description :
+ * Display the required string from the flash memory (PROGMEM or PSTR) on the screen
+ */
+void LCD_displayString_P(const char *Str);
+
+/*
+ * Description :
+ * Display the required string from the flash memory in a specified row and column index on the screen
+ */
+void LCD_displayStringRowColumn_P(uint8 row,uint8 col,const char *Str);
+
 /*
  * Description :
  * Display the required decimal value on the screen
@@ -111,4 +217,75 @@ void LCD_intgerToString(int data);
  */
 void LCD_clearScreen(void);
 
+/*
+ * Description :
+ * Fill the frame buffer with spaces, nothing is sent to the LCD until LCD_flush.
+ */
+void LCD_drawClear(void);
+
+/*
+ * Description :
+ * Put a character in the frame buffer.
+ */
+void LCD_drawCharacter(uint8 row,uint8 col,uint8 data);
+
+/*
+ * Description :
+ * Put a string in the frame buffer, it is clipped at the end of the row.
+ */
+void LCD_drawStringRowColumn(uint8 row,uint8 col,const char *Str);
+
+/*
+ * Description :
+ * Put a string from the flash memory in the frame buffer, it is clipped at the end of the row.
+ */
+void LCD_drawStringRowColumn_P(uint8 row,uint8 col,const char *Str);
+
+/*
+ * Description :
+ * Send the cells of the frame buffer that differ from the screen content.
+ * A run of changed cells costs one cursor command.
+ */
+void LCD_flush(void);
+
+/*
+ * Description :
+ * Copy the statistics of the bytes sent by LCD_flush.
+ */
+void LCD_getFlushStats(LCD_FlushStatsType *stats);
+
+/*
+ * Description :
+ * Load a 5x8 glyph (LCD_GLYPH_ROWS bytes in the flash memory, 5 low bits per row) in
+ * the CGRAM slot of the character code. Nothing is sent if this glyph is already loaded.
+ */
+void LCD_loadGlyph(uint8 code,const uint8 *pattern);
+
+/*
+ * Description :
+ * Load the partial cell glyphs and draw an empty bar in the frame buffer.
+ */
+void LCD_initProgressBar(LCD_ProgressBarType *bar,uint8 row,uint8 col,uint8 width);
+
+/*
+ * Description :
+ * Draw the bar filled at value/max in the frame buffer, only the cells between the old
+ * and the new end of the bar are drawn. Returns TRUE if a cell changed (flush needed).
+ */
+boolean LCD_drawProgressBar(LCD_ProgressBarType *bar,uint32 value,uint32 max);
+
+/*
+ * Description :
+ * Return TRUE when all the queued writes are sent and executed by the LCD.
+ * Always TRUE with blocking writes.
+ */
+boolean LCD_isIdle(void);
+
+/*
+ * Description :
+ * Wait until the queued writes are done, e.g. before timing a redraw or before
+ * a sleep mode that stops Timer0.
+ */
+void LCD_waitIdle(void);
+
 #endif /* LCD_H_ */
@@ -0,0 +1,142 @@
+ /******************************************************************************
+ *
+ * Module: FSM
+ *
+ * File Name: fsm.h
+ *
+ * Description: Header file for the table-driven finite state machine engine
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#ifndef FSM_H_
+#define FSM_H_
+
+#include "std_types.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * State IDs start from 1, the ID 0 is reserved to mark an empty cell in the
+ * transition table (the event is ignored in this state).
+ */
+#define FSM_NO_STATE                 0
+
+/*
+ * The state and transition tables are constant, on the AVR they are placed in
+ * the flash memory and read with the pgmspace functions to save SRAM.
+ */
+#ifdef __AVR__
+#include <avr/pgmspace.h>
+#define FSM_FLASH                    PROGMEM
+#else
+#define FSM_FLASH
+#endif
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+typedef uint8 FSM_StateType;
+typedef uint8 FSM_EventType;
+
+/* State activity, it runs while the machine is in the state and returns the generated event */
+typedef FSM_EventType (*FSM_HandlerType)(void);
+
+/* Transition guard, the transition is only taken if it returns TRUE */
+typedef boolean (*FSM_GuardType)(void);
+
+/* Transition action, executed once when the transition is taken */
+typedef void (*FSM_ActionType)(void);
+
+/* Time source used by the instrumentation */
+typedef uint32 (*FSM_TimeSourceType)(void);
+
+/* One cell of the transition table [state][event] */
+typedef struct
+{
+	FSM_GuardType guard;        /* NULL_PTR if the transition is unconditional */
+	FSM_ActionType action;      /* NULL_PTR if there is nothing to do */
+	FSM_StateType next_state;   /* FSM_NO_STATE if the event is ignored */
+}FSM_TransitionType;
+
+typedef struct
+{
+	const FSM_HandlerType *handlers;         /* [num_states] in flash */
+	const FSM_TransitionType *transitions;   /* [num_states][num_events] in flash */
+	uint8 num_states;                        /* Including the reserved FSM_NO_STATE */
+	uint8 num_events;
+	FSM_StateType initial_state;
+	FSM_TimeSourceType get_time;             /* NULL_PTR disables the time measurement */
+}FSM_ConfigType;
+
+/* Instrumentation record kept for each state */
+typedef struct
+{
+	uint32 time_in_state;   /* Accumulated time spent in the state, in get_time units */
+	uint16 entries;         /* Number of times the state was entered */
+}FSM_StateStatsType;
+
+typedef struct
+{
+	const FSM_ConfigType *config;
+	FSM_StateType current_state;
+	uint32 state_entry_time;
+	FSM_StateStatsType *state_stats;   /* [num_states] or NULL_PTR */
+	uint16 *transition_counts;         /* [num_states * num_events] or NULL_PTR */
+}FSM_Type;
+
+/*******************************************************************************
+ *                              Functions Prototypes                           *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Initialize the state machine and enter the initial state.
+ * state_stats and transition_counts are optional RAM arrays for the instrumentation,
+ * pass NULL_PTR to disable it.
+ */
+void FSM_init(FSM_Type *fsm, const FSM_ConfigType *config,
+		FSM_StateStatsType *state_stats, uint16 *transition_counts);
+
+/*
+ * Description :
+ * Look up the transition of the current state for the required event in O(1).
+ * Returns TRUE if a transition was taken, FALSE if the event is ignored or the guard failed.
+ */
+boolean FSM_dispatch(FSM_Type *fsm, FSM_EventType event);
+
+/*
+ * Description :
+ * Run the activity of the current state once and dispatch the event it returns.
+ */
+void FSM_run(FSM_Type *fsm);
+
+/*
+ * Description :
+ * Return the current state of the machine.
+ */
+FSM_StateType FSM_getState(const FSM_Type *fsm);
+
+/*
+ * Description :
+ * Return the total time spent in the required state, including the current visit.
+ */
+uint32 FSM_getTimeInState(const FSM_Type *fsm, FSM_StateType state);
+
+/*
+ * Description :
+ * Return how many times the transition [state][event] was taken.
+ */
+uint16 FSM_getTransitionCount(const FSM_Type *fsm, FSM_StateType state, FSM_EventType event);
+
+/*
+ * Description :
+ * Clear the instrumentation counters and restart the measurement of the current state.
+ */
+void FSM_resetStats(FSM_Type *fsm);
+
+#endif /* FSM_H_ */
@@ -0,0 +1,314 @@
+ /******************************************************************************
+ *
+ * Module: POWER
+ *
+ * File Name: power.c
+ *
+ * Description: Source file for the idle manager (idle sleep and power-down).
+ *              In idle mode the timers, UART and external interrupts keep running
+ *              so any of them wakes the MCU. In power-down (the power-save sleep mode)
+ *              only the external interrupts, the TWI address match and the asynchronous
+ *              Timer2 wake it, the Timer1 time base stops and Timer2 counts the time.
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#include "power.h"
+#include "systime.h"
+#include "timer.h"
+#include "registers.h"
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/* Timer2 clock: crystal / 1024 (CS22:0 = 7), 31.25 ms counts and an overflow every 8 s */
+#define POWER_CLOCK_SELECT             ((1 << CS22) | (1 << CS21) | (1 << CS20))
+#define POWER_CLOCK_US                 ((1000000UL * 1024) / POWER_CLOCK_CRYSTAL_HZ)
+
+/* Convert Timer2 counts to SysTime counts, in two parts to not overflow */
+#define POWER_CLOCK_TO_SYSTIME(counts) \
+	((((uint32)(counts) / SYSTIME_US_PER_COUNT) * POWER_CLOCK_US) + \
+	((((uint32)(counts) % SYSTIME_US_PER_COUNT) * POWER_CLOCK_US) / SYSTIME_US_PER_COUNT))
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+static volatile uint32 g_lastActivitySeconds = 0;
+static uint32 g_statsStartTime = 0;
+static volatile uint32 g_idleTime = 0;
+static volatile uint32 g_idleCount = 0;
+static volatile uint16 g_powerDownCount = 0;
+static volatile uint32 g_powerDownTime = 0;
+
+/* Timer2 overflows, the high part of the power-down clock */
+static volatile uint32 g_clockOverflows = 0;
+static boolean g_clockStarted = FALSE;
+
+static boolean (*volatile g_powerDownPrepare)(void) = NULL_PTR;
+static void (*volatile g_powerDownResume)(void) = NULL_PTR;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static boolean Power_enterPowerDown(void);
+static void Power_startClock(void);
+static void Power_syncClock(void);
+static uint32 Power_readClock(void);
+static void Power_clockOverflow(void);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Select the idle sleep mode and start the statistics. SysTime_init must be called first.
+ */
+void Power_init(void)
+{
+	set_sleep_mode(SLEEP_MODE_IDLE);
+	Power_notifyActivity();
+	Power_resetStats();
+}
+
+/*
+ * Description :
+ * Sleep until the next interrupt, call it whenever no work is pending.
+ * After POWER_DOWN_TIMEOUT_SECONDS without activity it enters power-down if a
+ * power-down wake source is registered.
+ */
+void Power_idle(void)
+{
+	uint32 sleep_start;
+	uint8 sreg;
+
+	if(SysTime_isElapsed(g_lastActivitySeconds, POWER_DOWN_TIMEOUT_SECONDS) == TRUE)
+	{
+		if(Power_enterPowerDown() == TRUE)
+		{
+			return;
+		}
+	}
+
+	sleep_start = SysTime_now();
+
+	/* The Timer1 tick wakes the MCU at least every SYSTIME_MS_PER_TICK */
+	sleep_enable();
+	sleep_cpu();
+	sleep_disable();
+
+	sreg = SREG;
+	cli();
+	g_idleTime += SysTime_now() - sleep_start;
+	g_idleCount++;
+	SREG = sreg;
+}
+
+/*
+ * Description :
+ * Sleep in idle mode for the required number of milliseconds.
+ */
+void Power_sleepMs(uint16 ms)
+{
+	uint32 start_ticks = SysTime_getTicks();
+	uint32 ticks = SYSTIME_MS_TO_TICKS(ms);
+
+	while((SysTime_getTicks() - start_ticks) < ticks)
+	{
+		Power_idle();
+	}
+}
+
+/*
+ * Description :
+ * Restart the inactivity timer (user input, link traffic...).
+ */
+void Power_notifyActivity(void)
+{
+	g_lastActivitySeconds = SysTime_getSeconds();
+}
+
+/*
+ * Description :
+ * Register the power-down wake source: prepare is called with interrupts disabled
+ * just before power-down to arm the wake interrupt, it can return FALSE to stay awake.
+ * resume is called after the wake up. Pass NULL_PTR to disable power-down.
+ */
+void Power_setPowerDownCallBacks(boolean (*a_prepare)(void), void (*a_resume)(void))
+{
+	g_powerDownPrepare = a_prepare;
+	g_powerDownResume = a_resume;
+
+	if(a_prepare != NULL_PTR)
+	{
+		Power_startClock();
+	}
+}
+
+/*
+ * Description :
+ * Copy the time spent in each sleep state since the last reset.
+ */
+void Power_getStats(Power_StatsType *stats)
+{
+	uint8 sreg = SREG;
+
+	cli();
+	stats->total_time = (SysTime_now() - g_statsStartTime) + g_powerDownTime;
+	stats->idle_time = g_idleTime;
+	stats->power_down_time = g_powerDownTime;
+	stats->idle_count = g_idleCount;
+	stats->power_down_count = g_powerDownCount;
+	SREG = sreg;
+}
+
+/*
+ * Description :
+ * Clear the statistics.
+ */
+void Power_resetStats(void)
+{
+	uint8 sreg = SREG;
+
+	cli();
+	g_statsStartTime = SysTime_now();
+	g_idleTime = 0;
+	g_idleCount = 0;
+	g_powerDownCount = 0;
+	g_powerDownTime = 0;
+	SREG = sreg;
+}
+
+/*******************************************************************************
+ *                      Private Functions Definitions                          *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Arm the wake source and power down, returns FALSE if power-down is not possible now.
+ */
+static boolean Power_enterPowerDown(void)
+{
+	boolean (*prepare)(void) = g_powerDownPrepare;
+	uint8 sreg = SREG;
+	uint32 sleep_start;
+
+	/* With interrupts disabled by the caller nothing would wake the MCU */
+	if((prepare == NULL_PTR) || ((sreg & (1 << 7)) == 0))
+	{
+		return FALSE;
+	}
+
+	/* Interrupts stay disabled until the sleep instruction, so a wake up can not be missed */
+	cli();
+	if(prepare() == FALSE)
+	{
+		SREG = sreg;
+		return FALSE;
+	}
+
+	Power_syncClock();
+	sleep_start = Power_readClock();
+
+	/* The Timer2 overflows wake the MCU too, sleep again until the wake source fired */
+	set_sleep_mode(SLEEP_MODE_PWR_SAVE);
+	do
+	{
+		sleep_enable();
+		sei(); /* The instruction after sei is always executed before any interrupt */
+		sleep_cpu();
+		sleep_disable();
+		cli();
+		Power_syncClock();
+	} while(prepare() == TRUE);
+	set_sleep_mode(SLEEP_MODE_IDLE);
+
+	g_powerDownTime += POWER_CLOCK_TO_SYSTIME(Power_readClock() - sleep_start);
+	g_powerDownCount++;
+	SREG = sreg;
+
+	if(g_powerDownResume != NULL_PTR)
+	{
+		g_powerDownResume();
+	}
+
+	Power_notifyActivity();
+
+	return TRUE;
+}
+
+/*
+ * Description :
+ * Start Timer2 on the watch crystal, in normal mode with the overflow interrupt.
+ */
+static void Power_startClock(void)
+{
+	uint8 sreg = SREG;
+
+	if(g_clockStarted == TRUE)
+	{
+		return;
+	}
+
+	cli();
+	Timer_setCallBack(Power_clockOverflow, TIMER2);
+	REG_CLEAR_BITS(TIMSK, (1 << OCIE2) | (1 << TOIE2));
+	REG_SET_BIT(ASSR, AS2);
+	REG_WRITE(TCNT2, 0);
+	REG_WRITE(OCR2, 0);
+	REG_WRITE(TCCR2, POWER_CLOCK_SELECT);
+	while((REG_READ(ASSR) & ((1 << TCN2UB) | (1 << OCR2UB) | (1 << TCR2UB))) != 0)
+	{
+	}
+	REG_WRITE(TIFR, (1 << OCF2) | (1 << TOV2)); /* The clock switch can corrupt them */
+	REG_SET_BIT(TIMSK, TOIE2);
+	g_clockStarted = TRUE;
+	SREG = sreg;
+}
+
+/*
+ * Description :
+ * Write OCR2 and wait for the write to reach the asynchronous clock domain: TCNT2 reads
+ * the right value and the MCU can sleep again only one TOSC1 cycle after a wake up.
+ */
+static void Power_syncClock(void)
+{
+	REG_WRITE(OCR2, 0);
+	while(REG_BIT_IS_SET(ASSR, OCR2UB))
+	{
+	}
+}
+
+/*
+ * Description :
+ * Timer2 counts since it started, with interrupts disabled.
+ */
+static uint32 Power_readClock(void)
+{
+	uint8 count = REG_READ(TCNT2);
+	uint32 overflows = g_clockOverflows;
+
+	/* Overflow not served yet, the count restarted from zero */
+	if(REG_BIT_IS_SET(TIFR, TOV2) && (count < 0x80))
+	{
+		overflows++;
+	}
+
+	return (overflows << 8) | count;
+}
+
+/*
+ * Description :
+ * Timer2 overflow callback.
+ */
+static void Power_clockOverflow(void)
+{
+	g_clockOverflows++;
+}
@@ -0,0 +1,100 @@
+ /******************************************************************************
+ *
+ * Module: POWER
+ *
+ * File Name: power.h
+ *
+ * Description: Header file for the idle manager (idle sleep and power-down)
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#ifndef POWER_H_
+#define POWER_H_
+
+#include "std_types.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/* Inactivity after which Power_idle enters power-down instead of idle */
+#define POWER_DOWN_TIMEOUT_SECONDS     30
+
+/*
+ * The power-down sleeps in power-save mode: Timer2 runs in the asynchronous mode and counts
+ * its length while Timer1 is stopped. The board needs a 32.768 kHz watch crystal on
+ * TOSC1/TOSC2 (PC6/PC7), without it the Timer2 register writes never complete and the
+ * power-down hangs. Timer2 belongs to this module once a wake source is registered.
+ */
+#define POWER_CLOCK_CRYSTAL_HZ         32768UL
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+/* Times are in SysTime counts (SYSTIME_US_PER_COUNT each) */
+typedef struct
+{
+	uint32 total_time;          /* Time since the last Power_resetStats, the power-downs included */
+	uint32 idle_time;           /* Time spent in SLEEP_MODE_IDLE */
+	uint32 power_down_time;     /* Time spent in power-down, counted by Timer2 at 32 Hz */
+	uint32 idle_count;          /* Number of idle sleeps */
+	uint16 power_down_count;    /* Number of power-downs */
+}Power_StatsType;
+
+/*******************************************************************************
+ *                              Functions Prototypes                           *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Select the idle sleep mode and start the statistics. SysTime_init must be called first.
+ */
+void Power_init(void);
+
+/*
+ * Description :
+ * Sleep until the next interrupt, call it whenever no work is pending.
+ * After POWER_DOWN_TIMEOUT_SECONDS without activity it enters power-down if a
+ * power-down wake source is registered.
+ */
+void Power_idle(void);
+
+/*
+ * Description :
+ * Sleep in idle mode for the required number of milliseconds.
+ */
+void Power_sleepMs(uint16 ms);
+
+/*
+ * Description :
+ * Restart the inactivity timer (user input, link traffic...).
+ */
+void Power_notifyActivity(void);
+
+/*
+ * Description :
+ * Register the power-down wake source: prepare is called with interrupts disabled
+ * just before power-down to arm the wake interrupt, it can return FALSE to stay awake.
+ * It is called again after each Timer2 overflow wake (every 8 s): TRUE sleeps again,
+ * FALSE ends the power-down once the wake source fired. resume is called after the
+ * wake up. The first wake source starts Timer2 (POWER_CLOCK_CRYSTAL_HZ).
+ * Pass NULL_PTR to disable power-down.
+ */
+void Power_setPowerDownCallBacks(boolean (*a_prepare)(void), void (*a_resume)(void));
+
+/*
+ * Description :
+ * Copy the time spent in each sleep state since the last reset.
+ */
+void Power_getStats(Power_StatsType *stats);
+
+/*
+ * Description :
+ * Clear the statistics.
+ */
+void Power_resetStats(void);
+
+#endif /* POWER_H_ */
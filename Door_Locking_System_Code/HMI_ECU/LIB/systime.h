@@ -0,0 +1,94 @@
+ /******************************************************************************
+ *
+ * Module: SYSTIME
+ *
+ * File Name: systime.h
+ *
+ * Description: Header file for the system time base built on Timer1
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#ifndef SYSTIME_H_
+#define SYSTIME_H_
+
+#include "std_types.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/* Timer1 runs from F_CPU/256, one count is 32us at 8MHz */
+#define SYSTIME_COUNTS_PER_SECOND      31250UL
+#define SYSTIME_US_PER_COUNT           32UL
+
+/* Timer1 compare period, 125 counts = 4ms tick */
+#define SYSTIME_COUNTS_PER_TICK        125U
+#define SYSTIME_TICKS_PER_SECOND       (SYSTIME_COUNTS_PER_SECOND / SYSTIME_COUNTS_PER_TICK)
+#define SYSTIME_MS_PER_TICK            (1000U / SYSTIME_TICKS_PER_SECOND)
+
+/* Maximum number of functions called on every tick */
+#define SYSTIME_MAX_TICK_HOOKS         4
+
+/* Convert a SysTime_now() difference to microseconds/milliseconds */
+#define SYSTIME_TO_US(counts)          ((uint32)(counts) * SYSTIME_US_PER_COUNT)
+#define SYSTIME_TO_MS(counts)          (((uint32)(counts) * SYSTIME_US_PER_COUNT) / 1000UL)
+
+/* Same in whole ticks then the rest, for the times over the 71 minutes where SYSTIME_TO_MS overflows */
+#define SYSTIME_LONG_TO_MS(counts) \
+	((((uint32)(counts) / SYSTIME_COUNTS_PER_TICK) * SYSTIME_MS_PER_TICK) + \
+	((((uint32)(counts) % SYSTIME_COUNTS_PER_TICK) * SYSTIME_MS_PER_TICK) / SYSTIME_COUNTS_PER_TICK))
+
+/* Convert milliseconds to ticks, rounded up */
+#define SYSTIME_MS_TO_TICKS(ms)        (((uint32)(ms) + SYSTIME_MS_PER_TICK - 1) / SYSTIME_MS_PER_TICK)
+
+/*******************************************************************************
+ *                              Functions Prototypes                           *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Start Timer1 in compare mode with a SYSTIME_MS_PER_TICK period and attach the time keeping callback.
+ */
+void SysTime_init(void);
+
+/*
+ * Description :
+ * Register a function to be called from the Timer1 interrupt on every tick.
+ * Hooks are called in the registration order.
+ * Returns FALSE if all the SYSTIME_MAX_TICK_HOOKS slots are used.
+ */
+boolean SysTime_addTickHook(void (*a_ptr)(void));
+
+/*
+ * Description :
+ * Return the time since SysTime_init in timer counts (SYSTIME_US_PER_COUNT each).
+ */
+uint32 SysTime_now(void);
+
+/*
+ * Description :
+ * Return the number of ticks since SysTime_init.
+ */
+uint32 SysTime_getTicks(void);
+
+/*
+ * Description :
+ * Return the number of whole seconds since SysTime_init.
+ */
+uint32 SysTime_getSeconds(void);
+
+/*
+ * Description :
+ * Return TRUE once the required number of seconds passed since start_seconds.
+ */
+boolean SysTime_isElapsed(uint32 start_seconds, uint8 seconds);
+
+/*
+ * Description :
+ * Busy wait for the required number of seconds.
+ */
+void SysTime_delaySeconds(uint8 seconds);
+
+#endif /* SYSTIME_H_ */
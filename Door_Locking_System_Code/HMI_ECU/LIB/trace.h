@@ -0,0 +1,134 @@
+ /******************************************************************************
+ *
+ * Module: TRACE
+ *
+ * File Name: trace.h
+ *
+ * Description: Header file for the binary trace buffer.
+ *              Fixed size records (timestamp, event, argument) are stored in an
+ *              SRAM ring and streamed over the UART link while it is idle.
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include "std_types.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/* Set to 0 to remove all the trace points (can also be overridden from the compiler command line) */
+#ifndef TRACE_ENABLE
+#define TRACE_ENABLE                   1
+#endif
+
+/* ISR entry/exit records, off by default as the 4ms tick alone fills the ring quickly */
+#define TRACE_ISR_ENABLE               0
+
+/* Number of records in the ring, must be a power of 2 */
+#define TRACE_BUFFER_SIZE              32
+
+/*
+ * Each drained record is one text line "T<source><time:8><event:2><arg:4>\n" in upper case hex.
+ * Text never contains the READY_BYTE/DONE_BYTE values, so the other ECU drops it
+ * while it waits for a handshake byte.
+ */
+#define TRACE_LINE_START               'T'
+
+/*
+ * Statistics read with STATS_SNAPSHOT_COMMAND, one text line per value
+ * "V<source><kind:2><id:4><value:8>\n" in upper case hex, times are in ms.
+ */
+#define TRACE_VALUE_LINE_START         'V'
+
+#if (TRACE_ENABLE == 1)
+#define TRACE(event, arg)              Trace_record((event), (arg))
+#else
+#define TRACE(event, arg)              ((void)(arg))
+#endif
+
+#if ((TRACE_ENABLE == 1) && (TRACE_ISR_ENABLE == 1))
+#define TRACE_ISR(event, isr)          Trace_record((event), (isr))
+#else
+#define TRACE_ISR(event, isr)          ((void)0)
+#endif
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+/* Event ids, keep Tools/trace_decode.py in sync */
+typedef enum
+{
+	TRACE_EVENT_DROPPED,           /* arg: number of records lost because the ring was full */
+	TRACE_EVENT_STATE,             /* arg: FSM state entered */
+	TRACE_EVENT_ISR_ENTER,         /* arg: Trace_IsrType */
+	TRACE_EVENT_ISR_EXIT,          /* arg: Trace_IsrType */
+	TRACE_EVENT_LINK_TX,           /* arg: protocol byte sent */
+	TRACE_EVENT_LINK_RX,           /* arg: protocol byte received */
+	TRACE_EVENT_TWI_READ,          /* arg: EEPROM address */
+	TRACE_EVENT_TWI_WRITE,         /* arg: EEPROM address */
+	TRACE_EVENT_TWI_END,           /* arg: SUCCESS/ERROR */
+	TRACE_EVENT_LCD_COMMAND,       /* arg: LCD command */
+	TRACE_EVENT_KEYPAD_WAKE,       /* arg: SysTime counts from the keypad wake interrupt to the first scan */
+	TRACE_EVENT_USER               /* First id free for the application */
+}Trace_EventType;
+
+/* Kinds of the statistics lines, keep Tools/latency_report.py in sync */
+typedef enum
+{
+	TRACE_VALUE_STATE_TIME,        /* id: FSM state, value: time spent in it */
+	TRACE_VALUE_STATE_ENTRIES,     /* id: FSM state, value: number of times it was entered */
+	TRACE_VALUE_TRANSITIONS,       /* id: state * number of events + event, value: number of times taken */
+	TRACE_VALUE_STACK_UNUSED,      /* id: task priority, value: stack bytes never used */
+	TRACE_VALUE_POWER_TIME,        /* id: Trace_PowerType, value: time in ms */
+	TRACE_VALUE_POWER_COUNT        /* id: Trace_PowerType, value: number of sleeps */
+}Trace_ValueType;
+
+/* Ids of the power statistics lines (LIB/power.h Power_StatsType) */
+typedef enum
+{
+	TRACE_POWER_TOTAL, TRACE_POWER_IDLE, TRACE_POWER_DOWN
+}Trace_PowerType;
+
+typedef enum
+{
+	TRACE_ISR_TIMER0, TRACE_ISR_TIMER1, TRACE_ISR_TIMER2, TRACE_ISR_UART_RX
+}Trace_IsrType;
+
+/*******************************************************************************
+ *                              Functions Prototypes                           *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Clear the ring and set the source character written in the drained lines
+ * ('C' for the Control ECU, 'H' for the HMI ECU).
+ */
+void Trace_init(uint8 source);
+
+/*
+ * Description :
+ * Store a record with the current SysTime_now() timestamp, can be called from an ISR.
+ * The record is dropped (and counted) if the ring is full.
+ */
+void Trace_record(uint8 event, uint16 arg);
+
+/*
+ * Description :
+ * Send the oldest record over the UART.
+ * Returns FALSE if the ring is empty.
+ */
+boolean Trace_drainRecord(void);
+
+/*
+ * Description :
+ * Send a statistics line at once (Trace_ValueType kind), not through the ring.
+ */
+void Trace_sendValue(uint8 kind, uint16 id, uint32 value);
+
+#endif /* TRACE_H_ */
@@ -11,8 +11,8 @@
  *******************************************************************************/
 
 #include "gpio.h"
-#include "common_macros.h" /* To use the macros like SET_BIT */
-#include "avr/io.h" /* To use the IO Ports Registers */
+#include "registers.h" /* To use the IO Ports Registers */
+#include <avr/interrupt.h> /* For cli() in the masked writes */
 
 /*
  * Description :
@@ -38,41 +38,41 @@ void GPIO_setupPinDirection(uint8 port_num, uint8 pin_num, GPIO_PinDirectionType
 		case PORTA_ID:
 			if(direction == PIN_OUTPUT)
 			{
-				SET_BIT(DDRA,pin_num);
+				REG_SET_BIT(DDRA,pin_num);
 			}
 			else
 			{
-				CLEAR_BIT(DDRA,pin_num);
+				REG_CLEAR_BIT(DDRA,pin_num);
 			}
 			break;
 		case PORTB_ID:
 			if(direction == PIN_OUTPUT)
 			{
-				SET_BIT(DDRB,pin_num);
+				REG_SET_BIT(DDRB,pin_num);
 			}
 			else
 			{
-				CLEAR_BIT(DDRB,pin_num);
+				REG_CLEAR_BIT(DDRB,pin_num);
 			}
 			break;
 		case PORTC_ID:
 			if(direction == PIN_OUTPUT)
 			{
-				SET_BIT(DDRC,pin_num);
+				REG_SET_BIT(DDRC,pin_num);
 			}
 			else
 			{
-				CLEAR_BIT(DDRC,pin_num);
+				REG_CLEAR_BIT(DDRC,pin_num);
 			}
 			break;
 		case PORTD_ID:
 			if(direction == PIN_OUTPUT)
 			{
-				SET_BIT(DDRD,pin_num);
+				REG_SET_BIT(DDRD,pin_num);
 			}
 			else
 			{
-				CLEAR_BIT(DDRD,pin_num);
+				REG_CLEAR_BIT(DDRD,pin_num);
 			}
 			break;
 		}
@@ -104,41 +104,41 @@ void GPIO_writePin(uint8 port_num, uint8 pin_num, uint8 value)
 		case PORTA_ID:
 			if(value == LOGIC_HIGH)
 			{
-				SET_BIT(PORTA,pin_num);
+				REG_SET_BIT(PORTA,pin_num);
 			}
 			else
 			{
-				CLEAR_BIT(PORTA,pin_num);
+				REG_CLEAR_BIT(PORTA,pin_num);
 			}
 			break;
 		case PORTB_ID:
 			if(value == LOGIC_HIGH)
 			{
-				SET_BIT(PORTB,pin_num);
+				REG_SET_BIT(PORTB,pin_num);
 			}
 			else
 			{
-				CLEAR_BIT(PORTB,pin_num);
+				REG_CLEAR_BIT(PORTB,pin_num);
 			}
 			break;
 		case PORTC_ID:
 			if(value == LOGIC_HIGH)
 			{
-				SET_BIT(PORTC,pin_num);
+				REG_SET_BIT(PORTC,pin_num);
 			}
 			else
 			{
-				CLEAR_BIT(PORTC,pin_num);
+				REG_CLEAR_BIT(PORTC,pin_num);
 			}
 			break;
 		case PORTD_ID:
 			if(value == LOGIC_HIGH)
 			{
-				SET_BIT(PORTD,pin_num);
+				REG_SET_BIT(PORTD,pin_num);
 			}
 			else
 			{
-				CLEAR_BIT(PORTD,pin_num);
+				REG_CLEAR_BIT(PORTD,pin_num);
 			}
 			break;
 		}
@@ -169,7 +169,7 @@ uint8 GPIO_readPin(uint8 port_num, uint8 pin_num)
 		switch(port_num)
 		{
 		case PORTA_ID:
-			if(BIT_IS_SET(PINA,pin_num))
+			if(REG_BIT_IS_SET(PINA,pin_num))
 			{
 				pin_value = LOGIC_HIGH;
 			}
@@ -179,7 +179,7 @@ uint8 GPIO_readPin(uint8 port_num, uint8 pin_num)
 			}
 			break;
 		case PORTB_ID:
-			if(BIT_IS_SET(PINB,pin_num))
+			if(REG_BIT_IS_SET(PINB,pin_num))
 			{
 				pin_value = LOGIC_HIGH;
 			}
@@ -189,7 +189,7 @@ uint8 GPIO_readPin(uint8 port_num, uint8 pin_num)
 			}
 			break;
 		case PORTC_ID:
-			if(BIT_IS_SET(PINC,pin_num))
+			if(REG_BIT_IS_SET(PINC,pin_num))
 			{
 				pin_value = LOGIC_HIGH;
 			}
@@ -199,7 +199,7 @@ uint8 GPIO_readPin(uint8 port_num, uint8 pin_num)
 			}
 			break;
 		case PORTD_ID:
-			if(BIT_IS_SET(PIND,pin_num))
+			if(REG_BIT_IS_SET(PIND,pin_num))
 			{
 				pin_value = LOGIC_HIGH;
 			}
@@ -237,16 +237,16 @@ void GPIO_setupPortDirection(uint8 port_num, GPIO_PortDirectionType direction)
 		switch(port_num)
 		{
 		case PORTA_ID:
-			DDRA = direction;
+			REG_WRITE(DDRA,direction);
 			break;
 		case PORTB_ID:
-			DDRB = direction;
+			REG_WRITE(DDRB,direction);
 			break;
 		case PORTC_ID:
-			DDRC = direction;
+			REG_WRITE(DDRC,direction);
 			break;
 		case PORTD_ID:
-			DDRD = direction;
+			REG_WRITE(DDRD,direction);
 			break;
 		}
 	}
@@ -275,16 +275,16 @@ void GPIO_writePort(uint8 port_num, uint8 value)
 		switch(port_num)
 		{
 		case PORTA_ID:
-			PORTA = value;
+			REG_WRITE(PORTA,value);
 			break;
 		case PORTB_ID:
-			PORTB = value;
+			REG_WRITE(PORTB,value);
 			break;
 		case PORTC_ID:
-			PORTC = value;
+			REG_WRITE(PORTC,value);
 			break;
 		case PORTD_ID:
-			PORTD = value;
+			REG_WRITE(PORTD,value);
 			break;
 		}
 	}
@@ -313,19 +313,107 @@ uint8 GPIO_readPort(uint8 port_num)
 		switch(port_num)
 		{
 		case PORTA_ID:
-			value = PINA;
+			value = REG_READ(PINA);
 			break;
 		case PORTB_ID:
-			value = PINB;
+			value = REG_READ(PINB);
 			break;
 		case PORTC_ID:
-			value = PINC;
+			value = REG_READ(PINC);
 			break;
 		case PORTD_ID:
-			value = PIND;
+			value = REG_READ(PIND);
 			break;
 		}
 	}
 
 	return value;
 }
+
+/*
+ * Description :
+ * Write the bits of value selected by mask on the required port, the other pins keep their value.
+ * The selected pins change together in one port write, with the interrupts disabled between
+ * the read and the write so an ISR changing other pins of the port is not undone.
+ * If the input port number is not correct, The function will not handle the request.
+ */
+void GPIO_writePortMasked(uint8 port_num, uint8 mask, uint8 value)
+{
+	uint8 sreg;
+
+	/*
+	 * Check if the input number is greater than NUM_OF_PORTS value.
+	 * In this case the input is not valid port number
+	 */
+	if(port_num >= NUM_OF_PORTS)
+	{
+		/* Do Nothing */
+	}
+	else
+	{
+		value &= mask;
+		sreg = SREG;
+		cli();
+		/* Write the selected pins of the port as required */
+		switch(port_num)
+		{
+		case PORTA_ID:
+			REG_WRITE(PORTA,(REG_READ(PORTA) & ~mask) | value);
+			break;
+		case PORTB_ID:
+			REG_WRITE(PORTB,(REG_READ(PORTB) & ~mask) | value);
+			break;
+		case PORTC_ID:
+			REG_WRITE(PORTC,(REG_READ(PORTC) & ~mask) | value);
+			break;
+		case PORTD_ID:
+			REG_WRITE(PORTD,(REG_READ(PORTD) & ~mask) | value);
+			break;
+		}
+		SREG = sreg;
+	}
+}
+
+/*
+ * Description :
+ * Setup the direction of the pins selected by mask, a bit of direction set to 1 makes its pin
+ * an output (PORT_OUTPUT/PORT_INPUT set all the selected pins). The other pins keep their direction.
+ * Same single interrupt-safe register write as GPIO_writePortMasked.
+ * If the input port number is not correct, The function will not handle the request.
+ */
+void GPIO_setupPortDirectionMasked(uint8 port_num, uint8 mask, uint8 direction)
+{
+	uint8 sreg;
+
+	/*
+	 * Check if the input number is greater than NUM_OF_PORTS value.
+	 * In this case the input is not valid port number
+	 */
+	if(port_num >= NUM_OF_PORTS)
+	{
+		/* Do Nothing */
+	}
+	else
+	{
+		direction &= mask;
+		sreg = SREG;
+		cli();
+		/* Setup the direction of the selected pins as required */
+		switch(port_num)
+		{
+		case PORTA_ID:
+			REG_WRITE(DDRA,(REG_READ(DDRA) & ~mask) | direction);
+			break;
+		case PORTB_ID:
+			REG_WRITE(DDRB,(REG_READ(DDRB) & ~mask) | direction);
+			break;
+		case PORTC_ID:
+			REG_WRITE(DDRC,(REG_READ(DDRC) & ~mask) | direction);
+			break;
+		case PORTD_ID:
+			REG_WRITE(DDRD,(REG_READ(DDRD) & ~mask) | direction);
+			break;
+		}
+		SREG = sreg;
+	}
+}
@@ -14,6 +14,8 @@
 #define GPIO_H_
 
 #include "std_types.h"
+#include <avr/io.h> /* For the registers of the compile-time access macros */
+#include <avr/interrupt.h> /* For cli() in the masked port macros */
 
 /*******************************************************************************
  *                                Definitions                                  *
@@ -99,4 +101,117 @@ void GPIO_writePort(uint8 port_num, uint8 value);
  */
 uint8 GPIO_readPort(uint8 port_num);
 
+/*
+ * Description :
+ * Write the bits of value selected by mask on the required port, the other pins keep their value.
+ * The selected pins change together in one port write, with the interrupts disabled between
+ * the read and the write so an ISR changing other pins of the port is not undone.
+ * If the input port number is not correct, The function will not handle the request.
+ */
+void GPIO_writePortMasked(uint8 port_num, uint8 mask, uint8 value);
+
+/*
+ * Description :
+ * Setup the direction of the pins selected by mask, a bit of direction set to 1 makes its pin
+ * an output (PORT_OUTPUT/PORT_INPUT set all the selected pins). The other pins keep their direction.
+ * Same single interrupt-safe register write as GPIO_writePortMasked.
+ * If the input port number is not correct, The function will not handle the request.
+ */
+void GPIO_setupPortDirectionMasked(uint8 port_num, uint8 mask, uint8 direction);
+
+/*******************************************************************************
+ *                        Compile-time Access Macros                           *
+ *******************************************************************************/
+
+/*
+ * Same operations as the functions above for constant ids: the port id must be one of
+ * the PORTx_ID values (or a macro defined as one), the pin id a constant expression.
+ * An invalid port id does not compile (undefined GPIO_xxx_REG_n), an invalid pin id
+ * fails with a negative array size. On the target a pin set/clear is one sbi/cbi
+ * instruction with any optimization level. In host builds (tools) the macros call
+ * the functions, so a host GPIO layer still sees every pin change.
+ * The functions stay for port and pin numbers only known at run time.
+ */
+
+/* Registers of a port id */
+#define GPIO_PORT_REG(port_id)             GPIO_PASTE(GPIO_PORT_REG_,port_id)
+#define GPIO_DDR_REG(port_id)              GPIO_PASTE(GPIO_DDR_REG_,port_id)
+#define GPIO_PIN_REG(port_id)              GPIO_PASTE(GPIO_PIN_REG_,port_id)
+
+/* The pin id, after checking it at compile time */
+#define GPIO_PIN_BIT(pin_id)               ((pin_id) + 0 * sizeof(char[((pin_id) < NUM_OF_PINS_PER_PORT) ? 1 : -1]))
+
+#if defined(__AVR__)
+
+#define GPIO_SET_PIN(port_id,pin_id)       GPIO_SBI(GPIO_PORT_REG(port_id),pin_id)
+#define GPIO_CLEAR_PIN(port_id,pin_id)     GPIO_CBI(GPIO_PORT_REG(port_id),pin_id)
+#define GPIO_PIN_OUTPUT(port_id,pin_id)    GPIO_SBI(GPIO_DDR_REG(port_id),pin_id)
+#define GPIO_PIN_INPUT(port_id,pin_id)     GPIO_CBI(GPIO_DDR_REG(port_id),pin_id)
+
+#define GPIO_READ_PIN(port_id,pin_id) \
+	((GPIO_PIN_REG(port_id) & (1 << GPIO_PIN_BIT(pin_id))) ? LOGIC_HIGH : LOGIC_LOW)
+#define GPIO_PORT_DIRECTION(port_id,direction) (GPIO_DDR_REG(port_id) = (direction))
+#define GPIO_WRITE_PORT(port_id,value)     (GPIO_PORT_REG(port_id) = (value))
+#define GPIO_READ_PORT(port_id)            (GPIO_PIN_REG(port_id))
+
+#define GPIO_WRITE_PORT_MASKED(port_id,mask,value) \
+	GPIO_MASKED_WRITE(GPIO_PORT_REG(port_id),mask,value)
+#define GPIO_PORT_DIRECTION_MASKED(port_id,mask,direction) \
+	GPIO_MASKED_WRITE(GPIO_DDR_REG(port_id),mask,direction)
+
+#else
+
+#define GPIO_SET_PIN(port_id,pin_id)       GPIO_writePin((port_id),GPIO_PIN_BIT(pin_id),LOGIC_HIGH)
+#define GPIO_CLEAR_PIN(port_id,pin_id)     GPIO_writePin((port_id),GPIO_PIN_BIT(pin_id),LOGIC_LOW)
+#define GPIO_PIN_OUTPUT(port_id,pin_id)    GPIO_setupPinDirection((port_id),GPIO_PIN_BIT(pin_id),PIN_OUTPUT)
+#define GPIO_PIN_INPUT(port_id,pin_id)     GPIO_setupPinDirection((port_id),GPIO_PIN_BIT(pin_id),PIN_INPUT)
+
+#define GPIO_READ_PIN(port_id,pin_id)      GPIO_readPin((port_id),GPIO_PIN_BIT(pin_id))
+#define GPIO_PORT_DIRECTION(port_id,direction) GPIO_setupPortDirection((port_id),(direction))
+#define GPIO_WRITE_PORT(port_id,value)     GPIO_writePort((port_id),(value))
+#define GPIO_READ_PORT(port_id)            GPIO_readPort(port_id)
+
+#define GPIO_WRITE_PORT_MASKED(port_id,mask,value) \
+	GPIO_writePortMasked((port_id),(mask),(value))
+#define GPIO_PORT_DIRECTION_MASKED(port_id,mask,direction) \
+	GPIO_setupPortDirectionMasked((port_id),(mask),(direction))
+
+#endif
+
+/* Write LOGIC_HIGH or LOGIC_LOW, a sbi or a cbi selected by the value */
+#define GPIO_WRITE_PIN(port_id,pin_id,value) \
+	do { if((value) == LOGIC_HIGH) { GPIO_SET_PIN(port_id,pin_id); } else { GPIO_CLEAR_PIN(port_id,pin_id); } } while(0)
+
+/* Helpers of the macros above */
+#define GPIO_PASTE(prefix,port_id)         GPIO_PASTE_EXPANDED(prefix,port_id)
+#define GPIO_PASTE_EXPANDED(prefix,port_id) prefix##port_id
+
+#define GPIO_PORT_REG_0                    PORTA
+#define GPIO_PORT_REG_1                    PORTB
+#define GPIO_PORT_REG_2                    PORTC
+#define GPIO_PORT_REG_3                    PORTD
+#define GPIO_DDR_REG_0                     DDRA
+#define GPIO_DDR_REG_1                     DDRB
+#define GPIO_DDR_REG_2                     DDRC
+#define GPIO_DDR_REG_3                     DDRD
+#define GPIO_PIN_REG_0                     PINA
+#define GPIO_PIN_REG_1                     PINB
+#define GPIO_PIN_REG_2                     PINC
+#define GPIO_PIN_REG_3                     PIND
+
+#define GPIO_SBI(reg,pin_id) \
+	__asm__ __volatile__ ("sbi %0, %1" : : "I" (_SFR_IO_ADDR(reg)), "I" (GPIO_PIN_BIT(pin_id)))
+#define GPIO_CBI(reg,pin_id) \
+	__asm__ __volatile__ ("cbi %0, %1" : : "I" (_SFR_IO_ADDR(reg)), "I" (GPIO_PIN_BIT(pin_id)))
+
+/* The new bits are computed before the interrupts are disabled, only the in/and/or/out is protected */
+#define GPIO_MASKED_WRITE(reg,mask,value) \
+	do { \
+		uint8 gpio_bits = (uint8)((value) & (mask)); \
+		uint8 gpio_sreg = SREG; \
+		cli(); \
+		(reg) = ((reg) & (uint8)~(mask)) | gpio_bits; \
+		SREG = gpio_sreg; \
+	} while(0)
+
 #endif /* GPIO_H_ */
@@ -0,0 +1,72 @@
+ /******************************************************************************
+ *
+ * Module: REGISTERS
+ *
+ * File Name: registers.h
+ *
+ * Description: Register access layer of the MCAL drivers. On the target the
+ *              macros are the plain <avr/io.h> register accesses, the generated
+ *              code is the same as writing the register directly. In host builds
+ *              (Tools/host) each register name is an address in a virtual register
+ *              file and the macros call it, so peripheral models see every access.
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#ifndef REGISTERS_H_
+#define REGISTERS_H_
+
+#include "std_types.h"
+#include <avr/io.h>
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * The drivers access the I/O registers through these macros only. A register used
+ * directly does not compile in a host build (the register names are not lvalues there).
+ * SREG is the exception: it is a plain variable on the host, the critical sections
+ * keep saving and restoring it directly.
+ */
+
+#if defined(__AVR__)
+
+#define REG_READ(reg)                  (reg)
+#define REG_WRITE(reg,value)           ((reg) = (value))
+#define REG_SET_BITS(reg,mask)         ((reg) |= (mask))
+#define REG_CLEAR_BITS(reg,mask)       ((reg) &= (uint8)~(mask))
+
+/* 16-bit registers (TCNT1, OCR1A...), the compiler orders the low/high byte accesses */
+#define REG_READ16(reg)                (reg)
+#define REG_WRITE16(reg,value)         ((reg) = (value))
+
+/* Reference to a register chosen at run time, read in an ISR without a switch */
+typedef volatile uint8 *REG_RefType;
+#define REG_REF(reg)                   (&(reg))
+#define REG_READ_REF(ref)              (*(ref))
+
+#else
+
+#define REG_READ(reg)                  Host_readRegister(reg)
+#define REG_WRITE(reg,value)           Host_writeRegister((reg),(value))
+#define REG_SET_BITS(reg,mask)         Host_writeRegister((reg),Host_readRegister(reg) | (mask))
+#define REG_CLEAR_BITS(reg,mask)       Host_writeRegister((reg),Host_readRegister(reg) & (uint8)~(mask))
+
+#define REG_READ16(reg)                Host_readRegister16(reg)
+#define REG_WRITE16(reg,value)         Host_writeRegister16((reg),(value))
+
+typedef Host_RegisterType REG_RefType;
+#define REG_REF(reg)                   (reg)
+#define REG_READ_REF(ref)              Host_readRegister(ref)
+
+#endif
+
+/* Single bit helpers, same meaning as the common_macros.h ones for registers */
+#define REG_SET_BIT(reg,bit)           REG_SET_BITS(reg,(1 << (bit)))
+#define REG_CLEAR_BIT(reg,bit)         REG_CLEAR_BITS(reg,(1 << (bit)))
+#define REG_BIT_IS_SET(reg,bit)        (REG_READ(reg) & (1 << (bit)))
+#define REG_BIT_IS_CLEAR(reg,bit)      (!(REG_READ(reg) & (1 << (bit))))
+
+#endif /* REGISTERS_H_ */
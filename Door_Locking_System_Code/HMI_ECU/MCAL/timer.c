@@ -6,9 +6,9 @@
 
 #include "timer.h"
 #include "gpio.h"
-#include <avr/io.h>
+#include "registers.h"
 #include <avr/interrupt.h>
-#include "common_macros.h"
+#include "trace.h"
 
 /* Callback function pointers for each timer */
 static volatile void (*g_callBackPtr_Timer0)(void) = NULL_PTR;
@@ -18,19 +18,23 @@ static volatile void (*g_callBackPtr_Timer2)(void) = NULL_PTR;
 /* ISR for Timer0 Overflow */
 ISR(TIMER0_OVF_vect)
 {
+    TRACE_ISR(TRACE_EVENT_ISR_ENTER, TRACE_ISR_TIMER0);
     if (g_callBackPtr_Timer0 != NULL_PTR)
     {
         g_callBackPtr_Timer0(); /* Call the callback function for Timer0 Overflow */
     }
+    TRACE_ISR(TRACE_EVENT_ISR_EXIT, TRACE_ISR_TIMER0);
 }
 
 /* ISR for Timer0 Compare Match */
 ISR(TIMER0_COMP_vect)
 {
+    TRACE_ISR(TRACE_EVENT_ISR_ENTER, TRACE_ISR_TIMER0);
     if (g_callBackPtr_Timer0 != NULL_PTR)
     {
         g_callBackPtr_Timer0(); /* Call the callback function for Timer0 Compare Match */
     }
+    TRACE_ISR(TRACE_EVENT_ISR_EXIT, TRACE_ISR_TIMER0);
 }
 
 /*************************** TIMER1 *******************************/
@@ -38,19 +42,23 @@ ISR(TIMER0_COMP_vect)
 /* ISR for Timer1 Overflow */
 ISR(TIMER1_OVF_vect)
 {
+    TRACE_ISR(TRACE_EVENT_ISR_ENTER, TRACE_ISR_TIMER1);
     if (g_callBackPtr_Timer1 != NULL_PTR)
     {
         g_callBackPtr_Timer1(); /* Call the callback function for Timer1 Overflow */
     }
+    TRACE_ISR(TRACE_EVENT_ISR_EXIT, TRACE_ISR_TIMER1);
 }
 
 /* ISR for Timer1 Compare Match */
 ISR(TIMER1_COMPA_vect)
 {
+    TRACE_ISR(TRACE_EVENT_ISR_ENTER, TRACE_ISR_TIMER1);
     if (g_callBackPtr_Timer1 != NULL_PTR)
     {
         g_callBackPtr_Timer1(); /* Call the callback function for Timer1 Compare Match */
     }
+    TRACE_ISR(TRACE_EVENT_ISR_EXIT, TRACE_ISR_TIMER1);
 }
 
 /************************** TIMER2 **************************/
@@ -58,19 +66,23 @@ ISR(TIMER1_COMPA_vect)
 /* ISR for Timer2 Overflow */
 ISR(TIMER2_OVF_vect)
 {
+    TRACE_ISR(TRACE_EVENT_ISR_ENTER, TRACE_ISR_TIMER2);
     if (g_callBackPtr_Timer2 != NULL_PTR)
     {
         g_callBackPtr_Timer2(); /* Call the callback function for Timer2 Overflow */
     }
+    TRACE_ISR(TRACE_EVENT_ISR_EXIT, TRACE_ISR_TIMER2);
 }
 
 /* ISR for Timer2 Compare Match */
 ISR(TIMER2_COMP_vect)
 {
+    TRACE_ISR(TRACE_EVENT_ISR_ENTER, TRACE_ISR_TIMER2);
     if (g_callBackPtr_Timer2 != NULL_PTR)
     {
         g_callBackPtr_Timer2(); /* Call the callback function for Timer2 Compare Match */
     }
+    TRACE_ISR(TRACE_EVENT_ISR_EXIT, TRACE_ISR_TIMER2);
 }
 
 /* Function to initialize the timer with configurations */
@@ -83,29 +95,29 @@ void Timer_init(const Timer_ConfigType *Config_Ptr)
 
 
 
-            TCNT0 = (uint8)(Config_Ptr->timer_InitialValue); /* Set initial count value */
+            REG_WRITE(TCNT0, (uint8)(Config_Ptr->timer_InitialValue)); /* Set initial count value */
 
-            TCCR0 = ((TCNT0 & 0xF8) | (Config_Ptr->timer_clock)); /* Set clock source */
+            REG_WRITE(TCCR0, ((REG_READ(TCNT0) & 0xF8) | (Config_Ptr->timer_clock))); /* Set clock source */
 
-            TCCR0 |= (1 << FOC0); /* Force Output Compare for non-PWM mode */
+            REG_SET_BIT(TCCR0, FOC0); /* Force Output Compare for non-PWM mode */
 
             /* Configure Timer0 Mode */
             switch (Config_Ptr->timer_mode)
             {
                 case OVERFLOW:
-                    CLEAR_BIT(TCCR0, WGM00); /* Set to normal mode */
-                    CLEAR_BIT(TCCR0, WGM01);
+                    REG_CLEAR_BIT(TCCR0, WGM00); /* Set to normal mode */
+                    REG_CLEAR_BIT(TCCR0, WGM01);
 
-                    SET_BIT(TIMSK, TOIE0); /* Enable Timer0 Overflow interrupt */
+                    REG_SET_BIT(TIMSK, TOIE0); /* Enable Timer0 Overflow interrupt */
                     break;
 
                 case COMPARE:
-                    SET_BIT(TCCR0, WGM01);   /* Set to CTC mode */
-                    CLEAR_BIT(TCCR0, WGM00);
+                    REG_SET_BIT(TCCR0, WGM01);   /* Set to CTC mode */
+                    REG_CLEAR_BIT(TCCR0, WGM00);
 
-                    OCR0 = (uint8)(Config_Ptr->timer_compare_MatchValue); /* Set compare match value */
+                    REG_WRITE(OCR0, (uint8)(Config_Ptr->timer_compare_MatchValue)); /* Set compare match value */
 
-                    SET_BIT(TIMSK, OCIE0); /* Enable Timer0 Compare Match interrupt */
+                    REG_SET_BIT(TIMSK, OCIE0); /* Enable Timer0 Compare Match interrupt */
                     break;
             }
             break;
@@ -115,72 +127,72 @@ void Timer_init(const Timer_ConfigType *Config_Ptr)
 
 
         	/* FOC1A = 1, FOC1B = 1 for non-PWM Modes */
-        	TCCR1A = (1 << FOC1A) | (1 << FOC1B);
-        	TCCR1B = 0;
+        	REG_WRITE(TCCR1A, (1 << FOC1A) | (1 << FOC1B));
+        	REG_WRITE(TCCR1B, 0);
 
-            TCNT1 = Config_Ptr->timer_InitialValue; /* Set initial count value */
+            REG_WRITE16(TCNT1, Config_Ptr->timer_InitialValue); /* Set initial count value */
 
     		/* Start clock source */
-    		TCCR1B |= (Config_Ptr->timer_clock);
+    		REG_SET_BITS(TCCR1B, (Config_Ptr->timer_clock));
 
             /* Configure Timer1 Mode */
             switch (Config_Ptr->timer_mode)
             {
                 case OVERFLOW:
-                    CLEAR_BIT(TCCR1B, WGM13); /* Set to normal mode */
-                    CLEAR_BIT(TCCR1B, WGM12);
-                    CLEAR_BIT(TCCR1A, WGM11);
-                    CLEAR_BIT(TCCR1A, WGM10);
+                    REG_CLEAR_BIT(TCCR1B, WGM13); /* Set to normal mode */
+                    REG_CLEAR_BIT(TCCR1B, WGM12);
+                    REG_CLEAR_BIT(TCCR1A, WGM11);
+                    REG_CLEAR_BIT(TCCR1A, WGM10);
 
-                    SET_BIT(TIMSK, TOIE0); /* Enable Timer1 Overflow interrupt */
+                    REG_SET_BIT(TIMSK, TOIE0); /* Enable Timer1 Overflow interrupt */
                     break;
 
                 case COMPARE:
 
-                    SET_BIT(TCCR1B, WGM12); /* Set to CTC mode */
+                    REG_SET_BIT(TCCR1B, WGM12); /* Set to CTC mode */
 
 
-                    OCR1A = Config_Ptr->timer_compare_MatchValue; /* Set compare match value */
+                    REG_WRITE16(OCR1A, Config_Ptr->timer_compare_MatchValue); /* Set compare match value */
 
-                    SET_BIT(TIMSK, OCIE1A); /* Enable Timer1 Compare Match interrupt */
+                    REG_SET_BIT(TIMSK, OCIE1A); /* Enable Timer1 Compare Match interrupt */
                     break;
             }
             break;
 
         /* Initialize Timer2 */
         case TIMER2:
-            TCCR2 = 0; /* Reset Timer2 control register */
-            TCNT2 = 0; /* Reset Timer2 counter register */
-            OCR2 = 0;  /* Reset Timer2 Output Compare register */
+            REG_WRITE(TCCR2, 0); /* Reset Timer2 control register */
+            REG_WRITE(TCNT2, 0); /* Reset Timer2 counter register */
+            REG_WRITE(OCR2, 0);  /* Reset Timer2 Output Compare register */
 
-            CLEAR_BIT(TIMSK, OCIE2); /* Disable Timer2 Compare Match interrupt */
-            CLEAR_BIT(TIMSK, TOIE2); /* Disable Timer2 Overflow interrupt */
+            REG_CLEAR_BIT(TIMSK, OCIE2); /* Disable Timer2 Compare Match interrupt */
+            REG_CLEAR_BIT(TIMSK, TOIE2); /* Disable Timer2 Overflow interrupt */
 
-            TCNT2 = (Config_Ptr->timer_InitialValue) & 0x00FF; /* Set initial count value */
+            REG_WRITE(TCNT2, (Config_Ptr->timer_InitialValue) & 0x00FF); /* Set initial count value */
 
-            TCCR2 = (TCCR2 & 0xF8) | (Config_Ptr->timer_clock); /* Set clock source */
+            REG_WRITE(TCCR2, (REG_READ(TCCR2) & 0xF8) | (Config_Ptr->timer_clock)); /* Set clock source */
 
             /* Configure Timer2 Mode */
             switch (Config_Ptr->timer_mode)
             {
                 case OVERFLOW:
-                    CLEAR_BIT(TCCR2, WGM20); /* Set to normal mode */
-                    CLEAR_BIT(TCCR2, WGM21);
+                    REG_CLEAR_BIT(TCCR2, WGM20); /* Set to normal mode */
+                    REG_CLEAR_BIT(TCCR2, WGM21);
 
-                    SET_BIT(TCCR2, FOC2); /* Force Output Compare for non-PWM mode */
+                    REG_SET_BIT(TCCR2, FOC2); /* Force Output Compare for non-PWM mode */
 
-                    SET_BIT(TIMSK, TOIE2); /* Enable Timer2 Overflow interrupt */
+                    REG_SET_BIT(TIMSK, TOIE2); /* Enable Timer2 Overflow interrupt */
                     break;
 
                 case COMPARE:
-                    CLEAR_BIT(TCCR2, WGM20); /* Set to CTC mode */
-                    SET_BIT(TCCR2, WGM21);
+                    REG_CLEAR_BIT(TCCR2, WGM20); /* Set to CTC mode */
+                    REG_SET_BIT(TCCR2, WGM21);
 
-                    SET_BIT(TCCR2, FOC2); /* Force Output Compare for non-PWM mode */
+                    REG_SET_BIT(TCCR2, FOC2); /* Force Output Compare for non-PWM mode */
 
-                    OCR2 = (Config_Ptr->timer_compare_MatchValue) & 0x00FF; /* Set compare match value */
+                    REG_WRITE(OCR2, (Config_Ptr->timer_compare_MatchValue) & 0x00FF); /* Set compare match value */
 
-                    SET_BIT(TIMSK, OCIE2); /* Enable Timer2 Compare Match interrupt */
+                    REG_SET_BIT(TIMSK, OCIE2); /* Enable Timer2 Compare Match interrupt */
                     break;
             }
             break;
@@ -194,37 +206,37 @@ void Timer_deInit(Timer_ID_Type timer_type)
 	case TIMER0:
 
 		/* Clear all registers of Timer0 */
-		TCCR0 = 0;
-		TCNT0 = 0;
-		OCR0 = 0;
+		REG_WRITE(TCCR0, 0);
+		REG_WRITE(TCNT0, 0);
+		REG_WRITE(OCR0, 0);
 
 		/* Clear all interrupt enables for Timer0 (OCIE0=0, TOIE0=0) */
-		CLEAR_BIT(TIMSK, OCIE0);
-		CLEAR_BIT(TIMSK, TOIE0);
+		REG_CLEAR_BIT(TIMSK, OCIE0);
+		REG_CLEAR_BIT(TIMSK, TOIE0);
 		break;
 
 	case TIMER1:
 
 		/* Clear all registers of Timer1 */
-		TCCR1A = 0;
-		TCCR1B = 0;
-		TCNT1 = 0;
-		OCR1A = 0;
+		REG_WRITE(TCCR1A, 0);
+		REG_WRITE(TCCR1B, 0);
+		REG_WRITE16(TCNT1, 0);
+		REG_WRITE16(OCR1A, 0);
 
 		/* Clear all interrupt enables for Timer1 (TICIE1=0, OCIE1A=0, OCIE1B=0, TOIE1=0) */
-		TIMSK &= 0xC3; // Clear bits OCIE1A, OCIE1B, and TOIE1
+		REG_WRITE(TIMSK, REG_READ(TIMSK) & 0xC3); // Clear bits OCIE1A, OCIE1B, and TOIE1
 		break;
 
 	case TIMER2:
 
 		/* Clear all registers of Timer2 */
-		TCCR2 = 0;
-		TCNT2 = 0;
-		OCR2 = 0;
+		REG_WRITE(TCCR2, 0);
+		REG_WRITE(TCNT2, 0);
+		REG_WRITE(OCR2, 0);
 
 		/* Clear all interrupt enables for Timer2 (OCIE2=0, TOIE2=0) */
-		CLEAR_BIT(TIMSK, OCIE2);
-		CLEAR_BIT(TIMSK, TOIE2);
+		REG_CLEAR_BIT(TIMSK, OCIE2);
+		REG_CLEAR_BIT(TIMSK, TOIE2);
 		break;
 	}
 }
@@ -245,3 +257,24 @@ void Timer_setCallBack(void (*a_ptr)(void), Timer_ID_Type a_timer_ID)
             break;
     }
 }
+
+/* Function to read the current counter value of a specific timer */
+uint16 Timer_getCount(Timer_ID_Type timer_type)
+{
+    uint16 count = 0;
+
+    switch (timer_type)
+    {
+        case TIMER0:
+            count = REG_READ(TCNT0);
+            break;
+        case TIMER1:
+            count = REG_READ16(TCNT1); /* 16-bit read, the compiler reads TCNT1L first to latch TCNT1H */
+            break;
+        case TIMER2:
+            count = REG_READ(TCNT2);
+            break;
+    }
+
+    return count;
+}
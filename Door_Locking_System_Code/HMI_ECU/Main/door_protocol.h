@@ -0,0 +1,65 @@
+ /******************************************************************************
+ *
+ * Module: Door Protocol
+ *
+ * File Name: door_protocol.h
+ *
+ * Description: Constants shared by the HMI and Control ECUs on the UART link,
+ *              this file must be identical in both projects
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#ifndef DOOR_PROTOCOL_H_
+#define DOOR_PROTOCOL_H_
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/* Password configuration */
+#define PASSWARD_LENGTH           5
+
+/* UART communication bytes for readiness and completion */
+#define READY_BYTE                0xFF
+#define DONE_BYTE                 0xF0
+
+/*
+ * Password transfer: 1 to stream the keys to the Control ECU as they are typed
+ * (READY_BYTE handshake, key bytes, KEY_SUBMIT_BYTE), 0 to send the whole password
+ * in one frame after the submit key. The Control ECU checks the password on the
+ * submit only, the HMI submits complete passwords only.
+ */
+#define PASSWARD_STREAM_ENABLE    1
+
+/* Bytes of the key stream besides the key values */
+#define KEY_ERASE_BYTE            0xE2
+#define KEY_SUBMIT_BYTE           0xE3
+
+/* Number of retry attempts after the first wrong password */
+#define RETRIES                   2
+
+/* Password comparison results */
+#define EQUAL_PASS                0x10
+#define NOT_EQUAL_PASS            0x11
+
+/* User choices in the main options menu */
+#define OPEN_DOOR_CHOICE          '+'
+#define CHANGE_PASS_CHOICE        '-'
+
+/* Door state sent by the Control ECU at the end of each door move */
+#define DOOR_OPENED_BYTE          0xD0
+#define DOOR_CLOSED_BYTE          0xD1
+#define DOOR_FAULT_BYTE           0xD2      /* End of travel switch not reached in time or obstruction while opening, the motor stopped */
+#define DOOR_OBSTRUCTED_BYTE      0xD3      /* Obstruction while closing, the door opens again (the open move result follows) */
+
+/* Single bytes sent outside a transfer to read or clear the Control ECU latency histograms */
+#define STATS_SNAPSHOT_COMMAND    0xE0
+#define STATS_RESET_COMMAND       0xE1
+
+/* Sequence timings in seconds, the door travel is the expected one until both ECUs learned it */
+#define DOOR_TRAVEL_SECONDS       15
+#define LOCKOUT_SECONDS           60
+
+#endif /* DOOR_PROTOCOL_H_ */
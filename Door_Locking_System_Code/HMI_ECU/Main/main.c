@@ -7,37 +7,218 @@
 
 #include "lcd.h"
 #include "keypad.h"
-#include "timer.h"
 #include "uart.h"
+#include "fsm.h"
+#include "systime.h"
+#include "power.h"
+#include "trace.h"
+#include "door_protocol.h"
+#include "messages.h"
 #include <avr/io.h>
-#include <util/delay.h>
-
-// Define constants for application steps
-#define CREATE_SYSTEM_PASSWARD 1
-#define CHECK_PASSWARD 2
-#define MAIN_OPTIONS 3
-#define OPEN_DOOR 4
-
-// Define constants for password management
-#define PASSWARD_LENGTH 5
-#define READY_BYTE 0xFF
-#define DONE_BYTE 0xF0
-#define RETRIES 2
-#define EQUAL_PASS 0x10
-#define NOT_EQUAL_PASS 0x11
+#include <avr/pgmspace.h>
+
+// Define constants for application steps, step 0 is reserved by the FSM engine
+typedef enum {
+    NO_STEP = FSM_NO_STATE,
+    CREATE_SYSTEM_PASSWARD,
+    CHECK_PASSWARD,
+    MAIN_OPTIONS,
+    VERIFY_OPEN_DOOR,
+    VERIFY_CHANGE_PASS,
+    RETRY_PASSWARD,
+    OPEN_DOOR,
+    WAIT_PEOPLE,
+    CLOSE_DOOR,
+    SYSTEM_LOCKED,
+    NUM_OF_STEPS
+} Application_StepType;
+
+// Define the events generated by the steps
+typedef enum {
+    PASSWARDS_SENT_EVENT,
+    PASS_MATCH_EVENT,
+    PASS_MISMATCH_EVENT,
+    RETRIES_EXHAUSTED_EVENT,
+    OPEN_CHOICE_EVENT,
+    CHANGE_CHOICE_EVENT,
+    TICK_EVENT,
+    DOOR_CLEAR_EVENT,
+    DOOR_OPENED_EVENT,
+    DOOR_CLOSED_EVENT,
+    DOOR_FAULT_EVENT,
+    DOOR_OBSTRUCTED_EVENT,
+    NUM_OF_EVENTS
+} Application_EventType;
+
+// Hidden main options keys for the statistics of both ECUs
+#define STATS_SNAPSHOT_KEY '*'
+#define STATS_RESET_KEY    '%'
+
+// Password entry keys
+#define ERASE_KEY          '*'
+#define SUBMIT_KEY         '='
+
+// Trace record of the time from the submit key to the password check result (SysTime counts)
+#define SUBMIT_LATENCY_EVENT TRACE_EVENT_USER
+
+// Set to 1 to show the LCD full screen redraw time at startup (for the LCD timing options)
+#define LCD_BENCHMARK_ENABLE 0
+// Busy loop window of the LCD benchmark in SysTime counts (20ms), longer than a redraw
+#define LCD_BENCHMARK_WINDOW 625UL
+// Set to 1 to show the CPU cycles of a full keypad scan (KEYPAD_NUM_ROWS ticks) at startup
+#define KEYPAD_BENCHMARK_ENABLE 0
+// Scanned rows of the keypad benchmark, 1024 ticks = 256 full scans of 4 rows
+#define KEYPAD_BENCHMARK_TICKS 1024U
+
+// Width of the lockout countdown bar, the remaining seconds are shown after it
+#define LOCKOUT_BAR_WIDTH 12
+
+// Time the door fault and obstruction messages stay on the screen
+#define DOOR_FAULT_MS 2000
+
+// Texts of the message catalog, they stay in the flash memory
+MESSAGES_CATALOG(MESSAGE_TEXT)
+
+static const char * const message_table[NUM_OF_MESSAGES] PROGMEM = {
+    MESSAGES_CATALOG(MESSAGE_POINTER)
+};
 
 // Global variables for password storage
 uint8 passward[PASSWARD_LENGTH], confirmed_passward[PASSWARD_LENGTH];
-uint8 application_steps = 1;
-uint8 ticks;
+uint8 failed_retries = 0;
+// Time of the last submit key, for the submit to result latency
+uint32 submit_time = 0;
+// Start and length of the running timed step
+uint32 timeout_start = 0;
+uint8 timeout_seconds = 0;
+// Set while the application waits for a key, the only wait where the MCU can power down
+volatile boolean waiting_key = FALSE;
+// Progress bar of the timed step, it fills up (door travel) or drains (lockout countdown)
+LCD_ProgressBarType progress_bar;
+uint32 progress_start = 0;
+uint32 progress_total = 0;
+boolean progress_countdown = FALSE;
+uint8 progress_seconds = 0;
+// Door travel times (SysTime counts) measured up to the door state of the Control ECU, for the progress bar
+uint32 open_travel = (uint32)DOOR_TRAVEL_SECONDS * SYSTIME_COUNTS_PER_SECOND;
+uint32 close_travel = (uint32)DOOR_TRAVEL_SECONDS * SYSTIME_COUNTS_PER_SECOND;
+// FALSE while the door opens again from where an obstruction stopped it, the travel is not measured
+boolean full_travel = TRUE;
 
 // Function prototypes
-void get_passward(uint8* passward_array);
+void get_passward(uint8* passward_array, uint8 col);
+#if (PASSWARD_STREAM_ENABLE == 0)
 void send_passward(uint8* passward_array);
+#endif
 void send_byte(uint8 byte);
 uint8 receive_byte();  // Prototype for receive_byte function
-void Timer_Callbackfunc();
-void _delay_seconds(uint8 seconds);
+boolean poll_byte(uint8 *byte);
+void start_timeout(uint8 seconds);
+void lcd_benchmark(void);
+void keypad_benchmark(void);
+void keypad_idle(void);
+void send_statistics(void);
+void send_power_stats(void);
+void reset_statistics(void);
+boolean prepare_power_down(void);
+uint32 benchmark_loops(uint32 start, uint32 window);
+const char *message_text(Message_IdType id);
+void show_screen(uint8 col0, Message_IdType row0, uint8 col1, Message_IdType row1);
+void start_progress(uint8 width, boolean countdown, uint32 total);
+void update_progress(void);
+
+// Steps activities
+FSM_EventType create_passward(void);
+FSM_EventType check_passward(void);
+FSM_EventType main_options(void);
+FSM_EventType verify_old_passward(void);
+FSM_EventType retry_passward(void);
+FSM_EventType wait_tick(void);
+FSM_EventType wait_door_state(void);
+FSM_EventType wait_door_clear(void);
+
+// Transitions guards and actions
+boolean is_timeout_elapsed(void);
+void show_wrong_pass(void);
+void send_open_choice(void);
+void send_change_choice(void);
+void start_retries(void);
+void lock_system(void);
+void unlock_system(void);
+void show_wait_people(void);
+void show_door_opened(void);
+void show_open_fault(void);
+void show_door_fault(void);
+void lock_door(void);
+void show_door_closed(void);
+void reopen_door(void);
+
+// Activity of each step
+static const FSM_HandlerType step_handlers[NUM_OF_STEPS] FSM_FLASH = {
+    [CREATE_SYSTEM_PASSWARD] = create_passward,
+    [CHECK_PASSWARD]         = check_passward,
+    [MAIN_OPTIONS]           = main_options,
+    [VERIFY_OPEN_DOOR]       = verify_old_passward,
+    [VERIFY_CHANGE_PASS]     = verify_old_passward,
+    [RETRY_PASSWARD]         = retry_passward,
+    [OPEN_DOOR]              = wait_door_state,
+    [WAIT_PEOPLE]            = wait_door_clear,
+    [CLOSE_DOOR]             = wait_door_state,
+    [SYSTEM_LOCKED]          = wait_tick,
+};
+
+// Transition table [step][event] = { guard, action, next step }
+static const FSM_TransitionType step_transitions[NUM_OF_STEPS][NUM_OF_EVENTS] FSM_FLASH = {
+    [CREATE_SYSTEM_PASSWARD] = {
+        [PASSWARDS_SENT_EVENT]    = { NULL_PTR, NULL_PTR, CHECK_PASSWARD },
+    },
+    [CHECK_PASSWARD] = {
+        [PASS_MATCH_EVENT]        = { NULL_PTR, NULL_PTR, MAIN_OPTIONS },
+        [PASS_MISMATCH_EVENT]     = { NULL_PTR, show_wrong_pass, CREATE_SYSTEM_PASSWARD },
+    },
+    [MAIN_OPTIONS] = {
+        [OPEN_CHOICE_EVENT]       = { NULL_PTR, NULL_PTR, VERIFY_OPEN_DOOR },
+        [CHANGE_CHOICE_EVENT]     = { NULL_PTR, NULL_PTR, VERIFY_CHANGE_PASS },
+    },
+    [VERIFY_OPEN_DOOR] = {
+        [PASS_MATCH_EVENT]        = { NULL_PTR, send_open_choice, OPEN_DOOR },
+        [PASS_MISMATCH_EVENT]     = { NULL_PTR, start_retries, RETRY_PASSWARD },
+    },
+    [VERIFY_CHANGE_PASS] = {
+        [PASS_MATCH_EVENT]        = { NULL_PTR, send_change_choice, CREATE_SYSTEM_PASSWARD },
+        [PASS_MISMATCH_EVENT]     = { NULL_PTR, start_retries, RETRY_PASSWARD },
+    },
+    [RETRY_PASSWARD] = {
+        [PASS_MATCH_EVENT]        = { NULL_PTR, NULL_PTR, MAIN_OPTIONS },
+        [PASS_MISMATCH_EVENT]     = { NULL_PTR, NULL_PTR, RETRY_PASSWARD },
+        [RETRIES_EXHAUSTED_EVENT] = { NULL_PTR, lock_system, SYSTEM_LOCKED },
+    },
+    [OPEN_DOOR] = {
+        [DOOR_OPENED_EVENT]       = { NULL_PTR, show_door_opened, WAIT_PEOPLE },
+        [DOOR_FAULT_EVENT]        = { NULL_PTR, show_open_fault, WAIT_PEOPLE },
+    },
+    [WAIT_PEOPLE] = {
+        [DOOR_CLEAR_EVENT]        = { NULL_PTR, lock_door, CLOSE_DOOR },
+    },
+    [CLOSE_DOOR] = {
+        [DOOR_CLOSED_EVENT]       = { NULL_PTR, show_door_closed, MAIN_OPTIONS },
+        [DOOR_FAULT_EVENT]        = { NULL_PTR, show_door_fault, MAIN_OPTIONS },
+        [DOOR_OBSTRUCTED_EVENT]   = { NULL_PTR, reopen_door, OPEN_DOOR },
+    },
+    [SYSTEM_LOCKED] = {
+        [TICK_EVENT]              = { is_timeout_elapsed, unlock_system, MAIN_OPTIONS },
+    },
+};
+
+static const FSM_ConfigType application_fsm_config = {
+    step_handlers, &step_transitions[0][0], NUM_OF_STEPS, NUM_OF_EVENTS,
+    CREATE_SYSTEM_PASSWARD, SysTime_now
+};
+
+// Application state machine and its instrumentation counters
+FSM_Type application_fsm;
+FSM_StateStatsType step_stats[NUM_OF_STEPS];
+uint16 transition_counts[NUM_OF_STEPS * NUM_OF_EVENTS];
 
 int main() {
 
@@ -48,187 +229,316 @@ int main() {
     UART_ConfigType Config_ptr = {Character_SIZE_8, EVEN_PARITY, ONE_BIT, 9600};
     UART_init(&Config_ptr);
 
-    /* Timer setup and callback function initialization */
-     Timer_ConfigType TIMER_configurations = { 0, 31250, TIMER1, F_CPU_256, COMPARE };
-     Timer_init(&TIMER_configurations);
-     Timer_setCallBack(&Timer_Callbackfunc, TIMER1);
+    /* Timer1 time base for the timed steps and the FSM instrumentation */
+    SysTime_init();
+
+    /* Sleep in idle mode while waiting for a key, a received byte or a timeout */
+    Power_init();
+    Trace_init('H');
+    KEYPAD_setIdleCallBack(keypad_idle);
+
+    UART_setIdleCallBack(Power_idle);
 
     // Initialize LCD
     LCD_init();
 
-    uint8 check_pass; // Variable to store password check result
-    uint8 choice;     // Variable to store user choice
+#if (LCD_BENCHMARK_ENABLE == 1)
+    lcd_benchmark();
+#endif
+
+    // Scan one keypad row on every SysTime tick, the keys are debounced in the background
+    KEYPAD_init();
+#if (KEYPAD_BENCHMARK_ENABLE == 1)
+    keypad_benchmark();
+#endif
+    SysTime_addTickHook(KEYPAD_tick);
+#if (KEYPAD_WAKE_ENABLE == 1)
+    // After POWER_DOWN_TIMEOUT_SECONDS without a key the MCU powers down, a key press wakes it
+    Power_setPowerDownCallBacks(prepare_power_down, KEYPAD_resumeScan);
+#endif
+
+    FSM_init(&application_fsm, &application_fsm_config, step_stats, transition_counts);
 
     // Main application loop
     while (1) {
-        switch (application_steps) {
-            case CREATE_SYSTEM_PASSWARD:
-                // Prompt user to enter a new password
-                LCD_clearScreen();
-                LCD_displayString("Plz Enter Pass: ");
-                LCD_moveCursor(1, 0);
-
-                // Get password from user
-                get_passward(passward);
-
-                // Confirm the entered password
-                LCD_displayStringRowColumn(0, 0, "Plz re-enter the");
-                LCD_displayStringRowColumn(1, 0, "same pass: ");
-                LCD_moveCursor(1, 10);
-
-                // Get the confirmed password from user
-                get_passward(confirmed_passward);
-
-                // Send passwords for validation
-                send_passward(passward);
-                send_passward(confirmed_passward);
-
-                // Move to check password step
-                application_steps = CHECK_PASSWARD;
-                break;
+        FSM_run(&application_fsm);
+    }
+}
 
-            case CHECK_PASSWARD:
-                // Receive check password result
-                check_pass = receive_byte();
+/*******************************************************************************
+ *                              Steps Activities                               *
+ *******************************************************************************/
 
-                // Determine next step based on password check result
-                if (check_pass != EQUAL_PASS) {
-                    LCD_clearScreen();
-                    LCD_displayStringRowColumn(0, 0, "   Wrong Pass   ");
-                    LCD_displayStringRowColumn(1, 0, "Please Try Again");
-                    _delay_ms(500); // Delay to show the message
+FSM_EventType create_passward(void) {
+    // Prompt user to enter a new password
+    show_screen(0, MSG_ENTER_PASS, 0, MSG_EMPTY);
 
-                    application_steps = CREATE_SYSTEM_PASSWARD; // Retry if not equal
+    // Get password from user
+    get_passward(passward, 0);
 
-                } else {
-                    application_steps = MAIN_OPTIONS; // Proceed to main options
-                }
-                break;
+    // Confirm the entered password
+    show_screen(0, MSG_REENTER_PASS, 0, MSG_SAME_PASS);
 
-            case MAIN_OPTIONS:
-                // Display main options to the user
-                LCD_clearScreen();
-                LCD_displayStringRowColumn(0, 0, "+ : OPEN DOOR");
-                LCD_displayStringRowColumn(1, 0, "- : CHANGE PASS");
-
-                // Get user choice
-                choice = KEYPAD_getPressedKey();
-
-                // Validate user choice input
-                while (choice != '+' && choice != '-') {
-                    choice = KEYPAD_getPressedKey();
-                }
-
-                // Prompt user to enter old password
-                LCD_clearScreen();
-                LCD_displayString("Plz Enter Old:  ");
-                LCD_moveCursor(1, 0);
-
-                // Get the old password from user
-                get_passward(passward);
-                send_passward(passward);
-
-                // Check if the entered password is correct
-                if (receive_byte() == EQUAL_PASS) {
-                    send_byte(choice); // Send user's choice
-
-                    // Determine next step based on choice
-                    if (choice == '+') {
-                        application_steps = OPEN_DOOR; // Proceed to open door
-                    } else if (choice == '-') {
-                        application_steps = CREATE_SYSTEM_PASSWARD; // Change password
-                    }
-                } else {
-                    // Handle incorrect password case
-                    uint8_t count;
-                    for (count = 0; count < RETRIES; count++) {
-                        // Display error message
-                        LCD_clearScreen();
-                        LCD_displayStringRowColumn(0, 0, "   Wrong Pass   ");
-                        LCD_displayStringRowColumn(1, 0, "Please Try Again");
-                        _delay_ms(500); // Delay to show the message
-
-                        // Prompt for old password again
-                        LCD_clearScreen();
-                        LCD_displayString("Enter Old Pass:");
-                        LCD_moveCursor(1, 0);
-
-                        // Retrieve and send the entered password for validation
-                        get_passward(passward);
-                        send_passward(passward);
-
-                        // Check if the entered password matches the stored password
-                        if (receive_byte() == EQUAL_PASS) {
-                            application_steps = MAIN_OPTIONS; // Password correct, proceed
-                            break;
-                        }
-                    }
-
-                    // Lock the system after maximum retries
-                    if (count == RETRIES) {
-                        LCD_clearScreen();
-                        LCD_displayStringRowColumn(0, 1, "System LOCKED");
-                        LCD_displayStringRowColumn(1, 0, "Wait for 1 min");
-
-
-                        _delay_seconds(60);
-
-                        // Reset to main options after lock period
-                        application_steps = MAIN_OPTIONS;
-                        LCD_clearScreen();
-                    }
-                }
-                break;
+    // Get the confirmed password from user
+    get_passward(confirmed_passward, 10);
 
-            case OPEN_DOOR:
-                // Indicate door unlocking
-                LCD_clearScreen();
-                LCD_displayStringRowColumn(0, 1, "Door Unlocking");
-                LCD_displayStringRowColumn(1, 4, "Please Wait");
+#if (PASSWARD_STREAM_ENABLE == 0)
+    // Send passwords for validation
+    send_passward(passward);
+    send_passward(confirmed_passward);
+#endif
 
-                _delay_seconds(15);
+    return PASSWARDS_SENT_EVENT;
+}
 
-                // Indicate waiting for people to enter
-                LCD_clearScreen();
-                LCD_displayStringRowColumn(0, 0, "wait for people");
-                LCD_displayStringRowColumn(1, 3, "To Enter");
+FSM_EventType check_passward(void) {
+    uint8 result;
 
-                receive_byte(); // Await confirmation from the other microcontroller
+    // Receive check password result
+    result = receive_byte();
+    TRACE(SUBMIT_LATENCY_EVENT, (uint16)(SysTime_now() - submit_time));
+    if (result != EQUAL_PASS) {
+        return PASS_MISMATCH_EVENT;
+    }
+    return PASS_MATCH_EVENT;
+}
 
-                // Indicate door locking
-                LCD_clearScreen();
-                LCD_displayStringRowColumn(0, 1, "  Door Locking  ");
+FSM_EventType main_options(void) {
+    uint8 choice;
 
-                _delay_seconds(15);
-                // Return to main options after locking
-                application_steps = MAIN_OPTIONS;
-                break;
+    // Display main options to the user, the keys pressed before are ignored
+    show_screen(0, MSG_OPEN_DOOR_OPTION, 0, MSG_CHANGE_PASS_OPTION);
+    KEYPAD_clearEvents();
+
+    // Get user choice
+    choice = KEYPAD_getPressedKey();
+
+    // Validate user choice input, the hidden keys read or clear the statistics of both ECUs
+    while (choice != OPEN_DOOR_CHOICE && choice != CHANGE_PASS_CHOICE) {
+        if (choice == STATS_SNAPSHOT_KEY) {
+            UART_sendByte(STATS_SNAPSHOT_COMMAND);
+            send_statistics();
+        } else if (choice == STATS_RESET_KEY) {
+            UART_sendByte(STATS_RESET_COMMAND);
+            reset_statistics();
         }
+        choice = KEYPAD_getPressedKey();
     }
+    Power_notifyActivity();
+
+    return (choice == OPEN_DOOR_CHOICE) ? OPEN_CHOICE_EVENT : CHANGE_CHOICE_EVENT;
+}
+
+FSM_EventType verify_old_passward(void) {
+    // Prompt user to enter old password
+    show_screen(0, MSG_ENTER_OLD, 0, MSG_EMPTY);
+
+    // Get the old password from user
+    get_passward(passward, 0);
+#if (PASSWARD_STREAM_ENABLE == 0)
+    send_passward(passward);
+#endif
+
+    // Check if the entered password is correct
+    return check_passward();
+}
+
+FSM_EventType retry_passward(void) {
+    FSM_EventType event;
+
+    // Display error message
+    show_wrong_pass();
+
+    // Prompt for old password again
+    show_screen(0, MSG_ENTER_OLD_PASS, 0, MSG_EMPTY);
+
+    // Retrieve and send the entered password for validation
+    get_passward(passward, 0);
+#if (PASSWARD_STREAM_ENABLE == 0)
+    send_passward(passward);
+#endif
+
+    // Lock the system after maximum retries
+    event = check_passward();
+    if (event == PASS_MISMATCH_EVENT && ++failed_retries >= RETRIES) {
+        event = RETRIES_EXHAUSTED_EVENT;
+    }
+    return event;
+}
+
+// Timed steps sleep until the next interrupt then poll their guard
+FSM_EventType wait_tick(void) {
+    update_progress();
+    Power_idle();
+    return TICK_EVENT;
 }
 
-// Function to get password from user input
-void get_passward(uint8* passward_array) {
-    uint8 key_pressed, counter;
+// The door moves until the Control ECU reports its end of travel switch, a fault or an obstruction
+FSM_EventType wait_door_state(void) {
+    uint8 state;
 
-    // Retrieve password input from keypad
-    for (counter = 0; counter < PASSWARD_LENGTH;) {
+    update_progress();
+    if (poll_byte(&state) == FALSE) {
+        Power_idle();
+        return NUM_OF_EVENTS;
+    }
+    if (state == DOOR_OPENED_BYTE) {
+        return DOOR_OPENED_EVENT;
+    } else if (state == DOOR_CLOSED_BYTE) {
+        return DOOR_CLOSED_EVENT;
+    } else if (state == DOOR_FAULT_BYTE) {
+        return DOOR_FAULT_EVENT;
+    } else if (state == DOOR_OBSTRUCTED_BYTE) {
+        return DOOR_OBSTRUCTED_EVENT;
+    }
+    return NUM_OF_EVENTS;
+}
+
+FSM_EventType wait_door_clear(void) {
+    receive_byte(); // Await confirmation from the other microcontroller
+    return DOOR_CLEAR_EVENT;
+}
+
+/*******************************************************************************
+ *                         Transitions Guards and Actions                      *
+ *******************************************************************************/
+
+boolean is_timeout_elapsed(void) {
+    return SysTime_isElapsed(timeout_start, timeout_seconds);
+}
+
+void show_wrong_pass(void) {
+    show_screen(0, MSG_WRONG_PASS, 0, MSG_TRY_AGAIN);
+    Power_sleepMs(500); // Delay to show the message
+}
+
+void send_open_choice(void) {
+    send_byte(OPEN_DOOR_CHOICE); // Send user's choice
+
+    // Indicate door unlocking
+    show_screen(1, MSG_DOOR_UNLOCKING, 0, MSG_EMPTY);
+    start_progress(LCD_COLS, FALSE, open_travel);
+    full_travel = TRUE;
+}
+
+void send_change_choice(void) {
+    send_byte(CHANGE_PASS_CHOICE); // Send user's choice
+}
+
+void start_retries(void) {
+    failed_retries = 0;
+}
+
+void lock_system(void) {
+    show_screen(1, MSG_SYSTEM_LOCKED, 0, MSG_EMPTY);
+    start_timeout(LOCKOUT_SECONDS);
+    start_progress(LOCKOUT_BAR_WIDTH, TRUE, (uint32)LOCKOUT_SECONDS * SYSTIME_COUNTS_PER_SECOND);
+}
+
+void unlock_system(void) {
+    show_screen(0, MSG_EMPTY, 0, MSG_EMPTY);
+    KEYPAD_clearEvents(); // Keys pressed during the lockout
+}
+
+void show_wait_people(void) {
+    // Indicate waiting for people to enter
+    show_screen(0, MSG_WAIT_PEOPLE, 3, MSG_TO_ENTER);
+}
+
+// The next door bar lasts as long as this travel did, unless it started half way
+void show_door_opened(void) {
+    if (full_travel == TRUE) {
+        open_travel = SysTime_now() - progress_start;
+    }
+    show_wait_people();
+}
+
+// The door stopped before it was fully open, people may still go through
+void show_open_fault(void) {
+    show_door_fault();
+    show_wait_people();
+}
+
+void show_door_fault(void) {
+    show_screen(2, MSG_DOOR_FAULT, 0, MSG_CHECK_DOOR);
+    Power_sleepMs(DOOR_FAULT_MS);
+}
+
+void lock_door(void) {
+    // Indicate door locking
+    show_screen(1, MSG_DOOR_LOCKING, 0, MSG_EMPTY);
+    start_progress(LCD_COLS, FALSE, close_travel);
+    full_travel = TRUE;
+}
+
+void show_door_closed(void) {
+    close_travel = SysTime_now() - progress_start;
+}
+
+// Something blocked the closing door, it opens again from where it stopped
+void reopen_door(void) {
+    show_screen(2, MSG_OBSTRUCTION, 0, MSG_EMPTY);
+    Power_sleepMs(DOOR_FAULT_MS);
+    show_screen(1, MSG_DOOR_UNLOCKING, 0, MSG_EMPTY);
+    start_progress(LCD_COLS, FALSE, open_travel);
+    full_travel = FALSE;
+}
+
+/*******************************************************************************
+ *                              Helper Functions                               *
+ *******************************************************************************/
+
+// Function to get password from user input, typed on the second row from column col.
+// In streaming mode each accepted key is sent to the Control ECU as it is typed.
+void get_passward(uint8* passward_array, uint8 col) {
+    uint8 key_pressed, counter = 0;
+
+#if (PASSWARD_STREAM_ENABLE == 1)
+    // Open the key stream, the Control ECU starts a new entry
+    UART_sendByte(READY_BYTE);
+    while (UART_recieveByte() != READY_BYTE);
+#endif
+
+    LCD_moveCursor(1, col);
+
+    // Retrieve password input from keypad until it is complete and submitted
+    while (1) {
         key_pressed = KEYPAD_getPressedKey();
+        Power_notifyActivity();
 
-        // Only accept valid characters
-        if (key_pressed != '+' && key_pressed != '-' && key_pressed != '*' && key_pressed != '%' && key_pressed != '=') {
+        if (key_pressed == SUBMIT_KEY) {
+            if (counter == PASSWARD_LENGTH) {
+                break;
+            }
+        } else if (key_pressed == ERASE_KEY) {
+            if (counter > 0) {
+                counter--;
+                LCD_moveCursor(1, col + counter);
+                LCD_displayCharacter(' ');
+                LCD_moveCursor(1, col + counter);
+#if (PASSWARD_STREAM_ENABLE == 1)
+                UART_sendByte(KEY_ERASE_BYTE);
+#endif
+            }
+        } else if (key_pressed != '+' && key_pressed != '-' && key_pressed != '%' && counter < PASSWARD_LENGTH) {
+            // Only accept valid characters
             passward_array[counter] = key_pressed; // Store the pressed key
             LCD_displayCharacter('*'); // Display asterisk for security
             counter++;
+#if (PASSWARD_STREAM_ENABLE == 1)
+            UART_sendByte(key_pressed);
+#endif
         }
-        _delay_ms(500); // Delay for debounce
     }
 
-    // Wait for confirmation of password entry
-    while (KEYPAD_getPressedKey() != '=');
+    submit_time = SysTime_now();
+#if (PASSWARD_STREAM_ENABLE == 1)
+    UART_sendByte(KEY_SUBMIT_BYTE);
+#endif
 }
 
-// Function to send password for validation
+#if (PASSWARD_STREAM_ENABLE == 0)
+// Function to send password for validation, in streaming mode the keys are sent as they are typed
 void send_passward(uint8* passward_array) {
     UART_sendByte(READY_BYTE); // Indicate ready to send
 
@@ -243,9 +553,11 @@ void send_passward(uint8* passward_array) {
     // Wait for confirmation that password is received
     while (UART_recieveByte() != DONE_BYTE);
 }
+#endif
 
 // Function to send a single byte
 void send_byte(uint8 byte) {
+    TRACE(TRACE_EVENT_LINK_TX, byte);
     UART_sendByte(READY_BYTE); // Indicate ready to send
 
     // Wait for acknowledgement
@@ -257,10 +569,28 @@ void send_byte(uint8 byte) {
     while (UART_recieveByte() != DONE_BYTE);
 }
 
+// Receive a byte if the other microcontroller started a transfer, the other bytes
+// (its trace) are dropped. Returns FALSE at once when nothing is waiting.
+boolean poll_byte(uint8 *byte) {
+    while (UART_isByteReceived() == TRUE) {
+        if (UART_recieveByte() == READY_BYTE) {
+            UART_sendByte(READY_BYTE); // Acknowledge receipt
+            *byte = UART_recieveByte();
+            UART_sendByte(DONE_BYTE); // Confirm receipt
+            TRACE(TRACE_EVENT_LINK_RX, *byte);
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
 // Function to receive a byte from UART
 uint8 receive_byte() {
     uint8 byte;
 
+    // Stream the trace while the link is idle, Control drops it as it only waits for READY_BYTE
+    while (UART_isByteReceived() == FALSE && Trace_drainRecord() == TRUE);
+
     // Wait for a byte to be ready
     while (UART_recieveByte() != READY_BYTE);
 
@@ -269,17 +599,202 @@ uint8 receive_byte() {
     byte = UART_recieveByte(); // Receive the byte
 
     UART_sendByte(DONE_BYTE); // Confirm receipt
+    TRACE(TRACE_EVENT_LINK_RX, byte);
 
     return byte; // Return the received byte
 }
-void _delay_seconds(uint8 seconds){
 
-    ticks = 0; // Reset tick counter
+// Flash address of a catalog text
+const char *message_text(Message_IdType id) {
+#ifdef __AVR__
+    return (const char *)pgm_read_word(&message_table[id]);
+#else
+    return message_table[id]; // Host pointers do not fit in a word
+#endif
+}
+
+// Draw a two rows screen in the LCD frame buffer and send only the cells that changed
+void show_screen(uint8 col0, Message_IdType row0, uint8 col1, Message_IdType row1) {
+    LCD_drawClear();
+    LCD_drawStringRowColumn_P(0, col0, message_text(row0));
+    LCD_drawStringRowColumn_P(1, col1, message_text(row1));
+    LCD_flush();
+}
+
+// Start measuring a timed step
+void start_timeout(uint8 seconds) {
+    timeout_start = SysTime_getSeconds();
+    timeout_seconds = seconds;
+}
+
+// Show the progress of the running timed step on the second row, total is its expected length
+// in SysTime counts, the bar stays full if the step lasts longer
+void start_progress(uint8 width, boolean countdown, uint32 total) {
+    progress_start = SysTime_now();
+    progress_total = total;
+    progress_countdown = countdown;
+    progress_seconds = 0;
+    LCD_initProgressBar(&progress_bar, 1, 0, width);
+}
+
+// Move the end of the progress bar and the countdown seconds, each change costs
+// a cursor move and one or two characters on the LCD
+void update_progress(void) {
+    uint32 total = progress_total;
+    uint32 elapsed = SysTime_now() - progress_start;
+    uint32 remaining;
+    uint8 seconds;
+    boolean changed;
+
+    if (elapsed > total) {
+        elapsed = total;
+    }
+    remaining = total - elapsed;
+
+    if (progress_countdown == FALSE) {
+        changed = LCD_drawProgressBar(&progress_bar, elapsed, total);
+    } else {
+        changed = LCD_drawProgressBar(&progress_bar, remaining, total);
+
+        seconds = (uint8)((remaining + SYSTIME_COUNTS_PER_SECOND - 1) / SYSTIME_COUNTS_PER_SECOND);
+        if (seconds != progress_seconds) {
+            progress_seconds = seconds;
+            LCD_drawCharacter(1, LCD_COLS - 3, (seconds >= 10) ? ('0' + (seconds / 10) % 10) : ' ');
+            LCD_drawCharacter(1, LCD_COLS - 2, '0' + (seconds % 10));
+            LCD_drawCharacter(1, LCD_COLS - 1, 's');
+            changed = TRUE;
+        }
+    }
+
+    if (changed == TRUE) {
+        LCD_flush();
+    }
+}
+
+// Keypad idle callback, a key wait can last long enough for power-down
+void keypad_idle(void) {
+    waiting_key = TRUE;
+    Power_idle();
+    waiting_key = FALSE;
+}
+
+// Streams the statistics of the HMI on its TX line after the snapshot command, the Control ECU
+// drops the text as it only waits for READY_BYTE. Time in each step (ms), the transitions taken
+// and the sleep statistics.
+void send_statistics(void) {
+    uint16 count;
+
+    for (FSM_StateType step = NO_STEP + 1; step < NUM_OF_STEPS; step++) {
+        Trace_sendValue(TRACE_VALUE_STATE_TIME, step, SYSTIME_LONG_TO_MS(FSM_getTimeInState(&application_fsm, step)));
+        Trace_sendValue(TRACE_VALUE_STATE_ENTRIES, step, step_stats[step].entries);
+        for (FSM_EventType event = 0; event < NUM_OF_EVENTS; event++) {
+            count = FSM_getTransitionCount(&application_fsm, step, event);
+            if (count != 0) {
+                Trace_sendValue(TRACE_VALUE_TRANSITIONS, (step * NUM_OF_EVENTS) + event, count);
+            }
+        }
+    }
+    send_power_stats();
+}
+
+// Time since the statistics reset, time in each sleep mode (ms) and number of sleeps
+void send_power_stats(void) {
+    Power_StatsType stats;
 
-    while (ticks < seconds); // Wait until the desired seconds have passed
+    Power_getStats(&stats);
+    Trace_sendValue(TRACE_VALUE_POWER_TIME, TRACE_POWER_TOTAL, SYSTIME_LONG_TO_MS(stats.total_time));
+    Trace_sendValue(TRACE_VALUE_POWER_TIME, TRACE_POWER_IDLE, SYSTIME_LONG_TO_MS(stats.idle_time));
+    Trace_sendValue(TRACE_VALUE_POWER_COUNT, TRACE_POWER_IDLE, stats.idle_count);
+    Trace_sendValue(TRACE_VALUE_POWER_TIME, TRACE_POWER_DOWN, SYSTIME_LONG_TO_MS(stats.power_down_time));
+    Trace_sendValue(TRACE_VALUE_POWER_COUNT, TRACE_POWER_DOWN, stats.power_down_count);
+}
+
+void reset_statistics(void) {
+    FSM_resetStats(&application_fsm);
+    Power_resetStats();
+}
+
+// Power-down prepare callback (interrupts disabled). The UART receive and the timed steps
+// need the timers running, and Timer0 must not stop with LCD writes still queued.
+boolean prepare_power_down(void) {
+#if (KEYPAD_WAKE_ENABLE == 1)
+    if (waiting_key == TRUE && LCD_isIdle() == TRUE) {
+        return KEYPAD_prepareWake();
+    }
+#endif
+    return FALSE;
+}
+
+// Count the turns of a loop until window counts elapsed since start
+uint32 benchmark_loops(uint32 start, uint32 window) {
+    uint32 loops = 0;
 
+    while ((SysTime_now() - start) < window) {
+        loops++;
+    }
+    return loops;
+}
+
+// Time a full screen redraw (clear + 2 rows of 16 characters = 35 LCD writes)
+// and show it in milliseconds and in CPU cycles per write (one SysTime count = 256 cycles).
+// Build it with LCD_DATA_BITS_MODE 4 and 8 to compare the bus modes.
+void lcd_benchmark(void) {
+    uint32 start, counts, cycles;
+#if (LCD_ASYNC_ENABLE == 1)
+    uint32 busy_loops, idle_loops;
+#endif
+
+    // Time until the LCD executed the writes, not only until they are queued
+    LCD_waitIdle();
+    start = SysTime_now();
+    LCD_clearScreen();
+    LCD_displayStringRowColumn_P(0, 0, message_text(MSG_BENCHMARK_PATTERN));
+    LCD_displayStringRowColumn_P(1, 0, message_text(MSG_BENCHMARK_PATTERN));
+    LCD_waitIdle();
+    counts = SysTime_now() - start;
+
+#if (LCD_ASYNC_ENABLE == 1)
+    // Most of the redraw time is spent waiting for the ticks, the CPU cost is what the
+    // queue and the ISR take from the application: count the turns of a busy loop
+    // during the same redraw and with the LCD idle
+    start = SysTime_now();
+    LCD_clearScreen();
+    LCD_displayStringRowColumn_P(0, 0, message_text(MSG_BENCHMARK_PATTERN));
+    LCD_displayStringRowColumn_P(1, 0, message_text(MSG_BENCHMARK_PATTERN));
+    busy_loops = benchmark_loops(start, LCD_BENCHMARK_WINDOW);
+    start = SysTime_now();
+    idle_loops = benchmark_loops(start, LCD_BENCHMARK_WINDOW);
+    cycles = ((idle_loops - busy_loops) * (LCD_BENCHMARK_WINDOW * 256UL / idle_loops)) / 35;
+#else
+    // Blocking writes, the CPU is busy during all the redraw
+    cycles = (counts * 256UL) / 35;
+#endif
+
+    LCD_clearScreen();
+    LCD_displayString_P(message_text(MSG_BENCHMARK_REDRAW));
+    LCD_intgerToString((int)SYSTIME_TO_MS(counts));
+    LCD_displayStringRowColumn_P(1, 0, message_text(MSG_BENCHMARK_CYCLES));
+    LCD_intgerToString((int)cycles);
+    LCD_displayString_P((LCD_DATA_BITS_MODE == 4) ? PSTR(" 4b") : PSTR(" 8b"));
+    Power_sleepMs(3000);
 }
-/* Timer callback function to increment tick count */
-void Timer_Callbackfunc() {
-    ticks++;
+
+// Time KEYPAD_BENCHMARK_TICKS row scans with no key pressed and show the CPU cycles of
+// a full scan (one SysTime count = 256 cycles), the loop overhead is included.
+// It runs before KEYPAD_tick is a tick hook, so the interrupt does not scan at the same time.
+void keypad_benchmark(void) {
+    uint32 start, counts;
+    uint16 i;
+
+    start = SysTime_now();
+    for (i = 0; i < KEYPAD_BENCHMARK_TICKS; i++) {
+        KEYPAD_tick();
+    }
+    counts = SysTime_now() - start;
+
+    LCD_clearScreen();
+    LCD_displayString_P(message_text(MSG_BENCHMARK_SCAN));
+    LCD_intgerToString((int)((counts * 256UL * KEYPAD_NUM_ROWS) / KEYPAD_BENCHMARK_TICKS));
+    Power_sleepMs(3000);
+    KEYPAD_init();
 }
@@ -0,0 +1,62 @@
+ /******************************************************************************
+ *
+ * Module: Messages
+ *
+ * File Name: messages.h
+ *
+ * Description: Catalog of the HMI texts. The message ids and the flash string
+ *              table are both generated from MESSAGES_CATALOG, so a text is
+ *              added or changed in this list only.
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#ifndef MESSAGES_H_
+#define MESSAGES_H_
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/* MESSAGE(id, text), the texts are at most 16 characters (one LCD row) */
+#define MESSAGES_CATALOG(MESSAGE) \
+    MESSAGE(MSG_EMPTY,               "") \
+    MESSAGE(MSG_ENTER_PASS,          "Plz Enter Pass: ") \
+    MESSAGE(MSG_REENTER_PASS,        "Plz re-enter the") \
+    MESSAGE(MSG_SAME_PASS,           "same pass: ") \
+    MESSAGE(MSG_OPEN_DOOR_OPTION,    "+ : OPEN DOOR") \
+    MESSAGE(MSG_CHANGE_PASS_OPTION,  "- : CHANGE PASS") \
+    MESSAGE(MSG_ENTER_OLD,           "Plz Enter Old:  ") \
+    MESSAGE(MSG_ENTER_OLD_PASS,      "Enter Old Pass:") \
+    MESSAGE(MSG_WRONG_PASS,          "   Wrong Pass   ") \
+    MESSAGE(MSG_TRY_AGAIN,           "Please Try Again") \
+    MESSAGE(MSG_DOOR_UNLOCKING,      "Door Unlocking") \
+    MESSAGE(MSG_SYSTEM_LOCKED,       "System LOCKED") \
+    MESSAGE(MSG_WAIT_PEOPLE,         "wait for people") \
+    MESSAGE(MSG_TO_ENTER,            "To Enter") \
+    MESSAGE(MSG_DOOR_LOCKING,        "  Door Locking  ") \
+    MESSAGE(MSG_DOOR_FAULT,          "Door Fault!") \
+    MESSAGE(MSG_CHECK_DOOR,          "Check the door") \
+    MESSAGE(MSG_OBSTRUCTION,         "Obstruction!") \
+    MESSAGE(MSG_BENCHMARK_PATTERN,   "0123456789ABCDEF") \
+    MESSAGE(MSG_BENCHMARK_REDRAW,    "Redraw ms: ") \
+    MESSAGE(MSG_BENCHMARK_CYCLES,    "Cyc/write: ") \
+    MESSAGE(MSG_BENCHMARK_SCAN,      "Cyc/scan: ")
+
+/* Generators for MESSAGES_CATALOG: the enum entries, the flash texts and the table entries */
+#define MESSAGE_ID(id, text)             id,
+#define MESSAGE_TEXT(id, text)           static const char id##_TEXT[] PROGMEM = text;
+#define MESSAGE_POINTER(id, text)        [id] = id##_TEXT,
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+typedef enum
+{
+	MESSAGES_CATALOG(MESSAGE_ID)
+	NUM_OF_MESSAGES
+}Message_IdType;
+
+#endif /* MESSAGES_H_ */
@@ -0,0 +1,738 @@
+ /******************************************************************************
+ *
+ * Module: Door Simulator
+ *
+ * File Name: door_sim.c
+ *
+ * Description: Runs Control_ECU/Main/door_core.c unchanged on the host with a
+ *              virtual millisecond clock, a RAM EEPROM, a random PIR sensor and a
+ *              door moving at a random speed from where it stopped to its end of
+ *              travel switch (or not moving, a jammed door, or stalling on an
+ *              obstruction). Random passwords, choices and time steps are played
+ *              against the core, and after each operation its state,
+ *              the result and the door state sent to the HMI, the stored password
+ *              and travel times and the motor and buzzer outputs are checked
+ *              against a reference model of the access policy:
+ *
+ *              - a result is sent for each password, EQUAL_PASS only if it matches
+ *                and was complete
+ *              - the motor runs only after a correct password and an open choice,
+ *                each way until its end of travel switch, a stall or the travel
+ *                timeout, and a stall while closing opens the door again
+ *              - the moves are planned over the learned travel times, which are
+ *                stored when they changed enough and dropped after a timeout
+ *              - only a move from an end of travel teaches its time (a reopening
+ *                or a move after a fault does not), and a door at its usual speed
+ *                never times out twice in a row the same way
+ *              - the lockout starts after RETRIES wrong passwords in the retry
+ *                state and the buzzer sounds only during the lockout
+ *
+ *              Build from Door_Locking_System_Code:
+ *
+ *              gcc -std=gnu99 -O2 -funsigned-char -DTRACE_ENABLE=0 \
+ *                  -IControl_ECU/LIB -IControl_ECU/Main \
+ *                  Tools/door_sim/door_sim.c Control_ECU/Main/door_core.c \
+ *                  Control_ECU/LIB/fsm.c -o door_sim
+ *
+ *              ./door_sim [operations] [seed]
+ *
+ *              The exit status is 1 if the core and the model disagree.
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "door_core.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define SIM_DEFAULT_OPERATIONS         1000000UL
+#define SIM_DEFAULT_SEED               1UL
+
+/* Longest time step while the core is busy */
+#define SIM_MAX_STEP_MS                250
+
+/* The clock starts before its wrap around to check the elapsed time computations */
+#define SIM_START_MS                   (0xFFFFFFFFUL - 20000UL)
+
+/* No result was sent by the last operation */
+#define SIM_NO_RESULT                  0
+
+/*
+ * Travel times of the simulated door: each run draws a travel time, the moves run at a
+ * speed giving it within SIM_DOOR_SPREAD_PERCENT from one end to the other. One move in
+ * SIM_ODD_MOVE_RATE does not move (jammed door), another one runs at any speed giving a
+ * travel up to past the longest timeout and another one stalls on an obstruction before
+ * its switch. A move stopped before its switch leaves the door where it is.
+ */
+#define SIM_MIN_DOOR_TRAVEL_MS         500
+#define SIM_MAX_DOOR_TRAVEL_MS         (DOOR_CORE_MAX_TRAVEL_MS + 2000)
+#define SIM_DOOR_SPREAD_PERCENT        10
+#define SIM_ODD_MOVE_RATE              32
+
+/* One password entry in SIM_INCOMPLETE_ENTRY_RATE is submitted before its last key */
+#define SIM_INCOMPLETE_ENTRY_RATE      16
+
+/* No door state was sent by the last operation */
+#define SIM_NO_DOOR_STATE              0
+
+/* Failures printed before the end report */
+#define SIM_MAX_PRINTED_FAILURES       10
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+/* Board seen by the core */
+typedef struct
+{
+	uint32 now_ms;
+	uint8 eeprom[PASSWARD_LENGTH];
+	uint8 result;                      /* Last result sent, SIM_NO_RESULT if none */
+	uint8 results;                     /* Results sent by the last operation */
+	boolean door_clear;                /* Door clear reported by the last operation */
+	uint8 door_state;                  /* Last door state sent, SIM_NO_DOOR_STATE if none */
+	uint8 door_states;                 /* Door states sent by the last operation */
+	DoorCore_TravelTimesType eeprom_travel_times;
+	DoorCore_MotorType motor;
+	uint32 planned_travel_ms;          /* Travel of the last move start */
+	uint32 move_start_ms;
+	uint32 move_travel_ms;             /* Travel between the ends at the speed of the move, 0xFFFFFFFF if jammed */
+	uint32 door_travel_ms;             /* Time the door needs to reach the switch, 0xFFFFFFFF if jammed */
+	uint32 stall_ms;                   /* Time the motor stalls, 0xFFFFFFFF if it does not */
+	uint32 typical_travel_ms;          /* Travel of the door of this run */
+	uint32 position;                   /* From the closed end, typical_travel_ms at the open end */
+	boolean usual_speed;               /* The move is not jammed and runs at the speed of the door */
+	uint8 timeouts[2];                 /* Opening and closing moves at the usual speed timed out in a row */
+	boolean buzzer;
+	boolean motion;
+}Sim_BoardType;
+
+/* Reference model of the access policy */
+typedef struct
+{
+	DoorCore_StateType state;
+	uint8 passward[PASSWARD_LENGTH];
+	uint8 failed_retries;
+	uint32 entry_ms;
+	boolean at_end;                               /* The door stopped at an end of travel switch */
+	boolean full_travel;                          /* The running move started from an end of travel */
+	DoorCore_TravelTimesType travel_times;        /* Learned, 0 while not learned */
+	DoorCore_TravelTimesType eeprom_travel_times; /* Expected EEPROM content */
+}Sim_ModelType;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static uint32 Sim_now(void);
+static void Sim_sendResult(uint8 result);
+static void Sim_reportDoorClear(void);
+static void Sim_reportDoorState(uint8 state);
+static void Sim_loadPassward(uint8 *passward);
+static void Sim_storePassward(const uint8 *passward);
+static void Sim_loadTravelTimes(DoorCore_TravelTimesType *times);
+static void Sim_storeTravelTimes(const DoorCore_TravelTimesType *times);
+static void Sim_setMotor(DoorCore_MotorType motion, uint32 travel_ms);
+static void Sim_stopDoor(void);
+static boolean Sim_isEndReached(DoorCore_MotorType motion);
+static boolean Sim_isStalled(void);
+static void Sim_setBuzzer(boolean on);
+static boolean Sim_isMotion(void);
+
+static void Sim_step(void);
+static void Sim_randomPassward(uint8 *passward);
+static void Sim_enter(DoorCore_StateType state);
+static uint16 *Sim_learnedTravel(DoorCore_TravelTimesType *times, DoorCore_MotorType motion);
+static void Sim_startMove(DoorCore_MotorType motion);
+static uint8 Sim_endMove(DoorCore_MotorType motion, uint32 door_travel_ms, uint32 stall_ms);
+static void Sim_check(uint8 expected_result, boolean expected_door_clear, uint8 expected_door_state);
+static void Sim_fail(const char *what);
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+static const DoorCore_OpsType g_ops =
+{
+	Sim_now, Sim_sendResult, Sim_reportDoorClear, Sim_reportDoorState,
+	Sim_loadPassward, Sim_storePassward, Sim_loadTravelTimes, Sim_storeTravelTimes,
+	Sim_setMotor, Sim_isEndReached, Sim_isStalled, Sim_setBuzzer, Sim_isMotion, NULL_PTR
+};
+
+static FSM_StateStatsType g_stateStats[DOOR_CORE_NUM_OF_STATES];
+static uint16 g_transitionCounts[DOOR_CORE_NUM_OF_STATES * DOOR_CORE_NUM_OF_EVENTS];
+
+static Sim_BoardType g_board;
+static Sim_ModelType g_model;
+
+static unsigned long g_operation = 0;
+static unsigned long g_failures = 0;
+static unsigned long g_doorOpenings = 0;
+static unsigned long g_doorFaults = 0;
+static unsigned long g_obstructions = 0;
+static unsigned long g_lockouts = 0;
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+int main(int argc, char *argv[])
+{
+	unsigned long operations = SIM_DEFAULT_OPERATIONS;
+	unsigned long seed = SIM_DEFAULT_SEED;
+	clock_t start;
+	float64 seconds;
+
+	if(argc > 3)
+	{
+		fprintf(stderr, "usage: %s [operations] [seed]\n", argv[0]);
+		return 2;
+	}
+	if(argc > 1)
+	{
+		operations = strtoul(argv[1], NULL, 10);
+	}
+	if(argc > 2)
+	{
+		seed = strtoul(argv[2], NULL, 10);
+	}
+	srand((unsigned int)seed);
+
+	memset(&g_board, 0, sizeof(g_board));
+	memset(g_board.eeprom, 0xFF, sizeof(g_board.eeprom));
+	memset(&g_board.eeprom_travel_times, 0xFF, sizeof(g_board.eeprom_travel_times));
+	g_board.now_ms = SIM_START_MS;
+	g_board.motor = DOOR_CORE_MOTOR_STOP;
+	g_board.typical_travel_ms = DOOR_CORE_MIN_TRAVEL_MS + (rand() % DOOR_CORE_TRAVEL_MS);
+	DoorCore_init(&g_ops, g_stateStats, g_transitionCounts);
+	g_model.state = DOOR_CORE_NEW_PASSWARD_STATE;
+	g_model.failed_retries = 0;
+	g_model.entry_ms = g_board.now_ms;
+	g_model.at_end = FALSE; /* The door is closed but the core does not know it yet */
+	memset(&g_model.travel_times, 0, sizeof(g_model.travel_times));
+	g_model.eeprom_travel_times = g_board.eeprom_travel_times; /* Erased, not learned */
+	Sim_check(SIM_NO_RESULT, FALSE, SIM_NO_DOOR_STATE);
+
+	start = clock();
+	for(g_operation = 1; g_operation <= operations; g_operation++)
+	{
+		Sim_step();
+	}
+	seconds = (float64)(clock() - start) / CLOCKS_PER_SEC;
+
+	printf("%lu operations in %.3f s (%.0f operations/s), seed %lu\n", operations, seconds,
+			(seconds > 0) ? operations / seconds : 0.0, seed);
+	printf("%lu door openings, %lu door faults, %lu obstructions, %lu lockouts, %.1f hours of virtual time\n",
+			g_doorOpenings, g_doorFaults, g_obstructions, g_lockouts, (g_board.now_ms - SIM_START_MS) / 3.6e6);
+	printf("door travel %lu ms, learned travel times: open %u ms, close %u ms\n",
+			(unsigned long)g_board.typical_travel_ms, g_model.travel_times.open_ms, g_model.travel_times.close_ms);
+	printf("%lu failures\n", g_failures);
+
+	return (g_failures != 0) ? 1 : 0;
+}
+
+/*******************************************************************************
+ *                      Private Functions Definitions                          *
+ *******************************************************************************/
+
+static uint32 Sim_now(void)
+{
+	return g_board.now_ms;
+}
+
+static void Sim_sendResult(uint8 result)
+{
+	g_board.result = result;
+	g_board.results++;
+}
+
+static void Sim_reportDoorClear(void)
+{
+	g_board.door_clear = TRUE;
+}
+
+static void Sim_reportDoorState(uint8 state)
+{
+	g_board.door_state = state;
+	g_board.door_states++;
+}
+
+static void Sim_loadPassward(uint8 *passward)
+{
+	memcpy(passward, g_board.eeprom, PASSWARD_LENGTH);
+}
+
+static void Sim_storePassward(const uint8 *passward)
+{
+	memcpy(g_board.eeprom, passward, PASSWARD_LENGTH);
+}
+
+static void Sim_loadTravelTimes(DoorCore_TravelTimesType *times)
+{
+	*times = g_board.eeprom_travel_times;
+}
+
+static void Sim_storeTravelTimes(const DoorCore_TravelTimesType *times)
+{
+	g_board.eeprom_travel_times = *times;
+}
+
+/*
+ * A stop leaves the door where the move took it. A new move draws its speed, then the time its
+ * door needs to reach the switch from where it is and the time of its stall.
+ */
+static void Sim_setMotor(DoorCore_MotorType motion, uint32 travel_ms)
+{
+	uint32 spread = (g_board.typical_travel_ms * SIM_DOOR_SPREAD_PERCENT) / 100;
+	uint32 distance;
+
+	if(motion == DOOR_CORE_MOTOR_STOP)
+	{
+		if(g_board.motor != DOOR_CORE_MOTOR_STOP)
+		{
+			Sim_stopDoor();
+		}
+		g_board.motor = motion;
+		return;
+	}
+	g_board.motor = motion;
+	g_board.planned_travel_ms = travel_ms;
+	g_board.move_start_ms = g_board.now_ms;
+	g_board.move_travel_ms = g_board.typical_travel_ms - spread + (rand() % (2 * spread + 1));
+	g_board.stall_ms = 0xFFFFFFFFUL;
+	g_board.usual_speed = FALSE;
+	switch(rand() % SIM_ODD_MOVE_RATE)
+	{
+	case 0:
+		g_board.move_travel_ms = 0xFFFFFFFFUL;
+		break;
+	case 1:
+		g_board.move_travel_ms = SIM_MIN_DOOR_TRAVEL_MS + (rand() % (SIM_MAX_DOOR_TRAVEL_MS - SIM_MIN_DOOR_TRAVEL_MS));
+		break;
+	default:
+		g_board.usual_speed = TRUE;
+		break;
+	}
+
+	distance = (motion == DOOR_CORE_MOTOR_OPEN) ? (g_board.typical_travel_ms - g_board.position) : g_board.position;
+	if(g_board.move_travel_ms == 0xFFFFFFFFUL)
+	{
+		g_board.door_travel_ms = 0xFFFFFFFFUL;
+	}
+	else
+	{
+		/* At least 1 ms, the switch is only seen after the door left the other end */
+		g_board.door_travel_ms = 1 + (uint32)(((uint64)distance * g_board.move_travel_ms) / g_board.typical_travel_ms);
+		if((rand() % SIM_ODD_MOVE_RATE) == 0)
+		{
+			g_board.stall_ms = rand() % g_board.door_travel_ms;
+		}
+	}
+}
+
+/*
+ * The door moved at the speed of the move until now, or up to its switch. A learned travel
+ * time too short for the door times its moves out: the core must drop it at the first timeout.
+ */
+static void Sim_stopDoor(void)
+{
+	uint32 elapsed = g_board.now_ms - g_board.move_start_ms;
+	uint32 distance = 0;
+	uint8 *timeouts = &g_board.timeouts[(g_board.motor == DOOR_CORE_MOTOR_OPEN) ? 0 : 1];
+
+	if(elapsed >= g_board.door_travel_ms)
+	{
+		g_board.position = (g_board.motor == DOOR_CORE_MOTOR_OPEN) ? g_board.typical_travel_ms : 0;
+		*timeouts = 0;
+		return;
+	}
+	if((g_board.usual_speed == TRUE) && (elapsed < g_board.stall_ms) && (++*timeouts >= 2))
+	{
+		Sim_fail("timeouts in a row of a door at its usual speed");
+	}
+	if(g_board.move_travel_ms != 0xFFFFFFFFUL)
+	{
+		distance = (uint32)(((uint64)elapsed * g_board.typical_travel_ms) / g_board.move_travel_ms);
+	}
+	if(g_board.motor == DOOR_CORE_MOTOR_OPEN)
+	{
+		g_board.position += distance;
+		if(g_board.position >= g_board.typical_travel_ms)
+		{
+			/* Rounded up to the end but the switch was not reached */
+			g_board.position = g_board.typical_travel_ms - 1;
+		}
+	}
+	else
+	{
+		g_board.position = (distance < g_board.position) ? (g_board.position - distance) : 1;
+	}
+}
+
+static boolean Sim_isEndReached(DoorCore_MotorType motion)
+{
+	if(motion != g_board.motor)
+	{
+		Sim_fail("switch of the move");
+	}
+	return ((g_board.now_ms - g_board.move_start_ms) >= g_board.door_travel_ms) ? TRUE : FALSE;
+}
+
+static boolean Sim_isStalled(void)
+{
+	if(g_board.motor == DOOR_CORE_MOTOR_STOP)
+	{
+		Sim_fail("stall of the move");
+	}
+	return ((g_board.now_ms - g_board.move_start_ms) >= g_board.stall_ms) ? TRUE : FALSE;
+}
+
+static void Sim_setBuzzer(boolean on)
+{
+	g_board.buzzer = on;
+}
+
+static boolean Sim_isMotion(void)
+{
+	return g_board.motion;
+}
+
+/*
+ * Description :
+ * Play one random operation of the link, or a time step while the core is busy,
+ * on the core and on the model, then compare them.
+ */
+static void Sim_step(void)
+{
+	uint8 passward[PASSWARD_LENGTH];
+	uint8 confirmed_passward[PASSWARD_LENGTH];
+	uint8 expected_result = SIM_NO_RESULT;
+	boolean expected_door_clear = FALSE;
+	uint8 expected_door_state = SIM_NO_DOOR_STATE;
+	boolean match;
+	boolean complete = ((rand() % SIM_INCOMPLETE_ENTRY_RATE) != 0) ? TRUE : FALSE;
+	boolean incomplete_first;
+	uint8 choice;
+	uint32 door_travel_ms;
+	uint32 stall_ms;
+
+	g_board.result = SIM_NO_RESULT;
+	g_board.results = 0;
+	g_board.door_clear = FALSE;
+	g_board.door_state = SIM_NO_DOOR_STATE;
+	g_board.door_states = 0;
+
+	switch(g_model.state)
+	{
+	case DOOR_CORE_NEW_PASSWARD_STATE:
+		Sim_randomPassward(passward);
+		memcpy(confirmed_passward, passward, PASSWARD_LENGTH);
+		if((rand() % 4) == 0)
+		{
+			confirmed_passward[rand() % PASSWARD_LENGTH] ^= 1 + (rand() % 9);
+		}
+		/* An incomplete entry is the first one or the confirmation */
+		incomplete_first = (rand() & 1) ? TRUE : FALSE;
+		DoorCore_setPassward(((complete == TRUE) || (incomplete_first == FALSE)) ? passward : NULL_PTR,
+				((complete == TRUE) || (incomplete_first == TRUE)) ? confirmed_passward : NULL_PTR);
+
+		if((complete == TRUE) && (memcmp(passward, confirmed_passward, PASSWARD_LENGTH) == 0))
+		{
+			expected_result = EQUAL_PASS;
+			memcpy(g_model.passward, passward, PASSWARD_LENGTH);
+			Sim_enter(DOOR_CORE_LOCKED_STATE);
+		}
+		else
+		{
+			expected_result = NOT_EQUAL_PASS;
+			Sim_enter(DOOR_CORE_NEW_PASSWARD_STATE);
+		}
+		break;
+
+	case DOOR_CORE_LOCKED_STATE:
+	case DOOR_CORE_RETRY_STATE:
+		if((rand() % 3) == 0)
+		{
+			Sim_randomPassward(passward);
+		}
+		else
+		{
+			memcpy(passward, g_model.passward, PASSWARD_LENGTH);
+		}
+		/* The digits of an incomplete entry may be the right ones, it is still wrong */
+		DoorCore_checkPassward((complete == TRUE) ? passward : NULL_PTR);
+
+		match = ((complete == TRUE) && (memcmp(passward, g_model.passward, PASSWARD_LENGTH) == 0)) ? TRUE : FALSE;
+		expected_result = (match == TRUE) ? EQUAL_PASS : NOT_EQUAL_PASS;
+		if(g_model.state == DOOR_CORE_LOCKED_STATE)
+		{
+			g_model.failed_retries = 0;
+			Sim_enter((match == TRUE) ? DOOR_CORE_CHOICE_STATE : DOOR_CORE_RETRY_STATE);
+		}
+		else if(match == TRUE)
+		{
+			Sim_enter(DOOR_CORE_LOCKED_STATE);
+		}
+		else if(++g_model.failed_retries >= RETRIES)
+		{
+			g_lockouts++;
+			Sim_enter(DOOR_CORE_LOCKOUT_STATE);
+		}
+		else
+		{
+			Sim_enter(DOOR_CORE_RETRY_STATE);
+		}
+		break;
+
+	case DOOR_CORE_CHOICE_STATE:
+		choice = (uint8)((rand() % 4 == 0) ? (rand() & 0xFF) : ((rand() % 3 == 0) ? CHANGE_PASS_CHOICE : OPEN_DOOR_CHOICE));
+		DoorCore_selectChoice(choice);
+
+		if(choice == OPEN_DOOR_CHOICE)
+		{
+			g_doorOpenings++;
+			Sim_enter(DOOR_CORE_OPENING_STATE);
+			Sim_startMove(DOOR_CORE_MOTOR_OPEN);
+		}
+		else if(choice == CHANGE_PASS_CHOICE)
+		{
+			Sim_enter(DOOR_CORE_NEW_PASSWARD_STATE);
+		}
+		else
+		{
+			Sim_enter(DOOR_CORE_LOCKED_STATE);
+		}
+		break;
+
+	default:
+		/* Busy, the time runs and people come and go */
+		g_board.now_ms += 1 + (rand() % SIM_MAX_STEP_MS);
+		if((rand() % 8) == 0)
+		{
+			g_board.motion = (g_board.motion == TRUE) ? FALSE : TRUE;
+		}
+		/* A reopening draws a new move, the model checks the running one */
+		door_travel_ms = g_board.door_travel_ms;
+		stall_ms = g_board.stall_ms;
+		DoorCore_update();
+
+		switch(g_model.state)
+		{
+		case DOOR_CORE_OPENING_STATE:
+			expected_door_state = Sim_endMove(DOOR_CORE_MOTOR_OPEN, door_travel_ms, stall_ms);
+			if(expected_door_state != SIM_NO_DOOR_STATE)
+			{
+				Sim_enter(DOOR_CORE_HOLDING_STATE);
+			}
+			break;
+		case DOOR_CORE_HOLDING_STATE:
+			if((g_board.now_ms - g_model.entry_ms) >= DOOR_CORE_HOLD_MS)
+			{
+				Sim_enter(DOOR_CORE_CLEARING_STATE);
+			}
+			break;
+		case DOOR_CORE_CLEARING_STATE:
+			if(g_board.motion == FALSE)
+			{
+				expected_door_clear = TRUE;
+				Sim_enter(DOOR_CORE_CLOSING_STATE);
+				Sim_startMove(DOOR_CORE_MOTOR_CLOSE);
+			}
+			break;
+		case DOOR_CORE_CLOSING_STATE:
+			expected_door_state = Sim_endMove(DOOR_CORE_MOTOR_CLOSE, door_travel_ms, stall_ms);
+			if(expected_door_state == DOOR_OBSTRUCTED_BYTE)
+			{
+				Sim_enter(DOOR_CORE_OPENING_STATE);
+				Sim_startMove(DOOR_CORE_MOTOR_OPEN);
+			}
+			else if(expected_door_state != SIM_NO_DOOR_STATE)
+			{
+				Sim_enter(DOOR_CORE_LOCKED_STATE);
+			}
+			break;
+		default:
+			if((g_board.now_ms - g_model.entry_ms) >= DOOR_CORE_LOCKOUT_MS)
+			{
+				Sim_enter(DOOR_CORE_LOCKED_STATE);
+			}
+			break;
+		}
+		break;
+	}
+
+	Sim_check(expected_result, expected_door_clear, expected_door_state);
+}
+
+/* Digits as sent by the HMI keypad */
+static void Sim_randomPassward(uint8 *passward)
+{
+	uint8 i;
+
+	for(i = 0; i < PASSWARD_LENGTH; i++)
+	{
+		passward[i] = (uint8)(rand() % 10);
+	}
+}
+
+static void Sim_enter(DoorCore_StateType state)
+{
+	g_model.state = state;
+	g_model.entry_ms = g_board.now_ms;
+}
+
+static uint16 *Sim_learnedTravel(DoorCore_TravelTimesType *times, DoorCore_MotorType motion)
+{
+	return (motion == DOOR_CORE_MOTOR_OPEN) ? &times->open_ms : &times->close_ms;
+}
+
+/*
+ * Description :
+ * A move starts: the planned travel is the learned one, or the default before it is learned.
+ * It is a full travel if the door stopped at an end of travel, which must be the other end.
+ */
+static void Sim_startMove(DoorCore_MotorType motion)
+{
+	uint16 learned = *Sim_learnedTravel(&g_model.travel_times, motion);
+
+	if(g_board.planned_travel_ms != ((learned == 0) ? DOOR_CORE_TRAVEL_MS : learned))
+	{
+		Sim_fail("planned travel");
+	}
+	if((g_model.at_end == TRUE) &&
+			(g_board.position != ((motion == DOOR_CORE_MOTOR_OPEN) ? 0 : g_board.typical_travel_ms)))
+	{
+		Sim_fail("end of travel of a full travel");
+	}
+	g_model.full_travel = g_model.at_end;
+	g_model.at_end = FALSE;
+}
+
+/*
+ * Description :
+ * Door state expected after a time step of the move drawn by the board: opened or closed once the switch is
+ * reached (checked first), then a stall (obstructed while closing, a fault while opening),
+ * the fault after the timeout, else none. The travel times of the full moves are learned,
+ * dropped after a timeout and stored as the core must do it.
+ */
+static uint8 Sim_endMove(DoorCore_MotorType motion, uint32 door_travel_ms, uint32 stall_ms)
+{
+	uint16 *learned = Sim_learnedTravel(&g_model.travel_times, motion);
+	uint16 stored = *Sim_learnedTravel(&g_model.eeprom_travel_times, motion);
+	uint32 elapsed = g_board.now_ms - g_model.entry_ms;
+	uint32 timeout = (*learned == 0) ? DOOR_CORE_MAX_TRAVEL_MS : (*learned + (*learned / 2));
+
+	if(timeout > DOOR_CORE_MAX_TRAVEL_MS)
+	{
+		timeout = DOOR_CORE_MAX_TRAVEL_MS;
+	}
+	if(elapsed >= door_travel_ms)
+	{
+		if((g_model.full_travel == TRUE) && (elapsed >= DOOR_CORE_MIN_TRAVEL_MS) && (elapsed <= DOOR_CORE_MAX_TRAVEL_MS))
+		{
+			*learned = (*learned == 0) ? (uint16)elapsed : (uint16)((3UL * *learned + elapsed + 2) / 4);
+			if((stored > DOOR_CORE_MAX_TRAVEL_MS) || (abs((int)*learned - (int)stored) >= (int)DOOR_CORE_TRAVEL_SAVE_MS))
+			{
+				g_model.eeprom_travel_times = g_model.travel_times;
+			}
+		}
+		g_model.at_end = TRUE;
+		return (motion == DOOR_CORE_MOTOR_OPEN) ? DOOR_OPENED_BYTE : DOOR_CLOSED_BYTE;
+	}
+	if(elapsed >= stall_ms)
+	{
+		if(motion == DOOR_CORE_MOTOR_CLOSE)
+		{
+			g_obstructions++;
+			return DOOR_OBSTRUCTED_BYTE;
+		}
+		g_doorFaults++;
+		return DOOR_FAULT_BYTE;
+	}
+	if(elapsed >= timeout)
+	{
+		/* Not stored again if it was not learned, an erased EEPROM loads as not learned */
+		*learned = 0;
+		if((stored >= DOOR_CORE_MIN_TRAVEL_MS) && (stored <= DOOR_CORE_MAX_TRAVEL_MS))
+		{
+			g_model.eeprom_travel_times = g_model.travel_times;
+		}
+		g_doorFaults++;
+		return DOOR_FAULT_BYTE;
+	}
+	return SIM_NO_DOOR_STATE;
+}
+
+/*
+ * Description :
+ * Compare the core and its outputs with the model after an operation.
+ */
+static void Sim_check(uint8 expected_result, boolean expected_door_clear, uint8 expected_door_state)
+{
+	DoorCore_MotorType expected_motor = DOOR_CORE_MOTOR_STOP;
+
+	if(g_model.state == DOOR_CORE_OPENING_STATE)
+	{
+		expected_motor = DOOR_CORE_MOTOR_OPEN;
+	}
+	else if(g_model.state == DOOR_CORE_CLOSING_STATE)
+	{
+		expected_motor = DOOR_CORE_MOTOR_CLOSE;
+	}
+
+	if(DoorCore_getState() != g_model.state)
+	{
+		Sim_fail("state");
+	}
+	if(g_board.results != ((expected_result == SIM_NO_RESULT) ? 0 : 1) || (g_board.result != expected_result))
+	{
+		Sim_fail("result sent to the HMI");
+	}
+	if(g_board.door_clear != expected_door_clear)
+	{
+		Sim_fail("door clear report");
+	}
+	if((g_board.door_states != ((expected_door_state == SIM_NO_DOOR_STATE) ? 0 : 1)) ||
+			(g_board.door_state != expected_door_state))
+	{
+		Sim_fail("door state sent to the HMI");
+	}
+	if(memcmp(&g_board.eeprom_travel_times, &g_model.eeprom_travel_times, sizeof(DoorCore_TravelTimesType)) != 0)
+	{
+		Sim_fail("stored travel times");
+	}
+	if(g_board.motor != expected_motor)
+	{
+		Sim_fail("motor");
+	}
+	if(g_board.buzzer != ((g_model.state == DOOR_CORE_LOCKOUT_STATE) ? TRUE : FALSE))
+	{
+		Sim_fail("buzzer");
+	}
+	if((g_model.state != DOOR_CORE_NEW_PASSWARD_STATE) &&
+			(memcmp(g_board.eeprom, g_model.passward, PASSWARD_LENGTH) != 0))
+	{
+		Sim_fail("stored password");
+	}
+	if(DoorCore_isBusy() != ((g_model.state >= DOOR_CORE_OPENING_STATE) ? TRUE : FALSE))
+	{
+		Sim_fail("busy");
+	}
+}
+
+static void Sim_fail(const char *what)
+{
+	if(g_failures < SIM_MAX_PRINTED_FAILURES)
+	{
+		fprintf(stderr, "operation %lu: %s differs, core state %u, model state %u\n",
+				g_operation, what, (unsigned)DoorCore_getState(), (unsigned)g_model.state);
+	}
+	g_failures++;
+}
@@ -0,0 +1,384 @@
+ /******************************************************************************
+ *
+ * Module: FSM Bench
+ *
+ * File Name: fsm_bench.c
+ *
+ * Description: Runs the FSM engine (LIB/fsm.c) unchanged on the host against a
+ *              random machine: each cell of its [state][event] table is empty,
+ *              plain or guarded, with or without an action, and each state has
+ *              an activity or none. Random events are dispatched (or the state
+ *              activity is run) with random guard results and time steps, and
+ *              after each one the result, the state and the actions are checked
+ *              against a reference model, and every BENCH_STATS_CHECK_PERIOD
+ *              operations and at the end also the time in each state, the state
+ *              entries and the transition counts of the instrumentation.
+ *
+ *              The throughput is then measured without the model: the same
+ *              random events are dispatched with the instrumentation enabled and
+ *              disabled, and the dispatches and transitions per second printed.
+ *
+ *              Build from Door_Locking_System_Code:
+ *
+ *              gcc -std=gnu99 -O2 -funsigned-char -DTRACE_ENABLE=0 \
+ *                  -IControl_ECU/LIB -IControl_ECU/Main \
+ *                  Tools/fsm_bench/fsm_bench.c Control_ECU/LIB/fsm.c -o fsm_bench
+ *
+ *              ./fsm_bench [operations] [seed]
+ *
+ *              The exit status is 1 if the engine and the model disagree.
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "fsm.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define BENCH_DEFAULT_OPERATIONS       10000000UL
+#define BENCH_DEFAULT_SEED             1UL
+
+/* Size of the random machine, the state 0 is the reserved FSM_NO_STATE */
+#define BENCH_NUM_OF_STATES            16
+#define BENCH_NUM_OF_EVENTS            8
+
+/* Kinds of the table cells, in percent */
+#define BENCH_EMPTY_PERCENT            25
+#define BENCH_GUARDED_PERCENT          30
+#define BENCH_ACTION_PERCENT           50
+#define BENCH_HANDLER_PERCENT          75
+
+/* One operation in BENCH_RUN_RATE runs the state activity instead of a dispatch */
+#define BENCH_RUN_RATE                 8
+
+/* The clock starts before its wrap around to check the time in state computations */
+#define BENCH_START_TIME               (0xFFFFFFFFUL - 100000UL)
+#define BENCH_MAX_STEP                 100
+
+/* The instrumentation is compared with the model after this many operations */
+#define BENCH_STATS_CHECK_PERIOD       65536UL
+
+/* Events of the timed runs, read in a loop */
+#define BENCH_NUM_OF_TIMED_EVENTS      4096
+
+/* Failures printed before the end report */
+#define BENCH_MAX_PRINTED_FAILURES     10
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+/* Reference model of the engine */
+typedef struct
+{
+	FSM_StateType state;
+	uint32 entry_time;
+	FSM_StateStatsType state_stats[BENCH_NUM_OF_STATES];
+	uint16 transition_counts[BENCH_NUM_OF_STATES * BENCH_NUM_OF_EVENTS];
+	unsigned long actions;                   /* Actions run so far */
+}Bench_ModelType;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static uint32 Bench_now(void);
+static boolean Bench_guard(void);
+static void Bench_action(void);
+static FSM_EventType Bench_handler(void);
+
+static void Bench_buildMachine(void);
+static void Bench_step(void);
+static boolean Bench_modelDispatch(FSM_EventType event);
+static void Bench_checkStats(void);
+static void Bench_measure(const char *name, FSM_StateStatsType *state_stats, uint16 *transition_counts,
+		unsigned long dispatches);
+static void Bench_fail(const char *what);
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+static FSM_HandlerType g_handlers[BENCH_NUM_OF_STATES];
+static FSM_TransitionType g_transitions[BENCH_NUM_OF_STATES * BENCH_NUM_OF_EVENTS];
+
+static const FSM_ConfigType g_config =
+{
+	g_handlers, g_transitions, BENCH_NUM_OF_STATES, BENCH_NUM_OF_EVENTS, 1, Bench_now
+};
+
+/* Without the time source, as a machine built without the instrumentation */
+static const FSM_ConfigType g_untimedConfig =
+{
+	g_handlers, g_transitions, BENCH_NUM_OF_STATES, BENCH_NUM_OF_EVENTS, 1, NULL_PTR
+};
+
+static FSM_Type g_fsm;
+static FSM_StateStatsType g_stateStats[BENCH_NUM_OF_STATES];
+static uint16 g_transitionCounts[BENCH_NUM_OF_STATES * BENCH_NUM_OF_EVENTS];
+static Bench_ModelType g_model;
+
+/* Seen by the guard, the action and the activity */
+static uint32 g_now = BENCH_START_TIME;
+static boolean g_guardResult = TRUE;
+static unsigned long g_actions = 0;
+static FSM_EventType g_handlerEvent = 0;
+
+static FSM_EventType g_timedEvents[BENCH_NUM_OF_TIMED_EVENTS];
+
+static unsigned long g_operation = 0;
+static unsigned long g_failures = 0;
+static unsigned long g_transitionsTaken = 0;
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+int main(int argc, char *argv[])
+{
+	unsigned long operations = BENCH_DEFAULT_OPERATIONS;
+	unsigned long seed = BENCH_DEFAULT_SEED;
+	uint16 i;
+
+	if(argc > 3)
+	{
+		fprintf(stderr, "usage: %s [operations] [seed]\n", argv[0]);
+		return 2;
+	}
+	if(argc > 1)
+	{
+		operations = strtoul(argv[1], NULL, 10);
+	}
+	if(argc > 2)
+	{
+		seed = strtoul(argv[2], NULL, 10);
+	}
+	srand((unsigned int)seed);
+
+	Bench_buildMachine();
+	FSM_init(&g_fsm, &g_config, g_stateStats, g_transitionCounts);
+	memset(&g_model, 0, sizeof(g_model));
+	g_model.state = g_config.initial_state;
+	g_model.entry_time = g_now;
+	g_model.state_stats[g_model.state].entries = 1;
+
+	for(g_operation = 1; g_operation <= operations; g_operation++)
+	{
+		Bench_step();
+		if((g_operation % BENCH_STATS_CHECK_PERIOD) == 0)
+		{
+			Bench_checkStats();
+		}
+	}
+	Bench_checkStats();
+	printf("%lu operations checked, %lu transitions, %lu actions, seed %lu\n",
+			operations, g_transitionsTaken, g_actions, seed);
+
+	/* The guards pass, so the timed runs take every transition that is not empty */
+	g_guardResult = TRUE;
+	for(i = 0; i < BENCH_NUM_OF_TIMED_EVENTS; i++)
+	{
+		g_timedEvents[i] = (FSM_EventType)(rand() % BENCH_NUM_OF_EVENTS);
+	}
+	Bench_measure("instrumented", g_stateStats, g_transitionCounts, operations);
+	Bench_measure("plain", NULL_PTR, NULL_PTR, operations);
+
+	printf("%lu failures\n", g_failures);
+
+	return (g_failures != 0) ? 1 : 0;
+}
+
+/*******************************************************************************
+ *                      Private Functions Definitions                          *
+ *******************************************************************************/
+
+static uint32 Bench_now(void)
+{
+	return g_now;
+}
+
+static boolean Bench_guard(void)
+{
+	return g_guardResult;
+}
+
+static void Bench_action(void)
+{
+	g_actions++;
+}
+
+static FSM_EventType Bench_handler(void)
+{
+	return g_handlerEvent;
+}
+
+/* Random cells, every state keeps at least one way out so the runs do not get stuck */
+static void Bench_buildMachine(void)
+{
+	FSM_StateType state;
+	FSM_EventType event;
+	FSM_TransitionType *cell;
+
+	for(state = 1; state < BENCH_NUM_OF_STATES; state++)
+	{
+		g_handlers[state] = ((rand() % 100) < BENCH_HANDLER_PERCENT) ? Bench_handler : NULL_PTR;
+		for(event = 0; event < BENCH_NUM_OF_EVENTS; event++)
+		{
+			cell = &g_transitions[(state * BENCH_NUM_OF_EVENTS) + event];
+			if((event != 0) && ((rand() % 100) < BENCH_EMPTY_PERCENT))
+			{
+				continue;
+			}
+			cell->next_state = (FSM_StateType)(1 + (rand() % (BENCH_NUM_OF_STATES - 1)));
+			cell->guard = ((event != 0) && ((rand() % 100) < BENCH_GUARDED_PERCENT)) ? Bench_guard : NULL_PTR;
+			cell->action = ((rand() % 100) < BENCH_ACTION_PERCENT) ? Bench_action : NULL_PTR;
+		}
+	}
+}
+
+/*
+ * One random operation: a time step, then a dispatch or a run of the state activity. The
+ * events include some out of the table, which are ignored.
+ */
+static void Bench_step(void)
+{
+	FSM_EventType event = (FSM_EventType)(rand() % (BENCH_NUM_OF_EVENTS + 1));
+	boolean expected_result;
+
+	g_now += rand() % (BENCH_MAX_STEP + 1);
+	g_guardResult = (rand() & 1) ? TRUE : FALSE;
+
+	if((rand() % BENCH_RUN_RATE) == 0)
+	{
+		/* The activity returns the event, FSM_run has no result to check */
+		g_handlerEvent = event;
+		expected_result = (g_handlers[g_model.state] != NULL_PTR) ? Bench_modelDispatch(event) : FALSE;
+		FSM_run(&g_fsm);
+	}
+	else
+	{
+		expected_result = Bench_modelDispatch(event);
+		if(FSM_dispatch(&g_fsm, event) != expected_result)
+		{
+			Bench_fail("dispatch result");
+		}
+	}
+
+	if(FSM_getState(&g_fsm) != g_model.state)
+	{
+		Bench_fail("state");
+	}
+	if(g_actions != g_model.actions)
+	{
+		Bench_fail("actions");
+	}
+	if(expected_result == TRUE)
+	{
+		g_transitionsTaken++;
+	}
+}
+
+/* The model of FSM_dispatch */
+static boolean Bench_modelDispatch(FSM_EventType event)
+{
+	uint16 index;
+	const FSM_TransitionType *cell;
+
+	if(event >= BENCH_NUM_OF_EVENTS)
+	{
+		return FALSE;
+	}
+	index = ((uint16)g_model.state * BENCH_NUM_OF_EVENTS) + event;
+	cell = &g_transitions[index];
+	if((cell->next_state == FSM_NO_STATE) || ((cell->guard != NULL_PTR) && (g_guardResult == FALSE)))
+	{
+		return FALSE;
+	}
+
+	g_model.transition_counts[index]++;
+	if(cell->action != NULL_PTR)
+	{
+		g_model.actions++;
+	}
+	g_model.state_stats[g_model.state].time_in_state += g_now - g_model.entry_time;
+	g_model.state = cell->next_state;
+	g_model.entry_time = g_now;
+	g_model.state_stats[g_model.state].entries++;
+
+	return TRUE;
+}
+
+static void Bench_checkStats(void)
+{
+	FSM_StateType state;
+	FSM_EventType event;
+	uint32 time;
+
+	for(state = 1; state < BENCH_NUM_OF_STATES; state++)
+	{
+		time = g_model.state_stats[state].time_in_state;
+		if(state == g_model.state)
+		{
+			time += g_now - g_model.entry_time;
+		}
+		if(FSM_getTimeInState(&g_fsm, state) != time)
+		{
+			Bench_fail("time in state");
+		}
+		if(g_stateStats[state].entries != g_model.state_stats[state].entries)
+		{
+			Bench_fail("state entries");
+		}
+		for(event = 0; event < BENCH_NUM_OF_EVENTS; event++)
+		{
+			if(FSM_getTransitionCount(&g_fsm, state, event)
+					!= g_model.transition_counts[(state * BENCH_NUM_OF_EVENTS) + event])
+			{
+				Bench_fail("transition count");
+			}
+		}
+	}
+}
+
+/* Dispatch the timed events in a loop and print the rates */
+static void Bench_measure(const char *name, FSM_StateStatsType *state_stats, uint16 *transition_counts,
+		unsigned long dispatches)
+{
+	const FSM_ConfigType *config = (state_stats != NULL_PTR) ? &g_config : &g_untimedConfig;
+	unsigned long transitions = 0;
+	unsigned long i;
+	clock_t start;
+	float64 seconds;
+
+	FSM_init(&g_fsm, config, state_stats, transition_counts);
+	start = clock();
+	for(i = 0; i < dispatches; i++)
+	{
+		transitions += FSM_dispatch(&g_fsm, g_timedEvents[i % BENCH_NUM_OF_TIMED_EVENTS]);
+	}
+	seconds = (float64)(clock() - start) / CLOCKS_PER_SEC;
+	if(seconds <= 0)
+	{
+		seconds = 1.0 / CLOCKS_PER_SEC;
+	}
+
+	printf("%s: %lu dispatches in %.3f s, %.1f M dispatches/s, %.1f M transitions/s\n", name,
+			dispatches, seconds, dispatches / seconds / 1e6, transitions / seconds / 1e6);
+}
+
+static void Bench_fail(const char *what)
+{
+	if(g_failures < BENCH_MAX_PRINTED_FAILURES)
+	{
+		fprintf(stderr, "operation %lu: %s differs, engine state %u, model state %u\n",
+				g_operation, what, (unsigned)FSM_getState(&g_fsm), (unsigned)g_model.state);
+	}
+	g_failures++;
+}
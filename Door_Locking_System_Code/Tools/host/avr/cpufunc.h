@@ -0,0 +1,24 @@
+ /******************************************************************************
+ *
+ * Module: Host AVR
+ *
+ * File Name: cpufunc.h
+ *
+ * Description: Host replacement of <avr/cpufunc.h>. A busy wait on a variable
+ *              written by an ISR accesses no register, so it runs _NOP() in its
+ *              body: one CPU cycle of virtual time, the timers and the ISRs
+ *              progress and the wait ends.
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#ifndef HOST_AVR_CPUFUNC_H_
+#define HOST_AVR_CPUFUNC_H_
+
+#include "host.h"
+
+#define _NOP()                         Host_advanceNs(HOST_CYCLE_NS)
+#define _MemoryBarrier()               __asm__ __volatile__("" ::: "memory")
+
+#endif /* HOST_AVR_CPUFUNC_H_ */
@@ -0,0 +1,26 @@
+ /******************************************************************************
+ *
+ * Module: Host AVR
+ *
+ * File Name: interrupt.h
+ *
+ * Description: Host replacement of <avr/interrupt.h>. cli/sei change the I bit
+ *              of SREG, host.c calls the ISRs when their flag and enable bits
+ *              are set while the I bit is set.
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#ifndef HOST_AVR_INTERRUPT_H_
+#define HOST_AVR_INTERRUPT_H_
+
+#include <avr/io.h>
+
+#define cli()                          (SREG &= (uint8_t)~(1 << SREG_I))
+#define sei()                          (SREG |= (1 << SREG_I))
+
+/* The vector names are __vector_n, host.c finds the defined ones by their (weak) symbol */
+#define ISR(vector, ...)               void vector(void); void vector(void)
+
+#endif /* HOST_AVR_INTERRUPT_H_ */
@@ -0,0 +1,370 @@
+ /******************************************************************************
+ *
+ * Module: Host AVR
+ *
+ * File Name: io.h
+ *
+ * Description: Host replacement of <avr/io.h> for the ATmega32. Each I/O register
+ *              name is its data space address in the virtual register file of
+ *              host.c, it is only usable through the registers.h macros. SREG is
+ *              a plain variable, the critical sections save and restore it directly.
+ *              The models define HOST_REGISTER_ADDRESSES before the include to get
+ *              the register names as plain addresses (like _SFR_ASM_COMPAT).
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#ifndef HOST_AVR_IO_H_
+#define HOST_AVR_IO_H_
+
+#include <stdint.h>
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+/* An I/O register, the struct makes a direct access (PORTA = 0) a compile error */
+typedef struct
+{
+	uint8_t address;
+}Host_RegisterType;
+
+#define HOST_REGISTER(address)         ((Host_RegisterType){ (address) })
+
+#if defined(HOST_REGISTER_ADDRESSES)
+#define HOST_SFR(address)              (address)
+#else
+#define HOST_SFR(address)              HOST_REGISTER(address)
+#endif
+
+/*******************************************************************************
+ *                              Functions Prototypes                           *
+ *******************************************************************************/
+
+/* Register accesses of the registers.h macros, implemented in host.c */
+uint8_t Host_readRegister(Host_RegisterType reg);
+void Host_writeRegister(Host_RegisterType reg, uint8_t value);
+uint16_t Host_readRegister16(Host_RegisterType reg);
+void Host_writeRegister16(Host_RegisterType reg, uint16_t value);
+
+/* Declared by <stdlib.h> in avr-libc, used by lcd.c without the include */
+char *itoa(int value, char *buffer, int radix);
+
+/*******************************************************************************
+ *                                 Registers                                   *
+ *******************************************************************************/
+
+extern volatile uint8_t SREG;
+
+#define SPH                            HOST_SFR(0x5E)
+#define SPL                            HOST_SFR(0x5D)
+#define OCR0                           HOST_SFR(0x5C)
+#define GICR                           HOST_SFR(0x5B)
+#define GIFR                           HOST_SFR(0x5A)
+#define TIMSK                          HOST_SFR(0x59)
+#define TIFR                           HOST_SFR(0x58)
+#define SPMCR                          HOST_SFR(0x57)
+#define TWCR                           HOST_SFR(0x56)
+#define MCUCR                          HOST_SFR(0x55)
+#define MCUCSR                         HOST_SFR(0x54)
+#define TCCR0                          HOST_SFR(0x53)
+#define TCNT0                          HOST_SFR(0x52)
+#define OSCCAL                         HOST_SFR(0x51)
+#define SFIOR                          HOST_SFR(0x50)
+#define TCCR1A                         HOST_SFR(0x4F)
+#define TCCR1B                         HOST_SFR(0x4E)
+#define TCNT1                          HOST_SFR(0x4C)
+#define TCNT1H                         HOST_SFR(0x4D)
+#define TCNT1L                         HOST_SFR(0x4C)
+#define OCR1A                          HOST_SFR(0x4A)
+#define OCR1AH                         HOST_SFR(0x4B)
+#define OCR1AL                         HOST_SFR(0x4A)
+#define OCR1B                          HOST_SFR(0x48)
+#define OCR1BH                         HOST_SFR(0x49)
+#define OCR1BL                         HOST_SFR(0x48)
+#define ICR1                           HOST_SFR(0x46)
+#define ICR1H                          HOST_SFR(0x47)
+#define ICR1L                          HOST_SFR(0x46)
+#define TCCR2                          HOST_SFR(0x45)
+#define TCNT2                          HOST_SFR(0x44)
+#define OCR2                           HOST_SFR(0x43)
+#define ASSR                           HOST_SFR(0x42)
+#define WDTCR                          HOST_SFR(0x41)
+#define UBRRH                          HOST_SFR(0x40) /* Same address as UCSRC, selected by URSEL */
+#define UCSRC                          HOST_SFR(0x40)
+#define EEARH                          HOST_SFR(0x3F)
+#define EEARL                          HOST_SFR(0x3E)
+#define EEDR                           HOST_SFR(0x3D)
+#define EECR                           HOST_SFR(0x3C)
+#define PORTA                          HOST_SFR(0x3B)
+#define DDRA                           HOST_SFR(0x3A)
+#define PINA                           HOST_SFR(0x39)
+#define PORTB                          HOST_SFR(0x38)
+#define DDRB                           HOST_SFR(0x37)
+#define PINB                           HOST_SFR(0x36)
+#define PORTC                          HOST_SFR(0x35)
+#define DDRC                           HOST_SFR(0x34)
+#define PINC                           HOST_SFR(0x33)
+#define PORTD                          HOST_SFR(0x32)
+#define DDRD                           HOST_SFR(0x31)
+#define PIND                           HOST_SFR(0x30)
+#define SPDR                           HOST_SFR(0x2F)
+#define SPSR                           HOST_SFR(0x2E)
+#define SPCR                           HOST_SFR(0x2D)
+#define UDR                            HOST_SFR(0x2C)
+#define UCSRA                          HOST_SFR(0x2B)
+#define UCSRB                          HOST_SFR(0x2A)
+#define UBRRL                          HOST_SFR(0x29)
+#define ACSR                           HOST_SFR(0x28)
+#define ADMUX                          HOST_SFR(0x27)
+#define ADCSRA                         HOST_SFR(0x26)
+#define ADC                            HOST_SFR(0x24)
+#define ADCH                           HOST_SFR(0x25)
+#define ADCL                           HOST_SFR(0x24)
+#define TWDR                           HOST_SFR(0x23)
+#define TWAR                           HOST_SFR(0x22)
+#define TWSR                           HOST_SFR(0x21)
+#define TWBR                           HOST_SFR(0x20)
+
+/*******************************************************************************
+ *                              Interrupt Vectors                              *
+ *******************************************************************************/
+
+/* Same numbers as avr-libc, ISR(vector) defines __vector_n */
+#define INT0_vect                      __vector_1
+#define INT1_vect                      __vector_2
+#define INT2_vect                      __vector_3
+#define TIMER2_COMP_vect               __vector_4
+#define TIMER2_OVF_vect                __vector_5
+#define TIMER1_CAPT_vect               __vector_6
+#define TIMER1_COMPA_vect              __vector_7
+#define TIMER1_COMPB_vect              __vector_8
+#define TIMER1_OVF_vect                __vector_9
+#define TIMER0_COMP_vect               __vector_10
+#define TIMER0_OVF_vect                __vector_11
+#define SPI_STC_vect                   __vector_12
+#define USART_RXC_vect                 __vector_13
+#define USART_UDRE_vect                __vector_14
+#define USART_TXC_vect                 __vector_15
+#define ADC_vect                       __vector_16
+#define EE_RDY_vect                    __vector_17
+#define ANA_COMP_vect                  __vector_18
+#define TWI_vect                       __vector_19
+#define SPM_RDY_vect                   __vector_20
+
+#define _VECTORS_SIZE                  84
+
+/*******************************************************************************
+ *                                Register Bits                                *
+ *******************************************************************************/
+
+/* SREG */
+#define SREG_I                         7
+
+/* TCCR0 */
+#define FOC0                           7
+#define WGM00                          6
+#define COM01                          5
+#define COM00                          4
+#define WGM01                          3
+#define CS02                           2
+#define CS01                           1
+#define CS00                           0
+
+/* TIMSK */
+#define OCIE2                          7
+#define TOIE2                          6
+#define TICIE1                         5
+#define OCIE1A                         4
+#define OCIE1B                         3
+#define TOIE1                          2
+#define OCIE0                          1
+#define TOIE0                          0
+
+/* TIFR */
+#define OCF2                           7
+#define TOV2                           6
+#define ICF1                           5
+#define OCF1A                          4
+#define OCF1B                          3
+#define TOV1                           2
+#define OCF0                           1
+#define TOV0                           0
+
+/* TCCR1A */
+#define COM1A1                         7
+#define COM1A0                         6
+#define COM1B1                         5
+#define COM1B0                         4
+#define FOC1A                          3
+#define FOC1B                          2
+#define WGM11                          1
+#define WGM10                          0
+
+/* TCCR1B */
+#define ICNC1                          7
+#define ICES1                          6
+#define WGM13                          4
+#define WGM12                          3
+#define CS12                           2
+#define CS11                           1
+#define CS10                           0
+
+/* TCCR2 */
+#define FOC2                           7
+#define WGM20                          6
+#define COM21                          5
+#define COM20                          4
+#define WGM21                          3
+#define CS22                           2
+#define CS21                           1
+#define CS20                           0
+
+/* ASSR */
+#define AS2                            3
+#define TCN2UB                         2
+#define OCR2UB                         1
+#define TCR2UB                         0
+
+/* UCSRA */
+#define RXC                            7
+#define TXC                            6
+#define UDRE                           5
+#define FE                             4
+#define DOR                            3
+#define PE                             2
+#define U2X                            1
+#define MPCM                           0
+
+/* UCSRB */
+#define RXCIE                          7
+#define TXCIE                          6
+#define UDRIE                          5
+#define RXEN                           4
+#define TXEN                           3
+#define UCSZ2                          2
+#define RXB8                           1
+#define TXB8                           0
+
+/* UCSRC */
+#define URSEL                          7
+#define UMSEL                          6
+#define UPM1                           5
+#define UPM0                           4
+#define USBS                           3
+#define UCSZ1                          2
+#define UCSZ0                          1
+#define UCPOL                          0
+
+/* TWCR */
+#define TWINT                          7
+#define TWEA                           6
+#define TWSTA                          5
+#define TWSTO                          4
+#define TWWC                           3
+#define TWEN                           2
+#define TWIE                           0
+
+/* TWSR */
+#define TWS7                           7
+#define TWS6                           6
+#define TWS5                           5
+#define TWS4                           4
+#define TWS3                           3
+#define TWPS1                          1
+#define TWPS0                          0
+
+/* TWAR */
+#define TWGCE                          0
+
+/* GICR */
+#define INT1                           7
+#define INT0                           6
+#define INT2                           5
+#define IVSEL                          1
+#define IVCE                           0
+
+/* GIFR */
+#define INTF1                          7
+#define INTF0                          6
+#define INTF2                          5
+
+/* MCUCR */
+#define SE                             7
+#define SM2                            6
+#define SM1                            5
+#define SM0                            4
+#define ISC11                          3
+#define ISC10                          2
+#define ISC01                          1
+#define ISC00                          0
+
+/* MCUCSR */
+#define JTD                            7
+#define ISC2                           6
+#define JTRF                           4
+#define WDRF                           3
+#define BORF                           2
+#define EXTRF                          1
+#define PORF                           0
+
+/* SFIOR */
+#define ADTS2                          7
+#define ADTS1                          6
+#define ADTS0                          5
+#define ACME                           3
+#define PUD                            2
+#define PSR2                           1
+#define PSR10                          0
+
+/* ADMUX */
+#define REFS1                          7
+#define REFS0                          6
+#define ADLAR                          5
+#define MUX4                           4
+#define MUX3                           3
+#define MUX2                           2
+#define MUX1                           1
+#define MUX0                           0
+
+/* ADCSRA */
+#define ADEN                           7
+#define ADSC                           6
+#define ADATE                          5
+#define ADIF                           4
+#define ADIE                           3
+#define ADPS2                          2
+#define ADPS1                          1
+#define ADPS0                          0
+
+/* ACSR */
+#define ACD                            7
+#define ACBG                           6
+#define ACO                            5
+#define ACI                            4
+#define ACIE                           3
+#define ACIC                           2
+#define ACIS1                          1
+#define ACIS0                          0
+
+/* SPCR / SPSR */
+#define SPIE                           7
+#define SPE                            6
+#define DORD                           5
+#define MSTR                           4
+#define CPOL                           3
+#define CPHA                           2
+#define SPR1                           1
+#define SPR0                           0
+#define SPIF                           7
+#define WCOL                           6
+#define SPI2X                          0
+
+/* EECR */
+#define EERIE                          3
+#define EEMWE                          2
+#define EEWE                           1
+#define EERE                           0
+
+#endif /* HOST_AVR_IO_H_ */
@@ -0,0 +1,25 @@
+ /******************************************************************************
+ *
+ * Module: Host AVR
+ *
+ * File Name: pgmspace.h
+ *
+ * Description: Host replacement of <avr/pgmspace.h>, the flash data is in
+ *              the normal address space.
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#ifndef HOST_AVR_PGMSPACE_H_
+#define HOST_AVR_PGMSPACE_H_
+
+#include <stdint.h>
+
+#define PROGMEM
+#define PSTR(s)                        (s)
+#define pgm_read_byte(address)         (*(const uint8_t *)(address))
+#define pgm_read_word(address)         (*(const uint16_t *)(address))
+#define pgm_read_dword(address)        (*(const uint32_t *)(address))
+
+#endif /* HOST_AVR_PGMSPACE_H_ */
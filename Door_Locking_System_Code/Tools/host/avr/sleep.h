@@ -0,0 +1,37 @@
+ /******************************************************************************
+ *
+ * Module: Host AVR
+ *
+ * File Name: sleep.h
+ *
+ * Description: Host replacement of <avr/sleep.h>. The sleep mode and enable bits
+ *              are written in MCUCR like avr-libc does, sleep_cpu advances the
+ *              virtual time until an interrupt wakes the MCU.
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#ifndef HOST_AVR_SLEEP_H_
+#define HOST_AVR_SLEEP_H_
+
+#include <avr/io.h>
+
+#define SLEEP_MODE_IDLE                0
+#define SLEEP_MODE_ADC                 (1 << SM0)
+#define SLEEP_MODE_PWR_DOWN            (1 << SM1)
+#define SLEEP_MODE_PWR_SAVE            ((1 << SM0) | (1 << SM1))
+#define SLEEP_MODE_STANDBY             ((1 << SM1) | (1 << SM2))
+#define SLEEP_MODE_EXT_STANDBY         ((1 << SM0) | (1 << SM1) | (1 << SM2))
+
+#define set_sleep_mode(mode) \
+	Host_writeRegister(MCUCR, (Host_readRegister(MCUCR) & ~((1 << SM0) | (1 << SM1) | (1 << SM2))) | (mode))
+#define sleep_enable()                 Host_writeRegister(MCUCR, Host_readRegister(MCUCR) | (1 << SE))
+#define sleep_disable()                Host_writeRegister(MCUCR, Host_readRegister(MCUCR) & ~(1 << SE))
+#define sleep_cpu()                    Host_sleep()
+#define sleep_mode()                   do { sleep_enable(); sleep_cpu(); sleep_disable(); } while(0)
+
+/* Implemented in host.c, returns at once if SE is not set */
+void Host_sleep(void);
+
+#endif /* HOST_AVR_SLEEP_H_ */
@@ -0,0 +1,507 @@
+ /******************************************************************************
+ *
+ * Module: Control Board
+ *
+ * File Name: control_board.c
+ *
+ * Description: Host model of the Control ECU board, linked with the unchanged
+ *              Control sources: timers, UART, TWI with the 24C16 EEPROM, external
+ *              interrupts, ADC, the PIR sensor played from a script and the door.
+ *              The door moves at a speed following the motor duty with some inertia,
+ *              the brake (IN1 = IN2 = 1) stops it faster than a released motor,
+ *              and it closes its end of travel switch (with contact bounce) at
+ *              each end. The motor current is the part of the duty not balanced by
+ *              the speed (back EMF) plus the friction, as the shunt amplifier
+ *              sees it on ADC0, or a recorded curve played from each motor start.
+ *              The motor (IN1/IN2 and the OCR0 duty), the switches and the buzzer
+ *              are printed when they change. The board is set up before main()
+ *              from the environment:
+ *
+ *              HOST_PIR         PIR output levels: 0 or 1, wNNN waits NNN ms,
+ *                               e.g. "w20000 1 w3000 0" (default: no motion)
+ *              HOST_DOOR_TRAVEL_MS  door travel at full duty (default 9000)
+ *              HOST_DOOR_JAM    the door can not open past this position, 0 (closed)
+ *                               to 100 (open): the motor stalls
+ *              HOST_DOOR_OBSTACLE  the door can not close past this position, the
+ *                               obstacle goes when the door opens after it
+ *              HOST_MOTOR_CURRENT  recorded current curve played instead of the
+ *                               model: "ms,mA" lines, the time from the motor start
+ *                               (interpolated, the last value holds)
+ *              HOST_EEPROM      file keeping the EEPROM between the runs
+ *              HOST_UART_IN     file or FIFO read by the receiver
+ *              HOST_UART_OUT    file or FIFO written by the transmitter
+ *              HOST_TIME_SCALE  pace on the real time, 1 = real time (default: as
+ *                               fast as possible)
+ *              HOST_RUN_SECONDS exit after this virtual time
+ *
+ *              Build from Door_Locking_System_Code:
+ *
+ *              gcc -std=gnu99 -funsigned-char -DF_CPU=8000000UL -ITools/host \
+ *                  -IControl_ECU/HAL -IControl_ECU/MCAL -IControl_ECU/LIB -IControl_ECU/Main \
+ *                  $(find Control_ECU -name '*.c') Tools/host/host.c Tools/host/host_timer.c \
+ *                  Tools/host/host_uart.c Tools/host/host_twi.c Tools/host/host_eeprom.c \
+ *                  Tools/host/host_extint.c Tools/host/host_adc.c Tools/host/control_board.c \
+ *                  -o control_host
+ *
+ *              See hmi_board.c to run it with the HMI ECU.
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#define HOST_REGISTER_ADDRESSES
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include "host.h"
+#include "gpio.h"
+#include "PIR.h"
+#include "DC_MOTOR.h"
+#include "BUZZER.h"
+#include "LIMIT_SWITCH.h"
+#include "MOTOR_CURRENT.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define BOARD_MAX_PIR_EVENTS           64
+
+/* Door mechanics: time constants of the speed with the motor driven, braked and released */
+#define BOARD_DOOR_TRAVEL_MS           9000
+#define BOARD_DOOR_DRIVE_TAU_S         0.15
+#define BOARD_DOOR_BRAKE_TAU_S         0.02
+#define BOARD_DOOR_COAST_TAU_S         0.5
+
+/* The switches close in the last 0.2% of the travel and bounce for 1 ms, a change every 100 us */
+#define BOARD_SWITCH_TRAVEL            0.002
+#define BOARD_SWITCH_BOUNCE_NS         1000000ULL
+#define BOARD_SWITCH_BOUNCE_STEP_NS    100000ULL
+
+/* Motor stall current at full duty and friction current, shunt amplifier output of 2 V/A */
+#define BOARD_MOTOR_STALL_MA           2000.0
+#define BOARD_MOTOR_FRICTION_MA        150.0
+#define BOARD_MOTOR_MV_PER_MA          2.0
+#define BOARD_ADC_MAX_MV               5000.0
+#define BOARD_MAX_CURRENT_POINTS       4096
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+typedef struct
+{
+	uint64 time_ns;
+	uint8 level;
+}Board_PirEventType;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static void Board_init(void) __attribute__((constructor));
+static void Board_parsePir(const char *script);
+static void Board_loadCurrent(const char *file_name);
+static float64 Board_replayCurrent(uint64 since_start_ns);
+static void Board_advance(uint64 elapsed_ns);
+static void Board_advanceDoor(uint64 elapsed_ns, uint8 motor_pins, uint8 motor_duty);
+static void Board_driveCurrent(uint8 motor_pins, uint8 motor_duty);
+static void Board_driveSwitches(void);
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+static Board_PirEventType g_pirEvents[BOARD_MAX_PIR_EVENTS];
+static uint8 g_numOfPirEvents = 0;
+static uint8 g_nextPirEvent = 0;
+
+/* Last printed outputs */
+static uint8 g_motorPins = 0;
+static uint8 g_motorDuty = 0;
+static uint8 g_buzzer = 0;
+
+/* Door position (0 closed to 1 open) and speed (travels per second) */
+static float64 g_doorPosition = 0;
+static float64 g_doorSpeed = 0;
+static float64 g_doorMaxSpeed = 1000.0 / BOARD_DOOR_TRAVEL_MS;
+static float64 g_doorJam = 2;                 /* Past the open end: none */
+static float64 g_doorObstacle = -1;           /* Negative: none */
+static boolean g_doorBlocked = FALSE;
+static boolean g_obstacleHit = FALSE;         /* The obstacle goes when the door opens after it */
+
+/* Recorded current curve (ms, mA) and the time of the last motor start */
+static float64 g_currentTimes[BOARD_MAX_CURRENT_POINTS];
+static float64 g_currentValues[BOARD_MAX_CURRENT_POINTS];
+static uint16 g_numOfCurrentPoints = 0;
+static uint64 g_motorStartNs = 0;
+
+/* Switch pins closed by the door (without the bounce), the pins that changed last and when */
+static uint8 g_switchPins = 0;
+static uint8 g_bouncePins = 0;
+static uint64 g_switchChangeNs = 0;
+static uint8 g_drivenSwitchPins = 0xFF;
+
+/*******************************************************************************
+ *                      Private Functions Definitions                          *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Power on the board before main().
+ */
+static void Board_init(void)
+{
+	const char *value;
+	int in_fd = -1;
+	int out_fd = -1;
+
+	setvbuf(stdout, NULL, _IOLBF, 0);
+	Host_init();
+	Host_initTimers();
+	Host_initExtInts();
+	Host_initTwi();
+	Host_initEeprom(getenv("HOST_EEPROM"));
+	Host_initAdc();
+
+	value = getenv("HOST_UART_IN");
+	if(value != NULL)
+	{
+		in_fd = open(value, O_RDONLY | O_NONBLOCK);
+	}
+	value = getenv("HOST_UART_OUT");
+	if(value != NULL)
+	{
+		out_fd = open(value, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	}
+	if(((getenv("HOST_UART_IN") != NULL) && (in_fd < 0)) || ((getenv("HOST_UART_OUT") != NULL) && (out_fd < 0)))
+	{
+		perror("control board: UART");
+		exit(2);
+	}
+	Host_initUart(in_fd, out_fd);
+
+	/* No motion until the script says otherwise */
+	Host_drivePins(PIR_PORT_ID, (1 << PIR_PIN_ID), 0);
+	value = getenv("HOST_PIR");
+	if(value != NULL)
+	{
+		Board_parsePir(value);
+	}
+	value = getenv("HOST_DOOR_TRAVEL_MS");
+	if(value != NULL)
+	{
+		g_doorMaxSpeed = 1000.0 / atof(value);
+	}
+	value = getenv("HOST_DOOR_JAM");
+	if(value != NULL)
+	{
+		g_doorJam = atof(value) / 100.0;
+	}
+	value = getenv("HOST_DOOR_OBSTACLE");
+	if(value != NULL)
+	{
+		g_doorObstacle = atof(value) / 100.0;
+	}
+	value = getenv("HOST_MOTOR_CURRENT");
+	if(value != NULL)
+	{
+		Board_loadCurrent(value);
+	}
+
+	/* The door starts closed on its switch */
+	g_switchPins = (1 << LIMIT_SWITCH_CLOSED_PIN_ID);
+	Board_driveSwitches();
+	Host_addDevice(Board_advance);
+
+	value = getenv("HOST_TIME_SCALE");
+	if(value != NULL)
+	{
+		Host_setTimeScale(atof(value));
+	}
+	value = getenv("HOST_RUN_SECONDS");
+	if(value != NULL)
+	{
+		Host_setRunLimit((uint64)(atof(value) * 1e9));
+	}
+}
+
+/*
+ * Description :
+ * Build the PIR level changes of the script.
+ */
+static void Board_parsePir(const char *script)
+{
+	uint64 time_ns = 0;
+
+	while(*script != '\0')
+	{
+		if(*script == 'w')
+		{
+			time_ns += HOST_MS_TO_NS(strtoul(script + 1, (char **)&script, 10));
+			continue;
+		}
+		if((*script == '0') || (*script == '1'))
+		{
+			if(g_numOfPirEvents >= BOARD_MAX_PIR_EVENTS)
+			{
+				fprintf(stderr, "control board: too many levels in HOST_PIR\n");
+				exit(2);
+			}
+			g_pirEvents[g_numOfPirEvents++] = (Board_PirEventType){ time_ns, (uint8)(*script - '0') };
+		}
+		else if((*script != ' ') && (*script != ','))
+		{
+			fprintf(stderr, "control board: unknown level '%c' in HOST_PIR\n", *script);
+			exit(2);
+		}
+		script++;
+	}
+}
+
+/*
+ * Description :
+ * Play the PIR levels that are due and print the outputs that changed.
+ */
+static void Board_advance(uint64 elapsed_ns)
+{
+	const Board_PirEventType *event;
+	uint8 motor_pins = Host_getPins(DC_MOTOR_PORT_ID) & ((1 << IN1_PIN_ID) | (1 << IN2_PIN_ID));
+	uint8 motor_duty = Host_getRegister(OCR0);
+	uint8 buzzer = (Host_getPins(BUZZER_PORT_ID) >> BUZZER_PIN_ID) & 1;
+
+	while((g_nextPirEvent < g_numOfPirEvents) && (g_pirEvents[g_nextPirEvent].time_ns <= Host_now()))
+	{
+		event = &g_pirEvents[g_nextPirEvent++];
+		Host_logTime();
+		printf("pir %s\n", (event->level == 1) ? "motion" : "no motion");
+		Host_drivePins(PIR_PORT_ID, (1 << PIR_PIN_ID), (uint8)(event->level << PIR_PIN_ID));
+	}
+
+	Board_advanceDoor(elapsed_ns, motor_pins, motor_duty);
+	Board_driveSwitches();
+	Board_driveCurrent(motor_pins, motor_duty);
+
+	if((motor_pins != g_motorPins) || ((motor_pins != 0) && (motor_duty != g_motorDuty)))
+	{
+		g_motorPins = motor_pins;
+		g_motorDuty = motor_duty;
+		Host_logTime();
+		printf("motor IN1=%u IN2=%u duty %u%%\n", (motor_pins >> IN1_PIN_ID) & 1, (motor_pins >> IN2_PIN_ID) & 1,
+				(unsigned)((motor_duty * 100U + 127) / 255));
+	}
+	if(buzzer != g_buzzer)
+	{
+		g_buzzer = buzzer;
+		Host_logTime();
+		printf("buzzer %s\n", (buzzer == 1) ? "on" : "off");
+	}
+}
+
+/*
+ * Description :
+ * Move the door: its speed goes to the one of the motor duty (IN2 opens, IN1 closes)
+ * or to 0 when braked or released, the ends and the jam stop it.
+ */
+static void Board_advanceDoor(uint64 elapsed_ns, uint8 motor_pins, uint8 motor_duty)
+{
+	float64 dt = elapsed_ns / 1e9;
+	float64 target = 0;
+	float64 tau = BOARD_DOOR_COAST_TAU_S;
+	uint8 switch_pins = 0;
+	boolean blocked;
+	float64 previous;
+
+	if(motor_pins == (1 << IN2_PIN_ID))
+	{
+		target = g_doorMaxSpeed * motor_duty / 255.0;
+		tau = BOARD_DOOR_DRIVE_TAU_S;
+	}
+	else if(motor_pins == (1 << IN1_PIN_ID))
+	{
+		target = -g_doorMaxSpeed * motor_duty / 255.0;
+		tau = BOARD_DOOR_DRIVE_TAU_S;
+	}
+	else if(motor_pins != 0)
+	{
+		tau = BOARD_DOOR_BRAKE_TAU_S;
+	}
+	g_doorSpeed += (target - g_doorSpeed) * ((dt < tau) ? (dt / tau) : 1);
+	previous = g_doorPosition;
+	g_doorPosition += g_doorSpeed * dt;
+
+	/* The jam and the obstacle stop the door moving into them */
+	blocked = FALSE;
+	if((previous <= g_doorJam) && (g_doorPosition >= g_doorJam))
+	{
+		g_doorPosition = g_doorJam;
+		g_doorSpeed = (g_doorSpeed > 0) ? 0 : g_doorSpeed;
+		blocked = TRUE;
+	}
+	if((previous >= g_doorObstacle) && (g_doorPosition <= g_doorObstacle))
+	{
+		g_doorPosition = g_doorObstacle;
+		g_doorSpeed = (g_doorSpeed < 0) ? 0 : g_doorSpeed;
+		blocked = TRUE;
+		g_obstacleHit = TRUE;
+	}
+	if(blocked != g_doorBlocked)
+	{
+		g_doorBlocked = blocked;
+		if(blocked == TRUE)
+		{
+			Host_logTime();
+			printf("door blocked at %.0f%%\n", 100 * g_doorPosition);
+		}
+	}
+	if(g_doorPosition >= 1)
+	{
+		g_doorPosition = 1;
+		g_doorSpeed = (g_doorSpeed > 0) ? 0 : g_doorSpeed;
+	}
+	else if(g_doorPosition <= 0)
+	{
+		g_doorPosition = 0;
+		g_doorSpeed = (g_doorSpeed < 0) ? 0 : g_doorSpeed;
+	}
+
+	if(g_doorPosition >= (1 - BOARD_SWITCH_TRAVEL))
+	{
+		switch_pins = (1 << LIMIT_SWITCH_OPEN_PIN_ID);
+	}
+	else if(g_doorPosition <= BOARD_SWITCH_TRAVEL)
+	{
+		switch_pins = (1 << LIMIT_SWITCH_CLOSED_PIN_ID);
+	}
+	if(switch_pins != g_switchPins)
+	{
+		Host_logTime();
+		if((switch_pins & (1 << LIMIT_SWITCH_OPEN_PIN_ID)) && (g_obstacleHit == TRUE))
+		{
+			g_doorObstacle = -1;
+			g_obstacleHit = FALSE;
+			printf("obstacle removed, ");
+		}
+		if(switch_pins != 0)
+		{
+			printf("door %s, speed %.1f%%\n", (switch_pins & (1 << LIMIT_SWITCH_OPEN_PIN_ID)) ? "open" : "closed",
+					100 * g_doorSpeed / g_doorMaxSpeed);
+		}
+		else
+		{
+			printf("door leaves the %s switch\n", (g_switchPins & (1 << LIMIT_SWITCH_OPEN_PIN_ID)) ? "open" : "closed");
+		}
+		g_bouncePins = switch_pins ^ g_switchPins;
+		g_switchPins = switch_pins;
+		g_switchChangeNs = Host_now();
+	}
+}
+
+/*
+ * Description :
+ * Pull the pins of the closed switches low, the open ones are released to their pull-up.
+ * After a change the changed switches bounce between both levels.
+ */
+static void Board_driveSwitches(void)
+{
+	uint64 since_change = Host_now() - g_switchChangeNs;
+	uint8 pins = g_switchPins;
+
+	if((since_change < BOARD_SWITCH_BOUNCE_NS) && (((since_change / BOARD_SWITCH_BOUNCE_STEP_NS) & 1) != 0))
+	{
+		pins ^= g_bouncePins;
+	}
+	if(pins != g_drivenSwitchPins)
+	{
+		g_drivenSwitchPins = pins;
+		Host_drivePins(LIMIT_SWITCH_PORT_ID, pins, 0);
+	}
+}
+
+/*
+ * Description :
+ * Shunt amplifier output: the recorded curve from the motor start, or the model. A low side
+ * shunt sees the current of a driven motor only, not the brake current.
+ */
+static void Board_driveCurrent(uint8 motor_pins, uint8 motor_duty)
+{
+	static uint8 last_pins = 0;
+	float64 current = 0;
+	float64 drive;
+	float64 speed = g_doorSpeed / g_doorMaxSpeed;
+
+	if(((motor_pins == (1 << IN1_PIN_ID)) || (motor_pins == (1 << IN2_PIN_ID))) && (motor_pins != last_pins))
+	{
+		g_motorStartNs = Host_now();
+	}
+	last_pins = motor_pins;
+
+	if((motor_pins == (1 << IN1_PIN_ID)) || (motor_pins == (1 << IN2_PIN_ID)))
+	{
+		if(g_numOfCurrentPoints != 0)
+		{
+			current = Board_replayCurrent(Host_now() - g_motorStartNs);
+		}
+		else
+		{
+			drive = motor_duty / 255.0;
+			speed = (motor_pins == (1 << IN1_PIN_ID)) ? -speed : speed;
+			current = BOARD_MOTOR_STALL_MA * (drive - speed) + BOARD_MOTOR_FRICTION_MA * drive;
+		}
+	}
+	current = (current < 0) ? 0 : current * BOARD_MOTOR_MV_PER_MA;
+	Host_setAnalogInput(MOTOR_CURRENT_ADC_CHANNEL, (uint16)((current > BOARD_ADC_MAX_MV) ? BOARD_ADC_MAX_MV : current));
+}
+
+/*
+ * Description :
+ * Read a recorded current curve, "ms,mA" lines in time order (other lines are skipped).
+ */
+static void Board_loadCurrent(const char *file_name)
+{
+	FILE *file = fopen(file_name, "r");
+	char line[128];
+
+	if(file == NULL)
+	{
+		perror("control board: HOST_MOTOR_CURRENT");
+		exit(2);
+	}
+	while((fgets(line, sizeof(line), file) != NULL) && (g_numOfCurrentPoints < BOARD_MAX_CURRENT_POINTS))
+	{
+		if(sscanf(line, "%lf,%lf", &g_currentTimes[g_numOfCurrentPoints], &g_currentValues[g_numOfCurrentPoints]) == 2)
+		{
+			g_numOfCurrentPoints++;
+		}
+	}
+	fclose(file);
+	if(g_numOfCurrentPoints == 0)
+	{
+		fprintf(stderr, "control board: no current point in %s\n", file_name);
+		exit(2);
+	}
+}
+
+/*
+ * Description :
+ * Current of the recorded curve, interpolated between its points.
+ */
+static float64 Board_replayCurrent(uint64 since_start_ns)
+{
+	float64 ms = since_start_ns / 1e6;
+	uint16 i;
+
+	if(ms <= g_currentTimes[0])
+	{
+		return g_currentValues[0];
+	}
+	for(i = 1; i < g_numOfCurrentPoints; i++)
+	{
+		if(ms < g_currentTimes[i])
+		{
+			return g_currentValues[i - 1] + ((g_currentValues[i] - g_currentValues[i - 1]) *
+					(ms - g_currentTimes[i - 1]) / (g_currentTimes[i] - g_currentTimes[i - 1]));
+		}
+	}
+	return g_currentValues[g_numOfCurrentPoints - 1];
+}
@@ -0,0 +1,320 @@
+ /******************************************************************************
+ *
+ * Module: HMI Board
+ *
+ * File Name: hmi_board.c
+ *
+ * Description: Host model of the HMI ECU board, linked with the unchanged HMI
+ *              sources: timers, UART, external interrupts, the LCD (its text is
+ *              printed when it changes) and the 4x4 keypad played from a script.
+ *              The board is set up before main() from the environment:
+ *
+ *              HOST_KEYS        keys to press: key labels 0..9 % * - = + and E
+ *                               (Enter), wNNN waits NNN ms, e.g. "w2000 12345="
+ *              HOST_UART_IN     file or FIFO read by the receiver
+ *              HOST_UART_OUT    file or FIFO written by the transmitter
+ *              HOST_TIME_SCALE  pace on the real time, 1 = real time (default: as
+ *                               fast as possible)
+ *              HOST_RUN_SECONDS exit after this virtual time
+ *
+ *              Build from Door_Locking_System_Code:
+ *
+ *              gcc -std=gnu99 -funsigned-char -DF_CPU=8000000UL \
+ *                  -ITools/host -ITools/lcd_emulator \
+ *                  -IHMI_ECU/HAL -IHMI_ECU/MCAL -IHMI_ECU/LIB -IHMI_ECU/Main \
+ *                  $(find HMI_ECU -name '*.c') Tools/host/host.c Tools/host/host_timer.c \
+ *                  Tools/host/host_uart.c Tools/host/host_extint.c \
+ *                  Tools/lcd_emulator/host_lcd.c Tools/lcd_emulator/hd44780.c \
+ *                  Tools/host/hmi_board.c -o hmi_host
+ *
+ *              Both ECUs talk through two FIFOs:
+ *
+ *              mkfifo /tmp/hmi_rx /tmp/control_rx
+ *              HOST_UART_IN=/tmp/control_rx HOST_UART_OUT=/tmp/hmi_rx HOST_TIME_SCALE=1 ./control_host &
+ *              HOST_UART_IN=/tmp/hmi_rx HOST_UART_OUT=/tmp/control_rx HOST_TIME_SCALE=1 \
+ *                  HOST_KEYS="w2000 12345= w1000 12345=" ./hmi_host
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#define HOST_REGISTER_ADDRESSES
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include "host.h"
+#include "host_lcd.h"
+#include "gpio.h"
+#include "lcd.h"
+#include "keypad.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define BOARD_MAX_KEY_EVENTS           128
+
+/* A scripted key is held down then released for these times */
+#define BOARD_KEY_PRESS_MS             100
+#define BOARD_KEY_RELEASE_MS           150
+
+/* The LCD text is compared at this period */
+#define BOARD_LCD_CHECK_NS             HOST_MS_TO_NS(10)
+
+/* Pin of the keypad diode-OR, INT0 */
+#define BOARD_WAKE_PORT_ID             PORTD_ID
+#define BOARD_WAKE_PIN_ID              PIN2_ID
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+typedef struct
+{
+	uint64 time_ns;
+	uint8 row;
+	uint8 col;
+	boolean pressed;
+}Board_KeyEventType;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static void Board_init(void) __attribute__((constructor));
+static void Board_parseKeys(const char *script);
+static boolean Board_findKey(char label, uint8 *row, uint8 *col);
+static void Board_advance(uint64 elapsed_ns);
+static uint8 Board_driveKeypad(uint8 port_num, uint8 levels);
+static void Board_printLcd(void);
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+/* Key labels as wired, the values returned by the keypad driver are in keypad.c */
+static const char g_keyLabels[KEYPAD_NUM_ROWS][KEYPAD_NUM_COLS] =
+{
+	{ '7', '8', '9', '%' },
+	{ '4', '5', '6', '*' },
+	{ '1', '2', '3', '-' },
+	{ 'E', '0', '=', '+' }
+};
+
+static Board_KeyEventType g_keyEvents[BOARD_MAX_KEY_EVENTS];
+static uint8 g_numOfKeyEvents = 0;
+static uint8 g_nextKeyEvent = 0;
+
+/* Key held down now */
+static boolean g_keyDown = FALSE;
+static uint8 g_keyRow = 0;
+static uint8 g_keyCol = 0;
+
+static char g_lcdText[LCD_ROWS][LCD_COLS + 1];
+static uint64 g_lcdCheckNs = 0;
+
+/*******************************************************************************
+ *                      Private Functions Definitions                          *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Power on the board before main().
+ */
+static void Board_init(void)
+{
+	const char *value;
+	int in_fd = -1;
+	int out_fd = -1;
+
+	setvbuf(stdout, NULL, _IOLBF, 0);
+	Host_init();
+	Host_initTimers();
+	Host_initExtInts();
+	Host_initLcd();
+
+	value = getenv("HOST_UART_IN");
+	if(value != NULL)
+	{
+		in_fd = open(value, O_RDONLY | O_NONBLOCK);
+	}
+	value = getenv("HOST_UART_OUT");
+	if(value != NULL)
+	{
+		out_fd = open(value, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	}
+	if(((getenv("HOST_UART_IN") != NULL) && (in_fd < 0)) || ((getenv("HOST_UART_OUT") != NULL) && (out_fd < 0)))
+	{
+		perror("hmi board: UART");
+		exit(2);
+	}
+	Host_initUart(in_fd, out_fd);
+
+	value = getenv("HOST_KEYS");
+	if(value != NULL)
+	{
+		Board_parseKeys(value);
+	}
+	Host_addPortSource(Board_driveKeypad);
+	Host_addDevice(Board_advance);
+
+	value = getenv("HOST_TIME_SCALE");
+	if(value != NULL)
+	{
+		Host_setTimeScale(atof(value));
+	}
+	value = getenv("HOST_RUN_SECONDS");
+	if(value != NULL)
+	{
+		Host_setRunLimit((uint64)(atof(value) * 1e9));
+	}
+
+	memset(g_lcdText, 0, sizeof(g_lcdText));
+	g_lcdCheckNs = 0;
+}
+
+/*
+ * Description :
+ * Build the key events of the script.
+ */
+static void Board_parseKeys(const char *script)
+{
+	uint64 time_ns = 0;
+	uint8 row;
+	uint8 col;
+
+	while(*script != '\0')
+	{
+		if(*script == 'w')
+		{
+			time_ns += HOST_MS_TO_NS(strtoul(script + 1, (char **)&script, 10));
+			continue;
+		}
+		if(Board_findKey(*script, &row, &col) == TRUE)
+		{
+			if(g_numOfKeyEvents + 2 > BOARD_MAX_KEY_EVENTS)
+			{
+				fprintf(stderr, "hmi board: too many keys in HOST_KEYS\n");
+				exit(2);
+			}
+			g_keyEvents[g_numOfKeyEvents++] = (Board_KeyEventType){ time_ns, row, col, TRUE };
+			time_ns += HOST_MS_TO_NS(BOARD_KEY_PRESS_MS);
+			g_keyEvents[g_numOfKeyEvents++] = (Board_KeyEventType){ time_ns, row, col, FALSE };
+			time_ns += HOST_MS_TO_NS(BOARD_KEY_RELEASE_MS);
+		}
+		else if((*script != ' ') && (*script != ','))
+		{
+			fprintf(stderr, "hmi board: unknown key '%c' in HOST_KEYS\n", *script);
+			exit(2);
+		}
+		script++;
+	}
+}
+
+static boolean Board_findKey(char label, uint8 *row, uint8 *col)
+{
+	for(*row = 0; *row < KEYPAD_NUM_ROWS; (*row)++)
+	{
+		for(*col = 0; *col < KEYPAD_NUM_COLS; (*col)++)
+		{
+			if(g_keyLabels[*row][*col] == label)
+			{
+				return TRUE;
+			}
+		}
+	}
+	return FALSE;
+}
+
+/*
+ * Description :
+ * Play the key events that are due and print the LCD when its text changed.
+ */
+static void Board_advance(uint64 elapsed_ns)
+{
+	const Board_KeyEventType *event;
+
+	(void)elapsed_ns;
+	while((g_nextKeyEvent < g_numOfKeyEvents) && (g_keyEvents[g_nextKeyEvent].time_ns <= Host_now()))
+	{
+		event = &g_keyEvents[g_nextKeyEvent++];
+		g_keyDown = event->pressed;
+		g_keyRow = event->row;
+		g_keyCol = event->col;
+		Host_logTime();
+		printf("key %c %s\n", g_keyLabels[event->row][event->col], (event->pressed == TRUE) ? "down" : "up");
+		Host_notifyPorts();
+	}
+
+	if(Host_now() >= g_lcdCheckNs)
+	{
+		g_lcdCheckNs = Host_now() + BOARD_LCD_CHECK_NS;
+		Board_printLcd();
+	}
+}
+
+/*
+ * Description :
+ * Port source of the keypad: the columns have external pull-ups, a pressed key
+ * joins its row and column so the column reads low when the row is driven low.
+ * The low columns pull the wake pin low through the diode-OR.
+ */
+static uint8 Board_driveKeypad(uint8 port_num, uint8 levels)
+{
+	uint8 row_pin = KEYPAD_FIRST_ROW_PIN_ID + g_keyRow;
+	uint8 row_port = Host_getRegister(GPIO_PORT_REG(KEYPAD_ROW_PORT_ID));
+	uint8 row_ddr = Host_getRegister(GPIO_DDR_REG(KEYPAD_ROW_PORT_ID));
+
+	if(port_num == KEYPAD_COL_PORT_ID)
+	{
+		levels |= (uint8)(((1 << KEYPAD_NUM_COLS) - 1) << KEYPAD_FIRST_COL_PIN_ID);
+	}
+	if((g_keyDown == FALSE) || !(row_ddr & (1 << row_pin)) || (row_port & (1 << row_pin)))
+	{
+		return levels;
+	}
+
+	if(port_num == KEYPAD_COL_PORT_ID)
+	{
+		levels &= ~(1 << (KEYPAD_FIRST_COL_PIN_ID + g_keyCol));
+	}
+	if(port_num == BOARD_WAKE_PORT_ID)
+	{
+		levels &= ~(1 << BOARD_WAKE_PIN_ID);
+	}
+	return levels;
+}
+
+/*
+ * Description :
+ * Print the LCD text if it changed since the last check.
+ */
+static void Board_printLcd(void)
+{
+	char text[LCD_ROWS][LCD_COLS + 1];
+	uint8 code;
+	uint8 row;
+	uint8 col;
+
+	for(row = 0; row < LCD_ROWS; row++)
+	{
+		for(col = 0; col < LCD_COLS; col++)
+		{
+			code = HD44780_getCell(&Host_lcd, LCD_ROWS, LCD_COLS, row, col);
+			text[row][col] = ((code >= ' ') && (code < 0x7F)) ? (char)code : '#';
+		}
+		text[row][LCD_COLS] = '\0';
+	}
+
+	if(memcmp(text, g_lcdText, sizeof(text)) != 0)
+	{
+		memcpy(g_lcdText, text, sizeof(text));
+		Host_logTime();
+		printf("lcd |%s|\n", text[0]);
+		for(row = 1; row < LCD_ROWS; row++)
+		{
+			printf("                 |%s|\n", text[row]);
+		}
+	}
+}
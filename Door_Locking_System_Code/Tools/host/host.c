@@ -0,0 +1,580 @@
+ /******************************************************************************
+ *
+ * Module: Host
+ *
+ * File Name: host.c
+ *
+ * Description: Register file, virtual time and interrupts of the host builds.
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#define HOST_REGISTER_ADDRESSES
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "host.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define HOST_NUM_OF_VECTORS            21
+
+/* The real time is checked once per virtual millisecond when the time is paced */
+#define HOST_PACE_PERIOD_NS            1000000ULL
+
+#define HOST_SREG_I                    (1 << SREG_I)
+#define HOST_SLEEP_MODE_MASK           ((1 << SM2) | (1 << SM1) | (1 << SM0))
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+/* Interrupt source of a vector, the ISR runs while both bits are set */
+typedef struct
+{
+	uint8 flag_address;
+	uint8 flag_bit;
+	uint8 enable_address;
+	uint8 enable_bit;
+	boolean clear_on_entry;            /* The flag is cleared by the hardware when the ISR starts */
+}Host_VectorType;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static void Host_dispatch(void);
+static void Host_pace(void);
+static uint8 Host_readPin(uint8 address, uint8 value);
+static void Host_writePort(uint8 address, uint8 old_value, uint8 value);
+
+/* The ISRs defined by the firmware, the others are NULL */
+#define HOST_DECLARE_VECTOR(n)         extern void __vector_##n(void) __attribute__((weak));
+HOST_DECLARE_VECTOR(1)  HOST_DECLARE_VECTOR(2)  HOST_DECLARE_VECTOR(3)  HOST_DECLARE_VECTOR(4)
+HOST_DECLARE_VECTOR(5)  HOST_DECLARE_VECTOR(6)  HOST_DECLARE_VECTOR(7)  HOST_DECLARE_VECTOR(8)
+HOST_DECLARE_VECTOR(9)  HOST_DECLARE_VECTOR(10) HOST_DECLARE_VECTOR(11) HOST_DECLARE_VECTOR(12)
+HOST_DECLARE_VECTOR(13) HOST_DECLARE_VECTOR(14) HOST_DECLARE_VECTOR(15) HOST_DECLARE_VECTOR(16)
+HOST_DECLARE_VECTOR(17) HOST_DECLARE_VECTOR(18) HOST_DECLARE_VECTOR(19) HOST_DECLARE_VECTOR(20)
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+volatile uint8_t SREG;
+
+/* In priority order, the lowest vector number first */
+static const Host_VectorType g_vectors[HOST_NUM_OF_VECTORS] =
+{
+	[1]  = { GIFR,   INTF0, GICR,   INT0,   TRUE  },
+	[2]  = { GIFR,   INTF1, GICR,   INT1,   TRUE  },
+	[3]  = { GIFR,   INTF2, GICR,   INT2,   TRUE  },
+	[4]  = { TIFR,   OCF2,  TIMSK,  OCIE2,  TRUE  },
+	[5]  = { TIFR,   TOV2,  TIMSK,  TOIE2,  TRUE  },
+	[6]  = { TIFR,   ICF1,  TIMSK,  TICIE1, TRUE  },
+	[7]  = { TIFR,   OCF1A, TIMSK,  OCIE1A, TRUE  },
+	[8]  = { TIFR,   OCF1B, TIMSK,  OCIE1B, TRUE  },
+	[9]  = { TIFR,   TOV1,  TIMSK,  TOIE1,  TRUE  },
+	[10] = { TIFR,   OCF0,  TIMSK,  OCIE0,  TRUE  },
+	[11] = { TIFR,   TOV0,  TIMSK,  TOIE0,  TRUE  },
+	[12] = { SPSR,   SPIF,  SPCR,   SPIE,   TRUE  },
+	[13] = { UCSRA,  RXC,   UCSRB,  RXCIE,  FALSE }, /* Cleared by reading UDR */
+	[14] = { UCSRA,  UDRE,  UCSRB,  UDRIE,  FALSE }, /* Cleared by writing UDR */
+	[15] = { UCSRA,  TXC,   UCSRB,  TXCIE,  TRUE  },
+	[16] = { ADCSRA, ADIF,  ADCSRA, ADIE,   TRUE  },
+	[18] = { ACSR,   ACI,   ACSR,   ACIE,   TRUE  },
+	[19] = { TWCR,   TWINT, TWCR,   TWIE,   FALSE }, /* Cleared by writing TWINT to one */
+	/* 17 (EEPROM ready) and 20 (SPM ready) are not modeled, their flag address stays 0 */
+};
+
+static void (* const g_isrs[HOST_NUM_OF_VECTORS])(void) =
+{
+	NULL, __vector_1, __vector_2, __vector_3, __vector_4, __vector_5, __vector_6, __vector_7,
+	__vector_8, __vector_9, __vector_10, __vector_11, __vector_12, __vector_13, __vector_14,
+	__vector_15, __vector_16, __vector_17, __vector_18, __vector_19, __vector_20
+};
+
+/* PIN, DDR and PORT addresses of each port, same order as the GPIO port ids */
+static const uint8 g_pinAddresses[HOST_NUM_OF_PORTS] = { PINA, PINB, PINC, PIND };
+
+static uint8 g_registers[HOST_NUM_OF_REGISTERS];
+static Host_ReadHookType g_readHooks[HOST_NUM_OF_REGISTERS];
+static Host_WriteHookType g_writeHooks[HOST_NUM_OF_REGISTERS];
+
+static Host_DeviceType g_devices[HOST_MAX_DEVICES];
+static uint8 g_numOfDevices = 0;
+
+/* Pins driven from outside the MCU */
+static uint8 g_drivenMasks[HOST_NUM_OF_PORTS];
+static uint8 g_drivenLevels[HOST_NUM_OF_PORTS];
+static Host_PortSourceType g_portSources[HOST_MAX_PORT_SOURCES];
+static uint8 g_numOfPortSources = 0;
+static Host_PortListenerType g_portListeners[HOST_MAX_PORT_LISTENERS];
+static uint8 g_numOfPortListeners = 0;
+
+static uint64 g_timeNs = 0;
+static boolean g_sleeping = FALSE;
+static uint64 g_runLimitNs = 0;
+
+/* Real time pacing */
+static float64 g_timeScale = 0;
+static struct timespec g_paceStart;      /* Real time of g_paceStartNs */
+static uint64 g_paceStartNs = 0;
+static uint64 g_nextPaceNs = 0;
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Power on reset: virtual time 0, registers at their reset value, no hooks and no models.
+ * The models are then attached with their Host_initXxx function.
+ */
+void Host_init(void)
+{
+	uint8 i;
+
+	for(i = 0; i < HOST_NUM_OF_REGISTERS; i++)
+	{
+		g_registers[i] = 0;
+		g_readHooks[i] = NULL;
+		g_writeHooks[i] = NULL;
+	}
+	for(i = 0; i < HOST_NUM_OF_PORTS; i++)
+	{
+		g_drivenMasks[i] = 0;
+		g_drivenLevels[i] = 0;
+		/* The PIN reads return the pin levels, the PORT/DDR writes notify the listeners */
+		Host_setReadHook(g_pinAddresses[i], Host_readPin);
+		Host_setWriteHook(g_pinAddresses[i] + 1, Host_writePort);
+		Host_setWriteHook(g_pinAddresses[i] + 2, Host_writePort);
+	}
+	g_numOfDevices = 0;
+	g_numOfPortSources = 0;
+	g_numOfPortListeners = 0;
+	g_timeNs = 0;
+	g_sleeping = FALSE;
+	g_runLimitNs = 0;
+	g_timeScale = 0;
+	SREG = 0;
+}
+
+/*
+ * Description :
+ * Return the virtual time in nanoseconds.
+ */
+uint64 Host_now(void)
+{
+	return g_timeNs;
+}
+
+/*
+ * Description :
+ * Advance the virtual time, the models follow and the pending interrupts are served.
+ */
+void Host_advanceNs(uint64 ns)
+{
+	uint64 step;
+	uint8 i;
+
+	do
+	{
+		step = (ns > HOST_STEP_NS) ? HOST_STEP_NS : ns;
+		ns -= step;
+		g_timeNs += step;
+		for(i = 0; i < g_numOfDevices; i++)
+		{
+			g_devices[i](step);
+		}
+
+		if((g_runLimitNs != 0) && (g_timeNs >= g_runLimitNs))
+		{
+			exit(0);
+		}
+		if((g_timeScale > 0) && (g_timeNs >= g_nextPaceNs))
+		{
+			Host_pace();
+		}
+
+		Host_dispatch();
+	} while(ns > 0);
+}
+
+/*
+ * Description :
+ * Pace the virtual time on the real time, scale times faster (0 runs as fast as possible).
+ * Needed when the ECU talks to another process, e.g. the other ECU over the UART.
+ */
+void Host_setTimeScale(float64 scale)
+{
+	g_timeScale = scale;
+	clock_gettime(CLOCK_MONOTONIC, &g_paceStart);
+	g_paceStartNs = g_timeNs;
+	g_nextPaceNs = g_timeNs;
+}
+
+/*
+ * Description :
+ * Exit the program with status 0 when the virtual time reaches limit_ns (0 for no limit).
+ * The atexit functions of the models print their reports.
+ */
+void Host_setRunLimit(uint64 limit_ns)
+{
+	g_runLimitNs = limit_ns;
+}
+
+/*
+ * Description :
+ * Register value without time cost, hooks or interrupts, for the models.
+ */
+uint8 Host_getRegister(uint8 address)
+{
+	return g_registers[address];
+}
+
+void Host_setRegister(uint8 address, uint8 value)
+{
+	g_registers[address] = value;
+}
+
+/*
+ * Description :
+ * Attach the model of a register, one read and one write hook per register.
+ */
+void Host_setReadHook(uint8 address, Host_ReadHookType hook)
+{
+	if((g_readHooks[address] != NULL) && (hook != NULL))
+	{
+		fprintf(stderr, "host: register 0x%02X already has a read model\n", address);
+		exit(2);
+	}
+	g_readHooks[address] = hook;
+}
+
+void Host_setWriteHook(uint8 address, Host_WriteHookType hook)
+{
+	if((g_writeHooks[address] != NULL) && (hook != NULL))
+	{
+		fprintf(stderr, "host: register 0x%02X already has a write model\n", address);
+		exit(2);
+	}
+	g_writeHooks[address] = hook;
+}
+
+/*
+ * Description :
+ * Attach a model function called on each time advance.
+ */
+void Host_addDevice(Host_DeviceType device)
+{
+	if(g_numOfDevices >= HOST_MAX_DEVICES)
+	{
+		fprintf(stderr, "host: too many models\n");
+		exit(2);
+	}
+	g_devices[g_numOfDevices++] = device;
+}
+
+/*
+ * Description :
+ * TRUE while the MCU sleeps in a mode that stops the I/O clock (power-down, power-save, standby).
+ */
+boolean Host_isClockStopped(void)
+{
+	uint8 mode = g_registers[MCUCR] & HOST_SLEEP_MODE_MASK;
+
+	return ((g_sleeping == TRUE) && (mode != 0) && (mode != (1 << SM0))) ? TRUE : FALSE;
+}
+
+/*
+ * Description :
+ * Drive the input pins of mask to levels, the other pins of the port are released.
+ */
+void Host_drivePins(uint8 port_num, uint8 mask, uint8 levels)
+{
+	if((g_drivenMasks[port_num] != mask) || (g_drivenLevels[port_num] != (levels & mask)))
+	{
+		g_drivenMasks[port_num] = mask;
+		g_drivenLevels[port_num] = levels & mask;
+		Host_notifyPorts();
+	}
+}
+
+/*
+ * Description :
+ * Attach a model that drives pins depending on the other pins (e.g. a keypad matrix).
+ */
+void Host_addPortSource(Host_PortSourceType source)
+{
+	if(g_numOfPortSources >= HOST_MAX_PORT_SOURCES)
+	{
+		fprintf(stderr, "host: too many port sources\n");
+		exit(2);
+	}
+	g_portSources[g_numOfPortSources++] = source;
+}
+
+/*
+ * Description :
+ * Attach a model notified when the pin levels may have changed.
+ */
+void Host_addPortListener(Host_PortListenerType listener)
+{
+	if(g_numOfPortListeners >= HOST_MAX_PORT_LISTENERS)
+	{
+		fprintf(stderr, "host: too many port listeners\n");
+		exit(2);
+	}
+	g_portListeners[g_numOfPortListeners++] = listener;
+}
+
+/*
+ * Description :
+ * Tell the listeners that a source changed its pins.
+ */
+void Host_notifyPorts(void)
+{
+	uint8 i;
+
+	for(i = 0; i < g_numOfPortListeners; i++)
+	{
+		g_portListeners[i]();
+	}
+}
+
+/*
+ * Description :
+ * Return the levels of the port pins, as a PIN read returns them.
+ */
+uint8 Host_getPins(uint8 port_num)
+{
+	uint8 port = g_registers[g_pinAddresses[port_num] + 2];
+	uint8 direction = g_registers[g_pinAddresses[port_num] + 1];
+	uint8 levels;
+	uint8 i;
+
+	/* Released input pins read their pull-up, a floating pin reads low */
+	levels = (port & ~g_drivenMasks[port_num]) | g_drivenLevels[port_num];
+	for(i = 0; i < g_numOfPortSources; i++)
+	{
+		levels = g_portSources[i](port_num, levels);
+	}
+
+	/* Output pins read back their own level */
+	return (levels & ~direction) | (port & direction);
+}
+
+/*
+ * Description :
+ * Print the virtual time at the start of a log line.
+ */
+void Host_logTime(void)
+{
+	printf("[%10.6f] ", HOST_NS_TO_SECONDS(g_timeNs));
+}
+
+/*
+ * Description :
+ * Register accesses of the registers.h macros, each one takes HOST_REGISTER_ACCESS_NS.
+ * The pending interrupts are served before the access.
+ */
+uint8_t Host_readRegister(Host_RegisterType reg)
+{
+	uint8 value;
+
+	Host_advanceNs(HOST_REGISTER_ACCESS_NS);
+	value = g_registers[reg.address];
+	if(g_readHooks[reg.address] != NULL)
+	{
+		value = g_readHooks[reg.address](reg.address, value);
+	}
+	return value;
+}
+
+void Host_writeRegister(Host_RegisterType reg, uint8_t value)
+{
+	uint8 old_value;
+
+	Host_advanceNs(HOST_REGISTER_ACCESS_NS);
+	old_value = g_registers[reg.address];
+	g_registers[reg.address] = value;
+	if(g_writeHooks[reg.address] != NULL)
+	{
+		g_writeHooks[reg.address](reg.address, old_value, value);
+	}
+}
+
+/*
+ * Description :
+ * 16-bit registers, low byte first on read and high byte first on write as the
+ * compiler does for the TEMP register.
+ */
+uint16_t Host_readRegister16(Host_RegisterType reg)
+{
+	uint8 low = Host_readRegister(reg);
+
+	return (uint16)((g_registers[reg.address + 1] << 8) | low);
+}
+
+void Host_writeRegister16(Host_RegisterType reg, uint16_t value)
+{
+	g_registers[reg.address + 1] = (uint8)(value >> 8);
+	Host_writeRegister(reg, (uint8)value);
+}
+
+/*
+ * Description :
+ * Sleep instruction: advance the time until an interrupt is served, at once if one is pending.
+ * Nothing happens if the sleep enable bit is not set.
+ */
+void Host_sleep(void)
+{
+	uint64 wake_time;
+
+	if(!(g_registers[MCUCR] & (1 << SE)))
+	{
+		return;
+	}
+
+	g_sleeping = TRUE;
+	wake_time = g_timeNs;
+	while(g_sleeping == TRUE)
+	{
+		if(!(SREG & HOST_SREG_I) && (g_timeNs - wake_time > HOST_MS_TO_NS(60000)))
+		{
+			fprintf(stderr, "host: sleeping with the interrupts disabled\n");
+			exit(2);
+		}
+		/* Host_dispatch clears g_sleeping before the ISR runs */
+		Host_advanceNs(HOST_STEP_NS);
+	}
+}
+
+/*
+ * Description :
+ * avr-libc provides itoa, glibc does not.
+ */
+char *itoa(int value, char *buffer, int radix)
+{
+	char digits[sizeof(int) * 8 + 1];
+	unsigned int magnitude = (value < 0 && radix == 10) ? -(unsigned int)value : (unsigned int)value;
+	uint8 count = 0;
+	uint8 i = 0;
+
+	do
+	{
+		digits[count++] = "0123456789abcdefghijklmnopqrstuvwxyz"[magnitude % radix];
+		magnitude /= radix;
+	} while(magnitude != 0);
+
+	if(value < 0 && radix == 10)
+	{
+		buffer[i++] = '-';
+	}
+	while(count > 0)
+	{
+		buffer[i++] = digits[--count];
+	}
+	buffer[i] = '\0';
+
+	return buffer;
+}
+
+/*******************************************************************************
+ *                      Private Functions Definitions                          *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Run the ISRs of the pending interrupts in priority order while the I bit is set.
+ * An ISR runs with the I bit cleared and the I bit is set again at its end (reti).
+ */
+static void Host_dispatch(void)
+{
+	const Host_VectorType *vector;
+	uint8 n;
+
+	while(SREG & HOST_SREG_I)
+	{
+		for(n = 1; n < HOST_NUM_OF_VECTORS; n++)
+		{
+			vector = &g_vectors[n];
+			if((vector->flag_address != 0) &&
+					(g_registers[vector->flag_address] & (1 << vector->flag_bit)) &&
+					(g_registers[vector->enable_address] & (1 << vector->enable_bit)))
+			{
+				break;
+			}
+		}
+		if(n == HOST_NUM_OF_VECTORS)
+		{
+			return;
+		}
+
+		if(g_isrs[n] == NULL)
+		{
+			/* avr-libc jumps to __bad_interrupt, which resets the MCU */
+			fprintf(stderr, "host: interrupt %u enabled without ISR\n", n);
+			exit(2);
+		}
+		if(vector->clear_on_entry == TRUE)
+		{
+			g_registers[vector->flag_address] &= ~(1 << vector->flag_bit);
+		}
+
+		g_sleeping = FALSE;
+		SREG &= ~HOST_SREG_I;
+		Host_advanceNs(HOST_INTERRUPT_NS);
+		g_isrs[n]();
+		SREG |= HOST_SREG_I;
+	}
+}
+
+/*
+ * Description :
+ * Wait until the real time catches up with the scaled virtual time.
+ */
+static void Host_pace(void)
+{
+	struct timespec now;
+	float64 real_ns;
+	float64 ahead_ns;
+
+	g_nextPaceNs = g_timeNs + HOST_PACE_PERIOD_NS;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	real_ns = (now.tv_sec - g_paceStart.tv_sec) * 1e9 + (now.tv_nsec - g_paceStart.tv_nsec);
+	ahead_ns = ((g_timeNs - g_paceStartNs) / g_timeScale) - real_ns;
+	if(ahead_ns > 0)
+	{
+		now.tv_sec = (time_t)(ahead_ns / 1e9);
+		now.tv_nsec = (long)(ahead_ns - now.tv_sec * 1e9);
+		nanosleep(&now, NULL);
+	}
+}
+
+/*
+ * Description :
+ * PIN read hook, the register file keeps the last value read.
+ */
+static uint8 Host_readPin(uint8 address, uint8 value)
+{
+	(void)value;
+	g_registers[address] = Host_getPins((uint8)((PINA - address) / 3));
+	return g_registers[address];
+}
+
+/*
+ * Description :
+ * PORT and DDR write hook.
+ */
+static void Host_writePort(uint8 address, uint8 old_value, uint8 value)
+{
+	(void)address;
+	if(old_value != value)
+	{
+		Host_notifyPorts();
+	}
+}
@@ -0,0 +1,264 @@
+ /******************************************************************************
+ *
+ * Module: Host
+ *
+ * File Name: host.h
+ *
+ * Description: Core of the host (Linux) builds of the ECUs. The I/O registers
+ *              are a virtual register file accessed through the registers.h
+ *              macros, each access costs one CPU cycle of virtual time. The
+ *              peripheral models are hooks on their registers plus a function
+ *              called when the time advances, the ISRs run when their flag and
+ *              enable bits are set and the I bit of SREG is set.
+ *
+ *              The GPIO ports are part of the core: a PIN read returns the
+ *              output pins, the pins driven by the models and the pull-ups.
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#ifndef HOST_H_
+#define HOST_H_
+
+#include "std_types.h"
+#include <avr/io.h>
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/* Size of the register file, the I/O registers are at the data addresses 0x20..0x5F */
+#define HOST_NUM_OF_REGISTERS          0x60
+
+/* Time of one CPU cycle at F_CPU */
+#define HOST_CYCLE_NS                  (1000000000ULL / F_CPU)
+
+/* Time taken by a register access (in/out/sbi/cbi, about one cycle) */
+#ifndef HOST_REGISTER_ACCESS_NS
+#define HOST_REGISTER_ACCESS_NS        HOST_CYCLE_NS
+#endif
+
+/* Interrupt response, prologue/epilogue and reti of a small ISR at -O0 */
+#ifndef HOST_INTERRUPT_NS
+#define HOST_INTERRUPT_NS              (40 * HOST_CYCLE_NS)
+#endif
+
+/* Longest time step of the models, a delay or a sleep is cut in steps so the
+ * interrupts are served on time (at most one step late) */
+#define HOST_STEP_NS                   1000ULL
+
+/* Maximum number of models advanced with the time and of port input sources/listeners */
+#define HOST_MAX_DEVICES               8
+#define HOST_MAX_PORT_SOURCES          4
+#define HOST_MAX_PORT_LISTENERS        4
+
+/* Number of GPIO ports, PORTA..PORTD */
+#define HOST_NUM_OF_PORTS              4
+
+/* Convert for the configuration and the logs */
+#define HOST_MS_TO_NS(ms)              ((uint64)(ms) * 1000000ULL)
+#define HOST_NS_TO_SECONDS(ns)         ((ns) / 1e9)
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+/* Called after a register write with its previous and written values */
+typedef void (*Host_WriteHookType)(uint8 address, uint8 old_value, uint8 value);
+
+/* Called on a register read with the register file value, returns the value read */
+typedef uint8 (*Host_ReadHookType)(uint8 address, uint8 value);
+
+/* Called when the virtual time advances by elapsed_ns */
+typedef void (*Host_DeviceType)(uint64 elapsed_ns);
+
+/* Returns the levels of the port pins with the pins driven by the source changed */
+typedef uint8 (*Host_PortSourceType)(uint8 port_num, uint8 levels);
+
+/* Called after a PORT/DDR write or a change of the driven pins */
+typedef void (*Host_PortListenerType)(void);
+
+/* Slave on the TWI bus, the functions return TRUE for an ACK */
+typedef struct
+{
+	uint8 address;                     /* First 7-bit slave address */
+	uint8 num_of_addresses;            /* Consecutive addresses answered (8 for a 24C16) */
+	boolean (*start)(uint8 address, boolean read);
+	boolean (*write)(uint8 data);
+	uint8 (*read)(boolean ack);
+	void (*stop)(void);
+}Host_TwiDeviceType;
+
+/*******************************************************************************
+ *                              Functions Prototypes                           *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Power on reset: virtual time 0, registers at their reset value, no hooks and no models.
+ * The models are then attached with their Host_initXxx function.
+ */
+void Host_init(void);
+
+/*
+ * Description :
+ * Return the virtual time in nanoseconds.
+ */
+uint64 Host_now(void);
+
+/*
+ * Description :
+ * Advance the virtual time, the models follow and the pending interrupts are served.
+ */
+void Host_advanceNs(uint64 ns);
+
+/*
+ * Description :
+ * Pace the virtual time on the real time, scale times faster (0 runs as fast as possible).
+ * Needed when the ECU talks to another process, e.g. the other ECU over the UART.
+ */
+void Host_setTimeScale(float64 scale);
+
+/*
+ * Description :
+ * Exit the program with status 0 when the virtual time reaches limit_ns (0 for no limit).
+ * The atexit functions of the models print their reports.
+ */
+void Host_setRunLimit(uint64 limit_ns);
+
+/*
+ * Description :
+ * Register value without time cost, hooks or interrupts, for the models.
+ */
+uint8 Host_getRegister(uint8 address);
+void Host_setRegister(uint8 address, uint8 value);
+
+/*
+ * Description :
+ * Attach the model of a register, one read and one write hook per register.
+ */
+void Host_setReadHook(uint8 address, Host_ReadHookType hook);
+void Host_setWriteHook(uint8 address, Host_WriteHookType hook);
+
+/*
+ * Description :
+ * Attach a model function called on each time advance.
+ */
+void Host_addDevice(Host_DeviceType device);
+
+/*
+ * Description :
+ * TRUE while the MCU sleeps in a mode that stops the I/O clock (power-down, power-save, standby).
+ */
+boolean Host_isClockStopped(void);
+
+/*
+ * Description :
+ * Drive the input pins of mask to levels, the other pins of the port are released.
+ */
+void Host_drivePins(uint8 port_num, uint8 mask, uint8 levels);
+
+/*
+ * Description :
+ * Attach a model that drives pins depending on the other pins (e.g. a keypad matrix).
+ */
+void Host_addPortSource(Host_PortSourceType source);
+
+/*
+ * Description :
+ * Attach a model notified when the pin levels may have changed.
+ */
+void Host_addPortListener(Host_PortListenerType listener);
+
+/*
+ * Description :
+ * Tell the listeners that a source changed its pins.
+ */
+void Host_notifyPorts(void);
+
+/*
+ * Description :
+ * Return the levels of the port pins, as a PIN read returns them.
+ */
+uint8 Host_getPins(uint8 port_num);
+
+/*
+ * Description :
+ * Print the virtual time at the start of a log line.
+ */
+void Host_logTime(void);
+
+/*******************************************************************************
+ *                              Peripheral Models                              *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Attach the Timer0/1/2 model (host_timer.c).
+ */
+void Host_initTimers(void);
+
+/*
+ * Description :
+ * Attach the UART model (host_uart.c), the sent bytes go to out_fd and the received
+ * bytes come from in_fd (-1 for none).
+ */
+void Host_initUart(int in_fd, int out_fd);
+
+/*
+ * Description :
+ * Set the function called with each byte sent, after it is written to out_fd.
+ */
+void Host_setUartTxCallBack(void (*a_ptr)(uint8 data));
+
+/*
+ * Description :
+ * Queue a byte on the receive line, it is received after the bytes already queued.
+ */
+void Host_injectUart(uint8 data);
+
+/*
+ * Description :
+ * Attach the TWI master model (host_twi.c) with no slave on the bus.
+ */
+void Host_initTwi(void);
+
+/*
+ * Description :
+ * Connect a slave model on the bus.
+ */
+void Host_addTwiDevice(const Host_TwiDeviceType *device);
+
+/*
+ * Description :
+ * Connect the 24C16 EEPROM model (host_eeprom.c) on the TWI bus, erased (0xFF) or
+ * loaded from file_name (NULL for none). The file is written after each write cycle.
+ */
+void Host_initEeprom(const char *file_name);
+
+/*
+ * Description :
+ * Byte of the EEPROM memory, for the checks of the programs.
+ */
+uint8 Host_getEepromByte(uint16 address);
+
+/*
+ * Description :
+ * Attach the INT0/INT1/INT2 model (host_extint.c).
+ */
+void Host_initExtInts(void);
+
+/*
+ * Description :
+ * Attach the ADC model (host_adc.c), all the inputs at 0 V.
+ */
+void Host_initAdc(void);
+
+/*
+ * Description :
+ * Set the voltage of an analog input (PA0..PA7) in millivolts.
+ */
+void Host_setAnalogInput(uint8 channel, uint16 millivolts);
+
+#endif /* HOST_H_ */
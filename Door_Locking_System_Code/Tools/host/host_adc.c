@@ -0,0 +1,211 @@
+ /******************************************************************************
+ *
+ * Module: Host ADC
+ *
+ * File Name: host_adc.c
+ *
+ * Description: Model of the ATmega32 ADC: single ended channels, AREF/AVCC/2.56V
+ *              references, ADLAR, single conversions and the free running mode.
+ *              A conversion takes 13 ADC clocks (25 for the first one after ADEN)
+ *              and uses the ADMUX value of its start. The inputs are set by the
+ *              board models in millivolts, each conversion adds 1 LSB of uniform
+ *              noise so the oversampled results average to the input. The
+ *              differential channels and the other auto trigger sources are not
+ *              modeled.
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#define HOST_REGISTER_ADDRESSES
+#include <stdlib.h>
+#include "host.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define HOST_ADC_NUM_OF_CHANNELS       8
+
+/* AVCC and the AREF pin of the boards, and the internal reference */
+#define HOST_ADC_AVCC_MV               5000
+#define HOST_ADC_AREF_MV               5000
+#define HOST_ADC_INTERNAL_MV           2560
+
+#define HOST_ADC_FIRST_CLOCKS          25
+#define HOST_ADC_CLOCKS                13
+#define HOST_ADC_MAX                   1023
+
+#define HOST_ADC_CHANNEL_MASK          0x1F
+#define HOST_ADC_PRESCALER_MASK        0x07
+#define HOST_ADC_TRIGGER_MASK          ((1 << ADTS2) | (1 << ADTS1) | (1 << ADTS0))
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static void Host_advanceAdc(uint64 elapsed_ns);
+static void Host_startConversion(uint8 clocks);
+static void Host_endConversion(void);
+static void Host_writeAdcControl(uint8 address, uint8 old_value, uint8 value);
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+/* ADC clock divider of each ADPS2:0 value */
+static const uint8 g_dividers[HOST_ADC_PRESCALER_MASK + 1] = { 2, 2, 4, 8, 16, 32, 64, 128 };
+
+static uint16 g_inputs[HOST_ADC_NUM_OF_CHANNELS];
+
+/* Conversion in progress: its ADMUX value, length and time since its start */
+static boolean g_converting = FALSE;
+static uint8 g_admux = 0;
+static uint64 g_conversionNs = 0;
+static uint64 g_elapsedNs = 0;
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Attach the ADC model, all the inputs at 0 V.
+ */
+void Host_initAdc(void)
+{
+	uint8 channel;
+
+	for(channel = 0; channel < HOST_ADC_NUM_OF_CHANNELS; channel++)
+	{
+		g_inputs[channel] = 0;
+	}
+	g_converting = FALSE;
+	Host_setWriteHook(ADCSRA, Host_writeAdcControl);
+	Host_addDevice(Host_advanceAdc);
+}
+
+/*
+ * Description :
+ * Set the voltage of an analog input (PA0..PA7) in millivolts.
+ */
+void Host_setAnalogInput(uint8 channel, uint16 millivolts)
+{
+	if(channel < HOST_ADC_NUM_OF_CHANNELS)
+	{
+		g_inputs[channel] = millivolts;
+	}
+}
+
+/*******************************************************************************
+ *                      Private Functions Definitions                          *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * End the conversions of the elapsed time, the free running mode starts the next one at once.
+ * The ADC stops in the deep sleep modes.
+ */
+static void Host_advanceAdc(uint64 elapsed_ns)
+{
+	if((g_converting == FALSE) || (Host_isClockStopped() == TRUE))
+	{
+		return;
+	}
+
+	g_elapsedNs += elapsed_ns;
+	while((g_converting == TRUE) && (g_elapsedNs >= g_conversionNs))
+	{
+		g_elapsedNs -= g_conversionNs;
+		Host_endConversion();
+	}
+}
+
+/*
+ * Description :
+ * Latch ADMUX and start a conversion, ADSC reads one until it ends.
+ */
+static void Host_startConversion(uint8 clocks)
+{
+	uint8 divider = g_dividers[Host_getRegister(ADCSRA) & HOST_ADC_PRESCALER_MASK];
+
+	g_admux = Host_getRegister(ADMUX);
+	g_conversionNs = (uint64)clocks * divider * HOST_CYCLE_NS;
+	g_converting = TRUE;
+	Host_setRegister(ADCSRA, Host_getRegister(ADCSRA) | (1 << ADSC));
+}
+
+/*
+ * Description :
+ * Write the result of the conversion and set ADIF.
+ */
+static void Host_endConversion(void)
+{
+	uint8 channel = g_admux & HOST_ADC_CHANNEL_MASK;
+	uint16 reference_mv;
+	float64 input = 0;
+	sint32 result;
+	uint16 data;
+
+	switch(g_admux >> REFS0)
+	{
+	case 0:
+		reference_mv = HOST_ADC_AREF_MV;
+		break;
+	case 1:
+		reference_mv = HOST_ADC_AVCC_MV;
+		break;
+	default:
+		reference_mv = HOST_ADC_INTERNAL_MV;
+		break;
+	}
+	if(channel < HOST_ADC_NUM_OF_CHANNELS)
+	{
+		input = (g_inputs[channel] * (HOST_ADC_MAX + 1.0)) / reference_mv;
+	}
+
+	/* Rounding at a random point is 1 LSB of uniform noise */
+	result = (sint32)(input + (rand() / (RAND_MAX + 1.0)) - 0.5);
+	result = (result < 0) ? 0 : ((result > HOST_ADC_MAX) ? HOST_ADC_MAX : result);
+	data = (g_admux & (1 << ADLAR)) ? (uint16)(result << 6) : (uint16)result;
+	Host_setRegister(ADCL, (uint8)data);
+	Host_setRegister(ADCH, (uint8)(data >> 8));
+	Host_setRegister(ADCSRA, Host_getRegister(ADCSRA) | (1 << ADIF));
+
+	if((Host_getRegister(ADCSRA) & (1 << ADATE)) && ((Host_getRegister(SFIOR) & HOST_ADC_TRIGGER_MASK) == 0))
+	{
+		Host_startConversion(HOST_ADC_CLOCKS);
+	}
+	else
+	{
+		g_converting = FALSE;
+		Host_setRegister(ADCSRA, Host_getRegister(ADCSRA) & ~(1 << ADSC));
+	}
+}
+
+/*
+ * Description :
+ * ADCSRA write: ADIF is cleared by writing a one to it, ADSC starts a conversion and is
+ * not cleared by software, ADEN cleared aborts the conversion.
+ */
+static void Host_writeAdcControl(uint8 address, uint8 old_value, uint8 value)
+{
+	boolean start = ((value & (1 << ADSC)) && (g_converting == FALSE)) ? TRUE : FALSE;
+	uint8 clocks = (old_value & (1 << ADEN)) ? HOST_ADC_CLOCKS : HOST_ADC_FIRST_CLOCKS;
+	uint8 flag = (value & (1 << ADIF)) ? 0 : (old_value & (1 << ADIF));
+
+	value = (uint8)((value & ~((1 << ADIF) | (1 << ADSC))) | flag | (old_value & (1 << ADSC)));
+	if(!(value & (1 << ADEN)))
+	{
+		g_converting = FALSE;
+		value &= ~(1 << ADSC);
+		start = FALSE;
+	}
+	Host_setRegister(address, value);
+
+	if(start == TRUE)
+	{
+		g_elapsedNs = 0;
+		Host_startConversion(clocks);
+	}
+}
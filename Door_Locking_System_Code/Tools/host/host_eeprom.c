@@ -0,0 +1,170 @@
+ /******************************************************************************
+ *
+ * Module: Host EEPROM
+ *
+ * File Name: host_eeprom.c
+ *
+ * Description: Model of a 24C16 I2C EEPROM (2K bytes, 16 bytes pages) on the TWI
+ *              model. The 3 high address bits are in the slave address, the
+ *              device does not answer during the write cycle after a STOP.
+ *              The memory can be kept in a file between the runs.
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include "host.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define HOST_EEPROM_SIZE               2048
+#define HOST_EEPROM_PAGE_SIZE          16
+#define HOST_EEPROM_ADDRESS            0x50
+
+/* Self-timed write cycle (tWR) */
+#define HOST_EEPROM_WRITE_NS           HOST_MS_TO_NS(5)
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static boolean Host_startEeprom(uint8 address, boolean read);
+static boolean Host_writeEeprom(uint8 data);
+static uint8 Host_readEeprom(boolean ack);
+static void Host_stopEeprom(void);
+static void Host_saveEeprom(void);
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+static const Host_TwiDeviceType g_eeprom =
+{
+	HOST_EEPROM_ADDRESS, HOST_EEPROM_SIZE / 256,
+	Host_startEeprom, Host_writeEeprom, Host_readEeprom, Host_stopEeprom
+};
+
+static uint8 g_memory[HOST_EEPROM_SIZE];
+static const char *g_fileName = NULL;
+
+static uint16 g_address = 0;
+static boolean g_addressSet = FALSE;   /* The word address byte of a write was received */
+static boolean g_written = FALSE;      /* Data bytes written, the STOP starts the write cycle */
+static uint64 g_busyUntilNs = 0;
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Connect the EEPROM on the TWI bus, erased (0xFF) or loaded from file_name (NULL for none).
+ * The file is written after each write cycle.
+ */
+void Host_initEeprom(const char *file_name)
+{
+	FILE *file;
+
+	memset(g_memory, 0xFF, sizeof(g_memory));
+	g_fileName = file_name;
+	if(file_name != NULL)
+	{
+		file = fopen(file_name, "rb");
+		if(file != NULL)
+		{
+			if(fread(g_memory, 1, sizeof(g_memory), file) != sizeof(g_memory))
+			{
+				fprintf(stderr, "host: %s is not a full EEPROM image\n", file_name);
+			}
+			fclose(file);
+		}
+	}
+	g_busyUntilNs = 0;
+	Host_addTwiDevice(&g_eeprom);
+}
+
+/*
+ * Description :
+ * Byte of the EEPROM memory, for the checks of the programs.
+ */
+uint8 Host_getEepromByte(uint16 address)
+{
+	return g_memory[address % HOST_EEPROM_SIZE];
+}
+
+/*******************************************************************************
+ *                      Private Functions Definitions                          *
+ *******************************************************************************/
+
+static boolean Host_startEeprom(uint8 address, boolean read)
+{
+	if(Host_now() < g_busyUntilNs)
+	{
+		return FALSE; /* Acknowledge polling: no ACK during the write cycle */
+	}
+
+	if(read == FALSE)
+	{
+		/* The block bits of the slave address are the high bits of the word address */
+		g_address = (uint16)(address - HOST_EEPROM_ADDRESS) << 8;
+		g_addressSet = FALSE;
+		g_written = FALSE;
+	}
+	return TRUE;
+}
+
+static boolean Host_writeEeprom(uint8 data)
+{
+	if(g_addressSet == FALSE)
+	{
+		g_address = (g_address & 0x0700) | data;
+		g_addressSet = TRUE;
+	}
+	else
+	{
+		g_memory[g_address] = data;
+		/* The address rolls over inside the page */
+		g_address = (g_address & ~(HOST_EEPROM_PAGE_SIZE - 1)) | ((g_address + 1) & (HOST_EEPROM_PAGE_SIZE - 1));
+		g_written = TRUE;
+	}
+	return TRUE;
+}
+
+static uint8 Host_readEeprom(boolean ack)
+{
+	uint8 data = g_memory[g_address];
+
+	(void)ack;
+	g_address = (g_address + 1) % HOST_EEPROM_SIZE;
+	return data;
+}
+
+static void Host_stopEeprom(void)
+{
+	if(g_written == TRUE)
+	{
+		g_written = FALSE;
+		g_busyUntilNs = Host_now() + HOST_EEPROM_WRITE_NS;
+		Host_saveEeprom();
+	}
+}
+
+static void Host_saveEeprom(void)
+{
+	FILE *file;
+
+	if(g_fileName == NULL)
+	{
+		return;
+	}
+	file = fopen(g_fileName, "wb");
+	if(file != NULL)
+	{
+		fwrite(g_memory, 1, sizeof(g_memory), file);
+		fclose(file);
+	}
+}
@@ -0,0 +1,167 @@
+ /******************************************************************************
+ *
+ * Module: Host External Interrupts
+ *
+ * File Name: host_extint.c
+ *
+ * Description: Model of INT0 (PD2), INT1 (PD3) and INT2 (PB2). The edges set the
+ *              INTFn flags as selected by ISCxx, a low level INT0/INT1 keeps its
+ *              flag set while the pin is low, so the ISR runs again as long as the
+ *              level stays (the hardware has no flag in this mode, the effect on
+ *              the program is the same). The pins work in every sleep mode.
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#define HOST_REGISTER_ADDRESSES
+#include "host.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define HOST_EXTINT_NUM_OF_INTS        3
+
+/* Port ids as in gpio.h */
+#define HOST_PORTB                     1
+#define HOST_PORTD                     3
+
+/* Sense control values */
+#define HOST_SENSE_LOW_LEVEL           0
+#define HOST_SENSE_ANY_CHANGE          1
+#define HOST_SENSE_FALLING             2
+#define HOST_SENSE_RISING              3
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+typedef struct
+{
+	uint8 port_num;
+	uint8 pin;
+	uint8 flag;                        /* INTFn bit in GIFR */
+}Host_ExtIntType;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static void Host_updateExtInts(void);
+static void Host_advanceExtInts(uint64 elapsed_ns);
+static uint8 Host_getSense(uint8 index);
+static void Host_writeExtIntFlags(uint8 address, uint8 old_value, uint8 value);
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+static const Host_ExtIntType g_ints[HOST_EXTINT_NUM_OF_INTS] =
+{
+	{ HOST_PORTD, 2, INTF0 }, { HOST_PORTD, 3, INTF1 }, { HOST_PORTB, 2, INTF2 }
+};
+
+static uint8 g_levels[HOST_EXTINT_NUM_OF_INTS];
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Attach the external interrupts model.
+ */
+void Host_initExtInts(void)
+{
+	uint8 i;
+
+	for(i = 0; i < HOST_EXTINT_NUM_OF_INTS; i++)
+	{
+		g_levels[i] = (Host_getPins(g_ints[i].port_num) >> g_ints[i].pin) & 1;
+	}
+	Host_setWriteHook(GIFR, Host_writeExtIntFlags);
+	Host_addPortListener(Host_updateExtInts);
+	Host_addDevice(Host_advanceExtInts);
+}
+
+/*******************************************************************************
+ *                      Private Functions Definitions                          *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Pin change: set the flags of the selected edges and of the low levels.
+ */
+static void Host_updateExtInts(void)
+{
+	uint8 flags = Host_getRegister(GIFR);
+	uint8 level;
+	uint8 sense;
+	uint8 i;
+
+	for(i = 0; i < HOST_EXTINT_NUM_OF_INTS; i++)
+	{
+		level = (Host_getPins(g_ints[i].port_num) >> g_ints[i].pin) & 1;
+		sense = Host_getSense(i);
+		if(((sense == HOST_SENSE_LOW_LEVEL) && (level == 0)) ||
+				((sense == HOST_SENSE_ANY_CHANGE) && (level != g_levels[i])) ||
+				((sense == HOST_SENSE_FALLING) && (level == 0) && (g_levels[i] == 1)) ||
+				((sense == HOST_SENSE_RISING) && (level == 1) && (g_levels[i] == 0)))
+		{
+			flags |= (1 << g_ints[i].flag);
+		}
+		else if((sense == HOST_SENSE_LOW_LEVEL) && (level == 1))
+		{
+			flags &= ~(1 << g_ints[i].flag);
+		}
+		g_levels[i] = level;
+	}
+	Host_setRegister(GIFR, flags);
+}
+
+/*
+ * Description :
+ * Keep the flag of a low level set after the ISR cleared it.
+ */
+static void Host_advanceExtInts(uint64 elapsed_ns)
+{
+	uint8 flags = Host_getRegister(GIFR);
+	uint8 i;
+
+	(void)elapsed_ns;
+	for(i = 0; i < 2; i++)
+	{
+		if((Host_getSense(i) == HOST_SENSE_LOW_LEVEL) && (g_levels[i] == 0))
+		{
+			flags |= (1 << g_ints[i].flag);
+		}
+	}
+	Host_setRegister(GIFR, flags);
+}
+
+/*
+ * Description :
+ * Sense control of an interrupt, INT2 has the falling or rising edge only.
+ */
+static uint8 Host_getSense(uint8 index)
+{
+	switch(index)
+	{
+	case 0:
+		return Host_getRegister(MCUCR) & ((1 << ISC01) | (1 << ISC00));
+	case 1:
+		return (Host_getRegister(MCUCR) >> ISC10) & 0x03;
+	default:
+		return (Host_getRegister(MCUCSR) & (1 << ISC2)) ? HOST_SENSE_RISING : HOST_SENSE_FALLING;
+	}
+}
+
+/*
+ * Description :
+ * GIFR write: a flag is cleared by writing a one to it.
+ */
+static void Host_writeExtIntFlags(uint8 address, uint8 old_value, uint8 value)
+{
+	Host_setRegister(address, old_value & ~value);
+}
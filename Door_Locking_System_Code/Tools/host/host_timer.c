@@ -0,0 +1,434 @@
+ /******************************************************************************
+ *
+ * Module: Host Timers
+ *
+ * File Name: host_timer.c
+ *
+ * Description: Model of the ATmega32 Timer0, Timer1 and Timer2: prescaler,
+ *              counting in every waveform generation mode, compare and overflow
+ *              flags, OCR double buffering in the PWM modes. The repeated periods
+ *              of the 8-bit PWM modes are skipped in long time steps. In the asynchronous
+ *              mode (ASSR AS2) Timer2 counts a 32.768 kHz watch crystal and keeps
+ *              counting in power-save, its register writes complete at once so the ASSR
+ *              busy flags read as zero. The output compare pins, the input capture and
+ *              the external clock inputs are not modeled.
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#define HOST_REGISTER_ADDRESSES
+#include "host.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define HOST_TIMER_CLOCK_MASK          0x07
+#define HOST_TIMER_NUM_OF_CLOCKS       8
+
+/* Waveform generation modes of the 8-bit timers, WGMn1:WGMn0 */
+#define HOST_TIMER8_NORMAL             0
+#define HOST_TIMER8_PHASE_CORRECT      1
+#define HOST_TIMER8_CTC                2
+#define HOST_TIMER8_FAST_PWM           3
+
+/* Clock of Timer2 in the asynchronous mode, watch crystal on TOSC1/TOSC2 */
+#define HOST_TIMER2_ASYNC_HZ           32768ULL
+
+/* Sleep modes where the asynchronous Timer2 runs on, SM2:0 in MCUCR */
+#define HOST_SLEEP_MODE_MASK           ((1 << SM2) | (1 << SM1) | (1 << SM0))
+#define HOST_SLEEP_MODE_PWR_SAVE       ((1 << SM1) | (1 << SM0))
+#define HOST_SLEEP_MODE_EXT_STANDBY    ((1 << SM2) | (1 << SM1) | (1 << SM0))
+
+/* Counts of a period of the 8-bit PWM modes */
+#define HOST_TIMER8_FAST_PWM_PERIOD    256
+#define HOST_TIMER8_PHASE_CORRECT_PERIOD 510
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+/* Registers and state of an 8-bit timer (Timer0 and Timer2 have the same layout) */
+typedef struct
+{
+	uint8 control_address;
+	uint8 counter_address;
+	uint8 compare_address;
+	uint8 compare_flag;                /* OCFn bit in TIFR */
+	uint8 overflow_flag;               /* TOVn bit in TIFR */
+	uint8 force_bit;                   /* FOCn, a strobe read as zero */
+	const uint16 *dividers;            /* Prescaler of each CSn2:0 value, 0 = no clock */
+	uint64 elapsed;                    /* Time since the last count, in ns x Hz of the timer clock */
+	uint16 compare;                    /* OCR in use, updated from the register at TOP/BOTTOM in the PWM modes */
+	boolean counting_down;             /* Phase correct PWM */
+}Host_TimerType;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static void Host_advanceTimers(uint64 elapsed_ns);
+static uint32 Host_getTimerCounts(Host_TimerType *timer, uint8 clock, uint64 clock_hz, uint64 elapsed_ns);
+static uint32 Host_skipTimer8Periods(Host_TimerType *timer, uint32 counts);
+static void Host_countTimer8(Host_TimerType *timer, uint32 counts);
+static void Host_countTimer1(void);
+static void Host_writeTimerControl(uint8 address, uint8 old_value, uint8 value);
+static void Host_writeTimerFlags(uint8 address, uint8 old_value, uint8 value);
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+static const uint16 g_dividers01[HOST_TIMER_NUM_OF_CLOCKS] = { 0, 1, 8, 64, 256, 1024, 0, 0 };
+static const uint16 g_dividers2[HOST_TIMER_NUM_OF_CLOCKS] = { 0, 1, 8, 32, 64, 128, 256, 1024 };
+
+static Host_TimerType g_timer0 = { TCCR0, TCNT0, OCR0, OCF0, TOV0, FOC0, g_dividers01, 0, 0, FALSE };
+static Host_TimerType g_timer2 = { TCCR2, TCNT2, OCR2, OCF2, TOV2, FOC2, g_dividers2, 0, 0, FALSE };
+
+/* Timer1 uses the common fields for TCCR1B, TCNT1 and OCR1A */
+static Host_TimerType g_timer1 = { TCCR1B, TCNT1, OCR1A, OCF1A, TOV1, 0, g_dividers01, 0, 0, FALSE };
+static uint16 g_timer1CompareB = 0;
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Attach the timers model.
+ */
+void Host_initTimers(void)
+{
+	g_timer0.elapsed = 0;
+	g_timer1.elapsed = 0;
+	g_timer2.elapsed = 0;
+	Host_setWriteHook(TCCR0, Host_writeTimerControl);
+	Host_setWriteHook(TCCR1A, Host_writeTimerControl);
+	Host_setWriteHook(TCCR2, Host_writeTimerControl);
+	Host_setWriteHook(TIFR, Host_writeTimerFlags);
+	Host_addDevice(Host_advanceTimers);
+}
+
+/*******************************************************************************
+ *                      Private Functions Definitions                          *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Count the timer clocks of the elapsed time, the timers stop in the deep sleep modes
+ * but the asynchronous Timer2 runs on in power-save and extended standby.
+ */
+static void Host_advanceTimers(uint64 elapsed_ns)
+{
+	boolean async = (Host_getRegister(ASSR) & (1 << AS2)) ? TRUE : FALSE;
+	uint8 sleep_mode = Host_getRegister(MCUCR) & HOST_SLEEP_MODE_MASK;
+	uint32 counts;
+
+	if(Host_isClockStopped() == FALSE)
+	{
+		counts = Host_getTimerCounts(&g_timer0, Host_getRegister(TCCR0) & HOST_TIMER_CLOCK_MASK, F_CPU, elapsed_ns);
+		Host_countTimer8(&g_timer0, Host_skipTimer8Periods(&g_timer0, counts));
+
+		counts = Host_getTimerCounts(&g_timer1, Host_getRegister(TCCR1B) & HOST_TIMER_CLOCK_MASK, F_CPU, elapsed_ns);
+		while(counts-- > 0)
+		{
+			Host_countTimer1();
+		}
+	}
+	else if((async == FALSE) ||
+			((sleep_mode != HOST_SLEEP_MODE_PWR_SAVE) && (sleep_mode != HOST_SLEEP_MODE_EXT_STANDBY)))
+	{
+		return;
+	}
+
+	counts = Host_getTimerCounts(&g_timer2, Host_getRegister(TCCR2) & HOST_TIMER_CLOCK_MASK,
+			(async == TRUE) ? HOST_TIMER2_ASYNC_HZ : F_CPU, elapsed_ns);
+	Host_countTimer8(&g_timer2, Host_skipTimer8Periods(&g_timer2, counts));
+}
+
+/*
+ * Description :
+ * Number of timer clocks in the elapsed time, the remainder is kept for the next call.
+ */
+static uint32 Host_getTimerCounts(Host_TimerType *timer, uint8 clock, uint64 clock_hz, uint64 elapsed_ns)
+{
+	uint64 period;
+	uint32 counts;
+
+	if(timer->dividers[clock] == 0)
+	{
+		timer->elapsed = 0;
+		return 0;
+	}
+
+	/* In ns x Hz, exact for the crystal clock whose period is not a whole number of ns */
+	period = timer->dividers[clock] * 1000000000ULL;
+	timer->elapsed += elapsed_ns * clock_hz;
+	counts = (uint32)(timer->elapsed / period);
+	timer->elapsed -= counts * period;
+
+	return counts;
+}
+
+/*
+ * Description :
+ * A PWM timer at a small prescaler counts millions of times a second. The registers do
+ * not change while the timer counts, so after its first period (the OCR update) the timer
+ * repeats the same periods: only two of them and the remainder are counted, with the same
+ * end state and flags. The other modes count every clock.
+ */
+static uint32 Host_skipTimer8Periods(Host_TimerType *timer, uint32 counts)
+{
+	uint8 control = Host_getRegister(timer->control_address);
+	uint8 mode = (((control >> WGM01) & 1) << 1) | ((control >> WGM00) & 1);
+	uint32 period;
+
+	if(mode == HOST_TIMER8_FAST_PWM)
+	{
+		period = HOST_TIMER8_FAST_PWM_PERIOD;
+	}
+	else if(mode == HOST_TIMER8_PHASE_CORRECT)
+	{
+		period = HOST_TIMER8_PHASE_CORRECT_PERIOD;
+	}
+	else
+	{
+		return counts;
+	}
+
+	return (counts >= 3 * period) ? (2 * period + (counts % period)) : counts;
+}
+
+/*
+ * Description :
+ * Clocks of Timer0 or Timer2, the registers are read and written once.
+ */
+static void Host_countTimer8(Host_TimerType *timer, uint32 counts)
+{
+	uint8 control;
+	uint8 mode;
+	uint8 count;
+	uint8 compare_register;
+	uint8 flags = 0;
+
+	if(counts == 0)
+	{
+		return;
+	}
+	control = Host_getRegister(timer->control_address);
+	mode = (((control >> WGM01) & 1) << 1) | ((control >> WGM00) & 1);
+	count = Host_getRegister(timer->counter_address);
+	compare_register = Host_getRegister(timer->compare_address);
+
+	while(counts-- > 0)
+	{
+		if((mode == HOST_TIMER8_NORMAL) || (mode == HOST_TIMER8_CTC))
+		{
+			/* Not buffered */
+			timer->compare = compare_register;
+		}
+
+		/* The compare flag is set on the clock after the match, with the CTC clear */
+		if(count == timer->compare)
+		{
+			flags |= (1 << timer->compare_flag);
+		}
+
+		if(mode == HOST_TIMER8_PHASE_CORRECT)
+		{
+			if(timer->counting_down == FALSE)
+			{
+				if(count == 0xFF)
+				{
+					timer->counting_down = TRUE;
+					timer->compare = compare_register;
+					count--;
+				}
+				else
+				{
+					count++;
+				}
+			}
+			else
+			{
+				if(count == 0)
+				{
+					timer->counting_down = FALSE;
+					flags |= (1 << timer->overflow_flag);
+					count++;
+				}
+				else
+				{
+					count--;
+				}
+			}
+		}
+		else
+		{
+			timer->counting_down = FALSE;
+			if(count == 0xFF)
+			{
+				flags |= (1 << timer->overflow_flag);
+			}
+			if((count == 0xFF) || ((mode == HOST_TIMER8_CTC) && (count == timer->compare)))
+			{
+				count = 0;
+				if(mode == HOST_TIMER8_FAST_PWM)
+				{
+					timer->compare = compare_register;
+				}
+			}
+			else
+			{
+				count++;
+			}
+		}
+	}
+
+	Host_setRegister(timer->counter_address, count);
+	Host_setRegister(TIFR, Host_getRegister(TIFR) | flags);
+}
+
+/*
+ * Description :
+ * One clock of Timer1, the 16 waveform generation modes.
+ */
+static void Host_countTimer1(void)
+{
+	uint8 mode = ((Host_getRegister(TCCR1B) >> WGM12) & 0x03) << 2 | (Host_getRegister(TCCR1A) & 0x03);
+	uint16 count = (Host_getRegister(TCNT1H) << 8) | Host_getRegister(TCNT1L);
+	uint16 icr = (Host_getRegister(ICR1H) << 8) | Host_getRegister(ICR1L);
+	uint16 ocra = (Host_getRegister(OCR1AH) << 8) | Host_getRegister(OCR1AL);
+	uint16 ocrb = (Host_getRegister(OCR1BH) << 8) | Host_getRegister(OCR1BL);
+	boolean dual_slope = ((mode >= 1) && (mode <= 3)) || ((mode >= 8) && (mode <= 11));
+	boolean buffered = (mode != 0) && (mode != 4) && (mode != 12);
+	boolean at_top;
+	uint16 top;
+	uint8 flags = 0;
+
+	switch(mode)
+	{
+	case 1: case 5:   top = 0x00FF; break;
+	case 2: case 6:   top = 0x01FF; break;
+	case 3: case 7:   top = 0x03FF; break;
+	case 8: case 10: case 12: case 14: top = icr; break;
+	case 0: case 13:  top = 0xFFFF; break;
+	default:          top = (buffered == TRUE) ? g_timer1.compare : ocra; break; /* 4, 9, 11, 15 */
+	}
+	if(buffered == FALSE)
+	{
+		g_timer1.compare = ocra;
+		g_timer1CompareB = ocrb;
+	}
+
+	/* The compare flags are set on the clock after the match, with the CTC clear */
+	if(count == g_timer1.compare)
+	{
+		flags |= (1 << OCF1A);
+	}
+	if(count == g_timer1CompareB)
+	{
+		flags |= (1 << OCF1B);
+	}
+
+	at_top = (count == top) ? TRUE : FALSE;
+	if(dual_slope == TRUE)
+	{
+		if(g_timer1.counting_down == FALSE)
+		{
+			if(at_top == TRUE)
+			{
+				g_timer1.counting_down = TRUE;
+				count--;
+			}
+			else
+			{
+				count++;
+			}
+		}
+		else
+		{
+			if(count == 0)
+			{
+				g_timer1.counting_down = FALSE;
+				flags |= (1 << TOV1);
+				count++;
+				if((mode == 8) || (mode == 9))
+				{
+					/* Phase and frequency correct, updated at BOTTOM */
+					g_timer1.compare = ocra;
+					g_timer1CompareB = ocrb;
+				}
+			}
+			else
+			{
+				count--;
+			}
+		}
+		if((at_top == TRUE) && (mode != 8) && (mode != 9))
+		{
+			g_timer1.compare = ocra;
+			g_timer1CompareB = ocrb;
+		}
+	}
+	else
+	{
+		g_timer1.counting_down = FALSE;
+		if((count == 0xFFFF) || ((at_top == TRUE) && (buffered == TRUE)))
+		{
+			flags |= (1 << TOV1);
+		}
+		if(at_top == TRUE || count == 0xFFFF)
+		{
+			count = 0;
+			if(buffered == TRUE)
+			{
+				g_timer1.compare = ocra;
+				g_timer1CompareB = ocrb;
+			}
+		}
+		else
+		{
+			count++;
+		}
+	}
+
+	if(at_top == TRUE)
+	{
+		if((mode == 12) || (mode == 14) || (mode == 8) || (mode == 10))
+		{
+			flags |= (1 << ICF1); /* ICR1 used as TOP */
+		}
+	}
+	Host_setRegister(TCNT1H, (uint8)(count >> 8));
+	Host_setRegister(TCNT1L, (uint8)count);
+	Host_setRegister(TIFR, Host_getRegister(TIFR) | flags);
+}
+
+/*
+ * Description :
+ * TCCR0/TCCR1A/TCCR2 write: the force output compare bits are strobes that read as zero.
+ */
+static void Host_writeTimerControl(uint8 address, uint8 old_value, uint8 value)
+{
+	(void)old_value;
+	if(address == TCCR1A)
+	{
+		value &= ~((1 << FOC1A) | (1 << FOC1B));
+	}
+	else
+	{
+		value &= ~(1 << FOC0); /* Same bit as FOC2 */
+	}
+	Host_setRegister(address, value);
+}
+
+/*
+ * Description :
+ * TIFR write: a flag is cleared by writing a one to it.
+ */
+static void Host_writeTimerFlags(uint8 address, uint8 old_value, uint8 value)
+{
+	Host_setRegister(address, old_value & ~value);
+}
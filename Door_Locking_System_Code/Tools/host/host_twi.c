@@ -0,0 +1,247 @@
+ /******************************************************************************
+ *
+ * Module: Host TWI
+ *
+ * File Name: host_twi.c
+ *
+ * Description: Model of the ATmega32 TWI in master mode. Writing TWINT to one
+ *              starts the action selected by TWSTA/TWSTO/TWEA/TWDR, it takes the
+ *              bus time of the TWBR/TWPS bit rate then TWINT is set with the status
+ *              code in TWSR. The slaves are models attached on the bus. The slave
+ *              modes and the arbitration are not modeled.
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#define HOST_REGISTER_ADDRESSES
+#include <stdio.h>
+#include <stdlib.h>
+#include "host.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define HOST_TWI_MAX_DEVICES           4
+
+/* Master status codes */
+#define HOST_TWI_START                 0x08
+#define HOST_TWI_REP_START             0x10
+#define HOST_TWI_MT_SLA_W_ACK          0x18
+#define HOST_TWI_MT_SLA_W_NACK         0x20
+#define HOST_TWI_MT_DATA_ACK           0x28
+#define HOST_TWI_MT_DATA_NACK          0x30
+#define HOST_TWI_MR_SLA_R_ACK          0x40
+#define HOST_TWI_MR_SLA_R_NACK         0x48
+#define HOST_TWI_MR_DATA_ACK           0x50
+#define HOST_TWI_MR_DATA_NACK          0x58
+#define HOST_TWI_NO_INFO               0xF8
+
+#define HOST_TWI_PRESCALER_MASK        0x03
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+typedef enum
+{
+	HOST_TWI_IDLE, HOST_TWI_STARTED, HOST_TWI_TRANSMITTER, HOST_TWI_RECEIVER, HOST_TWI_NOT_ADDRESSED
+}Host_TwiStateType;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static void Host_advanceTwi(uint64 elapsed_ns);
+static void Host_completeTwi(void);
+static uint64 Host_getTwiBitNs(void);
+static void Host_writeTwcr(uint8 address, uint8 old_value, uint8 value);
+static void Host_writeTwsr(uint8 address, uint8 old_value, uint8 value);
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+static const Host_TwiDeviceType *g_devices[HOST_TWI_MAX_DEVICES];
+static uint8 g_numOfDevices = 0;
+
+static Host_TwiStateType g_state = HOST_TWI_IDLE;
+static const Host_TwiDeviceType *g_slave = NULL;
+
+/* Action in progress, TWINT is set when its time has elapsed */
+static boolean g_busy = FALSE;
+static uint64 g_remainingNs = 0;
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Attach the TWI model with no slave on the bus.
+ */
+void Host_initTwi(void)
+{
+	g_numOfDevices = 0;
+	g_state = HOST_TWI_IDLE;
+	g_slave = NULL;
+	g_busy = FALSE;
+	Host_setRegister(TWSR, HOST_TWI_NO_INFO);
+	Host_setRegister(TWDR, 0xFF);
+	Host_setWriteHook(TWCR, Host_writeTwcr);
+	Host_setWriteHook(TWSR, Host_writeTwsr);
+	Host_addDevice(Host_advanceTwi);
+}
+
+/*
+ * Description :
+ * Connect a slave model on the bus.
+ */
+void Host_addTwiDevice(const Host_TwiDeviceType *device)
+{
+	if(g_numOfDevices >= HOST_TWI_MAX_DEVICES)
+	{
+		fprintf(stderr, "host: too many TWI devices\n");
+		exit(2);
+	}
+	g_devices[g_numOfDevices++] = device;
+}
+
+/*******************************************************************************
+ *                      Private Functions Definitions                          *
+ *******************************************************************************/
+
+static void Host_advanceTwi(uint64 elapsed_ns)
+{
+	if(g_busy == FALSE)
+	{
+		return;
+	}
+	if(g_remainingNs > elapsed_ns)
+	{
+		g_remainingNs -= elapsed_ns;
+		return;
+	}
+	g_busy = FALSE;
+	Host_completeTwi();
+}
+
+/*
+ * Description :
+ * End of the action started by the TWINT write: status code, TWDR and TWINT.
+ */
+static void Host_completeTwi(void)
+{
+	uint8 twcr = Host_getRegister(TWCR);
+	uint8 data = Host_getRegister(TWDR);
+	uint8 status = HOST_TWI_NO_INFO;
+	boolean ack;
+	uint8 i;
+
+	if(twcr & (1 << TWSTO))
+	{
+		if((g_slave != NULL) && (g_slave->stop != NULL))
+		{
+			g_slave->stop();
+		}
+		g_slave = NULL;
+		g_state = HOST_TWI_IDLE;
+		/* TWSTO is cleared when the STOP is sent, TWINT is not set */
+		Host_setRegister(TWCR, twcr & ~(1 << TWSTO));
+		Host_setRegister(TWSR, HOST_TWI_NO_INFO | (Host_getRegister(TWSR) & HOST_TWI_PRESCALER_MASK));
+		return;
+	}
+
+	if(twcr & (1 << TWSTA))
+	{
+		status = (g_state == HOST_TWI_IDLE) ? HOST_TWI_START : HOST_TWI_REP_START;
+		g_state = HOST_TWI_STARTED;
+	}
+	else if(g_state == HOST_TWI_STARTED)
+	{
+		/* SLA+R/W */
+		g_slave = NULL;
+		for(i = 0; i < g_numOfDevices; i++)
+		{
+			if(((data >> 1) >= g_devices[i]->address) &&
+					((data >> 1) < g_devices[i]->address + g_devices[i]->num_of_addresses))
+			{
+				g_slave = g_devices[i];
+			}
+		}
+		ack = ((g_slave != NULL) && (g_slave->start(data >> 1, data & 1) == TRUE)) ? TRUE : FALSE;
+		if(data & 1)
+		{
+			status = (ack == TRUE) ? HOST_TWI_MR_SLA_R_ACK : HOST_TWI_MR_SLA_R_NACK;
+			g_state = (ack == TRUE) ? HOST_TWI_RECEIVER : HOST_TWI_NOT_ADDRESSED;
+		}
+		else
+		{
+			status = (ack == TRUE) ? HOST_TWI_MT_SLA_W_ACK : HOST_TWI_MT_SLA_W_NACK;
+			g_state = (ack == TRUE) ? HOST_TWI_TRANSMITTER : HOST_TWI_NOT_ADDRESSED;
+		}
+	}
+	else if(g_state == HOST_TWI_TRANSMITTER)
+	{
+		ack = g_slave->write(data);
+		status = (ack == TRUE) ? HOST_TWI_MT_DATA_ACK : HOST_TWI_MT_DATA_NACK;
+	}
+	else if(g_state == HOST_TWI_RECEIVER)
+	{
+		ack = (twcr & (1 << TWEA)) ? TRUE : FALSE;
+		Host_setRegister(TWDR, g_slave->read(ack));
+		status = (ack == TRUE) ? HOST_TWI_MR_DATA_ACK : HOST_TWI_MR_DATA_NACK;
+	}
+
+	Host_setRegister(TWSR, status | (Host_getRegister(TWSR) & HOST_TWI_PRESCALER_MASK));
+	Host_setRegister(TWCR, twcr | (1 << TWINT));
+}
+
+/*
+ * Description :
+ * SCL period: (16 + 2 * TWBR * 4^TWPS) CPU cycles.
+ */
+static uint64 Host_getTwiBitNs(void)
+{
+	uint8 prescaler = Host_getRegister(TWSR) & HOST_TWI_PRESCALER_MASK;
+
+	return (16 + 2ULL * Host_getRegister(TWBR) * (1 << (2 * prescaler))) * HOST_CYCLE_NS;
+}
+
+/*
+ * Description :
+ * TWCR write: TWINT is cleared by writing a one, which starts the next action.
+ */
+static void Host_writeTwcr(uint8 address, uint8 old_value, uint8 value)
+{
+	uint8 twint = old_value & (1 << TWINT);
+
+	if(!(value & (1 << TWEN)))
+	{
+		/* The TWI is switched off, the bus is released */
+		g_busy = FALSE;
+		g_state = HOST_TWI_IDLE;
+		g_slave = NULL;
+		Host_setRegister(address, value & ~(1 << TWINT));
+		return;
+	}
+
+	if(value & (1 << TWINT))
+	{
+		twint = 0;
+		g_busy = TRUE;
+		/* START: one bit time, STOP: one bit time, a byte and its ACK: 9 bit times */
+		g_remainingNs = Host_getTwiBitNs() * (((value & ((1 << TWSTA) | (1 << TWSTO))) != 0) ? 1 : 9);
+	}
+	Host_setRegister(address, (value & ~(1 << TWINT)) | twint);
+}
+
+/*
+ * Description :
+ * TWSR write: only the prescaler bits are writable.
+ */
+static void Host_writeTwsr(uint8 address, uint8 old_value, uint8 value)
+{
+	Host_setRegister(address, (old_value & ~HOST_TWI_PRESCALER_MASK) | (value & HOST_TWI_PRESCALER_MASK));
+}
@@ -0,0 +1,359 @@
+ /******************************************************************************
+ *
+ * Module: Host UART
+ *
+ * File Name: host_uart.c
+ *
+ * Description: Model of the ATmega32 USART in asynchronous mode. The frames take
+ *              the time of the configured baud rate and frame format. The sent
+ *              bytes are written to a file descriptor, the received bytes are
+ *              read from a file descriptor (non-blocking) or injected by the
+ *              program. UDR has the 2 bytes receive FIFO and the transmit buffer
+ *              of the hardware, a byte received with the FIFO full sets DOR and
+ *              is lost. The receiver stops in the deep sleep modes.
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#define HOST_REGISTER_ADDRESSES
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "host.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define HOST_UART_RX_FIFO_SIZE         2
+#define HOST_UART_INPUT_SIZE           256
+
+/* Period of the input file descriptor polling, well below a frame at 115200 baud */
+#define HOST_UART_POLL_NS              20000ULL
+
+/* Bits of UCSRA written by the hardware only */
+#define HOST_UART_STATUS_BITS          ((1 << RXC) | (1 << UDRE) | (1 << FE) | (1 << DOR) | (1 << PE))
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static void Host_advanceUart(uint64 elapsed_ns);
+static uint64 Host_getFrameNs(void);
+static boolean Host_getInput(uint8 *data);
+static uint8 Host_readUdr(uint8 address, uint8 value);
+static void Host_writeUdr(uint8 address, uint8 old_value, uint8 value);
+static void Host_writeUcsra(uint8 address, uint8 old_value, uint8 value);
+static uint8 Host_readUcsrc(uint8 address, uint8 value);
+static void Host_writeUcsrc(uint8 address, uint8 old_value, uint8 value);
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+static int g_inFd = -1;
+static int g_outFd = -1;
+static void (*g_txCallBackPtr)(uint8 data) = NULL;
+
+/* UBRRH and UCSRC share the 0x40 address */
+static uint8 g_ubrrh = 0;
+static uint8 g_ucsrc = (1 << URSEL) | (1 << UCSZ1) | (1 << UCSZ0);
+
+/* Transmitter: shift register and UDR buffer */
+static boolean g_txShifting = FALSE;
+static uint8 g_txShift = 0;
+static boolean g_txBuffered = FALSE;
+static uint8 g_txBuffer = 0;
+static uint64 g_txRemainingNs = 0;
+
+/* Receiver: FIFO read through UDR, and the bytes waiting on the line */
+static uint8 g_rxFifo[HOST_UART_RX_FIFO_SIZE];
+static uint8 g_rxCount = 0;
+static boolean g_rxReceiving = FALSE;
+static uint8 g_rxShift = 0;
+static uint64 g_rxRemainingNs = 0;
+static uint64 g_rxIdleNs = 0;
+static uint8 g_input[HOST_UART_INPUT_SIZE];
+static uint16 g_inputHead = 0;
+static uint16 g_inputCount = 0;
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Attach the UART model, the sent bytes go to out_fd and the received bytes come
+ * from in_fd (-1 for none).
+ */
+void Host_initUart(int in_fd, int out_fd)
+{
+	g_inFd = in_fd;
+	g_outFd = out_fd;
+	if(in_fd >= 0)
+	{
+		fcntl(in_fd, F_SETFL, fcntl(in_fd, F_GETFL) | O_NONBLOCK);
+	}
+
+	g_txShifting = FALSE;
+	g_txBuffered = FALSE;
+	g_rxCount = 0;
+	g_rxReceiving = FALSE;
+	g_inputCount = 0;
+	g_ubrrh = 0;
+	g_ucsrc = (1 << URSEL) | (1 << UCSZ1) | (1 << UCSZ0);
+	Host_setRegister(UCSRA, (1 << UDRE));
+
+	Host_setReadHook(UDR, Host_readUdr);
+	Host_setWriteHook(UDR, Host_writeUdr);
+	Host_setWriteHook(UCSRA, Host_writeUcsra);
+	Host_setReadHook(UCSRC, Host_readUcsrc);
+	Host_setWriteHook(UCSRC, Host_writeUcsrc);
+	Host_addDevice(Host_advanceUart);
+}
+
+/*
+ * Description :
+ * Set the function called with each byte sent, after it is written to out_fd.
+ */
+void Host_setUartTxCallBack(void (*a_ptr)(uint8 data))
+{
+	g_txCallBackPtr = a_ptr;
+}
+
+/*
+ * Description :
+ * Queue a byte on the receive line, it is received after the bytes already queued.
+ */
+void Host_injectUart(uint8 data)
+{
+	if(g_inputCount < HOST_UART_INPUT_SIZE)
+	{
+		g_input[(g_inputHead + g_inputCount) % HOST_UART_INPUT_SIZE] = data;
+		g_inputCount++;
+	}
+}
+
+/*******************************************************************************
+ *                      Private Functions Definitions                          *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Shift the frames, one byte is sent and one byte can be received per frame time.
+ */
+static void Host_advanceUart(uint64 elapsed_ns)
+{
+	uint8 ucsra = Host_getRegister(UCSRA);
+	uint8 ucsrb = Host_getRegister(UCSRB);
+
+	if(g_txShifting == TRUE)
+	{
+		if(g_txRemainingNs > elapsed_ns)
+		{
+			g_txRemainingNs -= elapsed_ns;
+		}
+		else
+		{
+			if(g_outFd >= 0)
+			{
+				if(write(g_outFd, &g_txShift, 1) != 1)
+				{
+					g_outFd = -1; /* The other side is gone, the line is not connected anymore */
+				}
+			}
+			if(g_txCallBackPtr != NULL)
+			{
+				g_txCallBackPtr(g_txShift);
+			}
+			if(g_txBuffered == TRUE)
+			{
+				g_txShift = g_txBuffer;
+				g_txBuffered = FALSE;
+				g_txRemainingNs = Host_getFrameNs();
+				ucsra |= (1 << UDRE);
+			}
+			else
+			{
+				g_txShifting = FALSE;
+				ucsra |= (1 << TXC);
+			}
+		}
+	}
+
+	/* The start bit is not detected without the I/O clock */
+	if((ucsrb & (1 << RXEN)) && (Host_isClockStopped() == FALSE))
+	{
+		if(g_rxReceiving == FALSE)
+		{
+			/* The line is polled every HOST_UART_POLL_NS while it is idle */
+			g_rxIdleNs += elapsed_ns;
+			if((g_rxIdleNs >= HOST_UART_POLL_NS) && (Host_getInput(&g_rxShift) == TRUE))
+			{
+				g_rxReceiving = TRUE;
+				g_rxRemainingNs = Host_getFrameNs();
+			}
+			if(g_rxIdleNs >= HOST_UART_POLL_NS)
+			{
+				g_rxIdleNs = 0;
+			}
+		}
+		else
+		{
+			if(g_rxRemainingNs > elapsed_ns)
+			{
+				g_rxRemainingNs -= elapsed_ns;
+			}
+			else
+			{
+				/* Stop bit received */
+				g_rxReceiving = FALSE;
+				if(g_rxCount < HOST_UART_RX_FIFO_SIZE)
+				{
+					g_rxFifo[g_rxCount++] = g_rxShift;
+					ucsra |= (1 << RXC);
+				}
+				else
+				{
+					ucsra |= (1 << DOR);
+				}
+			}
+		}
+	}
+
+	Host_setRegister(UCSRA, ucsra);
+}
+
+/*
+ * Description :
+ * Time of a frame: start bit, data bits, parity bit and stop bits at the UBRR baud rate.
+ */
+static uint64 Host_getFrameNs(void)
+{
+	uint16 ubrr = ((g_ubrrh & 0x0F) << 8) | Host_getRegister(UBRRL);
+	uint8 divider = (Host_getRegister(UCSRA) & (1 << U2X)) ? 8 : 16;
+	uint8 data_bits = (Host_getRegister(UCSRB) & (1 << UCSZ2)) ? 9 : (5 + ((g_ucsrc >> UCSZ0) & 0x03));
+	uint8 bits = 1 + data_bits + ((g_ucsrc & (1 << UPM1)) ? 1 : 0) + ((g_ucsrc & (1 << USBS)) ? 2 : 1);
+
+	return (uint64)bits * divider * (ubrr + 1) * HOST_CYCLE_NS;
+}
+
+/*
+ * Description :
+ * Next byte of the receive line: the injected bytes, then the input file descriptor.
+ */
+static boolean Host_getInput(uint8 *data)
+{
+	if(g_inputCount > 0)
+	{
+		*data = g_input[g_inputHead];
+		g_inputHead = (g_inputHead + 1) % HOST_UART_INPUT_SIZE;
+		g_inputCount--;
+		return TRUE;
+	}
+	if((g_inFd >= 0) && (read(g_inFd, data, 1) == 1))
+	{
+		return TRUE;
+	}
+	return FALSE;
+}
+
+/*
+ * Description :
+ * UDR read: the oldest received byte, RXC is cleared when the FIFO is empty.
+ */
+static uint8 Host_readUdr(uint8 address, uint8 value)
+{
+	uint8 ucsra = Host_getRegister(UCSRA);
+
+	(void)address;
+	if(g_rxCount > 0)
+	{
+		value = g_rxFifo[0];
+		g_rxFifo[0] = g_rxFifo[1];
+		g_rxCount--;
+	}
+	if(g_rxCount == 0)
+	{
+		ucsra &= ~((1 << RXC) | (1 << DOR));
+	}
+	Host_setRegister(UCSRA, ucsra);
+
+	return value;
+}
+
+/*
+ * Description :
+ * UDR write: the byte goes to the shift register if it is free, else to the buffer.
+ */
+static void Host_writeUdr(uint8 address, uint8 old_value, uint8 value)
+{
+	uint8 ucsra = Host_getRegister(UCSRA);
+
+	(void)address;
+	(void)old_value;
+	if(!(Host_getRegister(UCSRB) & (1 << TXEN)) || !(ucsra & (1 << UDRE)))
+	{
+		return; /* Lost, as on the hardware */
+	}
+
+	if(g_txShifting == FALSE)
+	{
+		g_txShifting = TRUE;
+		g_txShift = value;
+		g_txRemainingNs = Host_getFrameNs();
+	}
+	else
+	{
+		g_txBuffered = TRUE;
+		g_txBuffer = value;
+		ucsra &= ~(1 << UDRE);
+	}
+	Host_setRegister(UCSRA, ucsra);
+}
+
+/*
+ * Description :
+ * UCSRA write: the status bits are read only and TXC is cleared by writing a one.
+ */
+static void Host_writeUcsra(uint8 address, uint8 old_value, uint8 value)
+{
+	uint8 status = old_value & HOST_UART_STATUS_BITS;
+
+	if(!(value & (1 << TXC)))
+	{
+		status |= old_value & (1 << TXC);
+	}
+	Host_setRegister(address, status | (value & ((1 << U2X) | (1 << MPCM))));
+}
+
+/*
+ * Description :
+ * 0x40 read: UBRRH, UCSRC is only read by two reads in a row (not modeled).
+ */
+static uint8 Host_readUcsrc(uint8 address, uint8 value)
+{
+	(void)address;
+	(void)value;
+	return g_ubrrh;
+}
+
+/*
+ * Description :
+ * 0x40 write: URSEL selects UCSRC or UBRRH.
+ */
+static void Host_writeUcsrc(uint8 address, uint8 old_value, uint8 value)
+{
+	(void)address;
+	(void)old_value;
+	if(value & (1 << URSEL))
+	{
+		g_ucsrc = value;
+	}
+	else
+	{
+		g_ubrrh = value & 0x0F;
+	}
+}
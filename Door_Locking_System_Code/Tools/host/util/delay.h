@@ -0,0 +1,22 @@
+ /******************************************************************************
+ *
+ * Module: Host AVR
+ *
+ * File Name: delay.h
+ *
+ * Description: Host replacement of <util/delay.h>, the delays advance the
+ *              virtual time instead of waiting.
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#ifndef HOST_UTIL_DELAY_H_
+#define HOST_UTIL_DELAY_H_
+
+#include "host.h"
+
+#define _delay_us(us)                  Host_advanceNs((uint64)((us) * 1000.0))
+#define _delay_ms(ms)                  Host_advanceNs((uint64)((ms) * 1000000.0))
+
+#endif /* HOST_UTIL_DELAY_H_ */
@@ -0,0 +1,209 @@
+ /******************************************************************************
+ *
+ * Module: Kernel Bench
+ *
+ * File Name: kernel_bench.c
+ *
+ * Description: Runs the Control ECU kernel (LIB/kernel.c) unchanged on the host,
+ *              with the SysTime and timer drivers on the register model of
+ *              Tools/host, and measures its context switch path:
+ *
+ *              - semaphore ping-pong: a high priority task and a lower one give
+ *                each other a semaphore, two switches per round. No register is
+ *                accessed so no tick comes in between. The real time of a switch
+ *                of the host build (ucontext) is printed.
+ *              - tick preemption: the high priority task waits one tick while a
+ *                low priority task keeps the CPU busy, and must be switched in by
+ *                the Timer1 tick exactly one tick later, every time.
+ *
+ *              The host numbers are not the ATmega32 ones. There the save and
+ *              restore of Kernel_switchContext take 164 cycles (20.5 us at 8 MHz)
+ *              counted from the instruction timings, plus Kernel_selectNextTask;
+ *              KERNEL_SWITCH_TRACE_ENABLE gives the whole tick to task pulse on a
+ *              pin for a simulator or a scope.
+ *
+ *              Build from Door_Locking_System_Code:
+ *
+ *              gcc -std=gnu99 -O2 -funsigned-char -DF_CPU=8000000UL -DTRACE_ENABLE=0 \
+ *                  -ITools/host -IControl_ECU/MCAL -IControl_ECU/LIB -IControl_ECU/Main \
+ *                  Tools/kernel_bench/kernel_bench.c Control_ECU/LIB/kernel.c \
+ *                  Control_ECU/LIB/systime.c Control_ECU/MCAL/timer.c \
+ *                  Tools/host/host.c Tools/host/host_timer.c -o kernel_bench
+ *
+ *              ./kernel_bench [rounds] [ticks]
+ *
+ *              The exit status is 1 if a switch did not happen as expected.
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#define HOST_REGISTER_ADDRESSES
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "host.h"
+#include "systime.h"
+#include "kernel.h"
+#include <avr/interrupt.h>
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define BENCH_DEFAULT_ROUNDS           1000000UL
+#define BENCH_DEFAULT_TICKS            1000UL
+
+#define BENCH_HIGH_PRIORITY            0
+#define BENCH_LOW_PRIORITY             1
+#define BENCH_BUSY_PRIORITY            2
+
+/* Not used by the host build of the kernel, which runs the tasks on host stacks */
+#define BENCH_STACK_SIZE               KERNEL_MIN_STACK_SIZE
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static void Bench_highTask(void);
+static void Bench_lowTask(void);
+static void Bench_busyTask(void);
+static float64 Bench_seconds(const struct timespec *start);
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+static Kernel_TaskType g_highTask, g_lowTask, g_busyTask;
+static uint8 g_highStack[BENCH_STACK_SIZE];
+static uint8 g_lowStack[BENCH_STACK_SIZE];
+static uint8 g_busyStack[BENCH_STACK_SIZE];
+
+static Kernel_SemaphoreType g_highSem, g_lowSem;
+
+static unsigned long g_rounds = BENCH_DEFAULT_ROUNDS;
+static unsigned long g_ticks = BENCH_DEFAULT_TICKS;
+
+/* Rounds seen by the low priority task, loops of the busy task */
+static volatile unsigned long g_lowRounds = 0;
+static volatile unsigned long g_busyLoops = 0;
+
+static unsigned long g_failures = 0;
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+int main(int argc, char *argv[])
+{
+	if(argc > 3)
+	{
+		fprintf(stderr, "usage: %s [rounds] [ticks]\n", argv[0]);
+		return 2;
+	}
+	if(argc > 1)
+	{
+		g_rounds = strtoul(argv[1], NULL, 10);
+	}
+	if(argc > 2)
+	{
+		g_ticks = strtoul(argv[2], NULL, 10);
+	}
+
+	Host_init();
+	Host_initTimers();
+	SysTime_init();
+
+	Kernel_semInit(&g_highSem, 0);
+	Kernel_semInit(&g_lowSem, 0);
+	Kernel_createTask(&g_highTask, Bench_highTask, BENCH_HIGH_PRIORITY, g_highStack, BENCH_STACK_SIZE);
+	Kernel_createTask(&g_lowTask, Bench_lowTask, BENCH_LOW_PRIORITY, g_lowStack, BENCH_STACK_SIZE);
+	Kernel_createTask(&g_busyTask, Bench_busyTask, BENCH_BUSY_PRIORITY, g_busyStack, BENCH_STACK_SIZE);
+	sei();
+	Kernel_start();
+
+	return 2;
+}
+
+/*******************************************************************************
+ *                      Private Functions Definitions                          *
+ *******************************************************************************/
+
+/* Runs both measurements, then ends the program */
+static void Bench_highTask(void)
+{
+	struct timespec start;
+	float64 seconds;
+	unsigned long i;
+	uint32 tick;
+	unsigned long busy_loops;
+
+	/* Ping-pong: taking the empty semaphore switches to the low task, its give switches back */
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(i = 0; i < g_rounds; i++)
+	{
+		Kernel_semGive(&g_lowSem);
+		Kernel_semTake(&g_highSem, KERNEL_WAIT_FOREVER);
+	}
+	seconds = Bench_seconds(&start);
+	if(g_lowRounds != g_rounds)
+	{
+		fprintf(stderr, "ping-pong: the low task ran %lu rounds of %lu\n", (unsigned long)g_lowRounds, g_rounds);
+		g_failures++;
+	}
+	printf("ping-pong: %lu switches in %.3f s, %.0f ns per switch\n", 2 * g_rounds, seconds,
+			(g_rounds > 0) ? seconds * 1e9 / (2 * g_rounds) : 0.0);
+
+	/* Tick preemption: the busy task runs until the tick switches this task in again */
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(i = 0; i < g_ticks; i++)
+	{
+		tick = SysTime_getTicks();
+		busy_loops = g_busyLoops;
+		Kernel_delay(1);
+		if((SysTime_getTicks() != tick + 1) || (g_busyLoops == busy_loops))
+		{
+			if(g_failures < 10)
+			{
+				fprintf(stderr, "tick %lu: woken at tick %lu, busy task loops %lu\n", (unsigned long)tick,
+						(unsigned long)SysTime_getTicks(), (unsigned long)(g_busyLoops - busy_loops));
+			}
+			g_failures++;
+		}
+	}
+	seconds = Bench_seconds(&start);
+	printf("tick preemption: %lu wakes in %.3f s (%.1f s of virtual time)\n", g_ticks, seconds,
+			Host_now() / 1e9);
+
+	printf("%lu failures\n", g_failures);
+	exit((g_failures != 0) ? 1 : 0);
+}
+
+static void Bench_lowTask(void)
+{
+	while(1)
+	{
+		Kernel_semTake(&g_lowSem, KERNEL_WAIT_FOREVER);
+		g_lowRounds++;
+		Kernel_semGive(&g_highSem);
+	}
+}
+
+/* Never blocks: the code that a tick preempts, one host step a loop */
+static void Bench_busyTask(void)
+{
+	while(1)
+	{
+		g_busyLoops++;
+		Host_advanceNs(HOST_STEP_NS);
+	}
+}
+
+static float64 Bench_seconds(const struct timespec *start)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
@@ -0,0 +1,249 @@
+#!/usr/bin/env python3
+"""
+Format the statistics sent by both ECUs after a STATS_SNAPSHOT_COMMAND
+byte ('*' in the HMI main options): the latency histograms of the Control
+ECU (LIB/histogram.c) and the statistics lines of each ECU (LIB/trace.c
+Trace_sendValue), the time spent in each state and the transitions taken,
+the time spent in each sleep mode and the stack watermarks of the Control
+ECU tasks.
+
+    latency_report.py control.log [hmi.log]
+
+The inputs are raw captures of each ECU TX line. Trace lines and protocol
+bytes are ignored. If a capture holds several snapshots, the last one of
+each histogram and value is reported.
+
+Percentiles are given as the upper limit of the bucket holding them, so
+they are rounded up by at most one bucket (x2.15 with 3 buckets/decade).
+The motor peak current histogram holds mA instead of times. The exit
+status is 1 if a task stack has less than KERNEL_STACK_MARGIN bytes never
+used: its budget in Main/main.c and LIB/kernel.h is wrong.
+"""
+
+import argparse
+import re
+import sys
+
+# SysTime_now() resolution, Timer1 at F_CPU/256 with F_CPU = 8MHz
+US_PER_COUNT = 32
+
+# Keep in sync with LIB/histogram.h
+BUCKETS_PER_DECADE = 3
+DECADES = 6
+LIMITS = [round(10 ** ((i + 1) / BUCKETS_PER_DECADE))
+          for i in range(BUCKETS_PER_DECADE * DECADES)]
+
+# Keep in sync with Application_LatencyType in Main/main.c
+NAMES = [
+    "receive", "eeprom read", "compare", "reply", "submit -> result",
+    "open -> motor start", "door travel", "pir clear", "motor peak current",
+]
+
+# Histograms that are not times, by id: unit of their values
+UNITS = {8: "mA"}
+
+# Keep in sync with DoorCore_StateType/DoorCore_EventType in Control_ECU/Main/door_core.h
+# and with Application_StepType/Application_EventType in HMI_ECU/Main/main.c
+STATES = {
+    "C": ["NO_STATE", "NEW_PASSWARD", "LOCKED", "RETRY", "CHOICE", "OPENING",
+          "HOLDING", "CLEARING", "CLOSING", "LOCKOUT"],
+    "H": ["NO_STEP", "CREATE_SYSTEM_PASSWARD", "CHECK_PASSWARD", "MAIN_OPTIONS",
+          "VERIFY_OPEN_DOOR", "VERIFY_CHANGE_PASS", "RETRY_PASSWARD", "OPEN_DOOR",
+          "WAIT_PEOPLE", "CLOSE_DOOR", "SYSTEM_LOCKED"],
+}
+EVENTS = {
+    "C": ["PASS_MATCH", "PASS_MISMATCH", "RETRIES_EXHAUSTED", "OPEN_CHOICE",
+          "CHANGE_CHOICE", "INVALID_CHOICE", "TIME_ELAPSED", "NO_MOTION",
+          "END_REACHED", "TRAVEL_TIMEOUT", "STALL"],
+    "H": ["PASSWARDS_SENT", "PASS_MATCH", "PASS_MISMATCH", "RETRIES_EXHAUSTED",
+          "OPEN_CHOICE", "CHANGE_CHOICE", "TICK", "DOOR_CLEAR", "DOOR_OPENED",
+          "DOOR_CLOSED", "DOOR_FAULT", "DOOR_OBSTRUCTED"],
+}
+ECU_NAMES = {"C": "Control_ECU", "H": "HMI_ECU"}
+
+# Tasks by priority, keep in sync with Control_ECU/Main/main.c and LIB/kernel.c
+TASKS = {1: "door task", 2: "link task", 0xFF: "idle task"}
+
+# Keep in sync with Control_ECU/LIB/kernel.h
+KERNEL_STACK_MARGIN = 16
+
+# Keep in sync with Trace_ValueType in LIB/trace.h
+STATE_TIME, STATE_ENTRIES, TRANSITIONS, STACK_UNUSED, POWER_TIME, POWER_COUNT = range(6)
+
+# Keep in sync with Trace_PowerType in LIB/trace.h
+POWER_TOTAL, POWER_IDLE, POWER_DOWN = range(3)
+
+SUMMARY = re.compile(rb"S([0-9A-F]{2})([0-9A-F]{4})([0-9A-F]{8})([0-9A-F]{8})\n")
+BUCKET = re.compile(rb"B([0-9A-F]{2})([0-9A-F]{2})([0-9A-F]{4})\n")
+VALUE = re.compile(rb"V([CH])([0-9A-F]{2})([0-9A-F]{4})([0-9A-F]{8})\n")
+
+
+def parse(data):
+    histograms = {}
+    for match in re.finditer(SUMMARY.pattern + rb"|" + BUCKET.pattern, data):
+        if match.group(0).startswith(b"S"):
+            hist_id = int(match.group(1), 16)
+            histograms[hist_id] = {
+                "count": int(match.group(2), 16),
+                "min": int(match.group(3), 16),
+                "max": int(match.group(4), 16),
+                "buckets": {},
+            }
+        else:
+            hist_id = int(match.group(5), 16)
+            if hist_id in histograms:
+                histograms[hist_id]["buckets"][int(match.group(6), 16)] = int(match.group(7), 16)
+    return histograms
+
+
+def parse_values(data, values):
+    """Add the statistics lines of a capture to values[source][kind][id]."""
+    for match in VALUE.finditer(data):
+        source = match.group(1).decode()
+        kind = int(match.group(2), 16)
+        values.setdefault(source, {}).setdefault(kind, {})[int(match.group(3), 16)] = int(match.group(4), 16)
+
+
+def name_of(table, index):
+    return table[index] if index < len(table) else str(index)
+
+
+def ms_text(ms):
+    if ms >= 60000:
+        return "%.1f min" % (ms / 60000)
+    if ms >= 1000:
+        return "%.2f s" % (ms / 1e3)
+    return "%d ms" % ms
+
+
+def print_histograms(histograms):
+    print("%-22s %7s %10s %10s %10s %10s" % ("latency", "count", "min", "p50", "p99", "max"))
+    for hist_id in sorted(histograms):
+        histogram = histograms[hist_id]
+        name = NAMES[hist_id] if hist_id < len(NAMES) else str(hist_id)
+        empty = histogram["count"] == 0
+        print("%-22s %7d %10s %10s %10s %10s" % (
+            name, histogram["count"],
+            "-" if empty else value_text(hist_id, histogram["min"]),
+            value_text(hist_id, percentile(histogram, 0.50)),
+            value_text(hist_id, percentile(histogram, 0.99)),
+            "-" if empty else value_text(hist_id, histogram["max"])))
+
+
+def print_states(source, values):
+    states = STATES.get(source, [])
+    events = EVENTS.get(source, [])
+    times = values.get(STATE_TIME, {})
+    entries = values.get(STATE_ENTRIES, {})
+    if not times and not entries:
+        return
+    total = sum(times.values())
+
+    print("\n%-34s %7s %10s %6s" % (ECU_NAMES.get(source, source) + " state", "entries", "time", "share"))
+    for state in sorted(set(times) | set(entries)):
+        time = times.get(state, 0)
+        print("%-34s %7d %10s %5.1f%%" % (name_of(states, state), entries.get(state, 0), ms_text(time),
+                                          100.0 * time / total if total else 0.0))
+
+    transitions = values.get(TRANSITIONS, {})
+    if transitions and events:
+        print("%-46s %7s" % ("transition", "count"))
+        for cell in sorted(transitions):
+            state, event = divmod(cell, len(events))
+            print("%-46s %7d" % ("%s --%s-->" % (name_of(states, state), name_of(events, event)),
+                                 transitions[cell]))
+
+
+def print_power(source, values):
+    times = values.get(POWER_TIME, {})
+    counts = values.get(POWER_COUNT, {})
+    total = times.get(POWER_TOTAL, 0)
+    if not times:
+        return
+    awake = total - times.get(POWER_IDLE, 0) - times.get(POWER_DOWN, 0)
+
+    print("\n%-34s %7s %10s %6s" % (ECU_NAMES.get(source, source) + " power", "sleeps", "time", "share"))
+    for name, time, count in (("running", awake, None),
+                              ("idle", times.get(POWER_IDLE, 0), counts.get(POWER_IDLE, 0)),
+                              ("power-down", times.get(POWER_DOWN, 0), counts.get(POWER_DOWN, 0))):
+        print("%-34s %7s %10s %5.1f%%" % (name, "-" if count is None else count, ms_text(time),
+                                          100.0 * time / total if total else 0.0))
+    print("%-34s %7s %10s" % ("total", "", ms_text(total)))
+
+
+def print_stacks(source, values):
+    """Print the stack watermarks, return False if one is under the margin."""
+    stacks = values.get(STACK_UNUSED, {})
+    if not stacks:
+        return True
+    print("\n%-34s %7s" % (ECU_NAMES.get(source, source) + " stack", "unused"))
+    for priority in sorted(stacks):
+        low = stacks[priority] < KERNEL_STACK_MARGIN
+        print("%-34s %7d%s" % (TASKS.get(priority, "priority %d" % priority), stacks[priority],
+                               "  under the %d bytes margin" % KERNEL_STACK_MARGIN if low else ""))
+    return all(unused >= KERNEL_STACK_MARGIN for unused in stacks.values())
+
+
+def percentile(histogram, fraction):
+    total = sum(histogram["buckets"].values())
+    if total == 0:
+        return None
+    rank = fraction * total
+    seen = 0
+    for bucket in sorted(histogram["buckets"]):
+        seen += histogram["buckets"][bucket]
+        if seen >= rank:
+            if bucket < len(LIMITS):
+                return min(LIMITS[bucket], histogram["max"])
+            return histogram["max"]
+    return histogram["max"]
+
+
+def time_text(counts):
+    if counts is None:
+        return "-"
+    us = counts * US_PER_COUNT
+    if us >= 1000000:
+        return "%.2f s" % (us / 1e6)
+    if us >= 1000:
+        return "%.1f ms" % (us / 1e3)
+    return "%d us" % us
+
+
+def value_text(hist_id, value):
+    if hist_id not in UNITS:
+        return time_text(value)
+    if value is None:
+        return "-"
+    return "%d %s" % (value, UNITS[hist_id])
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("captures", nargs="+", help="raw UART captures of the ECUs")
+    args = parser.parse_args()
+
+    histograms = {}
+    values = {}
+    for path in args.captures:
+        with open(path, "rb") as capture:
+            data = capture.read()
+        histograms.update(parse(data))
+        parse_values(data, values)
+    if not histograms and not values:
+        sys.exit("no statistics found")
+
+    if histograms:
+        print_histograms(histograms)
+    stacks_ok = True
+    for source in sorted(values):
+        print_states(source, values[source])
+        print_power(source, values[source])
+        stacks_ok = print_stacks(source, values[source]) and stacks_ok
+    if not stacks_ok:
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
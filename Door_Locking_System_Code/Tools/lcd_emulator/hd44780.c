@@ -0,0 +1,357 @@
+ /******************************************************************************
+ *
+ * Module: HD44780
+ *
+ * File Name: hd44780.c
+ *
+ * Description: Source file for the host model of the HD44780 LCD controller.
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#include <stdio.h>
+#include "hd44780.h"
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static void HD44780_latch(HD44780_Type *lcd, uint8 rs, uint8 value, uint64 now_ns);
+static void HD44780_instruction(HD44780_Type *lcd, uint8 command, uint64 now_ns);
+static void HD44780_writeData(HD44780_Type *lcd, uint8 data, uint64 now_ns);
+static void HD44780_moveAddress(HD44780_Type *lcd, boolean increment);
+static uint8 HD44780_ddramIndex(uint8 address);
+static void HD44780_violation(HD44780_Type *lcd, HD44780_ViolationType violation,
+		const char *text, uint64 now_ns);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Power on state: 8-bit interface, one line, display off, busy for HD44780_POWER_ON_NS.
+ */
+void HD44780_init(HD44780_Type *lcd)
+{
+	uint8 i;
+
+	for(i = 0; i < HD44780_DDRAM_SIZE; i++)
+	{
+		lcd->ddram[i] = ' ';
+	}
+	for(i = 0; i < HD44780_CGRAM_SIZE; i++)
+	{
+		lcd->cgram[i] = 0;
+	}
+	lcd->address = 0;
+	lcd->cgram_selected = FALSE;
+	lcd->increment = TRUE;
+	lcd->shift = FALSE;
+	lcd->display_on = FALSE;
+	lcd->cursor_on = FALSE;
+	lcd->blink_on = FALSE;
+	lcd->display_shift = 0;
+	lcd->eight_bits = TRUE;
+	lcd->two_lines = FALSE;
+
+	lcd->e_level = LOGIC_LOW;
+	lcd->e_rise_ns = 0;
+	lcd->e_fall_ns = 0;
+	lcd->second_nibble = FALSE;
+	lcd->high_nibble = 0;
+	lcd->read_value = 0;
+	lcd->driving = FALSE;
+	lcd->busy_until_ns = HD44780_POWER_ON_NS;
+
+	lcd->write_cycles = 0;
+	lcd->read_cycles = 0;
+	lcd->instructions = 0;
+	lcd->characters = 0;
+	for(i = 0; i < HD44780_NUM_OF_VIOLATIONS; i++)
+	{
+		lcd->violations[i] = 0;
+	}
+	lcd->report_violations = TRUE;
+}
+
+/*
+ * Description :
+ * Sample the bus pins at time now_ns. data holds DB0..DB7 (DB4..DB7 only in 4-bit mode).
+ * The model acts on the E edges, it can be called as often as the pins change.
+ */
+void HD44780_setPins(HD44780_Type *lcd, uint8 rs, uint8 rw, uint8 e, uint8 data, uint64 now_ns)
+{
+	uint8 value;
+
+	if((e == LOGIC_HIGH) && (lcd->e_level == LOGIC_LOW))
+	{
+		/* Rising edge, a read cycle puts the busy flag and the address counter on the bus */
+		lcd->e_rise_ns = now_ns;
+		if((rw == LOGIC_HIGH) && (rs == LOGIC_LOW))
+		{
+			value = ((now_ns < lcd->busy_until_ns) ? 0x80 : 0x00) | (lcd->address & 0x7F);
+			if((lcd->eight_bits == FALSE) && (lcd->second_nibble == TRUE))
+			{
+				value = (uint8)(lcd->read_value << 4);
+			}
+			lcd->read_value = value;
+			lcd->driving = TRUE;
+		}
+	}
+	else if((e == LOGIC_LOW) && (lcd->e_level == LOGIC_HIGH))
+	{
+		/* Falling edge, the data is latched */
+		if((now_ns - lcd->e_rise_ns) < HD44780_E_PULSE_WIDTH_NS)
+		{
+			HD44780_violation(lcd, HD44780_VIOLATION_E_PULSE, "E pulse shorter than 230ns", now_ns);
+		}
+		if((lcd->e_fall_ns != 0) && ((now_ns - lcd->e_fall_ns) < HD44780_E_CYCLE_NS))
+		{
+			HD44780_violation(lcd, HD44780_VIOLATION_E_CYCLE, "E cycle shorter than 500ns", now_ns);
+		}
+		lcd->e_fall_ns = now_ns;
+		lcd->driving = FALSE;
+
+		if(rw == LOGIC_HIGH)
+		{
+			lcd->read_cycles++;
+			if(lcd->eight_bits == FALSE)
+			{
+				lcd->second_nibble = !lcd->second_nibble;
+			}
+		}
+		else
+		{
+			lcd->write_cycles++;
+			if(lcd->eight_bits == TRUE)
+			{
+				HD44780_latch(lcd, rs, data, now_ns);
+			}
+			else if(lcd->second_nibble == FALSE)
+			{
+				if(now_ns < lcd->busy_until_ns)
+				{
+					HD44780_violation(lcd, HD44780_VIOLATION_BUSY, "high nibble written while busy", now_ns);
+				}
+				lcd->high_nibble = data & 0xF0;
+				lcd->second_nibble = TRUE;
+			}
+			else
+			{
+				lcd->second_nibble = FALSE;
+				HD44780_latch(lcd, rs, lcd->high_nibble | (data >> 4), now_ns);
+			}
+		}
+	}
+	lcd->e_level = e;
+}
+
+/*
+ * Description :
+ * Return TRUE while the LCD drives the data bus (read cycle), the driven byte is
+ * stored in data (DB0..DB7, the nibble being read in 4-bit mode is in DB4..DB7).
+ */
+boolean HD44780_getBus(const HD44780_Type *lcd, uint8 *data)
+{
+	*data = lcd->read_value;
+	return lcd->driving;
+}
+
+/*
+ * Description :
+ * Return the character code shown at a row and column of a rows x cols display,
+ * with the display shift applied. Returns ' ' when the display is off.
+ */
+uint8 HD44780_getCell(const HD44780_Type *lcd, uint8 rows, uint8 cols, uint8 row, uint8 col)
+{
+	uint8 line,position;
+
+	if((lcd->display_on == FALSE) || (row >= rows) || (col >= cols))
+	{
+		return ' ';
+	}
+
+	/* Rows 2 and 3 of a 4 rows display continue the two lines */
+	line = row & 1;
+	position = col + ((row & 2) ? cols : 0);
+	if((lcd->two_lines == FALSE) && (line == 1))
+	{
+		return ' ';
+	}
+	position = (position + lcd->display_shift) % HD44780_LINE_LENGTH;
+	return lcd->ddram[(line * HD44780_LINE_LENGTH) + position];
+}
+
+/*******************************************************************************
+ *                      Private Functions Definitions                          *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * A complete byte was written.
+ */
+static void HD44780_latch(HD44780_Type *lcd, uint8 rs, uint8 value, uint64 now_ns)
+{
+	if(now_ns < lcd->busy_until_ns)
+	{
+		HD44780_violation(lcd, HD44780_VIOLATION_BUSY,
+				(rs == LOGIC_HIGH) ? "character written while busy" : "instruction written while busy", now_ns);
+	}
+
+	if(rs == LOGIC_HIGH)
+	{
+		HD44780_writeData(lcd, value, now_ns);
+	}
+	else
+	{
+		HD44780_instruction(lcd, value, now_ns);
+	}
+}
+
+static void HD44780_instruction(HD44780_Type *lcd, uint8 command, uint64 now_ns)
+{
+	uint8 i;
+
+	lcd->instructions++;
+	lcd->busy_until_ns = now_ns + HD44780_EXECUTION_NS;
+
+	if(command & 0x80)
+	{
+		/* Set DDRAM address */
+		lcd->address = command & 0x7F;
+		lcd->cgram_selected = FALSE;
+	}
+	else if(command & 0x40)
+	{
+		/* Set CGRAM address */
+		lcd->address = command & 0x3F;
+		lcd->cgram_selected = TRUE;
+	}
+	else if(command & 0x20)
+	{
+		/* Function set, the 8-bit mode of the reset sequence ends a pending nibble */
+		lcd->eight_bits = (command & 0x10) ? TRUE : FALSE;
+		lcd->two_lines = (command & 0x08) ? TRUE : FALSE;
+		lcd->second_nibble = FALSE;
+	}
+	else if(command & 0x10)
+	{
+		/* Cursor or display shift */
+		if(command & 0x08)
+		{
+			lcd->display_shift = (command & 0x04) ?
+					((lcd->display_shift + HD44780_LINE_LENGTH - 1) % HD44780_LINE_LENGTH) :
+					((lcd->display_shift + 1) % HD44780_LINE_LENGTH);
+		}
+		else
+		{
+			HD44780_moveAddress(lcd, (command & 0x04) ? TRUE : FALSE);
+		}
+	}
+	else if(command & 0x08)
+	{
+		lcd->display_on = (command & 0x04) ? TRUE : FALSE;
+		lcd->cursor_on = (command & 0x02) ? TRUE : FALSE;
+		lcd->blink_on = (command & 0x01) ? TRUE : FALSE;
+	}
+	else if(command & 0x04)
+	{
+		lcd->increment = (command & 0x02) ? TRUE : FALSE;
+		lcd->shift = (command & 0x01) ? TRUE : FALSE;
+	}
+	else if(command & 0x02)
+	{
+		/* Return home */
+		lcd->address = 0;
+		lcd->cgram_selected = FALSE;
+		lcd->display_shift = 0;
+		lcd->busy_until_ns = now_ns + HD44780_CLEAR_EXECUTION_NS;
+	}
+	else if(command & 0x01)
+	{
+		/* Clear display */
+		for(i = 0; i < HD44780_DDRAM_SIZE; i++)
+		{
+			lcd->ddram[i] = ' ';
+		}
+		lcd->address = 0;
+		lcd->cgram_selected = FALSE;
+		lcd->display_shift = 0;
+		lcd->increment = TRUE;
+		lcd->busy_until_ns = now_ns + HD44780_CLEAR_EXECUTION_NS;
+	}
+}
+
+static void HD44780_writeData(HD44780_Type *lcd, uint8 data, uint64 now_ns)
+{
+	lcd->characters++;
+	lcd->busy_until_ns = now_ns + HD44780_EXECUTION_NS + HD44780_ADDRESS_UPDATE_NS;
+
+	if(lcd->cgram_selected == TRUE)
+	{
+		lcd->cgram[lcd->address & (HD44780_CGRAM_SIZE - 1)] = data & 0x1F;
+		lcd->address = (lcd->address + (lcd->increment ? 1 : -1)) & (HD44780_CGRAM_SIZE - 1);
+		return;
+	}
+
+	lcd->ddram[HD44780_ddramIndex(lcd->address)] = data;
+	HD44780_moveAddress(lcd, lcd->increment);
+	if(lcd->shift == TRUE)
+	{
+		lcd->display_shift = lcd->increment ?
+				((lcd->display_shift + 1) % HD44780_LINE_LENGTH) :
+				((lcd->display_shift + HD44780_LINE_LENGTH - 1) % HD44780_LINE_LENGTH);
+	}
+}
+
+/*
+ * Description :
+ * Move the DDRAM address counter by one, line 1 (0x00-0x27) wraps to line 2 (0x40-0x67)
+ * in two lines mode. The one line mode uses 0x00-0x4F.
+ */
+static void HD44780_moveAddress(HD44780_Type *lcd, boolean increment)
+{
+	uint8 address = lcd->address;
+
+	if(lcd->cgram_selected == TRUE)
+	{
+		lcd->address = (address + (increment ? 1 : -1)) & (HD44780_CGRAM_SIZE - 1);
+		return;
+	}
+
+	if(lcd->two_lines == FALSE)
+	{
+		address = increment ? ((address + 1) % HD44780_DDRAM_SIZE) :
+				((address + HD44780_DDRAM_SIZE - 1) % HD44780_DDRAM_SIZE);
+	}
+	else if(increment == TRUE)
+	{
+		address = (address == 0x27) ? 0x40 : ((address == 0x67) ? 0x00 : (address + 1));
+	}
+	else
+	{
+		address = (address == 0x40) ? 0x27 : ((address == 0x00) ? 0x67 : (address - 1));
+	}
+	lcd->address = address;
+}
+
+static uint8 HD44780_ddramIndex(uint8 address)
+{
+	if(address >= 0x40)
+	{
+		address = HD44780_LINE_LENGTH + ((address - 0x40) % HD44780_LINE_LENGTH);
+	}
+	return address % HD44780_DDRAM_SIZE;
+}
+
+static void HD44780_violation(HD44780_Type *lcd, HD44780_ViolationType violation,
+		const char *text, uint64 now_ns)
+{
+	lcd->violations[violation]++;
+	if(lcd->report_violations == TRUE)
+	{
+		fprintf(stderr, "HD44780 %10.3f ms: %s\n", now_ns / 1e6, text);
+	}
+}
@@ -0,0 +1,115 @@
+ /******************************************************************************
+ *
+ * Module: HD44780
+ *
+ * File Name: hd44780.h
+ *
+ * Description: Header file for the host model of the HD44780 LCD controller.
+ *              The model is fed the RS/RW/E/data pin levels with a time stamp,
+ *              decodes the bus cycles in 8-bit and 4-bit modes and keeps the
+ *              DDRAM, CGRAM, cursor and display state.
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#ifndef HD44780_H_
+#define HD44780_H_
+
+#include "std_types.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define HD44780_DDRAM_SIZE             80
+#define HD44780_CGRAM_SIZE             64
+#define HD44780_LINE_LENGTH            40
+
+/* Datasheet timings (fosc = 270kHz, VCC = 5V) in nanoseconds */
+#define HD44780_POWER_ON_NS            15000000ULL
+#define HD44780_EXECUTION_NS           37000ULL
+#define HD44780_CLEAR_EXECUTION_NS     1520000ULL
+#define HD44780_ADDRESS_UPDATE_NS      4000ULL
+#define HD44780_E_PULSE_WIDTH_NS       230ULL
+#define HD44780_E_CYCLE_NS             500ULL
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+typedef enum
+{
+	HD44780_VIOLATION_BUSY,            /* Write while an instruction is executing */
+	HD44780_VIOLATION_E_PULSE,         /* E high shorter than PWEH */
+	HD44780_VIOLATION_E_CYCLE,         /* E falling edges closer than tcycE */
+	HD44780_NUM_OF_VIOLATIONS
+}HD44780_ViolationType;
+
+typedef struct
+{
+	/* Memories and registers */
+	uint8 ddram[HD44780_DDRAM_SIZE];   /* Line 1 then line 2, 40 characters each */
+	uint8 cgram[HD44780_CGRAM_SIZE];
+	uint8 address;                     /* Address counter */
+	boolean cgram_selected;            /* The address counter points in the CGRAM */
+	boolean increment;                 /* Entry mode I/D */
+	boolean shift;                     /* Entry mode S */
+	boolean display_on;
+	boolean cursor_on;
+	boolean blink_on;
+	uint8 display_shift;               /* Display shift in characters (0..39) */
+	boolean eight_bits;                /* Function set DL */
+	boolean two_lines;                 /* Function set N */
+
+	/* Bus interface */
+	uint8 e_level;
+	uint64 e_rise_ns;
+	uint64 e_fall_ns;
+	boolean second_nibble;             /* 4-bit mode: the next cycle is the low nibble */
+	uint8 high_nibble;
+	uint8 read_value;                  /* Byte driven on the bus during a read */
+	boolean driving;                   /* TRUE while RW=1 and E=1 */
+	uint64 busy_until_ns;
+
+	/* Statistics */
+	uint32 write_cycles;               /* E falling edges with RW=0 */
+	uint32 read_cycles;                /* E falling edges with RW=1 */
+	uint32 instructions;
+	uint32 characters;
+	uint32 violations[HD44780_NUM_OF_VIOLATIONS];
+	boolean report_violations;         /* Print each violation on stderr */
+}HD44780_Type;
+
+/*******************************************************************************
+ *                              Functions Prototypes                           *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Power on state: 8-bit interface, one line, display off, busy for HD44780_POWER_ON_NS.
+ */
+void HD44780_init(HD44780_Type *lcd);
+
+/*
+ * Description :
+ * Sample the bus pins at time now_ns. data holds DB0..DB7 (DB4..DB7 only in 4-bit mode).
+ * The model acts on the E edges, it can be called as often as the pins change.
+ */
+void HD44780_setPins(HD44780_Type *lcd, uint8 rs, uint8 rw, uint8 e, uint8 data, uint64 now_ns);
+
+/*
+ * Description :
+ * Return TRUE while the LCD drives the data bus (read cycle), the driven byte is
+ * stored in data (DB0..DB7, the nibble being read in 4-bit mode is in DB4..DB7).
+ */
+boolean HD44780_getBus(const HD44780_Type *lcd, uint8 *data);
+
+/*
+ * Description :
+ * Return the character code shown at a row and column of a rows x cols display,
+ * with the display shift applied. Returns ' ' when the display is off.
+ */
+uint8 HD44780_getCell(const HD44780_Type *lcd, uint8 rows, uint8 cols, uint8 row, uint8 col);
+
+#endif /* HD44780_H_ */
@@ -0,0 +1,111 @@
+ /******************************************************************************
+ *
+ * Module: Host LCD
+ *
+ * File Name: host_lcd.c
+ *
+ * Description: HD44780 model wired on the virtual ports of the host core as
+ *              configured in lcd.h. The control and data pins are given to the
+ *              model after each PORT/DDR write, the model drives the data pins
+ *              during a read cycle.
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#include "host.h"
+#include "host_lcd.h"
+#include "gpio.h"
+#include "lcd.h"
+#include "common_macros.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#if (LCD_DATA_BITS_MODE == 4)
+/* DB0..DB3 are not connected */
+#define HOST_LCD_DATA_MASK             ((1 << LCD_DB4_PIN_ID) | (1 << LCD_DB5_PIN_ID) | \
+                                        (1 << LCD_DB6_PIN_ID) | (1 << LCD_DB7_PIN_ID))
+#else
+#define HOST_LCD_DATA_MASK             0xFF
+#endif
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static void Host_updateLcd(void);
+static uint8 Host_driveLcdBus(uint8 port_num, uint8 levels);
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+HD44780_Type Host_lcd;
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Power on the LCD model and connect it on the ports, after Host_init.
+ */
+void Host_initLcd(void)
+{
+	HD44780_init(&Host_lcd);
+	Host_addPortSource(Host_driveLcdBus);
+	Host_addPortListener(Host_updateLcd);
+}
+
+/*******************************************************************************
+ *                      Private Functions Definitions                          *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Give the LCD pin levels to the model.
+ */
+static void Host_updateLcd(void)
+{
+	uint8 port = Host_getPins(LCD_DATA_PORT_ID);
+	uint8 rs = GET_BIT(Host_getPins(LCD_RS_PORT_ID),LCD_RS_PIN_ID);
+	uint8 e = GET_BIT(Host_getPins(LCD_E_PORT_ID),LCD_E_PIN_ID);
+	uint8 rw = LOGIC_LOW;
+	uint8 data;
+
+#if (LCD_RW_PIN_ENABLE == 1)
+	rw = GET_BIT(Host_getPins(LCD_RW_PORT_ID),LCD_RW_PIN_ID);
+#endif
+
+#if (LCD_DATA_BITS_MODE == 4)
+	data = (GET_BIT(port,LCD_DB4_PIN_ID) << 4) | (GET_BIT(port,LCD_DB5_PIN_ID) << 5) |
+			(GET_BIT(port,LCD_DB6_PIN_ID) << 6) | (GET_BIT(port,LCD_DB7_PIN_ID) << 7);
+#else
+	data = port;
+#endif
+
+	HD44780_setPins(&Host_lcd, rs, rw, e, data, Host_now());
+}
+
+/*
+ * Description :
+ * Port source: the LCD drives the data pins during a read cycle.
+ */
+static uint8 Host_driveLcdBus(uint8 port_num, uint8 levels)
+{
+	uint8 bus;
+
+	if((port_num == LCD_DATA_PORT_ID) && (HD44780_getBus(&Host_lcd, &bus) == TRUE))
+	{
+#if (LCD_DATA_BITS_MODE == 4)
+		levels = (levels & ~HOST_LCD_DATA_MASK) |
+				(GET_BIT(bus,4) << LCD_DB4_PIN_ID) | (GET_BIT(bus,5) << LCD_DB5_PIN_ID) |
+				(GET_BIT(bus,6) << LCD_DB6_PIN_ID) | (GET_BIT(bus,7) << LCD_DB7_PIN_ID);
+#else
+		levels = bus;
+#endif
+	}
+	return levels;
+}
@@ -0,0 +1,37 @@
+ /******************************************************************************
+ *
+ * Module: Host LCD
+ *
+ * File Name: host_lcd.h
+ *
+ * Description: HD44780 model wired on the virtual ports of the host core as
+ *              configured in lcd.h, for the LCD emulator and the HMI host build.
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#ifndef HOST_LCD_H_
+#define HOST_LCD_H_
+
+#include "std_types.h"
+#include "hd44780.h"
+
+/*******************************************************************************
+ *                              Global Variables                               *
+ *******************************************************************************/
+
+/* The LCD wired on the virtual ports as configured in lcd.h */
+extern HD44780_Type Host_lcd;
+
+/*******************************************************************************
+ *                              Functions Prototypes                           *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Power on the LCD model and connect it on the ports, after Host_init.
+ */
+void Host_initLcd(void);
+
+#endif /* HOST_LCD_H_ */
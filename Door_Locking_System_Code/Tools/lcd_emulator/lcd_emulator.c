@@ -0,0 +1,394 @@
+ /******************************************************************************
+ *
+ * Module: LCD Emulator
+ *
+ * File Name: lcd_emulator.c
+ *
+ * Description: Runs HMI_ECU/HAL/lcd.c unchanged on the host against the HD44780
+ *              model and plays a script of LCD driver calls. Each call reports
+ *              its bus cycles and virtual time, "expect" lines check the text
+ *              shown on the screen and "bytes" lines the cost of the last flush.
+ *
+ *              The driver runs on the real GPIO driver and the register model of
+ *              Tools/host, so the virtual time includes the cost of each register
+ *              access. Build from Door_Locking_System_Code (add -DLCD_DATA_BITS_MODE=4
+ *              and/or -DLCD_RW_PIN_ENABLE=1 for the other wirings):
+ *
+ *              gcc -std=gnu99 -funsigned-char -DF_CPU=8000000UL -DTRACE_ENABLE=0 -DLCD_ASYNC_ENABLE=0 \
+ *                  -ITools/host -ITools/lcd_emulator \
+ *                  -IHMI_ECU/HAL -IHMI_ECU/MCAL -IHMI_ECU/LIB -IHMI_ECU/Main \
+ *                  Tools/lcd_emulator/lcd_emulator.c Tools/lcd_emulator/hd44780.c \
+ *                  Tools/lcd_emulator/host_lcd.c Tools/host/host.c \
+ *                  HMI_ECU/HAL/lcd.c HMI_ECU/MCAL/gpio.c -o lcd_emulator
+ *
+ *              ./lcd_emulator Tools/lcd_emulator/hmi_screens.lcd
+ *
+ *              The exit status is 1 if an expect line failed or a timing
+ *              violation was found.
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lcd.h"
+#include "host.h"
+#include "host_lcd.h"
+
+#if (LCD_ASYNC_ENABLE == 1)
+#error "Build the emulator with -DLCD_ASYNC_ENABLE=0, the queue needs the Timer0 interrupt"
+#endif
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define EMULATOR_MAX_LINE              256
+#define EMULATOR_MAX_ARGS              6
+
+/* Bus write cycles of a command or character byte */
+#define EMULATOR_CYCLES_PER_BYTE       ((LCD_DATA_BITS_MODE == 4) ? 2 : 1)
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+/* Script argument, strings may hold any character code written as \xHH */
+typedef struct
+{
+	char text[EMULATOR_MAX_LINE];
+	uint16 length;
+}Emulator_ArgType;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static uint8 Emulator_parse(const char *line, Emulator_ArgType *args);
+static boolean Emulator_run(const Emulator_ArgType *args, uint8 count, uint32 line_number);
+static boolean Emulator_expect(uint8 row, const Emulator_ArgType *text, uint32 line_number);
+static boolean Emulator_expectBytes(uint32 bytes, uint32 line_number);
+static void Emulator_show(void);
+static char Emulator_printable(uint8 code);
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+static LCD_ProgressBarType g_bar;
+static uint32 g_failures = 0;
+
+/* Bus write cycles of the last LCD_flush */
+static uint32 g_flushWrites = 0;
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+int main(int argc, char *argv[])
+{
+	FILE *script;
+	char line[EMULATOR_MAX_LINE];
+	Emulator_ArgType args[EMULATOR_MAX_ARGS];
+	uint8 count;
+	uint32 line_number = 0;
+	uint32 violations = 0;
+	uint8 i;
+
+	if(argc != 2)
+	{
+		fprintf(stderr, "usage: %s script.lcd\n", argv[0]);
+		return 2;
+	}
+	script = fopen(argv[1], "r");
+	if(script == NULL)
+	{
+		perror(argv[1]);
+		return 2;
+	}
+
+	Host_init();
+	Host_initLcd();
+	printf("LCD %dx%d, %d-bit bus, RW pin %s\n", LCD_ROWS, LCD_COLS, LCD_DATA_BITS_MODE,
+			(LCD_RW_PIN_ENABLE == 1) ? "connected" : "grounded");
+
+	while(fgets(line, sizeof(line), script) != NULL)
+	{
+		line_number++;
+		count = Emulator_parse(line, args);
+		if(count == 0)
+		{
+			continue;
+		}
+		if(Emulator_run(args, count, line_number) == FALSE)
+		{
+			fprintf(stderr, "line %lu: bad command\n", (unsigned long)line_number);
+			g_failures++;
+		}
+	}
+	fclose(script);
+
+	for(i = 0; i < HD44780_NUM_OF_VIOLATIONS; i++)
+	{
+		violations += Host_lcd.violations[i];
+	}
+	printf("total %10lu writes %6lu reads %10.3f ms, %lu timing violations, %lu failed checks\n",
+			(unsigned long)Host_lcd.write_cycles, (unsigned long)Host_lcd.read_cycles,
+			Host_now() / 1e6, (unsigned long)violations, (unsigned long)g_failures);
+
+	return ((violations != 0) || (g_failures != 0)) ? 1 : 0;
+}
+
+/*******************************************************************************
+ *                      Private Functions Definitions                          *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Split a script line in words and quoted strings, '#' starts a comment.
+ * Returns the number of arguments.
+ */
+static uint8 Emulator_parse(const char *line, Emulator_ArgType *args)
+{
+	uint8 count = 0;
+	Emulator_ArgType *arg;
+	unsigned int code;
+
+	while(count < EMULATOR_MAX_ARGS)
+	{
+		while((*line == ' ') || (*line == '\t'))
+		{
+			line++;
+		}
+		if((*line == '\0') || (*line == '\n') || (*line == '\r') || (*line == '#'))
+		{
+			break;
+		}
+
+		arg = &args[count];
+		arg->length = 0;
+		if(*line == '"')
+		{
+			line++;
+			while((*line != '"') && (*line != '\0') && (*line != '\n'))
+			{
+				if((line[0] == '\\') && (line[1] == 'x') && (sscanf(&line[2], "%2x", &code) == 1))
+				{
+					arg->text[arg->length++] = (char)code;
+					line += 4;
+				}
+				else if((line[0] == '\\') && (line[1] != '\0'))
+				{
+					arg->text[arg->length++] = line[1];
+					line += 2;
+				}
+				else
+				{
+					arg->text[arg->length++] = *line++;
+				}
+			}
+			if(*line == '"')
+			{
+				line++;
+			}
+		}
+		else
+		{
+			while((*line != ' ') && (*line != '\t') && (*line != '\0') && (*line != '\n') && (*line != '\r'))
+			{
+				arg->text[arg->length++] = *line++;
+			}
+		}
+		arg->text[arg->length] = '\0';
+		count++;
+	}
+	return count;
+}
+
+/*
+ * Description :
+ * Run one script command, the commands that use the bus report their cost.
+ */
+static boolean Emulator_run(const Emulator_ArgType *args, uint8 count, uint32 line_number)
+{
+	const char *command = args[0].text;
+	uint32 writes = Host_lcd.write_cycles;
+	uint32 reads = Host_lcd.read_cycles;
+	uint64 start = Host_now();
+
+	if((strcmp(command, "init") == 0) && (count == 1))
+	{
+		LCD_init();
+	}
+	else if((strcmp(command, "clear") == 0) && (count == 1))
+	{
+		LCD_clearScreen();
+	}
+	else if((strcmp(command, "cursor") == 0) && (count == 3))
+	{
+		LCD_moveCursor(atoi(args[1].text), atoi(args[2].text));
+	}
+	else if((strcmp(command, "string") == 0) && (count == 4))
+	{
+		LCD_displayStringRowColumn(atoi(args[1].text), atoi(args[2].text), args[3].text);
+	}
+	else if((strcmp(command, "char") == 0) && (count == 2))
+	{
+		LCD_displayCharacter((uint8)strtol(args[1].text, NULL, 0));
+	}
+	else if((strcmp(command, "screen") == 0) && (count == 5))
+	{
+		/* Same as show_screen in the HMI main */
+		LCD_drawClear();
+		LCD_drawStringRowColumn(0, atoi(args[1].text), args[2].text);
+		LCD_drawStringRowColumn(1, atoi(args[3].text), args[4].text);
+		LCD_flush();
+		g_flushWrites = Host_lcd.write_cycles - writes;
+	}
+	else if((strcmp(command, "draw") == 0) && (count == 4))
+	{
+		LCD_drawStringRowColumn(atoi(args[1].text), atoi(args[2].text), args[3].text);
+		return TRUE;
+	}
+	else if((strcmp(command, "flush") == 0) && (count == 1))
+	{
+		LCD_flush();
+		g_flushWrites = Host_lcd.write_cycles - writes;
+	}
+	else if((strcmp(command, "bar") == 0) && (count == 4))
+	{
+		LCD_initProgressBar(&g_bar, atoi(args[1].text), atoi(args[2].text), atoi(args[3].text));
+	}
+	else if((strcmp(command, "progress") == 0) && (count == 3))
+	{
+		if(LCD_drawProgressBar(&g_bar, strtoul(args[1].text, NULL, 0), strtoul(args[2].text, NULL, 0)) == TRUE)
+		{
+			LCD_flush();
+			g_flushWrites = Host_lcd.write_cycles - writes;
+		}
+	}
+	else if((strcmp(command, "wait") == 0) && (count == 2))
+	{
+		Host_advanceNs((uint64)(atof(args[1].text) * 1e6));
+		return TRUE;
+	}
+	else if((strcmp(command, "expect") == 0) && (count == 3))
+	{
+		return Emulator_expect(atoi(args[1].text), &args[2], line_number);
+	}
+	else if((strcmp(command, "bytes") == 0) && (count == 2))
+	{
+		return Emulator_expectBytes(strtoul(args[1].text, NULL, 0), line_number);
+	}
+	else if((strcmp(command, "show") == 0) && (count == 1))
+	{
+		Emulator_show();
+		return TRUE;
+	}
+	else
+	{
+		return FALSE;
+	}
+
+	printf("%-8s %6lu writes %6lu reads %10.3f ms\n", command,
+			(unsigned long)(Host_lcd.write_cycles - writes), (unsigned long)(Host_lcd.read_cycles - reads),
+			(Host_now() - start) / 1e6);
+	return TRUE;
+}
+
+/*
+ * Description :
+ * Compare a screen row with the expected text, padded with spaces.
+ */
+static boolean Emulator_expect(uint8 row, const Emulator_ArgType *text, uint32 line_number)
+{
+	uint8 col;
+	uint8 expected;
+	boolean match = TRUE;
+
+	for(col = 0; col < LCD_COLS; col++)
+	{
+		expected = (col < text->length) ? (uint8)text->text[col] : ' ';
+		if(HD44780_getCell(&Host_lcd, LCD_ROWS, LCD_COLS, row, col) != expected)
+		{
+			match = FALSE;
+		}
+	}
+	if(match == FALSE)
+	{
+		g_failures++;
+		printf("line %lu: row %u is not \"%s\"\n", (unsigned long)line_number, row, text->text);
+		Emulator_show();
+	}
+	return TRUE;
+}
+
+/*
+ * Description :
+ * Compare the bytes of the last flush counted by LCD_getFlushStats with the expected
+ * number, and with the bus writes the display saw during that flush.
+ */
+static boolean Emulator_expectBytes(uint32 bytes, uint32 line_number)
+{
+	LCD_FlushStatsType stats;
+
+	LCD_getFlushStats(&stats);
+	if((stats.last_bytes != bytes) || (g_flushWrites != (stats.last_bytes * EMULATOR_CYCLES_PER_BYTE)))
+	{
+		g_failures++;
+		printf("line %lu: last flush sent %u bytes in %lu bus writes, expected %lu bytes\n",
+				(unsigned long)line_number, stats.last_bytes, (unsigned long)g_flushWrites, (unsigned long)bytes);
+	}
+	return TRUE;
+}
+
+/*
+ * Description :
+ * Print the screen, the CGRAM characters are shown as their code (0..7) and the
+ * 0xFF block as '#'.
+ */
+static void Emulator_show(void)
+{
+	uint8 row,col;
+
+	printf("+");
+	for(col = 0; col < LCD_COLS; col++)
+	{
+		printf("-");
+	}
+	printf("+\n");
+	for(row = 0; row < LCD_ROWS; row++)
+	{
+		printf("|");
+		for(col = 0; col < LCD_COLS; col++)
+		{
+			printf("%c", Emulator_printable(HD44780_getCell(&Host_lcd, LCD_ROWS, LCD_COLS, row, col)));
+		}
+		printf("|\n");
+	}
+	printf("+");
+	for(col = 0; col < LCD_COLS; col++)
+	{
+		printf("-");
+	}
+	printf("+\n");
+}
+
+static char Emulator_printable(uint8 code)
+{
+	if(code < 0x10)
+	{
+		return '0' + (code & 0x07);
+	}
+	if(code == 0xFF)
+	{
+		return '#';
+	}
+	if((code < 0x20) || (code >= 0x7F))
+	{
+		return '?';
+	}
+	return (char)code;
+}
@@ -0,0 +1,261 @@
+ /******************************************************************************
+ *
+ * Module: Motion Plot
+ *
+ * File Name: motion_plot.c
+ *
+ * Description: Runs the Control ECU motion profiles (LIB/motion.c) unchanged on
+ *              the host, with the real motor, PWM, timer and SysTime drivers on
+ *              the register model of Tools/host. One move is played and the
+ *              commanded outputs (OCR0 duty and IN1/IN2) are sampled every
+ *              millisecond of virtual time, then printed as a chart or as CSV
+ *              (time_ms,in1,in2,duty_percent) for a plotting program.
+ *
+ *              -creep sets the creep duty, the end of travel switch is then hit
+ *              PLOT_CREEP_MS after the move. -stop calls Motion_stop at the given
+ *              time, e.g. in the middle of a ramp: the exit status is 1 if the
+ *              duty then rises over the duty at the stop (or the creep duty).
+ *
+ *              Build from Door_Locking_System_Code:
+ *
+ *              gcc -std=gnu99 -funsigned-char -DF_CPU=8000000UL -DTRACE_ENABLE=0 \
+ *                  -ITools/host -IControl_ECU/HAL -IControl_ECU/MCAL -IControl_ECU/LIB -IControl_ECU/Main \
+ *                  Tools/motion_plot/motion_plot.c Control_ECU/LIB/motion.c \
+ *                  Control_ECU/LIB/systime.c Control_ECU/HAL/DC_MOTOR.c \
+ *                  Control_ECU/MCAL/PWM.c Control_ECU/MCAL/gpio.c Control_ECU/MCAL/timer.c \
+ *                  Tools/host/host.c Tools/host/host_timer.c -o motion_plot
+ *
+ *              ./motion_plot [-csv] [-creep duty] [-stop stop_ms] [trapezoid|s-curve]
+ *                            [move_ms] [ramp_ms] [brake_ms]
+ *              ./motion_plot -creep 30 -stop 700
+ *
+ * Author: Mohamed Khaled
+ *
+ *******************************************************************************/
+
+#define HOST_REGISTER_ADDRESSES
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host.h"
+#include "gpio.h"
+#include "systime.h"
+#include "PWM.h"
+#include "DC_MOTOR.h"
+#include "motion.h"
+#include <avr/interrupt.h>
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/* Default move: the door travel of the firmware */
+#define PLOT_DEFAULT_MOVE_MS           15000UL
+#define PLOT_DEFAULT_RAMP_MS           1500U
+#define PLOT_DEFAULT_BRAKE_MS          200U
+
+/* Creep time to the end of travel switch when creeping, as the firmware plans it */
+#define PLOT_CREEP_MS                  500UL
+
+/* Time recorded after the move, the brake and the release are seen */
+#define PLOT_TAIL_MS                   500UL
+
+/* Chart size */
+#define PLOT_ROWS                      64
+#define PLOT_WIDTH                     50
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+typedef struct
+{
+	uint8 pins;                        /* IN2:IN1 */
+	uint8 duty;                        /* Percent */
+}Plot_SampleType;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static void Plot_chart(const Plot_SampleType *samples, uint32 count);
+static const char *Plot_pinsName(uint8 pins);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+int main(int argc, char *argv[])
+{
+	Motion_ConfigType config = { MOTION_S_CURVE, 100, 0, PLOT_DEFAULT_RAMP_MS, PLOT_DEFAULT_RAMP_MS, PLOT_DEFAULT_BRAKE_MS,
+			0, NULL_PTR };
+	uint32 move_ms = PLOT_DEFAULT_MOVE_MS;
+	uint32 stop_ms = 0;
+	uint32 creep_ms = 0;
+	uint8 stop_duty = 0;
+	uint8 max_duty;
+	uint32 rises = 0;
+	boolean csv = FALSE;
+	Plot_SampleType *samples;
+	uint32 count;
+	uint32 ms;
+	uint8 pins;
+	int arg = 1;
+
+	while((argc > arg) && (argv[arg][0] == '-'))
+	{
+		if(strcmp(argv[arg], "-csv") == 0)
+		{
+			csv = TRUE;
+			arg++;
+		}
+		else if((strcmp(argv[arg], "-creep") == 0) && (argc > arg + 1))
+		{
+			config.creep_duty = (uint8)strtoul(argv[arg + 1], NULL, 10);
+			creep_ms = PLOT_CREEP_MS;
+			arg += 2;
+		}
+		else if((strcmp(argv[arg], "-stop") == 0) && (argc > arg + 1))
+		{
+			stop_ms = strtoul(argv[arg + 1], NULL, 10);
+			arg += 2;
+		}
+		else
+		{
+			break;
+		}
+	}
+	if(argc > arg)
+	{
+		if(strcmp(argv[arg], "trapezoid") == 0)
+		{
+			config.shape = MOTION_TRAPEZOID;
+		}
+		else if(strcmp(argv[arg], "s-curve") != 0)
+		{
+			fprintf(stderr, "usage: %s [-csv] [-creep duty] [-stop stop_ms] [trapezoid|s-curve] [move_ms] [ramp_ms] [brake_ms]\n",
+					argv[0]);
+			return 2;
+		}
+		arg++;
+	}
+	if(argc > arg)
+	{
+		move_ms = strtoul(argv[arg++], NULL, 10);
+	}
+	if(argc > arg)
+	{
+		config.accel_ms = (uint16)strtoul(argv[arg++], NULL, 10);
+		config.decel_ms = config.accel_ms;
+	}
+	if(argc > arg)
+	{
+		config.brake_ms = (uint16)strtoul(argv[arg++], NULL, 10);
+	}
+
+	Host_init();
+	Host_initTimers();
+	sei();
+	SysTime_init();
+	DC_Motor_init();
+	Motion_init(&config);
+	SysTime_addTickHook(Motion_tick);
+
+	count = move_ms + creep_ms + config.brake_ms + PLOT_TAIL_MS;
+	samples = malloc(count * sizeof(Plot_SampleType));
+	if(samples == NULL)
+	{
+		perror("motion_plot");
+		return 2;
+	}
+
+	Motion_move(DC_MOTOR_CCW, move_ms);
+	for(ms = 0; ms < count; ms++)
+	{
+		if((stop_ms != 0) && (ms == stop_ms))
+		{
+			stop_duty = Motion_getDuty();
+			Motion_stop();
+		}
+		if((creep_ms != 0) && (ms == move_ms + creep_ms))
+		{
+			Motion_brake(); /* End of travel switch */
+		}
+		Host_advanceNs(HOST_MS_TO_NS(1));
+
+		/* A stop decelerates from the current duty, the brake is the only higher command */
+		max_duty = (stop_duty > config.creep_duty) ? stop_duty : config.creep_duty;
+		if((stop_ms != 0) && (ms >= stop_ms) && (Motion_getState() != MOTION_BRAKE) && (Motion_getDuty() > max_duty))
+		{
+			rises++;
+		}
+
+		pins = (Host_getPins(DC_MOTOR_PORT_ID) >> IN1_PIN_ID) & 1;
+		pins |= ((Host_getPins(DC_MOTOR_PORT_ID) >> IN2_PIN_ID) & 1) << 1;
+		samples[ms].pins = pins;
+		samples[ms].duty = (uint8)((Host_getRegister(OCR0) * 100U + PWM_TOP / 2) / PWM_TOP);
+		if(csv == TRUE)
+		{
+			printf("%lu,%u,%u,%u\n", (unsigned long)ms + 1, pins & 1, pins >> 1, samples[ms].duty);
+		}
+	}
+
+	if(csv == FALSE)
+	{
+		printf("%s move of %lu ms, ramps of %u ms, brake of %u ms, creep at %u%%\n",
+				(config.shape == MOTION_S_CURVE) ? "S-curve" : "Trapezoid", (unsigned long)move_ms,
+				config.accel_ms, config.brake_ms, config.creep_duty);
+		if(stop_ms != 0)
+		{
+			printf("stop at %lu ms from %u%%, %lu ms with the duty over it\n", (unsigned long)stop_ms, stop_duty,
+					(unsigned long)rises);
+		}
+		Plot_chart(samples, count);
+	}
+	free(samples);
+
+	return (rises != 0) ? 1 : 0;
+}
+
+/*******************************************************************************
+ *                      Private Functions Definitions                          *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Print one row per time slice with the duty at the end of the slice, the rows of the
+ * ramps and of the brake are printed at a finer step so their shape stays visible.
+ */
+static void Plot_chart(const Plot_SampleType *samples, uint32 count)
+{
+	uint32 step = (count + PLOT_ROWS - 1) / PLOT_ROWS;
+	uint32 fine_step = (step >= 10) ? (step / 5) : 1;
+	uint32 ms = 0;
+	uint8 bar;
+	char line[PLOT_WIDTH + 1];
+
+	while(ms < count)
+	{
+		bar = (uint8)((samples[ms].duty * PLOT_WIDTH + 50) / 100);
+		memset(line, (samples[ms].pins == 3) ? '=' : '#', bar);
+		line[bar] = '\0';
+		printf("%8.3f s %-5s %3u%% |%s\n", (ms + 1) / 1000.0, Plot_pinsName(samples[ms].pins), samples[ms].duty, line);
+
+		/* Fine rows while the duty changes or the motor brakes */
+		if((ms + step < count) && ((samples[ms + step].duty != samples[ms].duty) ||
+				(samples[ms + step].pins != samples[ms].pins)))
+		{
+			ms += fine_step;
+		}
+		else
+		{
+			ms += step;
+		}
+	}
+}
+
+static const char *Plot_pinsName(uint8 pins)
+{
+	static const char *names[] = { "off", "CW", "CCW", "brake" };
+	return names[pins & 3];
+}
@@ -0,0 +1,161 @@
+#!/usr/bin/env python3
+"""
+Decode the trace lines streamed by both ECUs (LIB/trace.c) into one
+Chrome trace JSON timeline (open it in chrome://tracing or Perfetto).
+
+The input files are raw captures of each ECU TX line (e.g. a Proteus
+virtual terminal or a USB-UART tap). The protocol bytes around the trace
+lines are ignored.
+
+    trace_decode.py control.log hmi.log -o door_trace.json
+
+The ECU clocks are independent. Unless --no-align is given, the HMI
+timeline is shifted so that the first byte sent by one ECU lines up with
+its reception on the other one.
+"""
+
+import argparse
+import json
+import re
+import sys
+
+# SysTime_now() resolution, Timer1 at F_CPU/256 with F_CPU = 8MHz
+US_PER_COUNT = 32
+
+LINE = re.compile(rb"T([CH])([0-9A-F]{8})([0-9A-F]{2})([0-9A-F]{4})\n")
+
+# Keep in sync with Trace_EventType in LIB/trace.h
+EVENTS = [
+    "DROPPED", "STATE", "ISR_ENTER", "ISR_EXIT", "LINK_TX", "LINK_RX",
+    "TWI_READ", "TWI_WRITE", "TWI_END", "LCD_COMMAND", "KEYPAD_WAKE",
+]
+ISRS = ["TIMER0", "TIMER1", "TIMER2", "UART_RX"]
+
+# Application events from TRACE_EVENT_USER on, keep in sync with both Main/main.c
+USER_EVENTS = {
+    "C": ["DEBOUNCE_PORT_CYCLES", "DEBOUNCE_PIN_CYCLES", "PWM_UPDATE_CYCLES", "PWM_REFERENCE_CYCLES"],
+    "H": ["SUBMIT_LATENCY"],
+}
+
+# Events recorded at their end with their length in SysTime counts as argument
+SPANS = {"KEYPAD_WAKE": "keypad", "SUBMIT_LATENCY": "link"}
+
+# Keep in sync with the stage/step enums of both Main/main.c
+STATES = {
+    "C": ["NO_STATE", "NEW_PASSWARD", "LOCKED", "RETRY", "CHOICE", "OPENING",
+          "HOLDING", "CLEARING", "CLOSING", "LOCKOUT"],
+    "H": ["NO_STEP", "CREATE_SYSTEM_PASSWARD", "CHECK_PASSWARD", "MAIN_OPTIONS",
+          "VERIFY_OPEN_DOOR", "VERIFY_CHANGE_PASS", "RETRY_PASSWARD", "OPEN_DOOR",
+          "WAIT_PEOPLE", "CLOSE_DOOR", "SYSTEM_LOCKED"],
+}
+ECU_NAMES = {"C": "Control_ECU", "H": "HMI_ECU"}
+PIDS = {"C": 1, "H": 2}
+
+
+def name_of(table, index):
+    return table[index] if index < len(table) else str(index)
+
+
+def read_records(path):
+    """Return the (source, time_us, event, arg) tuples of one capture."""
+    with open(path, "rb") as capture:
+        data = capture.read()
+    records = []
+    wraps = {}
+    last = {}
+    for match in LINE.finditer(data):
+        source = match.group(1).decode()
+        counts = int(match.group(2), 16)
+        # Unwrap the 32-bit counter (every ~38 hours)
+        if source in last and counts < last[source] - 0x80000000:
+            wraps[source] = wraps.get(source, 0) + 1
+        last[source] = counts
+        counts += wraps.get(source, 0) << 32
+        records.append((source, counts * US_PER_COUNT,
+                        int(match.group(3), 16), int(match.group(4), 16)))
+    return records
+
+
+def clock_offset(records):
+    """Offset to add to the HMI times, from the first byte seen on both sides."""
+    sent = {}
+    for source, time_us, event, arg in records:
+        if name_of(EVENTS, event) == "LINK_TX":
+            sent.setdefault((source, arg), time_us)
+    for source, time_us, event, arg in records:
+        if name_of(EVENTS, event) == "LINK_RX":
+            other = "H" if source == "C" else "C"
+            if (other, arg) in sent:
+                if source == "C":
+                    # HMI sent it, the Control ECU received it later
+                    return time_us - sent[(other, arg)]
+                return sent[(other, arg)] - time_us
+    return 0
+
+
+def to_chrome(records, offset):
+    events = []
+    for source in sorted({record[0] for record in records}):
+        events.append({"name": "process_name", "ph": "M", "pid": PIDS[source],
+                       "args": {"name": ECU_NAMES[source]}})
+
+    open_state = {}
+    for source, time_us, event, arg in records:
+        ts = time_us + (offset if source == "H" else 0)
+        pid = PIDS[source]
+        kind = name_of(EVENTS, event)
+        if event >= len(EVENTS):
+            kind = name_of(USER_EVENTS[source], event - len(EVENTS))
+        if kind == "STATE":
+            if source in open_state:
+                events.append({"name": open_state[source], "ph": "E", "ts": ts,
+                               "pid": pid, "tid": "fsm"})
+            open_state[source] = name_of(STATES[source], arg)
+            events.append({"name": open_state[source], "ph": "B", "ts": ts,
+                           "pid": pid, "tid": "fsm"})
+        elif kind in ("ISR_ENTER", "ISR_EXIT"):
+            events.append({"name": name_of(ISRS, arg),
+                           "ph": "B" if kind == "ISR_ENTER" else "E", "ts": ts,
+                           "pid": pid, "tid": "isr"})
+        elif kind in ("TWI_READ", "TWI_WRITE"):
+            events.append({"name": kind, "ph": "B", "ts": ts, "pid": pid,
+                           "tid": "twi", "args": {"address": arg}})
+        elif kind == "TWI_END":
+            events.append({"name": "TWI", "ph": "E", "ts": ts, "pid": pid,
+                           "tid": "twi", "args": {"status": arg}})
+        elif kind in SPANS:
+            events.append({"name": kind, "ph": "X", "ts": ts - arg * US_PER_COUNT,
+                           "dur": arg * US_PER_COUNT, "pid": pid, "tid": SPANS[kind]})
+        else:
+            events.append({"name": kind, "ph": "i", "s": "t", "ts": ts, "pid": pid,
+                           "tid": "link" if kind.startswith("LINK") else "events",
+                           "args": {"arg": "0x%04X" % arg}})
+    return {"traceEvents": events, "displayTimeUnit": "ms"}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("captures", nargs="+", help="raw UART captures of the ECUs")
+    parser.add_argument("-o", "--output", help="output file (default stdout)")
+    parser.add_argument("--no-align", action="store_true",
+                        help="do not align the HMI clock on the Control ECU clock")
+    args = parser.parse_args()
+
+    records = []
+    for path in args.captures:
+        records.extend(read_records(path))
+
+    offset = 0 if args.no_align else clock_offset(records)
+    records.sort(key=lambda record: record[1] + (offset if record[0] == "H" else 0))
+
+    trace = to_chrome(records, offset)
+    output = open(args.output, "w") if args.output else sys.stdout
+    json.dump(trace, output, indent=1)
+    if args.output:
+        output.close()
+    sys.stderr.write("%d records, HMI clock offset %d us\n" % (len(records), offset))
+
+
+if __name__ == "__main__":
+    main()